@@ -7,13 +7,44 @@
     *   @modify:    data            remarks
 **************************************************************/
 #include "bsp.h"
-#define UART2_BUF_SIZES     8
-uint8_t uart_rxbuf[UART2_BUF_SIZES];
-uint8_t uart_txbuf[UART2_BUF_SIZES];
-uint8_t buf_sizes = UART2_BUF_SIZES;
+
+enum
+{
+    LINK_WAIT_SOF = 0,
+    LINK_WAIT_LEN,
+    LINK_WAIT_SEQ,
+    LINK_WAIT_TYPE,
+    LINK_WAIT_PAYLOAD,
+    LINK_WAIT_CRC
+};
+
+struct link_parser
+{
+    uint8_t state;                      //解析状态
+    uint8_t len;                        //负载长度
+    uint8_t seq;                        //帧序号
+    uint8_t type;                       //帧类型
+    uint8_t idx;                        //已收负载字节数
+    uint8_t crc;                        //CRC8累计值
+    uint8_t payload[LINK_PAYLOAD_MAX];  //负载
+};
+
+uint8_t uart_rxbyte;                                //逐字节接收
+uint8_t uart_txbuf[LINK_FRAME_MIN];                 //重发请求帧
+uint8_t link_report[LINK_REPORT_LEN];               //当前报告
+uint8_t link_consumer[LINK_EXT_CONSUMER_LEN];       //当前消费类报告
+uint8_t link_system[LINK_EXT_SYSTEM_LEN];           //当前系统控制报告
+static struct link_parser link_rx;
+static uint8_t link_synced = 0;                     //0：等待快照
+static uint8_t link_expect_seq = 0;                 //下一帧增量的序号
+static volatile uint8_t link_tx_busy = 0;           //重发请求发送中
+volatile uint32_t link_crc_err = 0;                 //CRC错误次数
+volatile uint32_t link_resync = 0;                  //发送重发请求次数
 volatile uint32_t pass_code __attribute__((section("retention_mem_area0"), zero_init));
 extern enum REPORT_MODE kbd_reports_en;
 
+static void User_Uart2_TX_Callback(uint8_t state);
+
 /*============================================================
     *   @func:      XX
     *   @brief:     XX
@@ -28,7 +59,7 @@ static void user_Send_Passcode(void)
 
     for (uint8_t i = 0; i < 6; ++i)
     {
-        keycode = uart_rxbuf[i+2];
+        keycode = link_report[i+2];
 				//首先判断键值是否存在
         if(keycode == 0x00)         
         {
@@ -70,47 +101,295 @@ static void User_Send_HID_Report(void)
     req->hids_nb = 0;
     req->report_nb = 0;
     req->report_length = 8;
-    memcpy(req->report, uart_rxbuf, 8);
+    memcpy(req->report, link_report, 8);
 
     dbg_printf(DBG_SCAN_LVL, "Sending HOGPD_REPORT_UPD_REQ %02x:[%02x:%02x:%02x:%02x:%02x:%02x]\r\n",
-               (int)uart_rxbuf[0], (int)uart_rxbuf[2], (int)uart_rxbuf[3], (int)uart_rxbuf[4], (int)uart_rxbuf[5], (int)uart_rxbuf[6], (int)uart_rxbuf[7]);
+               (int)link_report[0], (int)link_report[2], (int)link_report[3], (int)link_report[4], (int)link_report[5], (int)link_report[6], (int)link_report[7]);
 
     ke_msg_send(req);
 }
 
 /*============================================================
-    *   @func:      XX
-    *   @brief:     XX
+    *   @func:      User_Send_Ext_Report
+    *   @brief:     发送消费类/系统控制报告
+    *   @param:     report_nb：HOGP报告序号 data：报告数据 len：长度
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+static void User_Send_Ext_Report(uint8_t report_nb, uint8_t *data, uint8_t len)
+{
+    struct hogpd_report_info *req;
+    req = KE_MSG_ALLOC_DYN(HOGPD_REPORT_UPD_REQ, TASK_HOGPD, TASK_APP, hogpd_report_info, len);
+
+    req->conhdl = app_env.conhdl;
+    req->hids_nb = 0;
+    req->report_nb = report_nb;
+    req->report_length = len;
+    memcpy(req->report, data, len);
+
+    ke_msg_send(req);
+}
+/*============================================================
+    *   @func:      User_Link_Ext
+    *   @brief:     EXT帧按报告ID覆盖对应报告，有变化且已连接时发给主机。
+    *               配对输入密码期间不发送
     *   @param:     NA
     *   @retval:    NA
     *   @modify:    data            remarks
 =============================================================*/
-static void User_Uart2_Callback(uint8_t state)
+static void User_Link_Ext(void)
 {
-    if(state == UART_STATUS_OK)
+    uint8_t *data = &link_rx.payload[1];
+    uint8_t len = link_rx.len - 1;
+    uint8_t *cur;
+    uint8_t report_nb;
+
+    if ((link_rx.payload[0] == LINK_EXT_CONSUMER_ID) && (len == LINK_EXT_CONSUMER_LEN))
+    {
+        cur = link_consumer;
+        report_nb = EXTENDED_REPORT;
+    }
+    else if ((link_rx.payload[0] == LINK_EXT_SYSTEM_ID) && (len == LINK_EXT_SYSTEM_LEN))
+    {
+        cur = link_system;
+        report_nb = SYSTEM_REPORT;
+    }
+    else
+    {
+        return;
+    }
+    if (memcmp(cur, data, len) == 0)
+    {
+        return;
+    }
+    memcpy(cur, data, len);
+    if (kbd_reports_en == REPORTS_ENABLED)
+    {
+        User_Send_Ext_Report(report_nb, cur, len);
+    }
+}
+/*============================================================
+    *   @func:      User_Report_Deliver
+    *   @brief:     报告发生变化，发送给主机或作为配对密码输入
+    *   @param:     NA
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+static void User_Report_Deliver(void)
+{
+    if (kbd_reports_en == REPORTS_ENABLED)
+    {
+        User_Send_HID_Report();
+    }
+    else
+    {
+        user_Send_Passcode();
+    }
+}
+/*============================================================
+    *   @func:      User_Link_CRC8
+    *   @brief:     CRC8，多项式0x07，与STM32端一致
+    *   @param:     NA
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+static uint8_t User_Link_CRC8(uint8_t crc, uint8_t byte)
+{
+    crc ^= byte;
+    for (uint8_t i = 0; i < 8; ++i)
+    {
+        crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+    }
+    return crc;
+}
+/*============================================================
+    *   @func:      User_Link_Resync
+    *   @brief:     失步，请求STM32重发快照。上一个请求未发完时不再重复发送
+    *   @param:     NA
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+static void User_Link_Resync(void)
+{
+    uint8_t crc = 0;
+
+    link_synced = 0;
+    if (link_tx_busy)
+    {
+        return;
+    }
+    uart_txbuf[0] = LINK_SOF;
+    uart_txbuf[1] = 0;
+    uart_txbuf[2] = link_expect_seq;
+    uart_txbuf[3] = LINK_TYPE_RESYNC;
+    for (uint8_t i = 1; i < LINK_FRAME_MIN - 1; ++i)
+    {
+        crc = User_Link_CRC8(crc, uart_txbuf[i]);
+    }
+    uart_txbuf[LINK_FRAME_MIN - 1] = crc;
+    link_tx_busy = 1;
+    link_resync++;
+    uart2_write(uart_txbuf, LINK_FRAME_MIN, &User_Uart2_TX_Callback);
+}
+/*============================================================
+    *   @func:      User_Link_Frame
+    *   @brief:     处理一个完整帧。快照直接覆盖当前报告；增量只在序号连续时应用，
+    *               否则请求快照；EXT为完整报告，总是应用，序号不连续说明其间
+    *               可能丢了增量帧，同样请求快照
+    *   @param:     NA
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+static void User_Link_Frame(void)
+{
+    uint8_t changed = 0;
+
+    if ((link_rx.type == LINK_TYPE_SNAPSHOT) && (link_rx.len == LINK_REPORT_LEN))
+    {
+        changed = (memcmp(link_report, link_rx.payload, LINK_REPORT_LEN) != 0);
+        memcpy(link_report, link_rx.payload, LINK_REPORT_LEN);
+        link_synced = 1;
+    }
+    else if (link_rx.type == LINK_TYPE_DELTA)
     {
-        if (kbd_reports_en == REPORTS_ENABLED)
+        if ((!link_synced) || (link_rx.seq != link_expect_seq))
         {
-            User_Send_HID_Report();
+            User_Link_Resync();
+            return;
         }
-        else
+        for (uint8_t i = 0; i + 1 < link_rx.len; i += 2)
         {
-            user_Send_Passcode();
+            if (link_rx.payload[i] < LINK_REPORT_LEN)
+            {
+                link_report[link_rx.payload[i]] = link_rx.payload[i + 1];
+            }
         }
-        uart2_write(uart_rxbuf, buf_sizes, NULL);    //串口2打印接收到的数据
-        User_Uart2_RX_Pre();                         //串口2重新进入接收状态
+        changed = 1;
+    }
+    else if ((link_rx.type == LINK_TYPE_EXT) && (link_rx.len >= 2))
+    {
+        if (link_synced && (link_rx.seq != link_expect_seq))
+        {
+            User_Link_Resync();
+        }
+        User_Link_Ext();
+    }
+    else
+    {
+        return;
+    }
+    link_expect_seq = link_rx.seq + 1;
+    if (changed)
+    {
+        User_Report_Deliver();
     }
 }
 /*============================================================
-    *   @func:      XX
-    *   @brief:     XX
+    *   @func:      User_Link_Parse
+    *   @brief:     逐字节解帧，CRC错误时请求快照并重新寻找SOF
+    *   @param:     byte：收到的字节
+    *   @retval:    1：收到完整有效帧 0：未完成
+    *   @modify:    data            remarks
+=============================================================*/
+static uint8_t User_Link_Parse(uint8_t byte)
+{
+    struct link_parser *p = &link_rx;
+
+    switch (p->state)
+    {
+    case LINK_WAIT_SOF:
+        if (byte == LINK_SOF)
+        {
+            p->crc = 0;
+            p->state = LINK_WAIT_LEN;
+        }
+        break;
+    case LINK_WAIT_LEN:
+        if (byte > LINK_PAYLOAD_MAX)
+        {
+            p->state = (byte == LINK_SOF) ? LINK_WAIT_LEN : LINK_WAIT_SOF;
+            break;
+        }
+        p->len = byte;
+        p->idx = 0;
+        p->crc = User_Link_CRC8(p->crc, byte);
+        p->state = LINK_WAIT_SEQ;
+        break;
+    case LINK_WAIT_SEQ:
+        p->seq = byte;
+        p->crc = User_Link_CRC8(p->crc, byte);
+        p->state = LINK_WAIT_TYPE;
+        break;
+    case LINK_WAIT_TYPE:
+        p->type = byte;
+        p->crc = User_Link_CRC8(p->crc, byte);
+        p->state = p->len ? LINK_WAIT_PAYLOAD : LINK_WAIT_CRC;
+        break;
+    case LINK_WAIT_PAYLOAD:
+        p->payload[p->idx++] = byte;
+        p->crc = User_Link_CRC8(p->crc, byte);
+        if (p->idx >= p->len)
+        {
+            p->state = LINK_WAIT_CRC;
+        }
+        break;
+    default:
+        if (byte == p->crc)
+        {
+            p->state = LINK_WAIT_SOF;
+            return 1;
+        }
+        link_crc_err++;
+        p->crc = 0;
+        p->state = (byte == LINK_SOF) ? LINK_WAIT_LEN : LINK_WAIT_SOF;     //帧被截断时可能是下一帧的SOF
+        User_Link_Resync();
+        break;
+    }
+    return 0;
+}
+/*============================================================
+    *   @func:      User_Uart2_TX_Callback
+    *   @brief:     重发请求发送完成
+    *   @param:     NA
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+static void User_Uart2_TX_Callback(uint8_t state)
+{
+    link_tx_busy = 0;
+}
+/*============================================================
+    *   @func:      User_Uart2_Callback
+    *   @brief:     串口2收到一个字节，送入帧解析
+    *   @param:     NA
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+static void User_Uart2_Callback(uint8_t state)
+{
+    if(state == UART_STATUS_OK)
+    {
+        if (User_Link_Parse(uart_rxbyte))
+        {
+            User_Link_Frame();
+        }
+    }
+    else
+    {
+        link_rx.state = LINK_WAIT_SOF;      //接收错误，丢弃当前帧
+    }
+    User_Uart2_RX_Pre();                    //串口2重新进入接收状态
+}
+/*============================================================
+    *   @func:      User_Uart2_RX_Pre
+    *   @brief:     串口2接收下一个字节
     *   @param:     NA
     *   @retval:    NA
     *   @modify:    data            remarks
 =============================================================*/
 void User_Uart2_RX_Pre(void)
 {
-    uart2_read_func(uart_rxbuf, buf_sizes, &User_Uart2_Callback);
+    uart2_read_func(&uart_rxbyte, 1, &User_Uart2_Callback);
 }
 
 
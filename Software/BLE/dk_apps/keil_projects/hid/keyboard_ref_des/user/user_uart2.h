@@ -1,5 +1,24 @@
 #ifndef __USER_UART2_H
 #define __USER_UART2_H
 #include "bsp.h"
+
+/*
+    与STM32的串口报告链路，帧格式与STM32端 user_link.h 一致：
+    [SOF][LEN][SEQ][TYPE][PAYLOAD(LEN字节)][CRC8]
+*/
+#define USER_UART2_BAUDRATE     2           //16MHz/(16*2) = 500000，与STM32 UART1_BAUD一致
+#define LINK_SOF                0xA5
+#define LINK_TYPE_SNAPSHOT      0x01        //完整报告
+#define LINK_TYPE_DELTA         0x02        //报告增量：[下标][新值]...
+#define LINK_TYPE_RESYNC        0x03        //请求重发快照
+#define LINK_TYPE_EXT           0x04        //完整的消费类/系统控制报告：[报告ID][数据]
+#define LINK_EXT_CONSUMER_ID    0x03        //消费类，HOGP报告2，3字节
+#define LINK_EXT_CONSUMER_LEN   3
+#define LINK_EXT_SYSTEM_ID      0x04        //系统控制，HOGP报告3，1字节
+#define LINK_EXT_SYSTEM_LEN     1
+#define LINK_REPORT_LEN         8
+#define LINK_PAYLOAD_MAX        LINK_REPORT_LEN
+#define LINK_FRAME_MIN          5           //无负载帧长度
+
 void User_Uart2_RX_Pre(void);		//uart2接收准备
 #endif
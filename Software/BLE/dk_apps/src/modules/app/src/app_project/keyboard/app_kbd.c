@@ -70,6 +70,10 @@
 #define __RETAINED __attribute__((section("retention_mem_area0"), zero_init))
 #define __RETAINED_ALIGN_16 __RETAINED __attribute__((aligned (16)))
 
+#if (HAS_ADAPTIVE_SCAN_TIMES) && ((FAST_SCAN_IN_MS * 1000) < ((KBD_NR_OUTPUTS + 1) * ROW_SCAN_TIME))
+#error "FAST_SCAN_IN_MS is too short to scan all rows!"
+#endif
+
 #if defined(REMOTE_WAKEUP_ON) && defined(INACTIVITY_TIMEOUT_ON)
 #warning "Remote Host may not handle properly RemoteWakeup when the Inactivity Timeout is on (Some Hosts do not expect to receive LL_TERMINATE_IND from Wakeup capable devices while they are sleeping...)"
 #endif
@@ -90,9 +94,11 @@ bool keycode_buf_overflow __RETAINED;                               // Flag to i
 uint8_t kbd_key_report[MAX_REPORTS][8] __RETAINED_ALIGN_16;         // Key Report buffers
 uint8_t normal_key_report_st[8] __RETAINED;                         // Holds the contents of the last Key Report for normal keys sent to the Host
 uint8_t extended_key_report_st[3] __RETAINED;                       // Holds the contents of the last Key Report for special functions sent to the Host
-kbd_rep_info report_list[MAX_REPORTS] __RETAINED;                   // The list of the reports instances (free or used)
-kbd_rep_info *kbd_trm_list __RETAINED;                              // Linked list of the pending Key Reports
-kbd_rep_info *kbd_free_list __RETAINED;                             // Linked list of the free Key Reports
+kbd_rep_info report_list[MAX_REPORTS] __RETAINED;                   // Ring of the reports instances (pending ones from kbd_trm_head on)
+uint8_t kbd_trm_head __RETAINED;                                    // Ring index of the oldest pending Key Report
+uint8_t kbd_trm_cnt __RETAINED;                                     // Number of pending Key Reports
+kbd_rep_info *kbd_last_normal __RETAINED;                           // Newest pending NORMAL Key Report, if any
+kbd_rep_info *kbd_last_extended __RETAINED;                         // Newest pending EXTENDED Key Report, if any
 //bool normal_key_report_ack_pending __RETAINED;                      // Keeps track of the acknowledgement of the last Key Report for normal keys sent to the Host
 //bool extended_key_report_ack_pending __RETAINED;                    // Keeps track of the acknowledgement of the last Key Report for special functions sent to the Host
     
@@ -112,26 +118,36 @@ bool ble_is_woken_up __RETAINED;                                    // Flag to i
  */
  
 bool systick_hit = false;
+uint16_t systick_wraps;             // SysTick periods completed since systick_start()
+uint32_t systick_counted;           // SysTick ticks since systick_start() already added to scan_elapsed_ticks
 bool wkup_hit = false;      // does not have to be a RETAINED var since the KBD application wakes up from Deep Sleep only from a key press!
 
 uint8_t kbd_membrane_status;                                        // 0: outputs are low => SW is prohibited, 1: outputs are high-Z => SW can do scanning
 scan_t kbd_scandata[KBD_NR_OUTPUTS];                                // last reported status of the keyboard
 bool kbd_active_row[KBD_NR_OUTPUTS];                                // last known status of the keyboard
 scan_t kbd_new_scandata[KBD_NR_OUTPUTS];                            // current status of the keyboard
+uint32_t kbd_key_exist[KBD_NR_OUTPUTS];                             // keys that physically exist: bit i of row o is set when kbd_keymap[0][o][i] != 0
 bool kbd_new_key_detected;                                          // flag to indicate that a new key was detected during the last scan
 int kbd_fn_modifier;                                                // Fn key has been pressed
 bool kbd_cntrl_active;                                              // flag to indicate the the Keyboard Controller is ON
 
 int scan_cycle_time;                                                // time until the next wake up from SysTick
 int scan_cycle_time_last;                                           // duration of the current scan cycle
+uint32_t scan_elapsed_ticks;                                        // SysTick ticks measured since the debouncing counters were last updated
+uint8_t scan_cycle_ms;                                              // scan period (in msec) of the current scan cycle
+enum SCAN_MODE kbd_scan_mode;                                       // scan mode of the current scan cycle
+enum SCAN_MODE kbd_scan_next_mode;                                  // scan mode chosen from the debouncing status at the end of the last scan
 bool full_scan;                                                     // when true a full keyboard scan is executed once. else only partial scan is done.
 bool next_is_full_scan;                                             // Got an interrupt (key press) during partial scanning
 
 uint8_t kbd_bounce_active;                                          // flag indicating we are still in debouncing mode
-uint16_t kbd_bounce_intersections[DEBOUNCE_BUFFER_SIZE];            // holds output - input pair (key) for which debouncing is on
-scan_t kbd_bounce_rows[KBD_NR_OUTPUTS];                             // holds the key mask ('1' is active) for each row that is being debounced
-struct debounce_counter_t kbd_bounce_counters[DEBOUNCE_BUFFER_SIZE];// counter for each intersection (key)
+scan_t kbd_bounce_rows[KBD_NR_OUTPUTS];                             // holds the key mask ('1' is active) of the keys that are not IDLE
+scan_t kbd_bounce_press[KBD_NR_OUTPUTS];                            // key mask of the keys in PRESS_DEBOUNCING
+scan_t kbd_bounce_release[KBD_NR_OUTPUTS];                          // key mask of the keys in RELEASE_DEBOUNCING (the rest of kbd_bounce_rows[] is in WAIT_RELEASE)
+uint8_t kbd_bounce_cnt[KBD_NR_OUTPUTS][KBD_NR_INPUTS];              // debouncing counter of each intersection (key)
+uint16_t kbd_keys_held;                                             // recorded key presses whose release has not been recorded yet
 uint8_t kbd_global_deb_cnt;                                         // counts down for press debouncing time when after a scan no new key has been detected
+struct kbd_scan_stats_t kbd_scan_stats;                             // scan statistics (only updated if HAS_SCAN_STATS)
 bool sync_key_press_evt;                                            // flag to indicate a Key press to the high-level FSM synchronously to the BLE
 bool sync_passcode_entered_evt;                                     // flag to indicate to the high-level FSM that the Passcode has been entered by the user, synchronously to the BLE
 
@@ -142,7 +158,10 @@ bool sync_passcode_entered_evt;                                     // flag to i
 
 static void kbd_enable_kbd_irq(void);
 static inline void kbd_process_scandata(void);
+static inline void kbd_update_bounce_counters(const uint8_t step);
+static inline void kbd_update_scan_mode(void);
 static int prepare_kbd_keyreport(void);
+__forceinline static int keycode_buffer_written_sz(void);
 
 
 
@@ -162,13 +181,13 @@ static inline uint8 hut_to_ascii(const uint8 hut)
 
 
 /*
- * (Report) List management functions
+ * (Report) Ring management functions
  ****************************************************************************************
  */
 
 /**
  ****************************************************************************************
- * @brief Initializes the lists
+ * @brief Initializes the report ring
  *
  * @param None
  *
@@ -180,7 +199,10 @@ static inline uint8 hut_to_ascii(const uint8 hut)
 	int i;
 	kbd_rep_info *node;
 
-	kbd_trm_list = NULL;
+	kbd_trm_head = 0;
+	kbd_trm_cnt = 0;
+	kbd_last_normal = NULL;
+	kbd_last_extended = NULL;
 	
 	for (i = 0; i < MAX_REPORTS; i++) 
     {
@@ -188,31 +210,36 @@ static inline uint8 hut_to_ascii(const uint8 hut)
 		node->pBuf = kbd_key_report[i];
 		node->type = FREE;
 		node->modifier_report = false; // normal keys
-		node->pNext = kbd_free_list;
-		kbd_free_list = node;
 	}
 }
 
 
 /**
  ****************************************************************************************
- * @brief Pulls one member from the beginning of the list
+ * @brief Pulls the oldest pending report from the ring
  *
- * @param[in] list The list to use
+ * @param None
  *
- * @return the member at the beginning of the list, if found, else NULL
+ * @return the oldest pending report, if any, else NULL. The report must be marked 
+ *         as FREE by the caller when it is no longer used.
  ****************************************************************************************
  */
-kbd_rep_info *kbd_pull_from_list(kbd_rep_info **list)
+kbd_rep_info *kbd_pull_report(void)
 {
 	kbd_rep_info *node;
 	
-	if (!(*list))
+	if (!kbd_trm_cnt)
 		return NULL;
 	
-	node = *list;
-	*list = node->pNext;
-	node->pNext = NULL;
+	node = &report_list[kbd_trm_head];
+	kbd_trm_head = (kbd_trm_head + 1) % MAX_REPORTS;
+	kbd_trm_cnt--;
+	
+	// the last pending report of a type is the newest one. if it is pulled there are no others
+	if (node == kbd_last_normal)
+		kbd_last_normal = NULL;
+	else if (node == kbd_last_extended)
+		kbd_last_extended = NULL;
 	
 	return node;
 }
@@ -220,55 +247,203 @@ kbd_rep_info *kbd_pull_from_list(kbd_rep_info **list)
 
 /**
  ****************************************************************************************
- * @brief Pushes one member at the end of the list
+ * @brief Allocates a new report at the end of the ring
  *
- * @param[in]   list    The list to use
- * @param[in]   node    Member to add to the list
+ * @param[in]   char_id     The report type (NORMAL_REPORT, EXTENDED_REPORT)
  *
- * @return   APP_KBD_ERR_OK if the member is successfully pushed or else APP_KBD_ERR_ERROR
+ * @return  the new report, if the ring is not full, else NULL
  ****************************************************************************************
  */
-int kbd_push_to_list(kbd_rep_info **list, kbd_rep_info *node)
+static kbd_rep_info *kbd_alloc_report(enum REPORT_TYPE char_id)
 {
-	kbd_rep_info *p;
+	kbd_rep_info *node;
+	
+	if (kbd_trm_cnt == MAX_REPORTS)
+		return NULL;
 	
-	if (!node)
-		return APP_KBD_ERR_ERROR;
+	node = &report_list[(kbd_trm_head + kbd_trm_cnt) % MAX_REPORTS];
+	kbd_trm_cnt++;
 	
-	if (!(*list))
-		*list = node;
-	else 
-    {
-		for (p = *list; p->pNext != NULL; p = p->pNext);
+	node->char_id = char_id;
+	if (char_id == NORMAL_REPORT)
+		kbd_last_normal = node;
+	else
+		kbd_last_extended = node;
+	
+	return node;
+}
+
+
+/**
+ ****************************************************************************************
+ * @brief Checks if a key is in the key array of a normal report
+ *
+ * @param[in]   buf     The report
+ * @param[in]   key     The key code
+ *
+ * @return  true, if found, else false
+ ****************************************************************************************
+ */
+static bool kbd_report_has_key(const uint8_t *buf, uint8_t key)
+{
+	for (int i = 2; i < 8; i++)
+		if (buf[i] == key)
+			return true;
+	
+	return false;
+}
+
+
+/**
+ ****************************************************************************************
+ * @brief Checks if the sequence prev -> tail -> now can be reported as prev -> now 
+ *        without hiding a key change from the Host: the modifiers do not change (normal 
+ *        reports), no key changes in both steps and the two steps do not both contain 
+ *        key presses (so the order of the presses is kept).
+ *
+ * @param[in]   char_id     The report type
+ * @param[in]   prev        The report before tail (pending or last sent)
+ * @param[in]   tail        The report to drop
+ * @param[in]   now         The report that follows tail
+ *
+ * @return  true, if the reports can be merged, else false
+ ****************************************************************************************
+ */
+static bool kbd_can_merge_reports(enum REPORT_TYPE char_id, const uint8_t *prev, const uint8_t *tail, const uint8_t *now)
+{
+	bool press1 = false, press2 = false;
+	
+	if (char_id == NORMAL_REPORT)
+	{
+		const uint8_t *list[3] = { prev, tail, now };
 		
-		p->pNext = node;
-		node->pNext = NULL;
+		if ( (prev[0] != tail[0]) || (tail[0] != now[0]) )
+			return false;
+		
+		for (int n = 0; n < 3; n++)
+		{
+			for (int i = 2; i < 8; i++)
+			{
+				const uint8_t key = list[n][i];
+				bool in_prev, in_tail, in_now;
+				
+				if (key == 0)
+					continue;
+				
+				in_prev = kbd_report_has_key(prev, key);
+				in_tail = kbd_report_has_key(tail, key);
+				in_now = kbd_report_has_key(now, key);
+				
+				if ( (in_prev != in_tail) && (in_tail != in_now) )
+					return false;
+				
+				press1 |= (in_tail && !in_prev);
+				press2 |= (in_now && !in_tail);
+			}
+		}
+	}
+	else
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			if ( (prev[i] ^ tail[i]) & (tail[i] ^ now[i]) )
+				return false;
+			
+			press1 |= (tail[i] & ~prev[i]) != 0;
+			press2 |= (now[i] & ~tail[i]) != 0;
+		}
 	}
 	
-	return APP_KBD_ERR_OK;
+	return !(press1 && press2);
 }
 
 
 /**
  ****************************************************************************************
- * @brief Finds the last instance of a specific type in a list
+ * @brief Merges the newest pending report into the one before it, if both are of the 
+ *        same type and no intermediate state is lost (see kbd_can_merge_reports()).
+ *        Reports in the ring have not been handed to HOGPD yet so they can be modified.
  *
- * @param[in]   list    The list to use
- * @param[in]   type    The type of the instance to search for (FREE, PRESS, RELEASE, EXTENDED)
+ * @param None
  *
- * @return  the last instance of a specific type in a list, if found, else NULL
+ * @return  true, if a report was freed, else false
  ****************************************************************************************
  */
-kbd_rep_info *kbd_search_in_list(kbd_rep_info *list, enum KEY_BUFF_TYPE type)
+static bool kbd_coalesce_reports(void)
 {
-	kbd_rep_info *node;
-	kbd_rep_info *last_found = NULL;
+	static const uint8_t no_report[8] = { 0 };
+	kbd_rep_info *now, *tail;
+	const uint8_t *prev = NULL;
+	int i;
+	
+	if (kbd_trm_cnt < 2)
+		return false;
 	
-	for (node = list; node != NULL; node = node->pNext)
-		if (node->type == type)
-			last_found = node;
+	now = &report_list[(kbd_trm_head + kbd_trm_cnt - 1) % MAX_REPORTS];
+	tail = &report_list[(kbd_trm_head + kbd_trm_cnt - 2) % MAX_REPORTS];
 	
-	return last_found;
+	if (now->char_id != tail->char_id)
+		return false;
+	
+	// find the state before tail: the previous pending report of this type or the last one sent
+	for (i = kbd_trm_cnt - 3; i >= 0; i--)
+	{
+		kbd_rep_info *node = &report_list[(kbd_trm_head + i) % MAX_REPORTS];
+		
+		if (node->char_id == now->char_id)
+		{
+			prev = node->pBuf;
+			break;
+		}
+	}
+	
+	if (prev == NULL)
+	{
+		if (now->char_id == EXTENDED_REPORT)
+			prev = extended_key_report_st;
+		else if (normal_key_report_st[0] != 0xFF)
+			prev = normal_key_report_st;
+		else
+			prev = no_report;
+	}
+	
+	if (!kbd_can_merge_reports(now->char_id, prev, tail->pBuf, now->pBuf))
+		return false;
+	
+	memcpy(tail->pBuf, now->pBuf, now->len);
+	if (now->type == PRESS)
+		tail->type = PRESS;
+	
+	now->type = FREE;
+	kbd_trm_cnt--;
+	if (now == kbd_last_normal)
+		kbd_last_normal = tail;
+	else if (now == kbd_last_extended)
+		kbd_last_extended = tail;
+	
+	if (HAS_SCAN_STATS)
+		kbd_scan_stats.reports_coalesced++;
+	
+	return true;
+}
+
+
+/**
+ ****************************************************************************************
+ * @brief Checks if a report can be allocated, merging the last two pending reports if
+ *        the ring is full
+ *
+ * @param None
+ *
+ * @return  true, if there is space in the ring, else false
+ ****************************************************************************************
+ */
+static bool kbd_report_available(void)
+{
+	if (kbd_trm_cnt == MAX_REPORTS)
+		kbd_coalesce_reports();
+	
+	return (kbd_trm_cnt < MAX_REPORTS);
 }
 
 
@@ -292,6 +467,8 @@ kbd_rep_info *kbd_search_in_list(kbd_rep_info *list, enum KEY_BUFF_TYPE type)
 static inline void systick_start(const int ticks, const int mode /* = 0*/)
 {
     systick_hit = false;
+    systick_wraps = 0;
+    systick_counted = 0;
 	SetWord32(0xE000E010, 0x00000000);      // disable systick
 	SetWord32(0xE000E014, ticks);           // set systick timeout based on 16MHz clock
 	SetWord32(0xE000E018, ticks);           // set systick timeout based on 16MHz clock
@@ -322,6 +499,38 @@ static inline void systick_stop(void)
 }
 
 
+/**
+ ****************************************************************************************
+ * @brief Adds the SysTick ticks counted since the last call (or since SysTick was
+ *        started) to scan_elapsed_ticks and to the dwell time of the current scan mode.
+ *        Called before SysTick is restarted or stopped while scanning.
+ *
+ * @param None
+ *
+ * @return  void
+ ****************************************************************************************
+ */
+static inline void scan_time_update(void)
+{
+    const uint32_t load = GetWord32(0xE000E014);
+    const uint32_t val = GetWord32(0xE000E018);
+    const uint32_t ticks = systick_wraps * load + (val ? (load - val) : 0);   // VAL is 0 until the first reload
+    const uint32_t delta = ticks - systick_counted;
+    
+    systick_counted = ticks;
+    scan_elapsed_ticks += delta;
+    
+    if (HAS_SCAN_STATS)
+    {
+        static uint32_t dwell_ticks[SCAN_MODE_NUM];
+        const uint32_t ms = (dwell_ticks[kbd_scan_mode] + delta) / (1000 * SYSTICK_TICKS_PER_US);
+        
+        dwell_ticks[kbd_scan_mode] += delta - ms * (1000 * SYSTICK_TICKS_PER_US);
+        kbd_scan_stats.mode_dwell_ms[kbd_scan_mode] += ms;
+    }
+}
+
+
 
 /*
  * GPIO handling 
@@ -438,14 +647,13 @@ static void kbd_init_scan_vars(void)
 	kbd_fn_modifier = 0;
     kbd_cntrl_active = false;
     
-	for (i = 0; i < DEBOUNCE_BUFFER_SIZE ; ++i)
-	{
-		kbd_bounce_intersections[i] = 0xFFFF;
-		kbd_bounce_counters[i].cnt = 0;
-        kbd_bounce_counters[i].state = IDLE;
-	}
+    memset(kbd_bounce_cnt, 0, sizeof(kbd_bounce_cnt));
+    kbd_keys_held = 0;
     kbd_global_deb_cnt = 0;
 	kbd_bounce_active = 0;
+    kbd_scan_mode = SCAN_MODE_NORMAL;
+    kbd_scan_next_mode = SCAN_MODE_FAST;
+    scan_elapsed_ticks = 0;
 	
 #ifdef ASCII_DEBUG
 	kbd_keybuffer_idx = 0;
@@ -458,6 +666,22 @@ static void kbd_init_scan_vars(void)
 		kbd_scandata[i] = val;
         kbd_active_row[i] = false;
         kbd_bounce_rows[i] = 0;
+        kbd_bounce_press[i] = 0;
+        kbd_bounce_release[i] = 0;
+    }
+    
+    // derive the existing keys from the keymap, so the deghosting mask cannot
+    // go out of sync with kbd_keymap[0]
+	for (i = 0; i < KBD_NR_OUTPUTS; ++i) 
+    {
+        int j;
+        
+        kbd_key_exist[i] = 0;
+        for (j = 0; j < KBD_NR_INPUTS; ++j)
+        {
+            if (kbd_keymap[0][i][j] != 0)
+                kbd_key_exist[i] |= 1UL << j;
+        }
     }
     
     kbd_new_key_detected = false;
@@ -608,24 +832,28 @@ bool app_kbd_scan_matrix(int *row)
     // no need to have a separate state for this! idle time follows the completion of the processing!
     if (i == KBD_NR_OUTPUTS) 
     {
-        // a. process scan results
-        kbd_process_scandata();
-
+        uint32_t stats_start = 0;
         
-        // b. Update debouncing counters
-        kbd_bounce_active = 0;
-        for (j = DEBOUNCE_BUFFER_SIZE-1; j >= 0 ; j--) 
+        if (HAS_SCAN_STATS)
+            stats_start = GetWord32(0xE000E018);                        // SysTick current value (counts down)
+        
+        // a. Update debouncing counters with the time measured by SysTick since the last 
+        //    processing, which is shorter than the scan period if the cycle was cut short 
+        //    (counters are in msec or in scan cycles)
+        scan_time_update();
+        if (HAS_ADAPTIVE_SCAN_TIMES)
         {
-            if (0xFFFF != kbd_bounce_intersections[j]) 
-            {
-                kbd_bounce_active = 1;
-                
-                if (kbd_bounce_counters[j].cnt) 
-                {
-                    --kbd_bounce_counters[j].cnt;
-                }
-            }
+            const uint32_t elapsed_ms = scan_elapsed_ticks / (1000 * SYSTICK_TICKS_PER_US);
+            
+            scan_elapsed_ticks -= elapsed_ms * (1000 * SYSTICK_TICKS_PER_US);
+            kbd_update_bounce_counters((elapsed_ms > 0xFF) ? 0xFF : elapsed_ms);
         }
+        else
+            kbd_update_bounce_counters(1);
+        
+        // b. process scan results and choose the scan mode of the next cycle
+        kbd_process_scandata();
+        kbd_update_scan_mode();
         
         // update the global debouncing counter as well
         if (kbd_global_deb_cnt)         // FIXME: to check!
@@ -634,6 +862,23 @@ bool app_kbd_scan_matrix(int *row)
             kbd_bounce_active++;        // 1 if no keys are being debounced/pressed, 2 if there are other keys being debounced/pressed
         }
         
+        if (HAS_SCAN_STATS)
+        {
+            const uint32_t stats_end = GetWord32(0xE000E018);
+            uint32_t elapsed;
+            
+            if (stats_end <= stats_start)
+                elapsed = stats_start - stats_end;
+            else                        // SysTick has been reloaded in the meantime
+                elapsed = stats_start + GetWord32(0xE000E014) + 1 - stats_end;
+            
+            kbd_scan_stats.scans++;
+            kbd_scan_stats.mode_scans[kbd_scan_mode]++;
+            kbd_scan_stats.last_us = elapsed / SYSTICK_TICKS_PER_US;
+            if (kbd_scan_stats.last_us > kbd_scan_stats.max_us)
+                kbd_scan_stats.max_us = kbd_scan_stats.last_us;
+        }
+        
         
         // c. check if there are key events in the buffer
         if (kbd_reports_en == REPORTS_DISABLED) // passcode mode
@@ -674,6 +919,7 @@ bool app_kbd_scan_matrix(int *row)
             scan_cycle_time = 20;
         
         scan_cycle_time += GetWord32(0xE000E018);
+        scan_time_update();
         systick_stop();
         systick_start(scan_cycle_time, 2);
     }
@@ -697,9 +943,8 @@ bool app_kbd_scan_matrix(int *row)
  */
 static inline int debounce_key(const uint16 output, const uint16 input, const int pressed)
 {
-    const uint16 my_intersection = (output << 8) | input;
+    uint8_t * const cnt = &kbd_bounce_cnt[output][input];
     const scan_t imask = 1 << input;
-    int i;
     
     // to check whether a key is valid or not we always check the default keymap (#0).
     // the assumption is that a key will definitely appear in the default  
@@ -713,118 +958,85 @@ static inline int debounce_key(const uint16 output, const uint16 input, const in
 
     // *** DEBOUNCE ***
     
-    // check if there's an entry for this intersection in the array. an entry is
-    // reserved when a key is pressed. if an entry is reserved, 
-    // then the entry remains reserved until the key is released!
-    for (i = 0; i < DEBOUNCE_BUFFER_SIZE ; ++i)
-        if (my_intersection == kbd_bounce_intersections[i])
-            break;
-           
-    // the debouncing counter is 2-field structure. the field is the state. 
-    // the second field is the debouncing counter that counts down when doing
-    // press and release debouncing
-    if (i != DEBOUNCE_BUFFER_SIZE)          // entry found!
+    // the state of each key is kept in the per row masks: IDLE keys are not in
+    // kbd_bounce_rows[], PRESS_DEBOUNCING and RELEASE_DEBOUNCING keys are in 
+    // kbd_bounce_press[] and kbd_bounce_release[] and the rest are in WAIT_RELEASE.
+    // every key has its own debouncing counter that counts down when doing
+    // press and release debouncing, so any number of keys can be debounced at once.
+    if (kbd_bounce_press[output] & imask)           // PRESS_DEBOUNCING
     {
-        struct debounce_counter_t *deb = &kbd_bounce_counters[i];
-        
-        switch(deb->state)
+        if (*cnt == 0)                  // debouncing done! check key status...
         {
-            case IDLE:
-                ASSERT_ERROR(0);            // cannot be in here!
-                break;
-            case PRESS_DEBOUNCING:
-                if (deb->cnt == 0)          // debouncing done! check key status...
-                {
-                    if (pressed)            // go to WAIT_RELEASE and continue with deghosting
-                        deb->state = WAIT_RELEASE;
-                    else 
-                    {
-                        deb->state = IDLE;  // key is ignored since after debouncing is inactive
-                        kbd_bounce_intersections[i] = 0xFFFF;
-                        kbd_bounce_rows[output] &= ~imask;
-                        return 0;
-                    }
-                } 
-                else 
-                {
-                    kbd_new_scandata[output] |= imask;  // this bit is still toggling! reset it to the previous stable state so that
-                                            // it doesn't affect deghosting of other valid keys below
-                                            
-                    return 0;               // still debouncing...
-                }
-                break;
-            case WAIT_RELEASE:
-                if (!pressed) 
-                {
-                    deb->state = RELEASE_DEBOUNCING;
-                    deb->cnt = DEBOUNCE_COUNTER_RELEASE;
-                    kbd_new_scandata[output] &= ~imask;  // this bit is still toggling! reset it to the previous stable state so that
-                                            // is doesn't affect deghosting of other valid keys below
-                                            
-                    return 0;               // do debouncing...
-                } 
-                else 
-                {                           // check if this key press has been reported (could be a ghost key)
-                    if ( !(kbd_scandata[output] & imask) )
-                        return 0;           // skip key press as it has already been reported!
-                    // else, do deghosting so as to report the key press if need be
-                }
-                break;
-            case RELEASE_DEBOUNCING:
-                if (deb->cnt == 0)          // debouncing done! check key status...
-                {
-                    if (pressed)            // still pressed? fake release! return to WAIT_RELEASE
-                    {
-                        deb->state = WAIT_RELEASE;
-                        return 0;
-                    } 
-                    else 
-                    {
-                        deb->state = IDLE;  // return to IDLE and continue to register the key release in the buffer if need be
-                        kbd_bounce_intersections[i] = 0xFFFF;
-                        kbd_bounce_rows[output] &= ~imask;
-                        if (kbd_scandata[output] & imask)   // check if the key press had been reported
-                            return 0;       // it hadn't so skip the release report!
-                    }
-                } 
-                else 
-                {
-                    kbd_new_scandata[output] &= ~imask;  // this bit is still toggling! reset it to the previous stable state so that
-                                            // is doesn't affect deghosting of other valid keys below
-                                            
-                    return 0;               // still debouncing...
-                }
-                break;
-            default:
-                break;
+            kbd_bounce_press[output] &= ~imask;
+            if (pressed)                // go to WAIT_RELEASE and continue with deghosting
+            {
+                if (HAS_SCAN_STATS)
+                    kbd_scan_stats.keystrokes++;
+            }
+            else 
+            {
+                kbd_bounce_rows[output] &= ~imask;  // key is ignored since after debouncing is inactive
+                return 0;
+            }
+        } 
+        else 
+        {
+            kbd_new_scandata[output] |= imask;  // this bit is still toggling! reset it to the previous stable state so that
+                                    // it doesn't affect deghosting of other valid keys below
+                                    
+            return 0;               // still debouncing...
+        }
+    }
+    else if (kbd_bounce_release[output] & imask)    // RELEASE_DEBOUNCING
+    {
+        if (*cnt == 0)                  // debouncing done! check key status...
+        {
+            kbd_bounce_release[output] &= ~imask;
+            if (pressed)                // still pressed? fake release! return to WAIT_RELEASE
+                return 0;
+            
+            kbd_bounce_rows[output] &= ~imask;      // return to IDLE and continue to register the key release in the buffer if need be
+            if (kbd_scandata[output] & imask)       // check if the key press had been reported
+                return 0;               // it hadn't so skip the release report!
+        } 
+        else 
+        {
+            kbd_new_scandata[output] &= ~imask;  // this bit is still toggling! reset it to the previous stable state so that
+                                    // is doesn't affect deghosting of other valid keys below
+                                    
+            return 0;               // still debouncing...
         }
     }
-    else                                    // find an empty place
+    else if (kbd_bounce_rows[output] & imask)       // WAIT_RELEASE
+    {
+        if (!pressed) 
+        {
+            kbd_bounce_release[output] |= imask;
+            *cnt = DEBOUNCE_COUNTER_RELEASE;
+            kbd_new_scandata[output] &= ~imask;  // this bit is still toggling! reset it to the previous stable state so that
+                                    // is doesn't affect deghosting of other valid keys below
+                                    
+            return 0;               // do debouncing...
+        } 
+        else 
+        {                           // check if this key press has been reported (could be a ghost key)
+            if ( !(kbd_scandata[output] & imask) )
+                return 0;           // skip key press as it has already been reported!
+            // else, do deghosting so as to report the key press if need be
+        }
+    }
+    else                                            // IDLE
     {
         if (!pressed)
-            return 0;                       // if it's a release then there should be a valid entry for this key in the array!
-                                            // if there isn't then this happened because the array was full and the key is ignored
-
-        for (i = 0; i < DEBOUNCE_BUFFER_SIZE ; ++i)
-            if (kbd_bounce_intersections[i] == 0xFFFF) 
-            {
-                if (kbd_bounce_counters[i].state != IDLE)
-                    ASSERT_ERROR(0);        // this should not happen!
-                
-                break;
-            }
-
-        if (i == DEBOUNCE_BUFFER_SIZE)      // no space available!
-            return 0;
+            return 0;               // a release of a key that is not pressed (i.e. a ghost that was never reported)
 
-        kbd_bounce_intersections[i] = my_intersection;
         kbd_bounce_rows[output] |= imask;
-        kbd_bounce_counters[i].cnt = DEBOUNCE_COUNTER_PRESS;
-        kbd_bounce_counters[i].state = PRESS_DEBOUNCING;
+        kbd_bounce_press[output] |= imask;
+        *cnt = DEBOUNCE_COUNTER_PRESS;
         kbd_new_scandata[output] |= imask;  // this bit is still toggling! reset it to the previous stable state so that
-                                            // is doesn't affect deghosting of other valid keys below
+                                    // is doesn't affect deghosting of other valid keys below
         
-        return 0;                           // debouncing is started! the key will be put into the key buffer when it's finished!
+        return 0;                   // debouncing is started! the key will be put into the key buffer when it's finished!
     }
 
     // No bounce, continue to check for ghosting
@@ -832,6 +1044,70 @@ static inline int debounce_key(const uint16 output, const uint16 input, const in
 }
 
 
+/**
+ ****************************************************************************************
+ * @brief Counts down the debouncing counters of the keys in PRESS_DEBOUNCING or 
+ *        RELEASE_DEBOUNCING state. Called before the scan results are processed, with
+ *        the time that has passed since the last processing.
+ *
+ * @param[in] step  time passed since the last update (msec or scan cycles)
+ *
+ * @return void
+ ****************************************************************************************
+ */
+static inline void kbd_update_bounce_counters(const uint8_t step)
+{
+    int i;
+    
+    for (i = 0; i < KBD_NR_OUTPUTS; ++i)
+    {
+        scan_t counting = kbd_bounce_press[i] | kbd_bounce_release[i];
+        
+        while (counting)
+        {
+            const int bit = 31 - __clz((uint32_t)counting);
+            uint8_t * const cnt = &kbd_bounce_cnt[i][bit];
+            
+            counting &= ~(1UL << bit);
+            if (*cnt) 
+            {
+                *cnt = (*cnt > step) ? (*cnt - step) : 0;
+            }
+        }
+    }
+}
+
+
+/**
+ ****************************************************************************************
+ * @brief Chooses the scan mode of the next cycle from the debouncing status (used only
+ *        if HAS_ADAPTIVE_SCAN_TIMES) and sets kbd_bounce_active if any key is not IDLE.
+ *
+ * @param None
+ *
+ * @return void
+ ****************************************************************************************
+ */
+static inline void kbd_update_scan_mode(void)
+{
+    int i;
+    
+    kbd_bounce_active = 0;
+    kbd_scan_next_mode = SCAN_MODE_HOLD;
+    
+    for (i = 0; i < KBD_NR_OUTPUTS; ++i)
+    {
+        if (kbd_bounce_rows[i])
+            kbd_bounce_active = 1;
+        
+        if (kbd_bounce_press[i])
+            kbd_scan_next_mode = SCAN_MODE_FAST;
+        else if (kbd_bounce_release[i] && (kbd_scan_next_mode != SCAN_MODE_FAST))
+            kbd_scan_next_mode = SCAN_MODE_NORMAL;
+    }
+}
+
+
 /**
  ****************************************************************************************
  * @brief Does deghosting for the given key. If everything is in order, adds the
@@ -889,91 +1165,67 @@ static inline int record_key(const uint16 output, const uint16 input, const int
         // this situation). Else, it should be reported normally.
         //
 
-        int i, o;
-        scan_t scandata;
-        scan_t mask = 1;
-
-        // also, skip this key if:
-        // a. a "square of active keys" in formed in the newly scanned matrix that 
-        //    includes this key
-        // b. the corresponding "square" in the last reported status contains only 1 
-        //    active key. this means that there's another new key in the row we're 
-        //    examining that creates this "ghost" status (implicit 'B' and 'C' cases)
-        scandata = kbd_new_scandata[output] & ~imask;
-        if (scandata != ~imask)              // other columns are being driven in the row under examination
-        {
-            for (i = 0; i < KBD_NR_INPUTS; ++i, mask <<= 1)
-            {
-                if (input == i)
-                    continue;               // skip this column (it's the input under investigation)
+        // The "other three corners exist" test only depends on kbd_keymap[0], so
+        // it is derived per row in kbd_key_exist[] by kbd_init_scan_vars(). For each other row o the
+        // candidate columns i are the ones where both (output, i) and (o, i) exist,
+        // and both checks below become a few ANDs per row instead of a loop over
+        // every column with three kbd_keymap[] probes each.
+        const scan_t full = (scan_t)((1UL << KBD_NR_INPUTS) - 1);
+        const scan_t out_new = ~kbd_new_scandata[output] & full & ~imask;  // other keys of this row in the new scan
+        const scan_t out_old = ~kbd_scandata[output] & full;               // keys of this row in the last report
+        const uint32_t out_exist = kbd_key_exist[output] & ~imask;
+        scan_t act, corners;
+        int o;
 
-                if ( !(scandata & mask) )   // column (input) found
-                {
-                    // check if any other newly scanned row reports a key pressed in any of the two columns { input - i }
-                    // if so, then a "square" is formed. 
-                    for (o = 0; o < KBD_NR_OUTPUTS; ++o)
-                    {
-                        if (output == o)
-                            continue;       // skip this row (it's the output under investigation)
-
-                        scan_t combined_mask = (mask | imask);
-                        scan_t new_scandata = ((~kbd_new_scandata[o]) & ((1 << KBD_NR_INPUTS) - 1));
-                        if ( (new_scandata & combined_mask) != 0) { // if any is used => "square" of { (output, input) - (o, i) }
-                            // the other "corner" is not detected because the scanning of the rows 
-                            // is done in series (one after the other). thus, one row may be scanned 
-                            // just before the key is released and the other just after. they are 
-                            // scanned during the same scan cycle but the first row does not
-                            // indicate the current status of the matrix but the previous one!
-                            int cnt = 0;
-                            
-                            if (kbd_keymap[0][output][i]) cnt++;
-                            if (kbd_keymap[0][o][input]) cnt++;
-                            if (kbd_keymap[0][o][i]) cnt++;
-                            
-                            if (cnt == 3)
-                                return 0;
-                        }
-                    }
-                }
-            }
-        }
-
-        // scan all rows once more just in case an input is "missed" in the row under examination
         for (o = 0; o < KBD_NR_OUTPUTS; ++o)
         {
-            if (output == o)
-                continue;                   // skip this row (it's the row under investigation)
-
-            scandata = kbd_new_scandata[o];
-            if ( !(scandata & imask) )      // this row has the same column (input) driven 
+            if ((o == output) || !(kbd_key_exist[o] & imask))
+                continue;                   // skip this row, or (o, input) is not a key => no square
+
+            act = ~kbd_new_scandata[o] & full;
+            if (!act)
+                continue;                   // nothing pressed in this row
+
+            corners = out_exist & kbd_key_exist[o];
+
+            // a. a "square of active keys" is formed in the newly scanned matrix 
+            //    that includes this key: another key (output, i) is pressed and row o
+            //    reports a key in either of the two columns { input - i }.
+            //    the other "corner" may not be detected because the rows are scanned
+            //    in series, so one row may show the status before a release and 
+            //    the other the status after it
+            if (corners & out_new & ((act & imask) ? full : act))
             {
-                // check if any other column has a key pressed in any of the two rows { output - o } (or both)
-                // if this is the case then a "square" is formed.
-                mask = 1;
-                for (i = 0; i < KBD_NR_INPUTS; ++i, mask <<= 1)
-                {
-                    if (input == i)
-                        continue;           // skip this column (it's the input under investigation)
-
-                    scan_t d1 = kbd_scandata[output] & mask;
-                    scan_t d2 = scandata & mask;
+                if (HAS_SCAN_STATS)
+                    kbd_scan_stats.ghosts++;
+                return 0;
+            }
 
-                    if ( !d1 || !d2 )       // at least one row uses an extra column. a "square" is formed
-                    {
-                        int cnt = 0;
-                        
-                        if (kbd_keymap[0][output][i]) cnt++;
-                        if (kbd_keymap[0][o][input]) cnt++;
-                        if (kbd_keymap[0][o][i]) cnt++;
-                        
-                        if (cnt == 3)
-                            return 0;
-                    }
-                }
+            // b. row o has the same column (input) driven and another column is
+            //    active in either of the two rows { output - o } (in case an input
+            //    is "missed" in the row under examination, the last reported 
+            //    status of this row is used). covers the implicit 'B' and 'C' cases
+            if ((act & imask) && (corners & (out_old | act)))
+            {
+                if (HAS_SCAN_STATS)
+                    kbd_scan_stats.ghosts++;
+                return 0;
             }
         }
     }
 
+    // backpressure: reports are not sent as fast as keys are recorded (i.e. long connection 
+    // interval) and the keycode buffer is filling up. new presses are not recorded; the key status
+    // is kept so they are retried on the next scan. a press is recorded only if the releases of all
+    // the recorded keys (kbd_keys_held) and of this one still fit, so the buffer does not overflow
+    // (which would flush all pending keys).
+    if (pressed && ((KEYCODE_BUFFER_SIZE - 1 - keycode_buffer_written_sz()) <= (kbd_keys_held + 1)))
+    {
+        if (HAS_SCAN_STATS)
+            kbd_scan_stats.presses_deferred++;
+        return 0;
+    }
+    
     // if no ghosting, then continue to buffer.
     bool block_key = false;
     
@@ -1084,7 +1336,7 @@ static inline void kbd_process_scandata(void)
             
             new_scan_status[i] = kbd_new_scandata[i];
             
-            // look into kbd_bounce_intersections[] for any keys that are being debounced 
+            // look into kbd_bounce_rows[] for any keys that are being debounced 
             // that might not be reported in the xorword
             xorword |= kbd_bounce_rows[i];
             
@@ -1150,6 +1402,10 @@ static inline void kbd_process_scandata(void)
                         // This keypress is ignored, copy the bit from kbd_scandata[i] to newscanword => always keep last key status!
                         new_scan_status[i] = (new_scan_status[i] & (~mask)) | (kbd_scandata[i] & mask);
                     }
+                    else if (press)
+                        kbd_keys_held++;
+                    else
+                        kbd_keys_held--;
                     xorword &= ~mask;
                     
                 } while (xorword);
@@ -1177,17 +1433,29 @@ static inline void kbd_process_scandata(void)
 static void update_scan_times(void)
 {
     // Re-init scan period time
-    if (HAS_ALTERNATIVE_SCAN_TIMES)
+    if (HAS_ADAPTIVE_SCAN_TIMES)
+    {
+        // scan fast after a new key press (the other keys of a chord follow within a few msec),
+        // slow down while only held keys are stable. when no key is pressed scanning stops
+        // and the Keyboard Controller IRQ takes over (see app_kbd_update_status())
+        static const uint8_t scan_mode_ms[SCAN_MODE_NUM] = { FAST_SCAN_IN_MS, PARTIAL_SCAN_IN_MS, HOLD_SCAN_IN_MS };
+        
+        kbd_scan_mode = full_scan ? SCAN_MODE_FAST : kbd_scan_next_mode;
+        scan_cycle_ms = scan_mode_ms[kbd_scan_mode];
+    }
+    else if (HAS_ALTERNATIVE_SCAN_TIMES)
     {
         if (full_scan)
-            scan_cycle_time = (FULL_SCAN_TIME * SYSTICK_TICKS_PER_US) - (ROW_SCAN_TIME * SYSTICK_TICKS_PER_US);
+            scan_cycle_ms = FULL_SCAN_IN_MS;
         else
-            scan_cycle_time = (PARTIAL_SCAN_TIME * SYSTICK_TICKS_PER_US) - (ROW_SCAN_TIME * SYSTICK_TICKS_PER_US);                
+            scan_cycle_ms = PARTIAL_SCAN_IN_MS;
     }
     else
     {
-        scan_cycle_time = (FULL_SCAN_TIME * SYSTICK_TICKS_PER_US) - (ROW_SCAN_TIME * SYSTICK_TICKS_PER_US);
+        scan_cycle_ms = FULL_SCAN_IN_MS;
     }
+    
+    scan_cycle_time = (scan_cycle_ms * 1000 * SYSTICK_TICKS_PER_US) - (ROW_SCAN_TIME * SYSTICK_TICKS_PER_US);
 
     scan_cycle_time_last = scan_cycle_time;
     
@@ -1212,6 +1480,7 @@ bool app_kbd_update_status(void)
     bool ret;
     
     // Stop SysTick
+    scan_time_update();
     systick_stop();
 
     GLOBAL_INT_DISABLE();
@@ -1237,7 +1506,7 @@ bool app_kbd_update_status(void)
             if (kbd_global_deb_cnt == 0)
             {
                 kbd_bounce_active = 1;
-                kbd_global_deb_cnt = DEBOUNCE_COUNTER_PRESS + 1;    // FIXME: to test!
+                kbd_global_deb_cnt = DEBOUNCE_COUNTER_GLOBAL;       // FIXME: to test!
             }
             else if (kbd_global_deb_cnt == 1)
             {
@@ -1353,12 +1622,10 @@ void app_kbd_flush_reports(void)
 {
     kbd_rep_info *pReportInfo;
       
-    // Clear trm list
-    while (kbd_trm_list)
+    // Clear trm ring
+    while ((pReportInfo = kbd_pull_report()) != NULL)
     {
-        pReportInfo = kbd_pull_from_list(&kbd_trm_list);
         pReportInfo->type = FREE;
-        kbd_push_to_list(&kbd_free_list, pReportInfo);
     }
     
     // Clear (or invalidate) the content of the last reports sent to the old host
@@ -1408,21 +1675,13 @@ __forceinline static int keycode_buffer_written_sz(void)
  */
 kbd_rep_info* get_last_report(enum REPORT_TYPE char_id)
 {
-    kbd_rep_info *p_report, *p_tmp;
-    
-    p_report = NULL;
-    p_tmp = kbd_trm_list;
-    
-    // Get the last pending key report of this type, if any
-    while (p_tmp)
-    {
-        if (p_tmp->char_id == char_id) 
-            p_report = p_tmp;
-            
-        p_tmp = p_tmp->pNext;
-    }
+    // the last pending key report of each type is tracked by the ring functions
+    if (char_id == NORMAL_REPORT)
+        return kbd_last_normal;
+    else if (char_id == EXTENDED_REPORT)
+        return kbd_last_extended;
     
-    return p_report;
+    return NULL;
 }
 
 
@@ -1441,14 +1700,17 @@ kbd_rep_info* prepare_normal_report(kbd_rep_info *last, enum KEY_BUFF_TYPE type,
 {
     kbd_rep_info *p_report;
 
+    // merge the last two pending reports if possible. last may have been merged into the one before it
+    if (kbd_coalesce_reports() && last)
+        last = get_last_report(NORMAL_REPORT);
+    
     // add one <type> report
-    p_report = kbd_pull_from_list(&kbd_free_list);
+    p_report = kbd_alloc_report(NORMAL_REPORT);
     ASSERT_WARNING(p_report);
     if (p_report)
     {
         p_report->type = type;
         p_report->modifier_report = modifier;
-        p_report->char_id = NORMAL_REPORT;
         p_report->len = 8;
         
         if (last == NULL)   // first entry - copy last one sent
@@ -1464,8 +1726,6 @@ kbd_rep_info* prepare_normal_report(kbd_rep_info *last, enum KEY_BUFF_TYPE type,
         } 
         else /*if (_pReportInfo)*/ // last report pending 
             memcpy(p_report->pBuf, last->pBuf, 8);
-
-        kbd_push_to_list(&kbd_trm_list, p_report);
     }
     
     return p_report;
@@ -1485,22 +1745,23 @@ kbd_rep_info* prepare_extended_report(kbd_rep_info *last)
 {
     kbd_rep_info *p_report;
 
+    // merge the last two pending reports if possible. last may have been merged into the one before it
+    if (kbd_coalesce_reports() && last)
+        last = get_last_report(EXTENDED_REPORT);
+    
     // add one <type> report
-    p_report = kbd_pull_from_list(&kbd_free_list);
+    p_report = kbd_alloc_report(EXTENDED_REPORT);
     ASSERT_WARNING(p_report);
     if (p_report)
     {
         p_report->type = EXTENDED;
         p_report->modifier_report = false;
-        p_report->char_id = EXTENDED_REPORT;
         p_report->len = 3;
         
         if (last == NULL)   // first entry - copy last one sent
             memcpy(p_report->pBuf, extended_key_report_st, 3);
         else /*if (_pReportInfo)*/ // last report pending 
             memcpy(p_report->pBuf, last->pBuf, 3);
-
-        kbd_push_to_list(&kbd_trm_list, p_report);
     }
     
     return p_report;
@@ -2028,7 +2289,7 @@ static int prepare_kbd_keyreport(void)
 {
     int ret;
     
-    if (kbd_free_list == NULL)
+    if (!kbd_report_available())
         return 0;
 
     if (kbd_keycode_buffer_head == kbd_keycode_buffer_tail) 
@@ -2044,7 +2305,7 @@ static int prepare_kbd_keyreport(void)
         if (ret)
             kbd_keycode_buffer_head = (kbd_keycode_buffer_head + 1) % KEYCODE_BUFFER_SIZE;
     } 
-    while ( ret && kbd_free_list && (keycode_buffer_written_sz() > 0) );
+    while ( ret && kbd_report_available() && (keycode_buffer_written_sz() > 0) );
 
     return 1;
 }
@@ -2077,7 +2338,7 @@ static int send_boot_report(void)
             if (!req)
                 break;
 
-            p = kbd_pull_from_list(&kbd_trm_list);
+            p = kbd_pull_report();
             
             ASSERT_WARNING(p);
             
@@ -2099,7 +2360,6 @@ static int send_boot_report(void)
             }
                 
             p->type = FREE;
-            kbd_push_to_list(&kbd_free_list, p);
             
             ret = 1;
         } while (0);
@@ -2134,7 +2394,7 @@ static int send_hid_report(void)
         if (!req)
             break;
 
-        p = kbd_pull_from_list(&kbd_trm_list);
+        p = kbd_pull_report();
         
         ASSERT_WARNING(p);
         
@@ -2163,7 +2423,6 @@ static int send_hid_report(void)
         }
         
         p->type = FREE;
-        kbd_push_to_list(&kbd_free_list, p);
         
         ret = 1;
     } while (0);
@@ -2266,6 +2525,16 @@ void KEYBRD_Handler(void)
     next_is_full_scan = true;
         
     kbd_cntrl_active = false;
+    
+    // a new key while scanning slowly (only held keys): do not wait for the rest 
+    // of the long scan cycle, start the next (full) scan now. only the time until
+    // now is charged to the debouncing counters
+    if (HAS_ADAPTIVE_SCAN_TIMES && (kbd_scan_mode == SCAN_MODE_HOLD)
+        && (GetWord32(0xE000E018) > (ROW_SCAN_TIME * SYSTICK_TICKS_PER_US)) )
+    {
+        scan_time_update();
+        systick_start( (ROW_SCAN_TIME * SYSTICK_TICKS_PER_US), 2);
+    }
 }
 
 
@@ -2537,6 +2806,7 @@ void SysTick_Handler(void)
 	ASSERT_ERROR(kbd_membrane_status != 0);
     
     systick_hit = true;
+    systick_wraps++;
 }
 
 
@@ -2610,11 +2880,11 @@ void app_hid_create_db(void)
         features->svc_features |= HOGPD_CFG_BOOT_KB_WR;
     } 
 
-    features->report_nb          = 3; 
+    features->report_nb          = 4; 
     features->report_char_cfg[0] = HOGPD_CFG_REPORT_IN | HOGPD_REPORT_NTF_CFG_MASK | HOGPD_CFG_REPORT_WR;
     features->report_char_cfg[1] = HOGPD_CFG_REPORT_OUT;
     features->report_char_cfg[2] = HOGPD_CFG_REPORT_IN | HOGPD_REPORT_NTF_CFG_MASK | HOGPD_CFG_REPORT_WR;
-    features->report_char_cfg[3] = 0;
+    features->report_char_cfg[3] = HOGPD_CFG_REPORT_IN | HOGPD_REPORT_NTF_CFG_MASK | HOGPD_CFG_REPORT_WR;   // System Control
     features->report_char_cfg[4] = 0;
 
     hid_info->bcdHID = 0x100;
@@ -2699,9 +2969,11 @@ void app_keyboard_enable(void)
 #ifdef DEBUG_WITH_TESTER    
     req->ntf_cfg[0].report_ntf_en[0] = 1;   // used with tester only!
     req->ntf_cfg[0].report_ntf_en[2] = 1;   // used with tester only!
+    req->ntf_cfg[0].report_ntf_en[3] = 1;   // used with tester only!
 #else
     req->ntf_cfg[0].report_ntf_en[0] = 0;
     req->ntf_cfg[0].report_ntf_en[2] = 0;
+    req->ntf_cfg[0].report_ntf_en[3] = 0;
 #endif    
 
     // Send the message
@@ -2854,7 +3126,7 @@ void app_kbd_stop_reporting(void)
 /**
  ****************************************************************************************
  * @brief Prepares HID reports based on keycode buffer data
- *        Called in case of free list depletion (in this case calls to prepare_kbd_keyreport()
+ *        Called in case of report ring depletion (in this case calls to prepare_kbd_keyreport()
  *        fail). This way, captured key events that have been stored in the keycode_buffer
  *        will not be missed.
  *
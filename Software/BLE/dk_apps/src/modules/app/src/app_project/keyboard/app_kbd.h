@@ -86,6 +86,12 @@
 #define HAS_SCAN_ALWAYS_ACTIVE                  0
 #endif
 
+#ifdef SCAN_STATS_ON
+#define HAS_SCAN_STATS                          1
+#else
+#define HAS_SCAN_STATS                          0
+#endif
+
 #ifdef DELAYED_WAKEUP_ON
 #define HAS_DELAYED_WAKEUP                      1
 #else
@@ -110,6 +116,12 @@
 #define HAS_ALTERNATIVE_SCAN_TIMES              0
 #endif
 
+#ifdef ADAPTIVE_SCAN_TIMES_ON
+#define HAS_ADAPTIVE_SCAN_TIMES                 1
+#else
+#define HAS_ADAPTIVE_SCAN_TIMES                 0
+#endif
+
 #ifdef USE_PREF_CONN_PARAMS_ON
 #define HAS_KBD_SWITCH_TO_PREFERRED_CONN_PARAMS 1
 #else
@@ -231,14 +243,28 @@ struct hid_msg {
  ****************************************************************************************
  */
  
+#if (HAS_ADAPTIVE_SCAN_TIMES)
+// the scan period changes, so the counters are in msec and are counted down by the 
+// duration of each scan cycle
+#define DEBOUNCE_COUNTER_PRESS      (DEBOUNCE_COUNTER_P_IN_MS)
+
+#define DEBOUNCE_COUNTER_RELEASE    (DEBOUNCE_COUNTER_R_IN_MS)
+
+// global debouncing is done in full scan mode which always uses FAST_SCAN_IN_MS
+#define DEBOUNCE_COUNTER_GLOBAL     (((DEBOUNCE_COUNTER_P_IN_MS + FAST_SCAN_IN_MS - 1) / FAST_SCAN_IN_MS) + 1)
+#else
 #define DEBOUNCE_COUNTER_PRESS      ((int)(1 + ( ((DEBOUNCE_COUNTER_P_IN_MS - FULL_SCAN_IN_MS) / PARTIAL_SCAN_IN_MS) + 0.999 ) ) - 1)
 
 #define DEBOUNCE_COUNTER_RELEASE    ((int)( (DEBOUNCE_COUNTER_R_IN_MS / PARTIAL_SCAN_IN_MS) + 0.999 ) - 1)
 
+#define DEBOUNCE_COUNTER_GLOBAL     (DEBOUNCE_COUNTER_PRESS + 1)
+#endif
+
 #define SYSTICK_CLOCK_RATE          (1000000)
 #define SYSTICK_TICKS_PER_US        (SYSTICK_CLOCK_RATE / 1000000)
 
 
+// debouncing state of a key, kept per row in kbd_bounce_rows[], kbd_bounce_press[] and kbd_bounce_release[]
 enum DEBOUNCE_STATE {
     IDLE = 0,
     PRESS_DEBOUNCING,
@@ -246,9 +272,23 @@ enum DEBOUNCE_STATE {
     RELEASE_DEBOUNCING,
 };
 
-struct debounce_counter_t {
-    enum DEBOUNCE_STATE state;
-    uint8_t cnt;
+enum SCAN_MODE {
+    SCAN_MODE_FAST = 0,     // a key press is being debounced (or full scan)
+    SCAN_MODE_NORMAL,       // a key release is being debounced
+    SCAN_MODE_HOLD,         // only stable keys are held
+    SCAN_MODE_NUM,
+};
+
+struct kbd_scan_stats_t {
+    uint32_t scans;         // completed scan cycles
+    uint32_t ghosts;        // key presses rejected by deghosting (counted on every scan)
+    uint32_t keystrokes;    // key presses accepted after debouncing (scans / keystrokes = scans per keystroke)
+    uint32_t mode_scans[SCAN_MODE_NUM];     // scan cycles per scan mode
+    uint32_t mode_dwell_ms[SCAN_MODE_NUM];  // time spent per scan mode
+    uint32_t presses_deferred;              // key presses not recorded yet because of backpressure (counted on every scan)
+    uint32_t reports_coalesced;             // pending reports merged into the previous one
+    uint16_t last_us;       // processing time of the last scan cycle
+    uint16_t max_us;        // max processing time of a scan cycle
 };
 
 
@@ -258,7 +298,7 @@ struct debounce_counter_t {
  ****************************************************************************************
  */
 
-#define MAX_REPORTS 5 
+#define MAX_REPORTS 12
 
 enum KEY_BUFF_TYPE {
 	FREE,
@@ -269,7 +309,8 @@ enum KEY_BUFF_TYPE {
 
 enum REPORT_TYPE {
     NORMAL_REPORT = 0,
-    EXTENDED_REPORT = 2
+    EXTENDED_REPORT = 2,
+    SYSTEM_REPORT = 3
 };
 
 typedef struct __kbd_rep_info {
@@ -278,7 +319,6 @@ typedef struct __kbd_rep_info {
     enum REPORT_TYPE char_id;
     uint8_t len;
 	uint8_t *pBuf;
-	struct __kbd_rep_info *pNext;
 } kbd_rep_info;
 
 enum REPORT_MODE {
@@ -288,8 +328,8 @@ enum REPORT_MODE {
 };
 
 
-// The roll-over buffer must be bigger than the debounce buffer.
-#define ROLL_OVER_BUF_SZ    (DEBOUNCE_BUFFER_SIZE * 2)
+// Keys held at the same time that are tracked during roll-over.
+#define ROLL_OVER_BUF_SZ    (32)
 #if (ROLL_OVER_BUF_SZ < 7)
 #error "Too small Roll-Over buffer!"
 #endif
@@ -308,8 +348,7 @@ struct roll_over_tag {
  ****************************************************************************************
  */
 
-extern kbd_rep_info *kbd_trm_list;
-extern kbd_rep_info *kbd_free_list;
+extern uint8_t kbd_trm_cnt;
 //extern bool normal_key_report_ack_pending;
 //extern bool extended_key_report_ack_pending;
 extern bool user_disconnection_req;
@@ -324,6 +363,7 @@ extern uint8_t kbd_proto_mode;
 extern enum delay_monitor_status monitor_kbd_delayed_start_st;
 extern enum delay_trigger_status trigger_kbd_delayed_start_st;
 extern bool ble_is_woken_up;
+extern struct kbd_scan_stats_t kbd_scan_stats;
 
 /*
  * FUNCTION DECLARATIONS
@@ -469,7 +509,7 @@ void app_kbd_flush_reports(void);
 /**
  ****************************************************************************************
  * @brief Prepares HID reports based on keycode buffer data
- *        Called in case of free list depletion (in this case calls to prepare_kbd_keyreport()
+ *        Called in case of report ring depletion (in this case calls to prepare_kbd_keyreport()
  *        fail). This way, captured key events that have been stored in the keycode_buffer
  *        will not be missed.
  *
@@ -58,6 +58,13 @@
 //#define SCAN_ALWAYS_ACTIVE_ON
 
 
+/****************************************************************************************
+ * Keep scan statistics (processing time per scan cycle, ghost keys) in kbd_scan_stats  *
+ * for inspection with the debugger. Uses the SysTick counter which runs at 1MHz.       *
+ ****************************************************************************************/
+//#define SCAN_STATS_ON
+
+
 /****************************************************************************************
  * Delayed wakeup (requires pressing a key for X ms to start)                           *
  ****************************************************************************************/
@@ -88,6 +95,15 @@
 //#define ALTERNATIVE_SCAN_TIMES_ON
 
 
+/****************************************************************************************
+ * Adapt the scan period to the key activity: FAST_SCAN_IN_MS while a key press is      *
+ * being debounced, PARTIAL_SCAN_IN_MS while a release is being debounced and           *
+ * HOLD_SCAN_IN_MS while only stable keys are held.                                     *
+ * Note: overrides ALTERNATIVE_SCAN_TIMES_ON.                                           *
+ ****************************************************************************************/
+//#define ADAPTIVE_SCAN_TIMES_ON
+
+
 /****************************************************************************************
  * Send a ConnUpdateParam request after connection completion                           *
  ****************************************************************************************/
@@ -175,7 +191,9 @@
 /****************************************************************************************
  * Choose keyboard layout                                                               *
  ****************************************************************************************/
+#ifndef MATRIX_SETUP
 #define MATRIX_SETUP                            (8)
+#endif
 
 
 
@@ -207,6 +225,10 @@
 #endif
 #define PARTIAL_SCAN_TIME                       (PARTIAL_SCAN_IN_MS * 1000)
 
+// Adaptive scan periods (ADAPTIVE_SCAN_TIMES_ON). FAST must leave time to scan all rows.
+#define FAST_SCAN_IN_MS                         (2)
+#define HOLD_SCAN_IN_MS                         (8)         // also the max extra delay for a release or a new key in a row with held keys
+
 // In general, debounce counters cannot be applied accurately. The reason is that 
 // debouncing is done in SW, based on SysTick interrupt events that are used to 
 // trigger the execution of the FSM.
@@ -225,8 +247,6 @@
 
 #define KEYCODE_BUFFER_SIZE                     (64)	// if set to more than 255, change the type of the rd & wr pointers from 8- to 16-bit
 
-#define DEBOUNCE_BUFFER_SIZE                    (16)
-
 
 /****************************************************************************************
  * Timeouts                                                                             *
@@ -61,39 +61,39 @@
 #define SET_MASK3_FROM_COLUMN(x)    ( (COLUMN_##x##_PORT == 3) ? (1 << COLUMN_##x##_PIN) : 0 )
 
 #define CHECK_MASK_FROM_COLUMN(x, m)                            \
-                                    ( (x == 0)  ? ##m##(0)  :   \
-                                      (x == 1)  ? ##m##(1)  :   \
-                                      (x == 2)  ? ##m##(2)  :   \
-                                      (x == 3)  ? ##m##(3)  :   \
-                                      (x == 4)  ? ##m##(4)  :   \
-                                      (x == 5)  ? ##m##(5)  :   \
-                                      (x == 6)  ? ##m##(6)  :   \
-                                      (x == 7)  ? ##m##(7)  :   \
-                                      (x == 8)  ? ##m##(8)  :   \
-                                      (x == 9)  ? ##m##(9)  :   \
-                                      (x == 10) ? ##m##(10) :   \
-                                      (x == 11) ? ##m##(11) :   \
-                                      (x == 12) ? ##m##(12) :   \
-                                      (x == 13) ? ##m##(13) :   \
-                                      (x == 14) ? ##m##(14) :   \
-                                      (x == 15) ? ##m##(15) :   \
-                                      (x == 16) ? ##m##(16) :   \
-                                      (x == 17) ? ##m##(17) :   \
-                                      (x == 18) ? ##m##(18) :   \
-                                      (x == 19) ? ##m##(19) :   \
-                                      (x == 20) ? ##m##(20) :   \
-                                      (x == 21) ? ##m##(21) :   \
-                                      (x == 22) ? ##m##(22) :   \
-                                      (x == 23) ? ##m##(23) :   \
-                                      (x == 24) ? ##m##(24) :   \
-                                      (x == 25) ? ##m##(25) :   \
-                                      (x == 26) ? ##m##(26) :   \
-                                      (x == 27) ? ##m##(27) :   \
-                                      (x == 28) ? ##m##(28) :   \
-                                      (x == 29) ? ##m##(29) :   \
-                                      (x == 30) ? ##m##(30) :   \
-                                      (x == 31) ? ##m##(31) :   \
-                                      (x == 32) ? ##m##(32) : 0  )
+                                    ( (x == 0)  ? m(0)  :   \
+                                      (x == 1)  ? m(1)  :   \
+                                      (x == 2)  ? m(2)  :   \
+                                      (x == 3)  ? m(3)  :   \
+                                      (x == 4)  ? m(4)  :   \
+                                      (x == 5)  ? m(5)  :   \
+                                      (x == 6)  ? m(6)  :   \
+                                      (x == 7)  ? m(7)  :   \
+                                      (x == 8)  ? m(8)  :   \
+                                      (x == 9)  ? m(9)  :   \
+                                      (x == 10) ? m(10) :   \
+                                      (x == 11) ? m(11) :   \
+                                      (x == 12) ? m(12) :   \
+                                      (x == 13) ? m(13) :   \
+                                      (x == 14) ? m(14) :   \
+                                      (x == 15) ? m(15) :   \
+                                      (x == 16) ? m(16) :   \
+                                      (x == 17) ? m(17) :   \
+                                      (x == 18) ? m(18) :   \
+                                      (x == 19) ? m(19) :   \
+                                      (x == 20) ? m(20) :   \
+                                      (x == 21) ? m(21) :   \
+                                      (x == 22) ? m(22) :   \
+                                      (x == 23) ? m(23) :   \
+                                      (x == 24) ? m(24) :   \
+                                      (x == 25) ? m(25) :   \
+                                      (x == 26) ? m(26) :   \
+                                      (x == 27) ? m(27) :   \
+                                      (x == 28) ? m(28) :   \
+                                      (x == 29) ? m(29) :   \
+                                      (x == 30) ? m(30) :   \
+                                      (x == 31) ? m(31) :   \
+                                      (x == 32) ? m(32) : 0  )
                                        
 #define CHECK_MASK0_FROM_COLUMN(x)      CHECK_MASK_FROM_COLUMN(x, SET_MASK0_FROM_COLUMN)
 #define CHECK_MASK12_FROM_COLUMN(x)     CHECK_MASK_FROM_COLUMN(x, SET_MASK12_FROM_COLUMN)
@@ -102,39 +102,39 @@
 #define SET_WKUP_MASK_FROM_COLUMN(m, x) ( (COLUMN_##x##_PORT == m) ? (1 << COLUMN_##x##_PIN) : 0 )
 
 #define CHECK_WKUP_MASK_FROM_COLUMN(p, x, m)                       \
-                                    ( (x == 0)  ? ##m##(p, 0)  :   \
-                                      (x == 1)  ? ##m##(p, 1)  :   \
-                                      (x == 2)  ? ##m##(p, 2)  :   \
-                                      (x == 3)  ? ##m##(p, 3)  :   \
-                                      (x == 4)  ? ##m##(p, 4)  :   \
-                                      (x == 5)  ? ##m##(p, 5)  :   \
-                                      (x == 6)  ? ##m##(p, 6)  :   \
-                                      (x == 7)  ? ##m##(p, 7)  :   \
-                                      (x == 8)  ? ##m##(p, 8)  :   \
-                                      (x == 9)  ? ##m##(p, 9)  :   \
-                                      (x == 10) ? ##m##(p, 10) :   \
-                                      (x == 11) ? ##m##(p, 11) :   \
-                                      (x == 12) ? ##m##(p, 12) :   \
-                                      (x == 13) ? ##m##(p, 13) :   \
-                                      (x == 14) ? ##m##(p, 14) :   \
-                                      (x == 15) ? ##m##(p, 15) :   \
-                                      (x == 16) ? ##m##(p, 16) :   \
-                                      (x == 17) ? ##m##(p, 17) :   \
-                                      (x == 18) ? ##m##(p, 18) :   \
-                                      (x == 19) ? ##m##(p, 19) :   \
-                                      (x == 20) ? ##m##(p, 20) :   \
-                                      (x == 21) ? ##m##(p, 21) :   \
-                                      (x == 22) ? ##m##(p, 22) :   \
-                                      (x == 23) ? ##m##(p, 23) :   \
-                                      (x == 24) ? ##m##(p, 24) :   \
-                                      (x == 25) ? ##m##(p, 25) :   \
-                                      (x == 26) ? ##m##(p, 26) :   \
-                                      (x == 27) ? ##m##(p, 27) :   \
-                                      (x == 28) ? ##m##(p, 28) :   \
-                                      (x == 29) ? ##m##(p, 29) :   \
-                                      (x == 30) ? ##m##(p, 30) :   \
-                                      (x == 31) ? ##m##(p, 31) :   \
-                                      (x == 32) ? ##m##(p, 32) : 0  )
+                                    ( (x == 0)  ? m(p, 0)  :   \
+                                      (x == 1)  ? m(p, 1)  :   \
+                                      (x == 2)  ? m(p, 2)  :   \
+                                      (x == 3)  ? m(p, 3)  :   \
+                                      (x == 4)  ? m(p, 4)  :   \
+                                      (x == 5)  ? m(p, 5)  :   \
+                                      (x == 6)  ? m(p, 6)  :   \
+                                      (x == 7)  ? m(p, 7)  :   \
+                                      (x == 8)  ? m(p, 8)  :   \
+                                      (x == 9)  ? m(p, 9)  :   \
+                                      (x == 10) ? m(p, 10) :   \
+                                      (x == 11) ? m(p, 11) :   \
+                                      (x == 12) ? m(p, 12) :   \
+                                      (x == 13) ? m(p, 13) :   \
+                                      (x == 14) ? m(p, 14) :   \
+                                      (x == 15) ? m(p, 15) :   \
+                                      (x == 16) ? m(p, 16) :   \
+                                      (x == 17) ? m(p, 17) :   \
+                                      (x == 18) ? m(p, 18) :   \
+                                      (x == 19) ? m(p, 19) :   \
+                                      (x == 20) ? m(p, 20) :   \
+                                      (x == 21) ? m(p, 21) :   \
+                                      (x == 22) ? m(p, 22) :   \
+                                      (x == 23) ? m(p, 23) :   \
+                                      (x == 24) ? m(p, 24) :   \
+                                      (x == 25) ? m(p, 25) :   \
+                                      (x == 26) ? m(p, 26) :   \
+                                      (x == 27) ? m(p, 27) :   \
+                                      (x == 28) ? m(p, 28) :   \
+                                      (x == 29) ? m(p, 29) :   \
+                                      (x == 30) ? m(p, 30) :   \
+                                      (x == 31) ? m(p, 31) :   \
+                                      (x == 32) ? m(p, 32) : 0  )
                                        
 #define CHECK_WKUP_MASK0_FROM_COLUMN(x)  CHECK_WKUP_MASK_FROM_COLUMN(0, x, SET_WKUP_MASK_FROM_COLUMN)
 #define CHECK_WKUP_MASK1_FROM_COLUMN(x)  CHECK_WKUP_MASK_FROM_COLUMN(1, x, SET_WKUP_MASK_FROM_COLUMN)
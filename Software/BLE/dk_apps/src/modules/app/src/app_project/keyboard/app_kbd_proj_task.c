@@ -44,7 +44,7 @@
 int extended_timer_cnt __attribute__((section("retention_mem_area0"), zero_init));
 
 
-#define REPORT_MAP_LEN (65 - 18 + 75)
+#define REPORT_MAP_LEN (65 - 18 + 79 + 27)
 // Report Descriptor == Report Map (HID1_11.pdf section E.6)
 KBD_TYPE_QUALIFIER uint8 report_map[REPORT_MAP_LEN] KBD_ARRAY_ATTRIBUTE =
 {
@@ -109,6 +109,22 @@ KBD_TYPE_QUALIFIER uint8 report_map[REPORT_MAP_LEN] KBD_ARRAY_ATTRIBUTE =
     0x0A, 0x26, 0x02,   //  Usage (AC Stop)
     0x0A, 0x27, 0x02,   //  Usage (AC Refresh)
     0x0A, 0x2A, 0x02,   //  Usage (AC Bookmarks)
+    0x09, 0x6F,         //  Usage (Display Brightness Increment)
+    0x09, 0x70,         //  Usage (Display Brightness Decrement)
+    0x95, 0x05,         //  Report Count (5)
+    0x81, 0x02,         //  Input (Data,Var,Abs,NWrp,Lin,Pref,NNul,Bit)
+    0x95, 0x03,         //  Report Count (3)
+    0x81, 0x01,         //  Input (Cnst,Ary,Abs)
+    0xC0,               // End Collection
+    0x05, 0x01,         // Usage Page (Generic Desktop)
+    0x09, 0x80,         // Usage (System Control)
+    0xA1, 0x01,         // Collection (Application)
+    0x85, 0x04,         //  Report ID (4)
+    0x19, 0x81,         //  Usage Minimum (System Power Down)
+    0x29, 0x83,         //  Usage Maximum (System Wake Up)
+    0x15, 0x00,         //  Logical Minimum (0)
+    0x25, 0x01,         //  Logical Maximum (1)
+    0x75, 0x01,         //  Report Size (1)
     0x95, 0x03,         //  Report Count (3)
     0x81, 0x02,         //  Input (Data,Var,Abs,NWrp,Lin,Pref,NNul,Bit)
     0x95, 0x05,         //  Report Count (5)
@@ -118,11 +118,11 @@ static inline bool app_asynch_trm(void)
                 
         if ( !ke_event_get(KE_EVENT_KE_MESSAGE) ) {
             // Since pkt reqs can be silently discarded if no Tx bufs are available, check first!
-            if (kbd_trm_list && app_kbd_check_conn_status() && l2cm_get_nb_buffer_available()) {
+            if (kbd_trm_cnt && app_kbd_check_conn_status() && l2cm_get_nb_buffer_available()) {
                 
                 if (app_kbd_send_key_report()) {
                     // One HID report is removed from the trm list. Check if other HID reports are to be
-                    // prepared because of unread data in the keycode_buffer now that the free list is not NULL.
+                    // prepared because of unread data in the keycode_buffer now that the report ring is not full.
                     app_kbd_prepare_keyreports();
                     
                     ret = true;
@@ -169,7 +169,7 @@ void periph_init(void)
     if (GetBits16(CLK_CTRL_REG, RUNNING_AT_XTAL16M))
     {
         SetBits16(CLK_PER_REG, UART2_ENABLE, 1);    // enable clock - always @16MHz
-			  uart2_init(UART_BAUDRATE_115K2, 3);
+			  uart2_init(USER_UART2_BAUDRATE, 3);
 				User_Uart2_RX_Pre();
 		}
 #endif		
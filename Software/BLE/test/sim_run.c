@@ -0,0 +1,363 @@
+/**
+ ****************************************************************************************
+ *
+ * @file sim_run.c
+ *
+ * @brief Script runner of the simulated keyboard. Runs app_kbd.c of one MATRIX_SETUP on
+ *        the simulated hardware and prints every HOGPD report and every completed scan
+ *        cycle (scan mode, scan period and the register accesses spent since the last
+ *        scan cycle). Script commands, one per line ('#' starts a comment):
+ *
+ *          conn <interval_us> <reports_per_event>  connection events (0: send at once)
+ *          press <key> ...                         close the switches of the keys
+ *          release <key> ...                       open the switches of the keys
+ *          wait <ms>                               run the simulation
+ *          expect <key> ...                        the Host holds exactly these normal keys
+ *          expect-released                         the last report of each type is empty
+ *          chords <keys> <count>                   random chords of distinct "@n" keys, pressed
+ *                                                  CHORD_STEP_MS apart, held and released together;
+ *                                                  prints the register accesses per new key
+ *                                                  (key of a chord); skipped if the setup has
+ *                                                  fewer keys
+ *
+ *        A key is "@n" (n-th key of kbd_keymap[0], in row order), "r,c" or a HID usage of
+ *        a normal key in hex ("0x04").
+ *
+ *        Usage: sim_kbd_setup_<n> [-q] [script]     (-q: reports only, stdin if no script)
+ *
+ ****************************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "app_kbd.c"
+#include "sim_matrix.h"
+
+#define CHORD_STEP_MS       (5)         // between the presses of a chord (rollover)
+#define CHORD_HOLD_MS       (40)
+#define CHORD_GAP_MS        (60)
+
+static const char * const mode_names[SCAN_MODE_NUM] = { "FAST", "NORMAL", "HOLD" };
+
+static bool quiet;
+static uint32_t reports_printed;
+static uint32_t scans_seen;
+static uint32_t scan_start_regs;
+
+// a key that can be pressed by "@n": wired, not 'Fn' and not a special function
+static bool is_script_key(int output, int input)
+{
+    const uint16_t code = kbd_keymap[0][output][input];
+
+    return kbd_out_bitmasks[output] && kbd_input_mode_regs[input] && (code != 0)
+           && ((code >> 8) != 0xF8) && ((code & 0xFFF0) != 0xF4F0);
+}
+
+static bool parse_key(const char *tok, int *output, int *input)
+{
+    int i, j, n;
+
+    if (sscanf(tok, "%d,%d", output, input) == 2)
+        return (*output >= 0) && (*output < KBD_NR_OUTPUTS) && (*input >= 0) && (*input < KBD_NR_INPUTS);
+
+    if (sscanf(tok, "@%d", &n) == 1)
+    {
+        for (i = 0; i < KBD_NR_OUTPUTS; i++)
+            for (j = 0; j < KBD_NR_INPUTS; j++)
+                if (is_script_key(i, j) && (n-- == 0))
+                {
+                    *output = i;
+                    *input = j;
+                    return true;
+                }
+        return false;
+    }
+
+    if (sscanf(tok, "0x%x", &n) == 1)
+    {
+        for (i = 0; i < KBD_NR_OUTPUTS; i++)
+            for (j = 0; j < KBD_NR_INPUTS; j++)
+                if (sim_is_normal_key(i, j) && ((kbd_keymap[0][i][j] & 0xFF) == n))
+                {
+                    *output = i;
+                    *input = j;
+                    return true;
+                }
+    }
+
+    return false;
+}
+
+// prints the reports and the scan cycles that are new since the last call
+static void print_events(void)
+{
+    for (; reports_printed < sim.report_cnt; reports_printed++)
+    {
+        const struct sim_report *rep = &sim.reports[reports_printed];
+        int i;
+
+        printf("%10u report %u :", rep->time_us, rep->report_nb);
+        for (i = 0; i < rep->len; i++)
+            printf(" %02x", rep->data[i]);
+        printf("\n");
+    }
+}
+
+static void run_ms(uint32_t ms)
+{
+    uint32_t us = ms * 1000;
+
+    while (us--)
+    {
+        sim_run_us(1);
+
+        if (kbd_scan_stats.scans != scans_seen)
+        {
+            scans_seen = kbd_scan_stats.scans;
+            if (!quiet)
+                printf("%10u scan %u mode %s period_ms %u regs %u\n", sim.time_us, scans_seen,
+                       mode_names[kbd_scan_mode], scan_cycle_ms, sim.reg_accesses - scan_start_regs);
+            scan_start_regs = sim.reg_accesses;
+        }
+
+        print_events();
+    }
+}
+
+static uint32_t next_number(uint32_t def)
+{
+    const char *tok = strtok(NULL, " \t\r\n");
+
+    return tok ? strtoul(tok, NULL, 0) : def;
+}
+
+static bool host_holds_only(const int *outputs, const int *inputs, int cnt)
+{
+    const struct sim_report *rep = sim_last_normal();
+    int i, held = 0;
+
+    if (rep == NULL)
+        return (cnt == 0);
+
+    for (i = 2; i < 8; i++)
+        if (rep->data[i])
+            held++;
+
+    for (i = 0; i < cnt; i++)
+        if (!sim_host_has(outputs[i], inputs[i]))
+            return false;
+
+    return (held == cnt);
+}
+
+static bool all_released(void)
+{
+    bool seen[256] = {false};
+    uint32_t n = sim.report_cnt;
+    int i;
+
+    // the last report of each report number must be empty
+    while (n--)
+    {
+        const struct sim_report *rep = &sim.reports[n];
+
+        if (seen[rep->report_nb])
+            continue;
+        seen[rep->report_nb] = true;
+        for (i = (rep->report_nb == NORMAL_REPORT) ? 2 : 0; i < rep->len; i++)
+            if (rep->data[i])
+                return false;
+    }
+
+    return true;
+}
+
+// plays random chords; the cost of the deghosting and debouncing of a chord shows in the
+// register accesses of the scan cycles, divided by the keys pressed by the chords
+static void run_chords(int keys, int count, const char *name, int line_nb)
+{
+    int outputs[KBD_NR_OUTPUTS * KBD_NR_INPUTS], inputs[KBD_NR_OUTPUTS * KBD_NR_INPUTS];
+    int chord[KBD_NR_OUTPUTS * KBD_NR_INPUTS];
+    const uint32_t regs = sim.reg_accesses;
+    const uint32_t scans = kbd_scan_stats.scans;
+    const uint32_t keystrokes = kbd_scan_stats.keystrokes;
+    int nr_keys = 0, n, i, j;
+    uint32_t debounced;
+
+    for (i = 0; i < KBD_NR_OUTPUTS; i++)
+        for (j = 0; j < KBD_NR_INPUTS; j++)
+            if (is_script_key(i, j))
+            {
+                outputs[nr_keys] = i;
+                inputs[nr_keys++] = j;
+            }
+
+    if (keys < 1)
+    {
+        printf("%s:%d: no chords of %d keys\n", name, line_nb, keys);
+        exit(EXIT_FAILURE);
+    }
+
+    // the same script runs on every setup; small ones skip the chords they cannot play
+    if (keys > nr_keys)
+    {
+        printf("chords of %d keys (MATRIX_SETUP %d): skipped, %d keys\n", keys, MATRIX_SETUP, nr_keys);
+        return;
+    }
+
+    for (n = 0; n < count; n++)
+    {
+        for (i = 0; i < keys; i++)
+        {
+            do
+            {
+                chord[i] = rand() % nr_keys;
+                for (j = 0; (j < i) && (chord[j] != chord[i]); j++)
+                    ;
+            } while (j < i);
+
+            sim_key(outputs[chord[i]], inputs[chord[i]], true);
+            run_ms(CHORD_STEP_MS);
+        }
+        run_ms(CHORD_HOLD_MS);
+
+        for (i = 0; i < keys; i++)
+            sim_key(outputs[chord[i]], inputs[chord[i]], false);
+        run_ms(CHORD_GAP_MS);
+    }
+
+    debounced = kbd_scan_stats.keystrokes - keystrokes;
+    printf("chords of %d keys (MATRIX_SETUP %d): %d chords, %u debounced presses, %u scan cycles, %u register accesses per new key\n",
+           keys, MATRIX_SETUP, count, debounced, kbd_scan_stats.scans - scans,
+           (sim.reg_accesses - regs) / (uint32_t)(keys * count));
+
+    // ghosts of a diode-less matrix are debounced too, so there may be more presses than keys
+    if (debounced < (uint32_t)(keys * count))
+    {
+        printf("%s:%d: keys of the chords not debounced\n", name, line_nb);
+        fail++;
+    }
+}
+
+static void run_script(FILE *f, const char *name)
+{
+    char line[256];
+    int line_nb = 0;
+
+    while (fgets(line, sizeof(line), f))
+    {
+        int outputs[KBD_NR_OUTPUTS * KBD_NR_INPUTS], inputs[KBD_NR_OUTPUTS * KBD_NR_INPUTS];
+        char *cmd, *tok;
+        int cnt = 0;
+
+        line_nb++;
+        if (strchr(line, '#'))
+            *strchr(line, '#') = '\0';
+
+        cmd = strtok(line, " \t\r\n");
+        if (cmd == NULL)
+            continue;
+
+        if (!strcmp(cmd, "conn"))
+        {
+            sim.conn_interval_us = next_number(0);
+            sim.tx_per_event = next_number(1);
+            continue;
+        }
+
+        if (!strcmp(cmd, "wait"))
+        {
+            run_ms(next_number(0));
+            continue;
+        }
+
+        if (!strcmp(cmd, "chords"))
+        {
+            const int keys = next_number(2);
+
+            run_chords(keys, next_number(1), name, line_nb);
+            continue;
+        }
+
+        if (!strcmp(cmd, "expect-released"))
+        {
+            if (!all_released())
+            {
+                printf("%s:%d: keys still held by the Host\n", name, line_nb);
+                fail++;
+            }
+            continue;
+        }
+
+        while ((tok = strtok(NULL, " \t\r\n")) != NULL)
+        {
+            if (!parse_key(tok, &outputs[cnt], &inputs[cnt]))
+            {
+                printf("%s:%d: no key '%s' in MATRIX_SETUP %d\n", name, line_nb, tok, MATRIX_SETUP);
+                exit(EXIT_FAILURE);
+            }
+            cnt++;
+        }
+
+        if (!strcmp(cmd, "press") || !strcmp(cmd, "release"))
+        {
+            int i;
+
+            for (i = 0; i < cnt; i++)
+                sim_key(outputs[i], inputs[i], !strcmp(cmd, "press"));
+        }
+        else if (!strcmp(cmd, "expect"))
+        {
+            if (!host_holds_only(outputs, inputs, cnt))
+            {
+                printf("%s:%d: the Host does not hold exactly the expected keys\n", name, line_nb);
+                fail++;
+            }
+        }
+        else
+        {
+            printf("%s:%d: unknown command '%s'\n", name, line_nb, cmd);
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const char *name = "<stdin>";
+    FILE *f = stdin;
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-q"))
+            quiet = true;
+        else
+        {
+            name = argv[i];
+            f = fopen(name, "r");
+            if (f == NULL)
+            {
+                perror(name);
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    srand(1);
+    sim_kbd_start();
+    scans_seen = kbd_scan_stats.scans;
+    scan_start_regs = sim.reg_accesses;
+    run_script(f, name);
+
+    if (sim.asserts)
+    {
+        printf("%s: %u asserts\n", name, sim.asserts);
+        fail++;
+    }
+
+    printf("sim_kbd (MATRIX_SETUP %d): %u reports, %u scan cycles, %u register accesses: %s\n",
+           MATRIX_SETUP, sim.report_cnt, kbd_scan_stats.scans, sim.reg_accesses, fail ? "FAIL" : "OK");
+    return fail ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,4 @@
+#ifndef SIM_APP_H
+#define SIM_APP_H
+#include "sim_sdk.h"
+#endif
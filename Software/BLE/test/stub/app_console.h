@@ -0,0 +1,4 @@
+#ifndef SIM_APP_CONSOLE_H
+#define SIM_APP_CONSOLE_H
+#include "sim_sdk.h"
+#endif
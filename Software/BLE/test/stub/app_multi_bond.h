@@ -0,0 +1,4 @@
+#ifndef SIM_APP_MULTI_BOND_H
+#define SIM_APP_MULTI_BOND_H
+#include "sim_sdk.h"
+#endif
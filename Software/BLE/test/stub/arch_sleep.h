@@ -0,0 +1,4 @@
+#ifndef SIM_ARCH_SLEEP_H
+#define SIM_ARCH_SLEEP_H
+#include "sim_sdk.h"
+#endif
@@ -0,0 +1,4 @@
+#ifndef SIM_CO_BT_H
+#define SIM_CO_BT_H
+#include "sim_sdk.h"
+#endif
@@ -0,0 +1,4 @@
+#ifndef SIM_GAP_H
+#define SIM_GAP_H
+#include "sim_sdk.h"
+#endif
@@ -0,0 +1,4 @@
+#ifndef SIM_GATTC_TASK_H
+#define SIM_GATTC_TASK_H
+#include "sim_sdk.h"
+#endif
@@ -0,0 +1,4 @@
+#ifndef SIM_GPIO_H
+#define SIM_GPIO_H
+#include "sim_sdk.h"
+#endif
@@ -0,0 +1,4 @@
+#ifndef SIM_HOGPD_TASK_H
+#define SIM_HOGPD_TASK_H
+#include "sim_sdk.h"
+#endif
@@ -0,0 +1,4 @@
+#ifndef SIM_KE_TASK_H
+#define SIM_KE_TASK_H
+#include "sim_sdk.h"
+#endif
@@ -0,0 +1,4 @@
+#ifndef SIM_PERIPH_SETUP_H
+#define SIM_PERIPH_SETUP_H
+#include "sim_sdk.h"
+#endif
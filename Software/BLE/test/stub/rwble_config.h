@@ -0,0 +1,4 @@
+#ifndef SIM_RWBLE_CONFIG_H
+#define SIM_RWBLE_CONFIG_H
+#include "sim_sdk.h"
+#endif
@@ -0,0 +1,495 @@
+/**
+ ****************************************************************************************
+ *
+ * @file sim_kbd.c
+ *
+ * @brief Host simulator of the DA14580 keyboard hardware used by app_kbd.c.
+ *
+ * Time advances in steps of 1 usec (1 SysTick tick). The GPIO ports are modelled at the
+ * pin level: an output is driven low when its mode is 0x300 and its latch bit is 0, and
+ * a closed switch connects a row pin and a column pin. There are no diodes, so every pin
+ * connected to a low output through any path of closed switches reads low (this is what
+ * produces the ghost keys). The Keyboard Controller and the Wakeup Timer fire as soon as
+ * a selected input is low; their debounce times are not modelled.
+ *
+ ****************************************************************************************
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "sim_sdk.h"
+#include "sim_kbd.h"
+#include "app_kbd.h"
+#include "app_kbd_fsm.h"
+#include "app_kbd_scan_fsm.h"
+
+#define SIM_PINS                (4 * 16)
+#define SIM_MAX_SWITCHES        (256)
+
+#define GPIO_BASE               (0x50003000)
+#define GPIO_END                (GPIO_BASE + 5 * 0x20)
+#define PERIPH_BASE             (0x50000000)
+#define PERIPH_WORDS            (0x2000)
+
+#define SYST_CSR                (0xE000E010)
+#define SYST_RVR                (0xE000E014)
+#define SYST_CVR                (0xE000E018)
+
+/*
+ * Application symbols not compiled in the simulator
+ ****************************************************************************************
+ */
+
+struct app_env_tag app_env;
+enum main_fsm_states current_fsm_state;
+bool reset_bonding_request;
+volatile uint32_t pass_code;
+
+extern void SysTick_Handler(void);
+extern void KEYBRD_Handler(void);
+
+struct sim_state sim;
+
+static uint16_t periph_regs[PERIPH_WORDS];
+static uint16_t pin_mode[SIM_PINS];
+static uint16_t port_latch[4];
+static struct { uint8_t row_pin, col_pin; } switches[SIM_MAX_SWITCHES];
+static int switch_cnt;
+static bool levels_dirty;
+static uint16_t port_levels[4];
+
+static uint32_t systick_csr, systick_rvr, systick_cvr;
+static bool nvic_en[32];
+static void (*wkup_callback)(void);
+static uint32_t next_conn_event_us;
+
+/*
+ * GPIO
+ ****************************************************************************************
+ */
+
+// register block of a port: port 3 is mapped after a gap (see the fix for port 3 in app_kbd.c)
+static int port_of_block(int blk)
+{
+    return (blk == 4) ? 3 : ((blk == 3) ? -1 : blk);
+}
+
+static int find_root(uint8_t *parent, int p)
+{
+    while (parent[p] != p)
+        p = parent[p] = parent[parent[p]];
+    return p;
+}
+
+static void update_levels(void)
+{
+    uint8_t parent[SIM_PINS];
+    bool low[SIM_PINS];
+    int p, i;
+
+    for (p = 0; p < SIM_PINS; p++)
+    {
+        parent[p] = p;
+        low[p] = false;
+    }
+
+    for (i = 0; i < switch_cnt; i++)
+    {
+        int a = find_root(parent, switches[i].row_pin);
+        int b = find_root(parent, switches[i].col_pin);
+
+        parent[a] = b;
+    }
+
+    for (p = 0; p < SIM_PINS; p++)
+    {
+        if ( (pin_mode[p] == 0x300) && !(port_latch[p >> 4] & (1 << (p & 0xF))) )
+            low[find_root(parent, p)] = true;
+    }
+
+    for (i = 0; i < 4; i++)
+        port_levels[i] = 0xFFFF;
+
+    for (p = 0; p < SIM_PINS; p++)
+    {
+        bool level;
+
+        if (pin_mode[p] == 0x300)
+            level = (port_latch[p >> 4] >> (p & 0xF)) & 1;
+        else
+            level = !low[find_root(parent, p)];         // pull-up, or floating high
+
+        if (!level)
+            port_levels[p >> 4] &= ~(1 << (p & 0xF));
+    }
+
+    levels_dirty = false;
+}
+
+static uint16_t gpio_read(uint32_t addr)
+{
+    const int blk = (addr - GPIO_BASE) / 0x20;
+    const int off = (addr - GPIO_BASE) % 0x20;
+    const int port = port_of_block(blk);
+
+    if (port < 0)
+        return 0;
+
+    if (off == 0)
+    {
+        if (levels_dirty)
+            update_levels();
+        return port_levels[port];
+    }
+    if (off >= 6)
+        return pin_mode[(port << 4) | ((off - 6) / 2)];
+
+    return 0;
+}
+
+static void gpio_write(uint32_t addr, uint16_t val)
+{
+    const int blk = (addr - GPIO_BASE) / 0x20;
+    const int off = (addr - GPIO_BASE) % 0x20;
+    const int port = port_of_block(blk);
+
+    if (port < 0)
+        return;
+
+    if (off == 0)
+        port_latch[port] = val;
+    else if (off == 2)
+        port_latch[port] |= val;
+    else if (off == 4)
+        port_latch[port] &= ~val;
+    else
+        pin_mode[(port << 4) | ((off - 6) / 2)] = val & 0x300;
+
+    levels_dirty = true;
+}
+
+/*
+ * Register file
+ ****************************************************************************************
+ */
+
+uint16_t GetWord16(uint32_t addr)
+{
+    sim.reg_accesses++;
+
+    if ( (addr >= GPIO_BASE) && (addr < GPIO_END) )
+        return gpio_read(addr);
+
+    if ( (addr >= PERIPH_BASE) && (addr < PERIPH_BASE + 2 * PERIPH_WORDS) )
+        return periph_regs[(addr - PERIPH_BASE) / 2];
+
+    return 0;
+}
+
+void SetWord16(uint32_t addr, uint16_t val)
+{
+    sim.reg_accesses++;
+
+    if ( (addr >= GPIO_BASE) && (addr < GPIO_END) )
+        gpio_write(addr, val);
+    else if ( (addr >= PERIPH_BASE) && (addr < PERIPH_BASE + 2 * PERIPH_WORDS) )
+    {
+        periph_regs[(addr - PERIPH_BASE) / 2] = val;
+        levels_dirty = true;                            // IRQ selections may have changed
+    }
+}
+
+uint32_t GetWord32(uint32_t addr)
+{
+    uint32_t val;
+
+    switch (addr)
+    {
+    case SYST_CSR:
+        sim.reg_accesses++;
+        val = systick_csr;
+        systick_csr &= ~0x10000;                        // COUNTFLAG is cleared by reading
+        return val;
+    case SYST_RVR:
+        sim.reg_accesses++;
+        return systick_rvr;
+    case SYST_CVR:
+        sim.reg_accesses++;
+        return systick_cvr;
+    default:
+        return GetWord16(addr);
+    }
+}
+
+void SetWord32(uint32_t addr, uint32_t val)
+{
+    switch (addr)
+    {
+    case SYST_CSR:
+        sim.reg_accesses++;
+        systick_csr = (systick_csr & 0x10000) | (val & 0x7);
+        break;
+    case SYST_RVR:
+        sim.reg_accesses++;
+        systick_rvr = val & 0xFFFFFF;
+        break;
+    case SYST_CVR:
+        sim.reg_accesses++;
+        systick_cvr = 0;                                // any write clears the counter
+        systick_csr &= ~0x10000;
+        break;
+    default:
+        SetWord16(addr, val);
+        break;
+    }
+}
+
+/*
+ * NVIC, kernel and application stubs
+ ****************************************************************************************
+ */
+
+void NVIC_EnableIRQ(int irq)
+{
+    if (irq >= 0)
+        nvic_en[irq] = true;
+    levels_dirty = true;
+}
+
+void NVIC_DisableIRQ(int irq)
+{
+    if (irq >= 0)
+        nvic_en[irq] = false;
+}
+
+void NVIC_ClearPendingIRQ(int irq)
+{
+}
+
+void NVIC_SetPriority(int irq, int prio)
+{
+}
+
+void sim_assert_hit(const char *file, int line)
+{
+    if (sim.asserts++ == 0)
+        printf("%s:%d: assertion failed at %u us\n", file, line, (unsigned)sim.time_us);
+}
+
+static union { uint64_t align; uint8_t buf[256]; } msg_param;
+static ke_msg_id_t msg_id;
+
+void *ke_msg_alloc(ke_msg_id_t id, ke_task_id_t dest, ke_task_id_t src, uint16_t len)
+{
+    if (len > sizeof(msg_param))
+        return NULL;
+
+    msg_id = id;
+    memset(msg_param.buf, 0, len);
+    return msg_param.buf;
+}
+
+void ke_msg_send(void const *param_ptr)
+{
+    struct sim_report *rep;
+
+    if (sim.report_cnt >= SIM_MAX_REPORTS)
+        return;
+
+    rep = &sim.reports[sim.report_cnt];
+
+    if (msg_id == HOGPD_REPORT_UPD_REQ)
+    {
+        const struct hogpd_report_info *req = param_ptr;
+
+        rep->report_nb = req->report_nb;
+        rep->len = req->report_length;
+        memcpy(rep->data, req->report, 8);
+    }
+    else if (msg_id == HOGPD_BOOT_REPORT_UPD_REQ)
+    {
+        const struct hogpd_boot_report_info *req = param_ptr;
+
+        rep->report_nb = NORMAL_REPORT;
+        rep->len = req->report_length;
+        memcpy(rep->data, req->boot_report, 8);
+    }
+    else
+        return;
+
+    rep->time_us = sim.time_us;
+    sim.report_cnt++;
+}
+
+ke_state_t ke_state_get(ke_task_id_t id)
+{
+    return APP_CONNECTED;
+}
+
+void wkupct_register_callback(void (*callback)(void))
+{
+    wkup_callback = callback;
+}
+
+void periph_init(void)
+{
+}
+
+void app_alt_pair_clear_all_bond_data(void)
+{
+}
+
+void app_state_update(enum main_fsm_events evt)
+{
+}
+
+void reset_bonding_data(void)
+{
+}
+
+void app_mitm_passcode_report(uint32_t code)
+{
+}
+
+/*
+ * Simulation
+ ****************************************************************************************
+ */
+
+void sim_reset(void)
+{
+    memset(&sim, 0, sizeof(sim));
+    memset(periph_regs, 0, sizeof(periph_regs));
+    memset(pin_mode, 0, sizeof(pin_mode));
+    memset(port_latch, 0, sizeof(port_latch));
+    memset(nvic_en, 0, sizeof(nvic_en));
+    switch_cnt = 0;
+    levels_dirty = true;
+    systick_csr = systick_rvr = systick_cvr = 0;
+    wkup_callback = NULL;
+    next_conn_event_us = 0;
+
+    current_fsm_state = CONNECTED_ST;
+    current_scan_state = KEY_SCAN_INACTIVE;
+    reset_bonding_request = false;
+}
+
+void sim_switch(uint8_t row_pin, uint8_t col_pin, bool pressed)
+{
+    int i;
+
+    for (i = 0; i < switch_cnt; i++)
+        if ( (switches[i].row_pin == row_pin) && (switches[i].col_pin == col_pin) )
+            break;
+
+    if (pressed && (i == switch_cnt) && (switch_cnt < SIM_MAX_SWITCHES))
+    {
+        switches[switch_cnt].row_pin = row_pin;
+        switches[switch_cnt].col_pin = col_pin;
+        switch_cnt++;
+    }
+    else if (!pressed && (i < switch_cnt))
+        switches[i] = switches[--switch_cnt];
+
+    levels_dirty = true;
+}
+
+// input pins selected by the Keyboard Controller (KBRD_IRQ_IN_SELx_REG) and the Wakeup Timer
+static bool irq_input_low(uint16_t p0, uint16_t p1, uint16_t p2, uint16_t p3)
+{
+    if (levels_dirty)
+        update_levels();
+
+    return ( (~port_levels[0] & p0) | (~port_levels[1] & p1) | (~port_levels[2] & p2) | (~port_levels[3] & p3) ) != 0;
+}
+
+static void sim_check_irqs(void)
+{
+    if (nvic_en[KEYBRD_IRQn])
+    {
+        const uint16_t sel0 = periph_regs[(KBRD_IRQ_IN_SEL0_REG - PERIPH_BASE) / 2];
+        const uint16_t sel1 = periph_regs[(KBRD_IRQ_IN_SEL1_REG - PERIPH_BASE) / 2];
+        const uint16_t sel2 = periph_regs[(0x50001416 - PERIPH_BASE) / 2];
+
+        if (irq_input_low(sel0 & 0xFF, (sel1 >> 10) & 0x3F, sel1 & 0x3FF, sel2 & 0xFF))
+        {
+            sim.kbd_irqs++;
+            KEYBRD_Handler();
+        }
+    }
+
+    if (nvic_en[WKUP_QUADEC_IRQn] && (periph_regs[(WKUP_CTRL_REG - PERIPH_BASE) / 2] & WKUP_ENABLE_IRQ) && wkup_callback)
+    {
+        const uint16_t *sel = &periph_regs[(WKUP_SELECT_P0_REG - PERIPH_BASE) / 2];
+        const uint16_t *pol = &periph_regs[(WKUP_POL_P0_REG - PERIPH_BASE) / 2];
+
+        if (irq_input_low(sel[0] & pol[0], sel[1] & pol[1], sel[2] & pol[2], sel[3] & pol[3]))
+        {
+            sim.wkup_irqs++;
+            wkup_callback();
+        }
+    }
+}
+
+// one SysTick tick (1 usec)
+static void sim_systick(void)
+{
+    if (!(systick_csr & 1))
+        return;
+
+    if (systick_cvr == 0)
+    {
+        systick_cvr = systick_rvr;                      // reload
+        return;
+    }
+
+    if (--systick_cvr == 0)
+    {
+        systick_csr |= 0x10000;
+        if (systick_csr & 2)
+        {
+            sim.systick_irqs++;
+            SysTick_Handler();
+        }
+    }
+}
+
+// the part of the main loop that handles the keyboard (see app_asynch_trm())
+static void sim_main_loop(void)
+{
+    fsm_scan_update();
+
+    if (current_fsm_state == CONNECTED_ST)
+        app_kbd_prepare_keyreports();
+    sync_key_press_evt = false;
+
+    if (sim.conn_interval_us == 0)
+    {
+        while (kbd_trm_cnt && app_kbd_send_key_report())
+            app_kbd_prepare_keyreports();
+    }
+    else if (sim.time_us >= next_conn_event_us)
+    {
+        int n;
+
+        next_conn_event_us = sim.time_us + sim.conn_interval_us;
+        for (n = 0; (n < sim.tx_per_event) && kbd_trm_cnt; n++)
+        {
+            if (!app_kbd_send_key_report())
+                break;
+            app_kbd_prepare_keyreports();
+        }
+    }
+}
+
+void sim_run_us(uint32_t us)
+{
+    while (us--)
+    {
+        sim.time_us++;
+        sim_systick();
+        sim_check_irqs();
+        sim_main_loop();
+    }
+}
@@ -0,0 +1,77 @@
+/**
+ ****************************************************************************************
+ *
+ * @file sim_kbd.h
+ *
+ * @brief Host simulator of the DA14580 keyboard hardware used by app_kbd.c: a register
+ *        file behind GetWord16()/SetWord16(), the GPIO ports with a key matrix without
+ *        diodes, SysTick, the Keyboard Controller and the Wakeup Timer. The main loop
+ *        of the application (scan FSM and HID report transmission) is emulated as well.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef SIM_KBD_H_
+#define SIM_KBD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SIM_MAX_REPORTS         (4096)
+
+// a pin is (port << 4) | pin, as in kbd_input_ports[]
+#define SIM_PIN(port, pin)      (((port) << 4) | (pin))
+
+struct sim_report
+{
+    uint32_t time_us;           // simulated time when HOGPD got the report
+    uint8_t report_nb;          // NORMAL_REPORT or EXTENDED_REPORT
+    uint8_t len;
+    uint8_t data[8];
+};
+
+struct sim_state
+{
+    uint32_t time_us;           // simulated time
+    uint32_t asserts;           // ASSERT_ERROR() / ASSERT_WARNING() hits
+    uint32_t systick_irqs;
+    uint32_t kbd_irqs;
+    uint32_t wkup_irqs;
+    uint32_t reg_accesses;      // GetWord16/32() and SetWord16/32() calls (bus accesses of the CPU)
+    uint32_t conn_interval_us;  // 0: reports are sent as soon as they are prepared
+    uint8_t tx_per_event;       // reports sent per connection event
+    uint32_t report_cnt;
+    struct sim_report reports[SIM_MAX_REPORTS];
+};
+
+extern struct sim_state sim;
+
+/**
+ ****************************************************************************************
+ * @brief Resets the simulated hardware and the report log. The caller initializes the
+ *        application (app_keyboard_init() etc.) afterwards.
+ ****************************************************************************************
+ */
+void sim_reset(void);
+
+/**
+ ****************************************************************************************
+ * @brief Closes or opens the switch between two pins
+ *
+ * @param[in] row_pin   The pin of the output
+ * @param[in] col_pin   The pin of the input
+ * @param[in] pressed   true to close the switch
+ ****************************************************************************************
+ */
+void sim_switch(uint8_t row_pin, uint8_t col_pin, bool pressed);
+
+/**
+ ****************************************************************************************
+ * @brief Runs the simulated system (interrupts and main loop) for the given time
+ *
+ * @param[in] us    Time to run in usec
+ ****************************************************************************************
+ */
+void sim_run_us(uint32_t us);
+
+#endif // SIM_KBD_H_
@@ -0,0 +1,83 @@
+/**
+ ****************************************************************************************
+ *
+ * @file sim_matrix.h
+ *
+ * @brief Key matrix helpers of the simulator tests. Included after app_kbd.c, so the
+ *        pin tables and the keymap of the MATRIX_SETUP being built are visible.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef SIM_MATRIX_H_
+#define SIM_MATRIX_H_
+
+#include "sim_kbd.h"
+
+#define CHECK(x)    do { if (!(x)) { printf("%s:%d: CHECK(%s)\n", __FILE__, __LINE__, #x); fail++; } } while (0)
+
+static int fail;
+
+// the pin of an output, decoded from its mode register (see SET_OUTPUT_MODE_REG())
+static inline uint8_t sim_row_pin(int output)
+{
+    const int off = kbd_output_mode_regs[output] - (P00_MODE_REG - P0_DATA_REG);
+    const int blk = off / 0x20;
+
+    return SIM_PIN((blk == 4) ? 3 : blk, (off % 0x20) / 2);
+}
+
+static inline void sim_key(int output, int input, bool pressed)
+{
+    sim_switch(sim_row_pin(output), kbd_input_ports[input], pressed);
+}
+
+// a key that is wired and reported as a normal key in the Key Report
+static inline bool sim_is_normal_key(int output, int input)
+{
+    const uint16_t code = kbd_keymap[0][output][input];
+
+    return kbd_out_bitmasks[output] && kbd_input_mode_regs[input] && ((code >> 8) == 0) && ((code & 0xFF) >= 4);
+}
+
+// resets the hardware and the application and leaves the keyboard connected and idle
+static inline void sim_kbd_start(void)
+{
+    sim_reset();
+    app_keyboard_init();
+    app_kbd_start_reporting();
+    sim_run_us(100);
+}
+
+static inline bool sim_report_has(const struct sim_report *rep, uint8_t code)
+{
+    int i;
+
+    for (i = 2; i < 8; i++)
+        if (rep->data[i] == code)
+            return true;
+
+    return false;
+}
+
+// the last Key Report for normal keys, if any, else NULL
+static inline const struct sim_report *sim_last_normal(void)
+{
+    uint32_t n = sim.report_cnt;
+
+    while (n--)
+        if (sim.reports[n].report_nb == NORMAL_REPORT)
+            return &sim.reports[n];
+
+    return NULL;
+}
+
+// the keys held by the Host, i.e. in the last Key Report for normal keys
+static inline bool sim_host_has(int output, int input)
+{
+    const struct sim_report *rep = sim_last_normal();
+
+    return rep && sim_report_has(rep, kbd_keymap[0][output][input] & 0xFF);
+}
+
+#endif // SIM_MATRIX_H_
@@ -0,0 +1,239 @@
+/**
+ ****************************************************************************************
+ *
+ * @file sim_sdk.h
+ *
+ * @brief Host stand-ins for the DA14580 SDK definitions used by app_kbd.c. All the SDK
+ *        headers included by app_kbd.c resolve to stub/<name>.h, which include this file.
+ *        Register accesses go to the register file of sim_kbd.c.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef SIM_SDK_H_
+#define SIM_SDK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef uint8_t  uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+
+/*
+ * Compiler
+ ****************************************************************************************
+ */
+
+#define __forceinline               inline __attribute__((always_inline))
+#define __clz(x)                    ((x) ? __builtin_clz(x) : 32)
+#define __asm(x)                    sim_assert_hit(__FILE__, __LINE__)
+
+#define KBD_TYPE_QUALIFIER          const
+#define KBD_ARRAY_ATTRIBUTE
+
+#define DEVELOPMENT_DEBUG           1
+
+/*
+ * Registers (addresses from datasheet.h)
+ ****************************************************************************************
+ */
+
+#define P0_DATA_REG                 (0x50003000)
+#define P1_DATA_REG                 (0x50003020)
+#define P2_DATA_REG                 (0x50003040)
+#define P3_DATA_REG                 (0x50003080)
+#define P0_RESET_DATA_REG           (0x50003004)
+#define P00_MODE_REG                (0x50003006)
+#define CLK_PER_REG                 (0x50000004)
+#define CLK_CTRL_REG                (0x5000000A)
+#define SYS_STAT_REG                (0x50000014)
+#define WKUP_CTRL_REG               (0x50000100)
+#define WKUP_COMPARE_REG            (0x50000102)
+#define WKUP_RESET_IRQ_REG          (0x50000104)
+#define WKUP_COUNTER_REG            (0x50000106)
+#define WKUP_RESET_CNTR_REG         (0x50000108)
+#define WKUP_SELECT_P0_REG          (0x5000010A)
+#define WKUP_SELECT_P1_REG          (0x5000010C)
+#define WKUP_SELECT_P2_REG          (0x5000010E)
+#define WKUP_SELECT_P3_REG          (0x50000110)
+#define WKUP_POL_P0_REG             (0x50000112)
+#define WKUP_POL_P1_REG             (0x50000114)
+#define WKUP_POL_P2_REG             (0x50000116)
+#define WKUP_POL_P3_REG             (0x50000118)
+#define GPIO_DEBOUNCE_REG           (0x5000140C)
+#define GPIO_RESET_IRQ_REG          (0x5000140E)
+#define KBRD_IRQ_IN_SEL0_REG        (0x50001412)
+#define KBRD_IRQ_IN_SEL1_REG        (0x50001414)
+#define WATCHDOG_REG                (0x50003100)
+#define RESET_FREEZE_REG            (0x50003302)
+
+#define WAKEUPCT_ENABLE             (0x0010)
+#define RUNNING_AT_RC16M            (0x0040)
+#define PER_IS_DOWN                 (0x0004)
+#define FRZ_WDOG                    (0x0008)
+#define WKUP_ENABLE_IRQ             (0x0080)
+
+uint16_t GetWord16(uint32_t addr);
+void SetWord16(uint32_t addr, uint16_t val);
+uint32_t GetWord32(uint32_t addr);
+void SetWord32(uint32_t addr, uint32_t val);
+
+#define GetBits16(a, f)             ((GetWord16(a) & (f)) >> __builtin_ctz(f))
+#define SetBits16(a, f, d)          SetWord16((a), (GetWord16(a) & ~(f)) | (((d) << __builtin_ctz(f)) & (f)))
+
+/*
+ * NVIC / interrupts
+ ****************************************************************************************
+ */
+
+enum { WKUP_QUADEC_IRQn = 9, KEYBRD_IRQn = 17, SysTick_IRQn = -1 };
+
+void NVIC_EnableIRQ(int irq);
+void NVIC_DisableIRQ(int irq);
+void NVIC_ClearPendingIRQ(int irq);
+void NVIC_SetPriority(int irq, int prio);
+
+#define GLOBAL_INT_DISABLE()        do {
+#define GLOBAL_INT_RESTORE()        } while (0)
+
+void sim_assert_hit(const char *file, int line);
+
+/*
+ * Kernel
+ ****************************************************************************************
+ */
+
+typedef uint16_t ke_task_id_t;
+typedef uint16_t ke_msg_id_t;
+typedef uint8_t  ke_state_t;
+
+enum { TASK_APP = 1, TASK_HOGPD = 2 };
+enum { APP_CONNECTABLE, APP_CONNECTED, APP_PARAM_UPD, APP_SECURITY };
+
+enum
+{
+    HOGPD_CREATE_DB_REQ = 0x100,
+    HOGPD_ENABLE_REQ,
+    HOGPD_REPORT_UPD_REQ,
+    HOGPD_BOOT_REPORT_UPD_REQ,
+};
+
+void *ke_msg_alloc(ke_msg_id_t id, ke_task_id_t dest, ke_task_id_t src, uint16_t len);
+void ke_msg_send(void const *param_ptr);
+ke_state_t ke_state_get(ke_task_id_t id);
+
+#define KE_MSG_ALLOC(id, dest, src, param_str) \
+    (struct param_str*) ke_msg_alloc(id, dest, src, sizeof(struct param_str))
+#define KE_MSG_ALLOC_DYN(id, dest, src, param_str, length) \
+    (struct param_str*) ke_msg_alloc(id, dest, src, (sizeof(struct param_str) + length));
+
+/*
+ * GATT / HOGPD
+ ****************************************************************************************
+ */
+
+#define PERM(access, right)         (0)
+#define PRF_CON_NORMAL              (1)
+#define PRF_ERR_OK                  (0)
+#define ATT_ERR_NO_ERROR            (0)
+#define ATT_ERR_ATTRIBUTE_NOT_FOUND (0x0A)
+#define ATT_DECL_PRIMARY_SERVICE    (0x2800)
+#define ATT_CHAR_BATTERY_LEVEL      (0x2A19)
+
+#define HOGPD_NB_HIDS_INST_MAX      (1)
+#define HOGPD_NB_REPORT_INST_MAX    (5)
+#define HOGPD_CFG_KEYBOARD          (0x01)
+#define HOGPD_CFG_PROTO_MODE        (0x04)
+#define HOGPD_CFG_MAP_EXT_REF       (0x08)
+#define HOGPD_CFG_BOOT_KB_WR        (0x10)
+#define HOGPD_CFG_REPORT_IN         (0x01)
+#define HOGPD_CFG_REPORT_OUT        (0x02)
+#define HOGPD_CFG_REPORT_WR         (0x10)
+#define HOGPD_REPORT_NTF_CFG_MASK   (0x20)
+#define HOGPD_BOOT_KB_IN_REPORT_CHAR (1)
+#define HOGP_BOOT_PROTOCOL_MODE     (0)
+#define HOGP_REPORT_PROTOCOL_MODE   (1)
+#define HIDS_REMOTE_WAKE_CAPABLE    (0x01)
+#define HIDS_NORM_CONNECTABLE       (0x02)
+
+struct hogpd_create_db_cfm;
+struct hogpd_disable_ind;
+struct hogpd_ntf_sent_cfm;
+struct hogpd_proto_mode_ind;
+struct hogpd_ntf_cfg_ind;
+struct hogpd_ctnl_pt_ind;
+struct gattc_cmp_evt;
+struct gapm_start_advertise_cmd;
+
+struct att_incl_desc { uint16_t start_hdl; uint16_t end_hdl; uint16_t uuid; };
+struct attm_elmt { uint8_t *value; };
+struct hids_hid_info { uint16_t bcdHID; uint8_t bCountryCode; uint8_t flags; };
+
+struct hogpd_features
+{
+    uint8_t svc_features;
+    uint8_t report_nb;
+    uint8_t report_char_cfg[HOGPD_NB_REPORT_INST_MAX];
+};
+
+struct hogpd_hids_cfg
+{
+    struct hogpd_features features;
+    struct hids_hid_info hid_info;
+    struct att_incl_desc ext_rep_ref;
+    uint16_t ext_rep_ref_uuid;
+};
+
+struct hogpd_hids_ntf_cfg
+{
+    uint16_t boot_kb_in_report_ntf_en;
+    uint16_t boot_mouse_in_report_ntf_en;
+    uint16_t report_ntf_en[HOGPD_NB_REPORT_INST_MAX];
+};
+
+struct hogpd_create_db_req { uint8_t hids_nb; struct hogpd_hids_cfg cfg[HOGPD_NB_HIDS_INST_MAX]; };
+
+struct hogpd_enable_req
+{
+    uint16_t conhdl;
+    uint8_t sec_lvl;
+    uint8_t con_type;
+    struct hogpd_hids_ntf_cfg ntf_cfg[HOGPD_NB_HIDS_INST_MAX];
+};
+
+struct hogpd_report_info
+{
+    uint16_t conhdl;
+    uint8_t hids_nb;
+    uint8_t report_nb;
+    uint16_t report_length;
+    uint8_t report[1];
+};
+
+struct hogpd_boot_report_info
+{
+    uint16_t conhdl;
+    uint8_t hids_nb;
+    uint8_t char_code;
+    uint8_t report_length;
+    uint8_t boot_report[1];
+};
+
+/*
+ * Application
+ ****************************************************************************************
+ */
+
+struct app_env_tag { uint16_t conhdl; uint8_t conidx; };
+extern struct app_env_tag app_env;
+
+#define HAS_MULTI_BOND              0
+
+void wkupct_register_callback(void (*callback)(void));
+void periph_init(void);
+void app_alt_pair_clear_all_bond_data(void);
+
+#endif // SIM_SDK_H_
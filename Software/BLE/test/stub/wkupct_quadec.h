@@ -0,0 +1,4 @@
+#ifndef SIM_WKUPCT_QUADEC_H
+#define SIM_WKUPCT_QUADEC_H
+#include "sim_sdk.h"
+#endif
@@ -0,0 +1,338 @@
+/**
+ ****************************************************************************************
+ *
+ * @file test_debounce.c
+ *
+ * @brief Debouncing: debounce_key(), kbd_update_bounce_counters() and kbd_update_scan_mode()
+ *        must behave like the per key PRESS_DEBOUNCING / WAIT_RELEASE / RELEASE_DEBOUNCING
+ *        state machine with a counter for every key, for any number of keys. A chord of more keys than the
+ *        former 16 debounce entries must be recorded and released on the simulated matrix.
+ *
+ ****************************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "app_kbd.c"
+#include "sim_matrix.h"
+
+#define RANDOM_SCANS        (20000)
+#define TOGGLE_ONE_IN       (40)        // a key changes state once every 40 scans on average
+#define MAX_BOUNCE_SCANS    (6)
+#define SETTLE_US           (100000)
+
+/*
+ * Reference model: one state and one counter per key
+ ****************************************************************************************
+ */
+
+struct ref_key
+{
+    enum DEBOUNCE_STATE state;
+    uint8_t cnt;
+};
+
+static struct ref_key ref[KBD_NR_OUTPUTS][KBD_NR_INPUTS];
+static scan_t ref_new[KBD_NR_OUTPUTS];
+static scan_t ref_scandata[KBD_NR_OUTPUTS];
+
+static int ref_debounce(int output, int input, int pressed)
+{
+    struct ref_key *deb = &ref[output][input];
+    const scan_t imask = 1 << input;
+
+    if (kbd_keymap[0][output][input] == 0)
+        return 0;
+
+    switch (deb->state)
+    {
+        case IDLE:
+            if (!pressed)
+                return 0;
+            deb->state = PRESS_DEBOUNCING;
+            deb->cnt = DEBOUNCE_COUNTER_PRESS;
+            ref_new[output] |= imask;
+            return 0;
+        case PRESS_DEBOUNCING:
+            if (deb->cnt)
+            {
+                ref_new[output] |= imask;
+                return 0;
+            }
+            if (!pressed)
+            {
+                deb->state = IDLE;
+                return 0;
+            }
+            deb->state = WAIT_RELEASE;
+            return 1;
+        case WAIT_RELEASE:
+            if (!pressed)
+            {
+                deb->state = RELEASE_DEBOUNCING;
+                deb->cnt = DEBOUNCE_COUNTER_RELEASE;
+                ref_new[output] &= ~imask;
+                return 0;
+            }
+            return (ref_scandata[output] & imask) ? 1 : 0;
+        case RELEASE_DEBOUNCING:
+            if (deb->cnt)
+            {
+                ref_new[output] &= ~imask;
+                return 0;
+            }
+            if (pressed)
+            {
+                deb->state = WAIT_RELEASE;
+                return 0;
+            }
+            deb->state = IDLE;
+            return (ref_scandata[output] & imask) ? 0 : 1;
+    }
+
+    return 0;
+}
+
+static void ref_charge(uint8_t step)
+{
+    int i, j;
+
+    for (i = 0; i < KBD_NR_OUTPUTS; i++)
+        for (j = 0; j < KBD_NR_INPUTS; j++)
+            ref[i][j].cnt = (ref[i][j].cnt > step) ? (ref[i][j].cnt - step) : 0;
+}
+
+static void ref_scan_mode(uint8_t *active, enum SCAN_MODE *next_mode)
+{
+    int i, j;
+
+    *active = 0;
+    *next_mode = SCAN_MODE_HOLD;
+
+    for (i = 0; i < KBD_NR_OUTPUTS; i++)
+        for (j = 0; j < KBD_NR_INPUTS; j++)
+        {
+            if (ref[i][j].state != IDLE)
+                *active = 1;
+            if (ref[i][j].state == PRESS_DEBOUNCING)
+                *next_mode = SCAN_MODE_FAST;
+            else if ( (ref[i][j].state == RELEASE_DEBOUNCING) && (*next_mode != SCAN_MODE_FAST) )
+                *next_mode = SCAN_MODE_NORMAL;
+        }
+}
+
+static scan_t ref_not_idle(int output)
+{
+    scan_t mask = 0;
+    int j;
+
+    for (j = 0; j < KBD_NR_INPUTS; j++)
+        if (ref[output][j].state != IDLE)
+            mask |= 1 << j;
+
+    return mask;
+}
+
+static enum DEBOUNCE_STATE kbd_state(int output, int input)
+{
+    const scan_t imask = 1 << input;
+
+    if (kbd_bounce_press[output] & imask)
+        return PRESS_DEBOUNCING;
+    if (kbd_bounce_release[output] & imask)
+        return RELEASE_DEBOUNCING;
+    if (kbd_bounce_rows[output] & imask)
+        return WAIT_RELEASE;
+    return IDLE;
+}
+
+/*
+ * Equivalence on random bouncy key sequences
+ ****************************************************************************************
+ */
+
+static void test_equivalence(void)
+{
+    static bool down[KBD_NR_OUTPUTS][KBD_NR_INPUTS];
+    static uint8_t bounce[KBD_NR_OUTPUTS][KBD_NR_INPUTS];
+    int n, i, j, busiest = 0, mismatches = 0;
+
+    srand(1);
+    kbd_init_scan_vars();
+    memset(ref, 0, sizeof(ref));
+    for (i = 0; i < KBD_NR_OUTPUTS; i++)
+        ref_scandata[i] = kbd_scandata[i];
+
+    for (n = 0; n < RANDOM_SCANS; n++)
+    {
+        const uint8_t step = 1 + rand() % 8;
+        uint8_t ref_active;
+        enum SCAN_MODE ref_mode;
+        int busy = 0;
+
+        // raw scan words ('0' is pressed), bouncing for a few scans after each change
+        for (i = 0; i < KBD_NR_OUTPUTS; i++)
+        {
+            scan_t raw = (1 << KBD_NR_INPUTS) - 1;
+
+            for (j = 0; j < KBD_NR_INPUTS; j++)
+            {
+                if ((rand() % TOGGLE_ONE_IN) == 0)
+                {
+                    down[i][j] = !down[i][j];
+                    bounce[i][j] = rand() % (MAX_BOUNCE_SCANS + 1);
+                }
+                if (bounce[i][j] ? (rand() & 1) : down[i][j])
+                    raw &= ~(1 << j);
+                if (bounce[i][j])
+                    bounce[i][j]--;
+            }
+            kbd_new_scandata[i] = raw;
+            ref_new[i] = raw;
+        }
+
+        // the time since the last scan is charged before the scan results are processed
+        kbd_update_bounce_counters(step);
+        ref_charge(step);
+
+        // same calls as kbd_process_scandata(): rows in order, keys from the highest bit
+        for (i = 0; i < KBD_NR_OUTPUTS; i++)
+        {
+            scan_t status, xorword;
+
+            if (!kbd_out_bitmasks[i])
+                continue;
+
+            status = kbd_new_scandata[i];
+            xorword = (kbd_scandata[i] ^ kbd_new_scandata[i]) | kbd_bounce_rows[i];
+            if (xorword != ((ref_scandata[i] ^ ref_new[i]) | ref_not_idle(i)))
+                mismatches++;
+
+            while (xorword)
+            {
+                const int bit = 31 - __clz(xorword);
+                const scan_t mask = 1 << bit;
+                const int press = !(status & mask);
+                const int ret = debounce_key(i, bit, press);
+
+                if (ret != ref_debounce(i, bit, press))
+                    mismatches++;
+
+                // a key accepted by debouncing may still be rejected by deghosting or backpressure
+                if (!ret || ((rand() % 8) == 0))
+                    status = (status & ~mask) | (kbd_scandata[i] & mask);
+                xorword &= ~mask;
+            }
+            kbd_scandata[i] = status;
+            ref_scandata[i] = status;
+        }
+
+        for (i = 0; i < KBD_NR_OUTPUTS; i++)
+            if (kbd_new_scandata[i] != ref_new[i])
+                mismatches++;
+
+        kbd_update_scan_mode();
+        ref_scan_mode(&ref_active, &ref_mode);
+        if ((kbd_bounce_active != ref_active) || (kbd_scan_next_mode != ref_mode))
+            mismatches++;
+
+        for (i = 0; i < KBD_NR_OUTPUTS; i++)
+            for (j = 0; j < KBD_NR_INPUTS; j++)
+            {
+                if ( (kbd_state(i, j) != ref[i][j].state) || (kbd_bounce_cnt[i][j] != ref[i][j].cnt) )
+                    mismatches++;
+                if (ref[i][j].state != IDLE)
+                    busy++;
+            }
+
+        if (busy > busiest)
+            busiest = busy;
+    }
+
+    CHECK(mismatches == 0);
+    CHECK(busiest > 16);
+    printf("test_debounce: %d scans, up to %d keys debounced or held at once\n", RANDOM_SCANS, busiest);
+}
+
+/*
+ * A chord of more than 16 keys on the simulated matrix
+ ****************************************************************************************
+ */
+
+// a row and a column without the key where they cross: no three keys are on the corners of a
+// square, so no key is held back by deghosting
+static void test_chord(void)
+{
+    int best_row = 0, best_col = 0, best = -1, keys = 0, i, j;
+    int row_keys[KBD_NR_OUTPUTS] = {0}, col_keys[KBD_NR_INPUTS] = {0};
+    uint32_t n;
+
+    for (i = 0; i < KBD_NR_OUTPUTS; i++)
+        for (j = 0; j < KBD_NR_INPUTS; j++)
+            if (sim_is_normal_key(i, j))
+            {
+                row_keys[i]++;
+                col_keys[j]++;
+            }
+
+    for (i = 0; i < KBD_NR_OUTPUTS; i++)
+        for (j = 0; j < KBD_NR_INPUTS; j++)
+        {
+            const int cnt = row_keys[i] + col_keys[j] - (sim_is_normal_key(i, j) ? 2 : 0);
+
+            if (cnt > best)
+            {
+                best = cnt;
+                best_row = i;
+                best_col = j;
+            }
+        }
+
+    sim_kbd_start();
+
+    for (i = 0; i < KBD_NR_OUTPUTS; i++)
+        for (j = 0; j < KBD_NR_INPUTS; j++)
+            if ( ((i == best_row) != (j == best_col)) && sim_is_normal_key(i, j) )
+            {
+                sim_key(i, j, true);
+                keys++;
+            }
+
+    sim_run_us(SETTLE_US);
+
+    CHECK(keys > 16);
+    CHECK(kbd_keys_held == keys);
+    for (i = 0; i < KBD_NR_OUTPUTS; i++)
+        for (j = 0; j < KBD_NR_INPUTS; j++)
+            if ( ((i == best_row) != (j == best_col)) && sim_is_normal_key(i, j) )
+                CHECK(!(kbd_scandata[i] & (1 << j)));
+
+    for (i = 0; i < KBD_NR_OUTPUTS; i++)
+        for (j = 0; j < KBD_NR_INPUTS; j++)
+            if ( ((i == best_row) != (j == best_col)) && sim_is_normal_key(i, j) )
+                sim_key(i, j, false);
+
+    sim_run_us(SETTLE_US);
+
+    CHECK(kbd_keys_held == 0);
+    for (i = 0; i < KBD_NR_OUTPUTS; i++)
+        CHECK(kbd_bounce_rows[i] == 0);
+
+    // all keys are released for the Host
+    CHECK(sim_last_normal() != NULL);
+    if (sim_last_normal())
+        for (n = 2; n < 8; n++)
+            CHECK(sim_last_normal()->data[n] == 0);
+
+    CHECK(sim.asserts == 0);
+    printf("test_debounce: chord of %d keys\n", keys);
+}
+
+int main(void)
+{
+    test_equivalence();
+    test_chord();
+    printf("test_debounce: %s\n", fail ? "FAIL" : "OK");
+    return fail ? EXIT_FAILURE : EXIT_SUCCESS;
+}
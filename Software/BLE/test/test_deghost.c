@@ -0,0 +1,114 @@
+/**
+ ****************************************************************************************
+ *
+ * @file test_deghost.c
+ *
+ * @brief Deghosting on the simulated key matrix: kbd_key_exist[] must match kbd_keymap[0],
+ *        the third key of a square whose fourth corner is a key must be held back (2KRO)
+ *        without the ghost ever being reported, and it must be reported normally when
+ *        the fourth corner is not a key.
+ *
+ ****************************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "app_kbd.c"
+#include "sim_matrix.h"
+
+#define SQUARES_PER_CASE    (24)
+#define SETTLE_US           (60000)
+
+static void test_key_exist(void)
+{
+    int i, j;
+
+    sim_kbd_start();
+
+    for (i = 0; i < KBD_NR_OUTPUTS; i++)
+    {
+        uint32_t exist = 0;
+
+        for (j = 0; j < KBD_NR_INPUTS; j++)
+            if (kbd_keymap[0][i][j] != 0)
+                exist |= 1UL << j;
+
+        CHECK(kbd_key_exist[i] == exist);
+    }
+}
+
+// a = (r1, c1), b = (r1, c2), c = (r2, c1), g = (r2, c2) is the fourth corner
+static void run_square(int r1, int r2, int c1, int c2)
+{
+    const bool g_exists = (kbd_keymap[0][r2][c2] != 0);
+    const uint8_t g_code = kbd_keymap[0][r2][c2] & 0xFF;
+    uint32_t n;
+
+    sim_kbd_start();
+
+    sim_key(r1, c1, true);
+    sim_run_us(SETTLE_US);
+    sim_key(r1, c2, true);
+    sim_run_us(SETTLE_US);
+    sim_key(r2, c1, true);
+    sim_run_us(SETTLE_US);
+
+    CHECK(sim_host_has(r1, c1) && sim_host_has(r1, c2));
+    CHECK(sim_host_has(r2, c1) == !g_exists);
+
+    // b released: the ghost is gone and c is reported in both cases
+    sim_key(r1, c2, false);
+    sim_run_us(SETTLE_US);
+    CHECK(sim_host_has(r1, c1) && !sim_host_has(r1, c2) && sim_host_has(r2, c1));
+
+    sim_key(r1, c1, false);
+    sim_key(r2, c1, false);
+    sim_run_us(SETTLE_US);
+    CHECK(sim_last_normal() && !sim_host_has(r1, c1) && !sim_host_has(r2, c1));
+
+    if (g_exists)
+        for (n = 0; n < sim.report_cnt; n++)
+            if (sim.reports[n].report_nb == NORMAL_REPORT)
+                CHECK(!sim_report_has(&sim.reports[n], g_code));
+
+    CHECK(sim.asserts == 0);
+}
+
+static void test_squares(bool g_exists)
+{
+    int r1, r2, c1, c2, found = 0, seen = 0;
+
+    for (r1 = 0; r1 < KBD_NR_OUTPUTS; r1++)
+    for (r2 = 0; r2 < KBD_NR_OUTPUTS; r2++)
+    for (c1 = 0; c1 < KBD_NR_INPUTS; c1++)
+    for (c2 = 0; c2 < KBD_NR_INPUTS; c2++)
+    {
+        if ( (r1 == r2) || (c1 == c2) || (found == SQUARES_PER_CASE) )
+            continue;
+
+        if (!sim_is_normal_key(r1, c1) || !sim_is_normal_key(r1, c2) || !sim_is_normal_key(r2, c1))
+            continue;
+
+        if (g_exists ? !sim_is_normal_key(r2, c2) : (kbd_keymap[0][r2][c2] != 0))
+            continue;
+
+        // spread the squares over the matrix
+        if ((seen++ % 7) != 0)
+            continue;
+
+        found++;
+        run_square(r1, r2, c1, c2);
+    }
+
+    printf("test_deghost: %d squares with the fourth corner %s\n", found, g_exists ? "wired" : "missing");
+}
+
+int main(void)
+{
+    test_key_exist();
+    test_squares(true);
+    test_squares(false);
+    printf("test_deghost: %s\n", fail ? "FAIL" : "OK");
+    return fail ? EXIT_FAILURE : EXIT_SUCCESS;
+}
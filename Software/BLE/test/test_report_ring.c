@@ -0,0 +1,360 @@
+/**
+ ****************************************************************************************
+ *
+ * @file test_report_ring.c
+ *
+ * @brief Fuzzing of the report ring (report_list, kbd_alloc_report(), kbd_pull_report(),
+ *        kbd_coalesce_reports(), kbd_report_available()). Random key changes are added
+ *        through prepare_normal_report() / prepare_extended_report() and random reports
+ *        are pulled as the HOGPD senders do. After every operation the ring is checked
+ *        against its invariants; after every round the reports pulled by the Host must
+ *        show every key change of the reports that were added, in the same order.
+ *
+ ****************************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "app_kbd.c"
+#include "sim_matrix.h"
+
+#define ROUNDS              (400)
+#define ADDS_PER_ROUND      (200)
+#define MAX_STATES          (ADDS_PER_ROUND + 1)
+#define KEY_FIRST           (0x04)      // normal keys are picked from a few codes so that they repeat
+#define KEY_CODES           (10)
+#define NR_ITEMS            (256 + 8)   // key codes and modifier bits (normal), bits 0-23 (extended)
+
+/*
+ * Model: the reports added and the reports pulled, per report type
+ ****************************************************************************************
+ */
+
+struct seq
+{
+    int cnt;
+    uint8_t state[MAX_STATES][8];
+};
+
+static struct seq added[2], pulled[2];      // [0]: NORMAL_REPORT, [1]: EXTENDED_REPORT
+static uint32_t total_adds, total_pulls, total_full, max_pending;
+
+static int seq_idx(enum REPORT_TYPE char_id)
+{
+    return (char_id == NORMAL_REPORT) ? 0 : 1;
+}
+
+static bool item_in(int idx, const uint8_t *buf, int item)
+{
+    int i;
+
+    if (idx == 1)
+        return (item < 24) && (buf[item / 8] & (1 << (item % 8)));
+
+    if (item >= 256)
+        return (buf[0] & (1 << (item - 256))) != 0;
+
+    for (i = 2; i < 8; i++)
+        if (buf[i] == item)
+            return true;
+
+    return false;
+}
+
+static void seq_push(struct seq *s, const uint8_t *buf, int len)
+{
+    CHECK(s->cnt < MAX_STATES);
+    if (s->cnt == MAX_STATES)
+        return;
+
+    memset(s->state[s->cnt], 0, 8);
+    memcpy(s->state[s->cnt], buf, len);
+    s->cnt++;
+}
+
+// the states an item goes through, without repetitions
+static int item_trace(int idx, const struct seq *s, int item, bool *trace)
+{
+    int n, len = 0;
+
+    for (n = 0; n < s->cnt; n++)
+    {
+        const bool in = item_in(idx, s->state[n], item);
+
+        if ((len == 0) || (trace[len - 1] != in))
+            trace[len++] = in;
+    }
+
+    return len;
+}
+
+// the n-th step of a sequence that presses items, or -1
+static int press_step(int idx, const struct seq *s, int from)
+{
+    int n, item;
+
+    for (n = from; n < s->cnt; n++)
+        for (item = 1; item < NR_ITEMS; item++)
+            if (item_in(idx, s->state[n], item) && !item_in(idx, s->state[n - 1], item))
+                return n;
+
+    return -1;
+}
+
+static bool same_presses(int idx, const uint8_t *a0, const uint8_t *a1, const uint8_t *b0, const uint8_t *b1)
+{
+    int item;
+
+    for (item = 1; item < NR_ITEMS; item++)
+        if ( (item_in(idx, a1, item) && !item_in(idx, a0, item)) != (item_in(idx, b1, item) && !item_in(idx, b0, item)) )
+            return false;
+
+    return true;
+}
+
+// the Host sees every change of every item and the presses in the order they were added
+static void check_round(void)
+{
+    static bool trace_a[MAX_STATES], trace_p[MAX_STATES];
+    int idx, item, na, np;
+
+    for (idx = 0; idx < 2; idx++)
+    {
+        const struct seq *a = &added[idx], *p = &pulled[idx];
+
+        CHECK(memcmp(a->state[a->cnt - 1], p->state[p->cnt - 1], 8) == 0);
+
+        for (item = 1; item < NR_ITEMS; item++)
+        {
+            const int la = item_trace(idx, a, item, trace_a);
+            const int lp = item_trace(idx, p, item, trace_p);
+
+            CHECK((la == lp) && !memcmp(trace_a, trace_p, la * sizeof(bool)));
+        }
+
+        na = press_step(idx, a, 1);
+        np = press_step(idx, p, 1);
+        while ((na > 0) && (np > 0))
+        {
+            CHECK(same_presses(idx, a->state[na - 1], a->state[na], p->state[np - 1], p->state[np]));
+            na = press_step(idx, a, na + 1);
+            np = press_step(idx, p, np + 1);
+        }
+        CHECK((na < 0) && (np < 0));
+    }
+}
+
+/*
+ * Ring invariants
+ ****************************************************************************************
+ */
+
+static bool is_pending(const kbd_rep_info *node)
+{
+    const int slot = node - report_list;
+
+    return ((slot - kbd_trm_head + MAX_REPORTS) % MAX_REPORTS) < kbd_trm_cnt;
+}
+
+static void check_ring(void)
+{
+    kbd_rep_info *newest[2] = { NULL, NULL };
+    int i;
+
+    CHECK(kbd_trm_head < MAX_REPORTS);
+    CHECK(kbd_trm_cnt <= MAX_REPORTS);
+
+    for (i = 0; i < MAX_REPORTS; i++)
+    {
+        // reports are used in place, in their own buffer
+        CHECK(report_list[i].pBuf == kbd_key_report[i]);
+        CHECK((report_list[i].type == FREE) != is_pending(&report_list[i]));
+    }
+
+    for (i = 0; i < kbd_trm_cnt; i++)
+    {
+        kbd_rep_info *node = &report_list[(kbd_trm_head + i) % MAX_REPORTS];
+
+        CHECK((node->char_id == NORMAL_REPORT) || (node->char_id == EXTENDED_REPORT));
+        newest[seq_idx(node->char_id)] = node;
+    }
+
+    CHECK(kbd_last_normal == newest[0]);
+    CHECK(kbd_last_extended == newest[1]);
+    CHECK(get_last_report(NORMAL_REPORT) == newest[0]);
+    CHECK(get_last_report(EXTENDED_REPORT) == newest[1]);
+
+    if (kbd_trm_cnt > max_pending)
+        max_pending = kbd_trm_cnt;
+}
+
+/*
+ * Operations
+ ****************************************************************************************
+ */
+
+static void change_normal(uint8_t *buf)
+{
+    const uint8_t key = KEY_FIRST + rand() % KEY_CODES;
+    int i, free_slot = 0;
+
+    if ((rand() % 8) == 0)
+    {
+        buf[0] ^= 1 << (rand() % 8);
+        return;
+    }
+
+    for (i = 2; i < 8; i++)
+    {
+        if (buf[i] == key)
+        {
+            buf[i] = 0;
+            return;
+        }
+        if ((buf[i] == 0) && !free_slot)
+            free_slot = i;
+    }
+
+    if (free_slot)
+        buf[free_slot] = key;
+    else
+        buf[2 + rand() % 6] = 0;
+}
+
+static void add_report(void)
+{
+    const bool normal = (rand() % 4) != 0;
+    const int idx = normal ? 0 : 1;
+    struct seq *a = &added[idx];
+    kbd_rep_info *p;
+    int i;
+
+    if (a->cnt == MAX_STATES)
+        return;
+
+    if (!kbd_report_available())
+    {
+        total_full++;
+        CHECK(kbd_trm_cnt == MAX_REPORTS);
+        return;
+    }
+
+    if (normal)
+        p = prepare_normal_report(get_last_report(NORMAL_REPORT), PRESS, false);
+    else
+        p = prepare_extended_report(get_last_report(EXTENDED_REPORT));
+    check_ring();
+
+    CHECK(p != NULL);
+    if (p == NULL)
+        return;
+
+    // a new report starts from the last state added
+    CHECK(memcmp(p->pBuf, a->state[a->cnt - 1], p->len) == 0);
+
+    if (normal)
+    {
+        change_normal(p->pBuf);
+        p->type = RELEASE;
+        for (i = 2; i < 8; i++)
+            if (p->pBuf[i] && !item_in(0, a->state[a->cnt - 1], p->pBuf[i]))
+                p->type = PRESS;
+    }
+    else
+        p->pBuf[rand() % 3] ^= 1 << (rand() % 8);
+
+    seq_push(a, p->pBuf, p->len);
+    total_adds++;
+}
+
+// as send_hid_report()
+static bool pull_report(void)
+{
+    kbd_rep_info *p = kbd_pull_report();
+    const uint8_t *prev;
+    int i;
+
+    if (p == NULL)
+    {
+        CHECK(kbd_trm_cnt == 0);
+        return false;
+    }
+
+    CHECK(p->type != FREE);
+    CHECK(!is_pending(p));
+
+    if (p->char_id == NORMAL_REPORT)
+    {
+        // a report that presses keys is a PRESS report, also after merging
+        prev = pulled[0].state[pulled[0].cnt - 1];
+        for (i = 2; i < 8; i++)
+            if (p->pBuf[i] && !item_in(0, prev, p->pBuf[i]))
+                CHECK(p->type == PRESS);
+        memcpy(normal_key_report_st, p->pBuf, 8);
+    }
+    else
+        memcpy(extended_key_report_st, p->pBuf, 3);
+
+    seq_push(&pulled[seq_idx(p->char_id)], p->pBuf, p->len);
+    p->type = FREE;
+    total_pulls++;
+    return true;
+}
+
+static void run_round(int pull_one_in)
+{
+    static const uint8_t no_report[8] = { 0 };
+    int n;
+
+    kbd_init_lists();
+    app_kbd_flush_reports();
+    memset(added, 0, sizeof(added));
+    memset(pulled, 0, sizeof(pulled));
+    for (n = 0; n < 2; n++)
+    {
+        seq_push(&added[n], no_report, 8);
+        seq_push(&pulled[n], no_report, 8);
+    }
+    check_ring();
+
+    for (n = 0; n < ADDS_PER_ROUND; n++)
+    {
+        add_report();
+        while ((rand() % pull_one_in) == 0)
+        {
+            if (!pull_report())
+                break;
+            check_ring();
+        }
+    }
+
+    while (pull_report())
+        check_ring();
+
+    check_round();
+}
+
+int main(void)
+{
+    int r;
+
+    srand(1);
+    sim_reset();
+    kbd_scan_stats.reports_coalesced = 0;
+
+    // from a ring that is seldom full to one that is full most of the time
+    for (r = 0; r < ROUNDS; r++)
+        run_round(1 + r % 16);
+
+    CHECK(kbd_scan_stats.reports_coalesced > 0);
+    CHECK(total_adds == total_pulls + kbd_scan_stats.reports_coalesced);
+    CHECK(total_full > 0);
+    CHECK(max_pending == MAX_REPORTS);
+    CHECK(sim.asserts == 0);
+
+    printf("test_report_ring: %u reports added, %u pulled, %u coalesced, %u times full\n",
+           total_adds, total_pulls, kbd_scan_stats.reports_coalesced, total_full);
+    printf("test_report_ring: %s\n", fail ? "FAIL" : "OK");
+    return fail ? EXIT_FAILURE : EXIT_SUCCESS;
+}
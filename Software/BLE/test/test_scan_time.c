@@ -0,0 +1,131 @@
+/**
+ ****************************************************************************************
+ *
+ * @file test_scan_time.c
+ *
+ * @brief Adaptive scan times (built with ADAPTIVE_SCAN_TIMES_ON and SCAN_STATS_ON): the
+ *        debouncing counters and mode_dwell_ms are charged with the time that has passed,
+ *        also when a new key cuts a HOLD cycle short (early restart in KEYBRD_Handler()).
+ *
+ ****************************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "app_kbd.c"
+#include "sim_matrix.h"
+
+#define CUT_AFTER_US        (2000)      // a new key this long after the processing of a HOLD cycle
+#define TIMEOUT_US          (100000)
+
+static uint32_t dwell_total(void)
+{
+    return kbd_scan_stats.mode_dwell_ms[SCAN_MODE_FAST] + kbd_scan_stats.mode_dwell_ms[SCAN_MODE_NORMAL]
+           + kbd_scan_stats.mode_dwell_ms[SCAN_MODE_HOLD];
+}
+
+// runs until the given mode has one more processed scan cycle
+static void run_to_scan(enum SCAN_MODE mode)
+{
+    const uint32_t scans = kbd_scan_stats.mode_scans[mode];
+    uint32_t us = TIMEOUT_US;
+
+    while (us-- && (kbd_scan_stats.mode_scans[mode] == scans))
+        sim_run_us(1);
+
+    CHECK(kbd_scan_stats.mode_scans[mode] != scans);
+}
+
+static uint32_t report_time(uint8_t code)
+{
+    uint32_t n;
+
+    for (n = 0; n < sim.report_cnt; n++)
+        if ( (sim.reports[n].report_nb == NORMAL_REPORT) && sim_report_has(&sim.reports[n], code) )
+            return sim.reports[n].time_us;
+
+    return 0;
+}
+
+static void test_hold_cut(void)
+{
+    int a_out = -1, a_in = 0, b_out = -1, b_in = 0, i, j;
+    uint32_t hold_dwell, dwell, start, pressed_at, reported_at;
+
+    // two normal keys in different rows (pins) and columns
+    for (i = 0; i < KBD_NR_OUTPUTS; i++)
+        for (j = 0; j < KBD_NR_INPUTS; j++)
+            if (sim_is_normal_key(i, j))
+            {
+                if (a_out < 0)
+                {
+                    a_out = i;
+                    a_in = j;
+                }
+                else if ( (b_out < 0) && (sim_row_pin(i) != sim_row_pin(a_out)) && (j != a_in) )
+                {
+                    b_out = i;
+                    b_in = j;
+                }
+            }
+
+    CHECK((a_out >= 0) && (b_out >= 0));
+    if ((a_out < 0) || (b_out < 0))
+        return;
+
+    sim_kbd_start();
+    sim_key(a_out, a_in, true);
+
+    // 'a' is stable: held keys are scanned slowly
+    run_to_scan(SCAN_MODE_HOLD);
+    run_to_scan(SCAN_MODE_HOLD);
+    CHECK(sim_host_has(a_out, a_in));
+
+    // a HOLD cycle lasts about HOLD_SCAN_IN_MS and it is charged as it was measured
+    dwell = dwell_total();
+    start = sim.time_us;
+    run_to_scan(SCAN_MODE_HOLD);
+    CHECK(sim.time_us - start <= HOLD_SCAN_IN_MS * 1000);
+    CHECK(sim.time_us - start + 2 * ROW_SCAN_TIME >= HOLD_SCAN_IN_MS * 1000);
+    CHECK(dwell_total() - dwell + 1 >= (sim.time_us - start) / 1000);
+    CHECK(dwell_total() - dwell <= (sim.time_us - start) / 1000 + 1);
+
+    // 'b' cuts this HOLD cycle short: only the time until the restart is charged
+    hold_dwell = kbd_scan_stats.mode_dwell_ms[SCAN_MODE_HOLD];
+    sim_run_us(CUT_AFTER_US);
+    sim_key(b_out, b_in, true);
+    pressed_at = sim.time_us;
+    run_to_scan(SCAN_MODE_FAST);
+
+    dwell = kbd_scan_stats.mode_dwell_ms[SCAN_MODE_HOLD] - hold_dwell;
+    CHECK(dwell < HOLD_SCAN_IN_MS);
+    CHECK(dwell * 1000 + 500 >= CUT_AFTER_US + ROW_SCAN_TIME);
+
+    // 'b' is reported after DEBOUNCE_COUNTER_P_IN_MS, not earlier
+    sim_run_us(TIMEOUT_US);
+    reported_at = report_time(kbd_keymap[0][b_out][b_in] & 0xFF);
+    CHECK(reported_at >= pressed_at + DEBOUNCE_COUNTER_P_IN_MS * 1000);
+    CHECK(reported_at <= pressed_at + (DEBOUNCE_COUNTER_P_IN_MS + 2 * FAST_SCAN_IN_MS) * 1000);
+
+    // the dwell time follows the simulated time while scanning
+    dwell = dwell_total();
+    start = sim.time_us;
+    sim_run_us(TIMEOUT_US);
+    dwell = dwell_total() - dwell;
+    CHECK(dwell * 1000 + HOLD_SCAN_IN_MS * 1000 >= sim.time_us - start);
+    CHECK(dwell * 1000 <= sim.time_us - start + HOLD_SCAN_IN_MS * 1000);
+
+    sim_key(a_out, a_in, false);
+    sim_key(b_out, b_in, false);
+    sim_run_us(TIMEOUT_US);
+    CHECK(sim_last_normal() && !sim_host_has(a_out, a_in) && !sim_host_has(b_out, b_in));
+    CHECK(sim.asserts == 0);
+}
+
+int main(void)
+{
+    test_hold_cut();
+    printf("test_scan_time: %s\n", fail ? "FAIL" : "OK");
+    return fail ? EXIT_FAILURE : EXIT_SUCCESS;
+}
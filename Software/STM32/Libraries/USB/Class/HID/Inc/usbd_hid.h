@@ -50,21 +50,51 @@
   * @{
   */ 
 #define HID_EPIN_ADDR                 0x81
-#define HID_EPIN_SIZE                 0x08
+#define HID_EPIN_SIZE                 0x20
 #define HID_EPOUT_ADDR                 0x01
-#define HID_EPOUT_SIZE                 0x01
+#define HID_EPOUT_SIZE                 0x02
 
 #define USB_HID_CONFIG_DESC_SIZ       41
 #define USB_HID_DESC_SIZ              9
 //#define HID_MOUSE_REPORT_DESC_SIZE    74
-#define HID_KEYBOARD_REPORT_DESC_SIZE    65
+#define HID_KEYBOARD_REPORT_DESC_SIZE    (61 + 79 + 27 + 23)
+
+/* Boot protocol: 8 byte 6KRO report without report ID
+   Report protocol: report ID + modifiers + 128 bit usage bitmap (NKRO) */
+#define HID_BOOT_REPORT_LEN           8
+#define HID_NKRO_REPORT_ID            0x01
+#define HID_NKRO_KEY_MAX              128
+#define HID_NKRO_REPORT_LEN           (2 + HID_NKRO_KEY_MAX / 8)
+
+/* Report protocol only: consumer control (report ID + 21 bit usage bitmap,
+   same layout as the BLE report map) and system control (report ID + 3 bits) */
+#define HID_CONSUMER_REPORT_ID        0x03
+#define HID_CONSUMER_REPORT_LEN       4
+#define HID_SYSTEM_REPORT_ID          0x04
+#define HID_SYSTEM_REPORT_LEN         2
+
+/* Vendor feature report for keymap editing, see user_keymap.h */
+#define HID_FEATURE_REPORT_ID         0x05
+#define HID_FEATURE_REPORT_LEN        32
+#define HID_REPORT_TYPE_FEATURE       0x03
+
+#define HID_PROTOCOL_BOOT             0x00
+#define HID_PROTOCOL_REPORT           0x01
 
 
 #define HID_DESCRIPTOR_TYPE           0x21
 #define HID_REPORT_DESC               0x22
 
+/* 1: low latency mode, bInterval = 1ms and key scan aligned to USB SOF
+   0: bInterval = 10ms, key scan driven by TMR_KEY_SCAN */
+#define HID_LOW_LATENCY                1
+
 #define HID_HS_BINTERVAL               0x07
+#if HID_LOW_LATENCY == 1
+#define HID_FS_BINTERVAL               0x01
+#else
 #define HID_FS_BINTERVAL               0x0A
+#endif
 #define HID_POLLING_INTERVAL           0x0A
 
 #define HID_REQ_SET_PROTOCOL          0x0B
@@ -132,6 +162,8 @@ uint8_t USBD_HID_SendReport (USBD_HandleTypeDef *pdev,
 
 uint32_t USBD_HID_GetPollingInterval (USBD_HandleTypeDef *pdev);
 
+uint8_t USBD_HID_GetProtocol (USBD_HandleTypeDef *pdev);
+
 /**
   * @}
   */ 
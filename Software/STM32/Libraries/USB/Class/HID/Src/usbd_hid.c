@@ -53,7 +53,9 @@
 #include "bsp.h"
 extern PCD_HandleTypeDef hpcd;
 
-static uint8_t rx_buf;
+static uint8_t rx_buf[HID_EPOUT_SIZE];
+static uint8_t feature_buf[HID_FEATURE_REPORT_LEN];
+static uint8_t feature_len = 0;    /* SET_REPORT(Feature) data stage pending */
 
 
 /** @addtogroup STM32_USB_DEVICE_LIBRARY
@@ -113,6 +115,10 @@ static uint8_t  *USBD_HID_GetDeviceQualifierDesc (uint16_t *length);
 
 static uint8_t  USBD_HID_DataIn (USBD_HandleTypeDef *pdev, uint8_t epnum);
 static uint8_t USBD_HID_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum);
+static uint8_t USBD_HID_EP0_RxReady(USBD_HandleTypeDef *pdev);
+#if HID_LOW_LATENCY == 1
+static uint8_t USBD_HID_SOF(USBD_HandleTypeDef *pdev);
+#endif
 /**
   * @}
   */ 
@@ -127,10 +133,14 @@ USBD_ClassTypeDef  USBD_HID =
   USBD_HID_DeInit,
   USBD_HID_Setup,
   NULL, /*EP0_TxSent*/  
-  NULL, /*EP0_RxReady*/
+  USBD_HID_EP0_RxReady, /*EP0_RxReady*/
   USBD_HID_DataIn, /*DataIn*/
   USBD_HID_DataOut, /*DataOut*/
+#if HID_LOW_LATENCY == 1
+  USBD_HID_SOF, /*SOF */
+#else
   NULL, /*SOF */
+#endif
   NULL,
   NULL,      
   USBD_HID_GetCfgDesc,
@@ -185,7 +195,7 @@ __ALIGN_BEGIN static uint8_t USBD_HID_CfgDesc[USB_HID_CONFIG_DESC_SIZ]  __ALIGN_
   0x03,          /*bmAttributes: Interrupt endpoint*/
   HID_EPIN_SIZE, /*wMaxPacketSize: 4 Byte max */
   0x00,
-  HID_FS_BINTERVAL,          /*bInterval: Polling Interval (10 ms)*/
+  HID_FS_BINTERVAL,          /*bInterval: Polling Interval (1 or 10 ms)*/
   /* 34 */
 	0x07,          /*bLength: Endpoint Descriptor size*/
   USB_DESC_TYPE_ENDPOINT, /*bDescriptorType:*/
@@ -194,7 +204,7 @@ __ALIGN_BEGIN static uint8_t USBD_HID_CfgDesc[USB_HID_CONFIG_DESC_SIZ]  __ALIGN_
   0x03,          /*bmAttributes: Interrupt endpoint*/
   HID_EPOUT_SIZE, /*wMaxPacketSize: 4 Byte max */
   0x00,
-  HID_FS_BINTERVAL,          /*bInterval: Polling Interval (10 ms)*/
+  HID_FS_BINTERVAL,          /*bInterval: Polling Interval (1 or 10 ms)*/
  
 } ;
 
@@ -233,6 +243,7 @@ __ALIGN_BEGIN static uint8_t HID_KEYBOARD_ReportDesc[HID_KEYBOARD_REPORT_DESC_SI
     0x05, 0x01,                    // USAGE_PAGE (Generic Desktop)
     0x09, 0x06,                    // USAGE_PAGE (Keyboard)
     0xa1, 0x01,                    // COLLECTION (Application)
+    0x85, HID_NKRO_REPORT_ID,      //   REPORT_ID (1)
     0x05, 0x07,                    //   USAGE_PAGE (Keyboard)
     0x19, 0xe0,                    //   USAGE_MINIMUM (Keyboard LeftControl)
     0x29, 0xe7,                    //   USAGE_MAXIMUM (Keyboard Right GUI)
@@ -241,16 +252,13 @@ __ALIGN_BEGIN static uint8_t HID_KEYBOARD_ReportDesc[HID_KEYBOARD_REPORT_DESC_SI
     0x75, 0x01,                    //   REPORT_SIZE (1)
     0x95, 0x08,                    //   REPORT_COUNT (8)
     0x81, 0x02,                    //   INPUT (Data,Var,Abs)
-    0x75, 0x08,                    //   REPORT_SIZE (8)
-    0x95, 0x01,                    //   REPORT_COUNT (1)
-    0x81, 0x01,                    //   INPUT (Cnst,Ary,Abs)
     0x19, 0x00,                    //   USAGE_MINIMUM (Reserved (no event indicated))
-    0x29, 0x65,                    //   USAGE_MAXIMUM (Keyboard Application)
+    0x29, HID_NKRO_KEY_MAX - 1,    //   USAGE_MAXIMUM (127)
     0x15, 0x00,                    //   LOGICAL_MINIMUM (0)
-    0x25, 0x65,                    //   LOGICAL_MAXIMUM (101)
-    0x75, 0x08,                    //   REPORT_SIZE (8)
-    0x95, 0x06,                    //   REPORT_COUNT (6)
-    0x81, 0x00,                    //   INPUT (Data,Ary,Abs)
+    0x25, 0x01,                    //   LOGICAL_MAXIMUM (1)
+    0x75, 0x01,                    //   REPORT_SIZE (1)
+    0x95, HID_NKRO_KEY_MAX,        //   REPORT_COUNT (128)
+    0x81, 0x02,                    //   INPUT (Data,Var,Abs)
     0x05, 0x08,                    //   USAGE_PAGE (LEDs)
     0x19, 0x01,                    //   USAGE_MINIMUM (Num Lock)
     0x29, 0x03,                    //   USAGE_MAXIMUM (Scroll Lock)
@@ -262,6 +270,66 @@ __ALIGN_BEGIN static uint8_t HID_KEYBOARD_ReportDesc[HID_KEYBOARD_REPORT_DESC_SI
     0x75, 0x05,                    //   REPORT_SIZE (5)
     0x95, 0x01,                    //   REPORT_COUNT (1)
     0x91, 0x03,                    //   OUTPUT (Cnst,Var,Abs)
+    0xc0,                          // END_COLLECTION
+    0x05, 0x0c,                    // USAGE_PAGE (Consumer Devices)
+    0x09, 0x01,                    // USAGE (Consumer Control)
+    0xa1, 0x01,                    // COLLECTION (Application)
+    0x85, HID_CONSUMER_REPORT_ID,  //   REPORT_ID (3)
+    0x15, 0x00,                    //   LOGICAL_MINIMUM (0)
+    0x25, 0x01,                    //   LOGICAL_MAXIMUM (1)
+    0x75, 0x01,                    //   REPORT_SIZE (1)
+    0x95, 0x08,                    //   REPORT_COUNT (8)
+    0x09, 0xb5,                    //   USAGE (Scan Next Track)
+    0x09, 0xb6,                    //   USAGE (Scan Previous Track)
+    0x09, 0xb7,                    //   USAGE (Stop)
+    0x09, 0xb8,                    //   USAGE (Eject)
+    0x09, 0xcd,                    //   USAGE (Play/Pause)
+    0x09, 0xe2,                    //   USAGE (Mute)
+    0x09, 0xe9,                    //   USAGE (Volume Increment)
+    0x09, 0xea,                    //   USAGE (Volume Decrement)
+    0x81, 0x02,                    //   INPUT (Data,Var,Abs)
+    0x0a, 0x83, 0x01,              //   USAGE (AL Consumer Control Configuration)
+    0x0a, 0x8a, 0x01,              //   USAGE (AL Email Reader)
+    0x0a, 0x92, 0x01,              //   USAGE (AL Calculator)
+    0x0a, 0x94, 0x01,              //   USAGE (AL Local Machine Browser)
+    0x0a, 0x21, 0x02,              //   USAGE (AC Search)
+    0x1a, 0x23, 0x02,              //   USAGE_MINIMUM (AC Home)
+    0x2a, 0x25, 0x02,              //   USAGE_MAXIMUM (AC Forward)
+    0x81, 0x02,                    //   INPUT (Data,Var,Abs)
+    0x0a, 0x26, 0x02,              //   USAGE (AC Stop)
+    0x0a, 0x27, 0x02,              //   USAGE (AC Refresh)
+    0x0a, 0x2a, 0x02,              //   USAGE (AC Bookmarks)
+    0x09, 0x6f,                    //   USAGE (Display Brightness Increment)
+    0x09, 0x70,                    //   USAGE (Display Brightness Decrement)
+    0x95, 0x05,                    //   REPORT_COUNT (5)
+    0x81, 0x02,                    //   INPUT (Data,Var,Abs)
+    0x95, 0x03,                    //   REPORT_COUNT (3)
+    0x81, 0x01,                    //   INPUT (Cnst,Ary,Abs)
+    0xc0,                          // END_COLLECTION
+    0x05, 0x01,                    // USAGE_PAGE (Generic Desktop)
+    0x09, 0x80,                    // USAGE (System Control)
+    0xa1, 0x01,                    // COLLECTION (Application)
+    0x85, HID_SYSTEM_REPORT_ID,    //   REPORT_ID (4)
+    0x19, 0x81,                    //   USAGE_MINIMUM (System Power Down)
+    0x29, 0x83,                    //   USAGE_MAXIMUM (System Wake Up)
+    0x15, 0x00,                    //   LOGICAL_MINIMUM (0)
+    0x25, 0x01,                    //   LOGICAL_MAXIMUM (1)
+    0x75, 0x01,                    //   REPORT_SIZE (1)
+    0x95, 0x03,                    //   REPORT_COUNT (3)
+    0x81, 0x02,                    //   INPUT (Data,Var,Abs)
+    0x95, 0x05,                    //   REPORT_COUNT (5)
+    0x81, 0x01,                    //   INPUT (Cnst,Ary,Abs)
+    0xc0,                          // END_COLLECTION
+    0x06, 0x00, 0xff,              // USAGE_PAGE (Vendor Defined 0xFF00)
+    0x09, 0x01,                    // USAGE (Vendor Usage 1)
+    0xa1, 0x01,                    // COLLECTION (Application)
+    0x85, HID_FEATURE_REPORT_ID,   //   REPORT_ID (5)
+    0x09, 0x02,                    //   USAGE (Vendor Usage 2)
+    0x15, 0x00,                    //   LOGICAL_MINIMUM (0)
+    0x26, 0xff, 0x00,              //   LOGICAL_MAXIMUM (255)
+    0x75, 0x08,                    //   REPORT_SIZE (8)
+    0x95, HID_FEATURE_REPORT_LEN - 1, //   REPORT_COUNT (31)
+    0xb1, 0x02,                    //   FEATURE (Data,Var,Abs)
     0xc0                           // END_COLLECTION
 }; 
 
@@ -298,7 +366,7 @@ static uint8_t  USBD_HID_Init (USBD_HandleTypeDef *pdev,
   
   pdev->pClassData = USBD_malloc(sizeof (USBD_HID_HandleTypeDef));
      //set EP_OUT 1 prepared to received the data
-    USBD_LL_PrepareReceive(pdev, HID_EPOUT_ADDR, &rx_buf, 1);
+    USBD_LL_PrepareReceive(pdev, HID_EPOUT_ADDR, rx_buf, HID_EPOUT_SIZE);
   if(pdev->pClassData == NULL)
   {
     ret = 1; 
@@ -306,7 +374,10 @@ static uint8_t  USBD_HID_Init (USBD_HandleTypeDef *pdev,
   else
   {
     ((USBD_HID_HandleTypeDef *)pdev->pClassData)->state = HID_IDLE;
+    /* Devices come up in report protocol (NKRO) after enumeration */
+    ((USBD_HID_HandleTypeDef *)pdev->pClassData)->Protocol = HID_PROTOCOL_REPORT;
   }
+  Report_Queue_Init();
   return ret;
 }
 
@@ -359,7 +430,13 @@ static uint8_t  USBD_HID_Setup (USBD_HandleTypeDef *pdev,
       
       
     case HID_REQ_SET_PROTOCOL:
-      hhid->Protocol = (uint8_t)(req->wValue);
+      if(hhid->Protocol != (uint8_t)(req->wValue))
+      {
+        hhid->Protocol = (uint8_t)(req->wValue);
+        /* Queued reports use the old format, drop them. Keyboard_Task
+           resends the current key state in the new format */
+        Report_Queue_Init();
+      }
       break;
       
     case HID_REQ_GET_PROTOCOL:
@@ -378,6 +455,29 @@ static uint8_t  USBD_HID_Setup (USBD_HandleTypeDef *pdev,
                         1);        
       break;      
       
+    case HID_REQ_SET_REPORT:
+      /* Only the keymap feature report is written over EP0 */
+      if((req->wValue != ((HID_REPORT_TYPE_FEATURE << 8) | HID_FEATURE_REPORT_ID)) || (req->wLength == 0))
+      {
+        USBD_CtlError (pdev, req);
+        return USBD_FAIL;
+      }
+      feature_len = MIN(HID_FEATURE_REPORT_LEN, req->wLength);
+      USBD_CtlPrepareRx (pdev, feature_buf, feature_len);
+      break;
+      
+    case HID_REQ_GET_REPORT:
+      if(req->wValue != ((HID_REPORT_TYPE_FEATURE << 8) | HID_FEATURE_REPORT_ID))
+      {
+        USBD_CtlError (pdev, req);
+        return USBD_FAIL;
+      }
+      len = Keymap_Feature_Get(feature_buf);
+      USBD_CtlSendData (pdev, 
+                        feature_buf,
+                        MIN(len, req->wLength));
+      break;
+      
     default:
       USBD_CtlError (pdev, req);
       return USBD_FAIL; 
@@ -424,7 +524,9 @@ static uint8_t  USBD_HID_Setup (USBD_HandleTypeDef *pdev,
   *         Send HID Report
   * @param  pdev: device instance
   * @param  buff: pointer to report
-  * @retval status
+  * @retval USBD_OK: report handed to the endpoint
+  *         USBD_BUSY: previous report not yet sent
+  *         USBD_FAIL: device not configured
   */
 uint8_t USBD_HID_SendReport     (USBD_HandleTypeDef  *pdev, 
                                  uint8_t *report,
@@ -442,6 +544,15 @@ uint8_t USBD_HID_SendReport     (USBD_HandleTypeDef  *pdev,
                         report,
                         len);
     }
+    else
+    {
+      /* Endpoint still busy, caller keeps the report queued until DataIn */
+      return USBD_BUSY;
+    }
+  }
+  else
+  {
+    return USBD_FAIL;
   }
   return USBD_OK;
 }
@@ -474,6 +585,23 @@ uint32_t USBD_HID_GetPollingInterval (USBD_HandleTypeDef *pdev)
   return ((uint32_t)(polling_interval));
 }
 
+/**
+  * @brief  USBD_HID_GetProtocol 
+  *         return the protocol selected by the host
+  * @param  pdev: device instance
+  * @retval HID_PROTOCOL_BOOT or HID_PROTOCOL_REPORT
+  */
+uint8_t USBD_HID_GetProtocol (USBD_HandleTypeDef *pdev)
+{
+  USBD_HID_HandleTypeDef     *hhid = (USBD_HID_HandleTypeDef*)pdev->pClassData;
+
+  if(hhid == NULL)
+  {
+    return HID_PROTOCOL_REPORT;
+  }
+  return (uint8_t)hhid->Protocol;
+}
+
 /**
   * @brief  USBD_HID_GetCfgDesc 
   *         return configuration descriptor
@@ -502,12 +630,50 @@ static uint8_t  USBD_HID_DataIn (USBD_HandleTypeDef *pdev,
   /* Ensure that the FIFO is empty before a new transfer, this condition could 
   be caused by  a new transfer before the end of the previous transfer */
   ((USBD_HID_HandleTypeDef *)pdev->pClassData)->state = HID_IDLE;
+  Report_Queue_TxCplt();
+  return USBD_OK;
+}
+#if HID_LOW_LATENCY == 1
+/**
+  * @brief  USBD_HID_SOF
+  *         handle SOF event, start of every 1ms full-speed frame
+  * @param  pdev: device instance
+  * @retval status
+  */
+static uint8_t USBD_HID_SOF(USBD_HandleTypeDef *pdev)
+{
+  Keyboard_USB_SOF();
+  return USBD_OK;
+}
+#endif
+/**
+  * @brief  USBD_HID_EP0_RxReady
+  *         SET_REPORT(Feature) data stage received
+  * @param  pdev: device instance
+  * @retval status
+  */
+static uint8_t USBD_HID_EP0_RxReady(USBD_HandleTypeDef *pdev)
+{
+  if(feature_len)
+  {
+    Keymap_Feature_Set(feature_buf, feature_len);
+    feature_len = 0;
+  }
   return USBD_OK;
 }
 static uint8_t USBD_HID_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum)
 {
-	  HAL_PCD_EP_Receive(&hpcd, HID_EPOUT_ADDR, &rx_buf, 1);
-		Keyboard_ReceiveReport(rx_buf);
+	  uint32_t len = USBD_LL_GetRxDataSize(pdev, epnum);
+	  /* Report protocol prefixes the LED report with its report ID */
+	  if((len == 2) && (rx_buf[0] == HID_NKRO_REPORT_ID))
+	  {
+	    Keyboard_ReceiveReport(rx_buf[1]);
+	  }
+	  else
+	  {
+	    Keyboard_ReceiveReport(rx_buf[0]);
+	  }
+	  HAL_PCD_EP_Receive(&hpcd, HID_EPOUT_ADDR, rx_buf, HID_EPOUT_SIZE);
 		return USBD_OK;
 }
 
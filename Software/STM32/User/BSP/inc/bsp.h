@@ -17,12 +17,21 @@
 #include "bsp_pwm.h"
 #include "bsp_74hc595.h"
 #include "bsp_lowpwr.h"
+#include "bsp_hwtimer.h"
+#include "bsp_clock.h"
 #include "user_display.h"
 
 #include "keycode.h"
 #include "keymap.h"
+#include "user_layer.h"
+#include "user_debounce.h"
 #include "user_key.h"
 #include "keyboard.h"
+#include "user_report.h"
+#include "user_link.h"
+#include "user_event.h"
+#include "user_macro.h"
+#include "user_keymap.h"
 
 
 
@@ -42,8 +51,6 @@
 /****BSP***/
 
 void bsp_Init(void);
-void bsp_RunPer10ms(void);
-void bsp_RunPer1ms(void);
 void bsp_Idle(void);
 
 #endif
@@ -2,6 +2,8 @@
 #define __BSP_74HC595_H 
 #include "bsp.h"
 #define SPI_74HC595			SPI1
+#define HC595_DMA_CH		LL_DMA_CHANNEL_3		//SPI1_TX 为DMA请求1
+#define HC595_DMA_IRQn		DMA1_Channel2_3_IRQn
 
 #define GPIO_PORT_HC595			GPIOA
 #define GPIO_PIN_HC595_CLK		LL_GPIO_PIN_5
@@ -12,10 +14,16 @@
 
 #define HC595_LAT_HIGH()		LL_GPIO_SetOutputPin(GPIO_PORT_HC595_LAT,GPIO_PIN_HC595_LAT)
 #define HC595_LAT_LOW()			LL_GPIO_ResetOutputPin(GPIO_PORT_HC595_LAT,GPIO_PIN_HC595_LAT)
+#define HC595_LATCH()			do{HC595_LAT_HIGH();HC595_LAT_LOW();}while(0)		//上升沿锁存，LAT平时为低
 
 void bsp_74hc595_Init(void);			//74hc595初始化
 void HC595_SendByte(uint8_t byte);		//发送一字节数据
 void HC595_Send2Byte(uint16_t byte);	//发送两个字节
 void HC595_SendData(uint16_t *pbuf, uint8_t len);		//发送指定长度数据
+void HC595_SendData_DMA(uint16_t *pbuf, uint8_t len);	//DMA移入数据，不锁存，完成后回调 Display_BCM_DMA_ISR
+uint8_t HC595_DMA_Done(void);			//DMA移位是否完成
+void HC595_DMA_Abort(void);				//停止DMA发送
+void HC595_Wait_Shift(void);			//DMA完成后等待最后一个字移出
+void HC595_DMA_ISR(void);				//DMA发送完成中断处理
 
 #endif
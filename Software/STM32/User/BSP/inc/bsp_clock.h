@@ -0,0 +1,61 @@
+#ifndef __BSP_CLOCK_H
+#define __BSP_CLOCK_H
+#include "bsp.h"
+
+#define CLOCK_GOV_EN		1					//1：没有升频需求时降到MSI 0：始终运行在PLL
+
+#define CLOCK_PLL_MUL		RCC_PLLMUL_12		//HSE 8MHz ×12 /3 = 32MHz
+#define CLOCK_PLL_DIV		RCC_PLLDIV_3
+#define CLOCK_MSI_RANGE		RCC_MSIRANGE_6		//4.194MHz。USART1 500k、过采样8时BRR=17，误差-1.3%；
+												//更低档位BRR小于16，与BLE模块无法通信
+
+/* 升频需求，满足任一条件即运行在PLL */
+#define CLOCK_REQ_KEY		(1 << 0)			//按键定时扫描中
+#define CLOCK_REQ_LED		(1 << 1)			//LED BCM运行中，位平面中断需要PLL
+#define CLOCK_REQ_USB		(1 << 2)			//USB模式
+#define CLOCK_USB_SUSPEND	(1 << 3)			//USB总线挂起，屏蔽 CLOCK_REQ_USB
+
+/* 电流模型(uA)，STM32L053数据手册典型值，不含LED、USB收发器和BLE模块 */
+#define CLOCK_PLL_RUN_UA	4900				//PLL 32MHz 电压档1 Flash运行，含HSE和PLL
+#define CLOCK_PLL_SLEEP_UA	1300				//PLL 32MHz WFI睡眠
+#define CLOCK_MSI_RUN_UA	480					//MSI 4.2MHz 电压档3 运行
+#define CLOCK_MSI_SLEEP_UA	110					//MSI 4.2MHz WFI睡眠
+#define CLOCK_MODEL_UA(run, sleep, permil)	(((run) * (permil) + (sleep) * (1000 - (permil))) / 1000)
+
+/*
+	各模式电流预算，CPU占空比取 Event_GetStat 实测的量级：
+	模式					时钟	CPU占空比	平均电流
+	USB 连续输入			PLL		10%			CLOCK_MODEL_UA(4900, 1300, 100) = 1660uA
+	USB 空闲(总线活动)		PLL		1%			CLOCK_MODEL_UA(4900, 1300, 10)  = 1336uA
+	BLE 连续输入			PLL		5%			CLOCK_MODEL_UA(4900, 1300, 50)  = 1480uA
+	LED 点亮(BCM)			PLL		4%			CLOCK_MODEL_UA(4900, 1300, 40)  = 1444uA，另加LED电流
+	USB挂起/BLE 空闲		MSI		0.1%		CLOCK_MODEL_UA(480, 110, 1)     = 110uA
+	不降频时空闲约1.34mA，降到MSI后约0.11mA
+*/
+
+typedef enum
+{
+	CLOCK_LEVEL_MSI = 0,
+	CLOCK_LEVEL_PLL,
+	CLOCK_LEVEL_COUNT
+}CLOCK_LEVEL;
+
+typedef struct
+{
+	uint32_t enter[CLOCK_LEVEL_COUNT];		//切换到该级的次数
+	uint32_t time_ms[CLOCK_LEVEL_COUNT];	//该级累计时间(ms)
+	uint32_t idle_ms[CLOCK_LEVEL_COUNT];	//其中WFI睡眠的时间(ms)
+	uint32_t up_us;							//最近一次升频耗时(us)，含HSE起振和PLL锁定
+	uint32_t up_us_max;						//升频最长耗时(us)
+	uint32_t defer;							//串口发送未完成、推迟降频的次数
+}CLOCK_STAT;
+
+void bsp_Init_Clock(void);					//时钟管理初始化，SystemClock_Config之后调用
+void Clock_Demand(uint8_t req, uint8_t on);	//设置/清除升频需求，可在中断中调用
+void Clock_Update(void);					//按需求切换时钟，主程序中调用
+void Clock_Resume(void);					//STOP唤醒、SystemClock_Config之后同步状态
+void Clock_Idle(uint32_t us);				//WFI睡眠时间计入当前级
+uint8_t Clock_GetLevel(void);				//当前时钟级
+CLOCK_STAT *Clock_GetStat(void);			//获取各级时间统计
+uint32_t Clock_Current_uA(void);			//按各级时间和电流模型估算平均电流
+#endif
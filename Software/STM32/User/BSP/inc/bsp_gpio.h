@@ -67,4 +67,5 @@ void bsp_Init_GPIO(void);
 void GPIO_BLE_Power(uint8_t state);
 void GPIO_LED_Power(uint8_t state);
 void GPIO_Config_EXTI(void);
+void GPIO_Disable_EXTI(void);
 #endif
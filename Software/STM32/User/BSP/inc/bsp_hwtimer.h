@@ -0,0 +1,25 @@
+#ifndef __BSP_HWTIMER_H
+#define __BSP_HWTIMER_H
+#include "bsp.h"
+
+#define HW_TIMER			TIM6			//按键行稳定定时器，单次模式，1us计数
+#define HW_TIMER_IRQn		TIM6_DAC_IRQn
+#define LED_TIMER			TIM21			//LED位平面定时器，连续模式，1us计数
+#define LED_TIMER_IRQn		TIM21_IRQn
+#define US_TIMER			TIM22			//微秒计数器，自由运行，1us计数，无中断
+#define HW_TIMER_PSC()		((SystemCoreClock + 500000U) / 1000000U - 1)	//1us计数的预分频，MSI下取最接近的整数
+
+void bsp_Init_HwTimer(void);				//硬件定时器初始化
+void bsp_HwTimer_Start(uint16_t us);		//单次定时，到时进入中断
+void bsp_HwTimer_Stop(void);				//停止定时
+void bsp_HwTimer_ISR(void);					//定时器中断处理
+void bsp_Init_LedTimer(void);				//LED位平面定时器初始化
+void bsp_LedTimer_Start(uint16_t us, uint16_t next_us);	//启动，第一段 us，第二段 next_us
+void bsp_LedTimer_SetNext(uint16_t us);		//设置下一段时间，在中断中调用
+void bsp_LedTimer_Stop(void);				//停止LED定时器
+void bsp_LedTimer_ISR(void);				//LED定时器中断处理
+void bsp_Init_UsTimer(void);				//微秒计数器初始化
+uint16_t bsp_UsTimer_Now(void);				//微秒计数值，16位回绕
+void bsp_HwTimer_SetClock(void);			//系统时钟切换后更新预分频
+
+#endif
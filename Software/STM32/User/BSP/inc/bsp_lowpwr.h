@@ -1,6 +1,37 @@
 #ifndef __BSP_LOWPWR_H
 #define __BSP_LOWPWR_H
 #include "bsp.h"
+
+#define PWR_WARM_RESUME		1		//1：STOP唤醒后只恢复时钟和被关闭的IO，保留按键状态 0：全部重新初始化
+#define PWR_GPIO_PORTS		5		//STOP前保存的GPIO端口数：A B C D H
+
+#define PWR_WAKE_QUEUE		0x01	//唤醒键报告已生成
+#define PWR_WAKE_SEND		0x02	//唤醒键报告已发出
+
+typedef struct
+{
+	uint32_t moder;
+	uint32_t otyper;
+	uint32_t ospeedr;
+	uint32_t pupdr;
+	uint32_t odr;
+	uint32_t afr[2];
+}PWR_GPIO_SAVE;
+
+typedef struct
+{
+	uint32_t wake_count;			//STOP唤醒次数
+	uint32_t miss;					//恢复时唤醒键已释放的次数
+	uint32_t clock_us;				//唤醒到系统时钟恢复(us)
+	uint32_t resume_us;				//唤醒到热恢复完成(us)
+	uint32_t queue_us;				//唤醒到唤醒键报告生成(us)
+	uint32_t queue_us_max;
+	uint32_t send_us;				//唤醒到唤醒键报告发出(us)，USB为交给端点，含主机重新枚举时间
+	uint32_t send_us_max;
+}PWR_WAKE_STAT;
+
 void System_Enter_StopMode(void);
 void Pwr_Sleep_Check(void);
+void Pwr_Wake_Report(uint8_t stage);		//唤醒键报告生成/发出时调用，记录耗时
+PWR_WAKE_STAT *Pwr_Wake_GetStat(void);		//获取唤醒耗时统计
 #endif
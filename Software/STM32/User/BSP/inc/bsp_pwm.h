@@ -8,5 +8,6 @@
 
 
 void bsp_Init_PWM(void);
+void bsp_PWM_SetClock(void);		//系统时钟切换后更新预分频
 
 #endif
@@ -5,7 +5,7 @@
 	ڴ˶ɸʱȫֱ
 	ע__IO  volatileΪжϺͬʱʣпɱŻ
 */
-#define TMR_COUNT					6		/* ʱĸ ʱIDΧ 0 - 3) */
+#define TMR_COUNT					7		/* ʱĸ ʱIDΧ 0 - 3) */
 #define TMR_PERIOD_15MS		15
 #define TMR_PERIOD_20MS		20
 #define TMR_PERIOD_30MS		30
@@ -25,7 +25,9 @@ enum
 	TMR_LED_CTRL=1,
 	TMR_LED_INIT=2,
 	TMR_KEY_SCAN=3,
-	TMR_SLEEP
+	TMR_SLEEP=4,
+	TMR_LINK=5,
+	TMR_MACRO=6
 };
 
 
@@ -36,23 +38,37 @@ typedef enum
 	TMR_AUTO_MODE = 1		/* Զʱģʽ */
 }TMR_MODE_E;
 
-/* ʱṹ壬Ա volatile, CŻʱ */
+#define TMR_NONE			0xFF	/*  */
+
+typedef void (*TMR_CALLBACK)(void);	/* ʱصSysTickжִ */
+
+/* ʱṹ壬Ա volatile, CŻʱ⡣
+   еĶʱʱųɲDelta Ϊǰһʱĵʱ */
 typedef struct
 {
-	volatile uint32_t Count;	/*  */
+	volatile uint32_t Delta;	/* ǰһʱ(ms) */
 	volatile uint32_t PreLoad;	/* Ԥװֵ */
 	volatile uint8_t Mode;		/* ģʽ1 */
 	volatile uint8_t Flag;		/* ʱ־  */
+	volatile uint8_t Next;		/* һTMR_NONEΪ */
+	volatile uint8_t Active;	/*  */
+	TMR_CALLBACK Callback;		/* ʱصΪ */
 }SOFT_TMR;
 
 /* ṩCļõĺ */
 void bsp_InitTimer(void);
+void bsp_TimerSuspend(void);
+uint32_t bsp_TimerResume(void);
+void bsp_TimerSetClock(void);
 void bsp_DelayMS(uint32_t n);
 void bsp_DelayUS(uint32_t n);
 void bsp_StartTimer(uint8_t _id, uint32_t _period);
 void bsp_StartAutoTimer(uint8_t _id, uint32_t _period);
 void bsp_StopTimer(uint8_t _id);
 uint8_t bsp_CheckTimer(uint8_t _id);
+void bsp_SetTimerCallback(uint8_t _id, TMR_CALLBACK _cb);
 int32_t bsp_GetRunTime(void);
+uint32_t bsp_GetRunTimeUs(void);
+uint32_t bsp_GetTickWakeups(void);
 
 #endif
@@ -14,9 +14,11 @@ typedef enum
 
 /* 崮ڲʺFIFOСΪͻͽջ, ֧ȫ˫ */
 #if UART1_FIFO_EN == 1
-	#define UART1_BAUD			115200
+	#define UART1_BAUD			500000		/* DA14580 UART2Ƶ(16MHz/16/2)һ */
 	#define UART1_TX_BUF_SIZE	1*512
 	#define UART1_RX_BUF_SIZE	1*128
+	#define UART1_TX_DMA_EN		1					/* 1ʹDMA0ֽTXEж */
+	#define UART1_TX_DMA_CH		LL_DMA_CHANNEL_4	/* USART1_TX ΪDMA3 */
 #endif
 
 #if UART2_FIFO_EN == 1
@@ -40,6 +42,14 @@ typedef struct
 	uint16_t usRxRead;			/* ջָ */
 	uint16_t usRxCount;			/* δȡݸ */
 
+	uint8_t ucTxDma;			/* 1ʹDMA */
+	uint8_t ucTxDmaExt;			/* 1ǰDMA͵㿽 */
+	uint16_t usTxDmaLen;		/* ǰDMAͳȣ0ʾDMA */
+	uint16_t usTxDmaDone;		/* ǰDMAѹ黹FIFOֽ */
+	uint8_t *pTxExt;			/* 㿽ͻ0ʾ */
+	uint16_t usTxExtLen;		/* 㿽ͳ */
+	uint16_t usTxExtMark;		/* 㿽֮ǰFIFOȷֽ */
+
 	void (*SendBefor)(void); 	/* ʼ֮ǰĻصָ루ҪRS485лģʽ */
 	void (*SendOver)(void); 	/* ϵĻصָ루ҪRS485ģʽлΪģʽ */
 	void (*ReciveNew)(void);	/* յݵĻصָ */
@@ -47,11 +57,16 @@ typedef struct
 
 void bsp_InitUart(void);
 void comSendBuf(COM_PORT_E _ucPort, uint8_t *_ucaBuf, uint16_t _usLen);
+uint8_t comSendBufNoCopy(COM_PORT_E _ucPort, uint8_t *_ucaBuf, uint16_t _usLen);
+uint8_t comNoCopyBusy(COM_PORT_E _ucPort);
 void comSendChar(COM_PORT_E _ucPort, uint8_t _ucByte);
 uint8_t comGetChar(COM_PORT_E _ucPort, uint8_t *_pByte);
 
 void comClearTxFifo(COM_PORT_E _ucPort);
 void comClearRxFifo(COM_PORT_E _ucPort);
+void comSetReceiveNew(COM_PORT_E _ucPort, void (*_pCallback)(void));
+uint8_t comTxIdle(COM_PORT_E _ucPort);
+void bsp_UartSetClock(void);
 
 #endif
 
@@ -21,28 +21,10 @@ void bsp_Init(void)
 	bsp_Init_PWM();
 	bsp_74hc595_Init();
 	bsp_InitTimer();
-}
-/*============================================================
-	*	@func:		bsp_RunPer10ms
-	*	@brief:		XX
-	*	@param:		NA
-	*	@retval:	NA	
-	*	@modify: 	data 			remarks 
-=============================================================*/
-void bsp_RunPer10ms(void)
-{
-	
-}
-/*============================================================
-	*	@func:		bsp_RunPer1ms
-	*	@brief:		XX
-	*	@param:		NA
-	*	@retval:	NA	
-	*	@modify: 	data 			remarks 
-=============================================================*/
-void bsp_RunPer1ms(void)
-{
-
+	bsp_Init_HwTimer();
+	bsp_Init_LedTimer();
+	bsp_Init_UsTimer();
+	bsp_Init_Clock();
 }
 /*============================================================
 	*	@func:		bsp_Idle
@@ -53,5 +35,5 @@ void bsp_RunPer1ms(void)
 =============================================================*/
 void bsp_Idle(void)
 {
-
+	__WFI();			//SysTick按延时到期时间定时，到时唤醒
 }
@@ -10,6 +10,7 @@
 
 static void HC595_SPI_Init(void);       //SPI ³õÊ¼»¯
 static void HC595_GPIO_Config(void);    //SPI IOÅäÖÃ
+static void HC595_DMA_Init(void);       //SPI1 发送DMA初始化
 /*============================================================
     *   @func:      bsp_74hc595_Init
     *   @brief:     595³õÊ¼»¯£¬IOÅäÖÃ
@@ -21,6 +22,7 @@ void bsp_74hc595_Init(void)
 {
     HC595_GPIO_Config();
     HC595_SPI_Init();
+    HC595_DMA_Init();
 }
 /*============================================================
     *   @func:      HC595_GPIO_Config
@@ -107,3 +109,101 @@ void HC595_SendData(uint16_t *pbuf, uint8_t len)
         HC595_Send2Byte(*(pbuf++));
     }
 }
+/*============================================================
+    *   @func:      HC595_DMA_Init
+    *   @brief:     SPI1_TX 使用DMA通道3(请求1)，16位宽，传输完成中断。
+    *               中断优先级与LED定时器相同，两者不会互相打断
+    *   @param:     NA
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+static void HC595_DMA_Init(void)
+{
+    LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMA1);
+    LL_DMA_DisableChannel(DMA1, HC595_DMA_CH);
+    LL_DMA_SetPeriphRequest(DMA1, HC595_DMA_CH, LL_DMA_REQUEST_1);
+    LL_DMA_ConfigTransfer(DMA1, HC595_DMA_CH, LL_DMA_DIRECTION_MEMORY_TO_PERIPH | LL_DMA_PRIORITY_MEDIUM |
+                          LL_DMA_MODE_NORMAL | LL_DMA_PERIPH_NOINCREMENT | LL_DMA_MEMORY_INCREMENT |
+                          LL_DMA_PDATAALIGN_HALFWORD | LL_DMA_MDATAALIGN_HALFWORD);
+    LL_DMA_SetPeriphAddress(DMA1, HC595_DMA_CH, LL_SPI_DMA_GetRegAddr(SPI_74HC595));
+    LL_DMA_ClearFlag_GI3(DMA1);
+    LL_DMA_EnableIT_TC(DMA1, HC595_DMA_CH);
+    LL_SPI_EnableDMAReq_TX(SPI_74HC595);
+
+    NVIC_SetPriority(HC595_DMA_IRQn, 3);
+    NVIC_EnableIRQ(HC595_DMA_IRQn);
+}
+/*============================================================
+    *   @func:      HC595_SendData_DMA
+    *   @brief:     用DMA把一组数据移入595，立即返回，不锁存。
+    *               输出保持原锁存内容，之后用 HC595_LATCH 一次更新。
+    *               传输完成后在DMA中断中回调 Display_BCM_DMA_ISR
+    *   @param:     pbuf：数据，发送完成前不能改写 len：16位数据个数
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+void HC595_SendData_DMA(uint16_t *pbuf, uint8_t len)
+{
+    LL_DMA_DisableChannel(DMA1, HC595_DMA_CH);
+    LL_DMA_ClearFlag_GI3(DMA1);
+    LL_DMA_SetMemoryAddress(DMA1, HC595_DMA_CH, (uint32_t)pbuf);
+    LL_DMA_SetDataLength(DMA1, HC595_DMA_CH, len);
+    LL_DMA_EnableChannel(DMA1, HC595_DMA_CH);
+}
+/*============================================================
+    *   @func:      HC595_DMA_Done
+    *   @brief:     DMA发送的数据是否已全部移入595
+    *   @param:     NA
+    *   @retval:    1：完成 0：发送中
+    *   @modify:    data            remarks
+=============================================================*/
+uint8_t HC595_DMA_Done(void)
+{
+    if(LL_DMA_IsEnabledChannel(DMA1, HC595_DMA_CH) && !LL_DMA_IsActiveFlag_TC3(DMA1))
+    {
+        return 0;
+    }
+    return !LL_SPI_IsActiveFlag_BSY(SPI_74HC595);
+}
+/*============================================================
+    *   @func:      HC595_DMA_Abort
+    *   @brief:     停止DMA发送并清除挂起的完成中断，595中的数据不完整，
+    *               重新启动时整行重发
+    *   @param:     NA
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+void HC595_DMA_Abort(void)
+{
+    LL_DMA_DisableChannel(DMA1, HC595_DMA_CH);
+    LL_DMA_ClearFlag_GI3(DMA1);
+    NVIC_ClearPendingIRQ(HC595_DMA_IRQn);
+}
+/*============================================================
+    *   @func:      HC595_Wait_Shift
+    *   @brief:     DMA完成时最后的数据仍在SPI中移位，等待移位结束。
+    *               只在DMA已完成后调用，最多等待两个16位字(8us@4MHz)
+    *   @param:     NA
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+void HC595_Wait_Shift(void)
+{
+    while(LL_SPI_IsActiveFlag_BSY(SPI_74HC595));
+}
+/*============================================================
+    *   @func:      HC595_DMA_ISR
+    *   @brief:     DMA发送完成中断处理，在 DMA1_Channel2_3_IRQHandler 中调用
+    *   @param:     NA
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+void HC595_DMA_ISR(void)
+{
+    if(LL_DMA_IsActiveFlag_TC3(DMA1))
+    {
+        LL_DMA_ClearFlag_GI3(DMA1);
+        LL_DMA_DisableChannel(DMA1, HC595_DMA_CH);
+        Display_BCM_DMA_ISR();
+    }
+}
@@ -0,0 +1,319 @@
+/************************************************************
+	*	@file:		bsp_clock.c
+	*	@brief:		系统时钟管理。没有按键扫描、LED和活动的USB总线时运行在MSI，
+	*				有需求时升到PLL 32MHz；每次切换后重新计算SysTick、延时、
+	*				串口波特率和定时器预分频，并统计各级时钟的运行和睡眠时间
+	*	@author:	XIET
+	*	@version:	V1.0
+	*	@data:		201x-xx-xx
+	*	@modify:	data  			remarks
+**************************************************************/
+#include "bsp.h"
+
+static const uint16_t s_usRunUA[CLOCK_LEVEL_COUNT] = {CLOCK_MSI_RUN_UA, CLOCK_PLL_RUN_UA};
+static const uint16_t s_usSleepUA[CLOCK_LEVEL_COUNT] = {CLOCK_MSI_SLEEP_UA, CLOCK_PLL_SLEEP_UA};
+
+static volatile uint8_t s_ucDemand = 0;		//升频需求
+static uint8_t s_ucLevel = CLOCK_LEVEL_PLL;	//当前时钟级
+static int32_t s_iLevelTime = 0;			//上次统计的时间
+static uint32_t s_uiIdleUs = 0;				//不足1ms的睡眠时间
+static CLOCK_STAT s_tClockStat;
+
+static uint8_t Clock_Need(void);
+static void Clock_Account(void);
+static void Clock_Switch(RCC_ClkInitTypeDef *clk, uint32_t latency, uint8_t level);
+static void Clock_To_PLL(void);
+static void Clock_To_MSI(void);
+/*============================================================
+	*	@func:		bsp_Init_Clock
+	*	@brief:		时钟管理初始化，SystemClock_Config 已切换到PLL。
+	*				上电为USB模式，与 keyboard.c 中 USB_BLE_Switch 一致
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void bsp_Init_Clock(void)
+{
+	memset(&s_tClockStat, 0, sizeof(s_tClockStat));
+	s_ucDemand = CLOCK_REQ_USB;
+	s_ucLevel = CLOCK_LEVEL_PLL;
+	s_tClockStat.enter[CLOCK_LEVEL_PLL] = 1;
+	s_iLevelTime = bsp_GetRunTime();
+	s_uiIdleUs = 0;
+}
+/*============================================================
+	*	@func:		Clock_Demand
+	*	@brief:		设置或清除升频需求，只记录，在 Clock_Update 中切换。
+	*				保存并恢复中断状态，可在中断中调用
+	*	@param:		req：CLOCK_REQ_xx on：1置位 0清除
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void Clock_Demand(uint8_t req, uint8_t on)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	DISABLE_INT();
+	if(on)
+	{
+		s_ucDemand |= req;
+	}
+	else
+	{
+		s_ucDemand &= (uint8_t)~req;
+	}
+	__set_PRIMASK(primask);
+}
+/*============================================================
+	*	@func:		Clock_Update
+	*	@brief:		按需求切换时钟，在主程序中调用：主循环每次睡眠前，以及启动
+	*				需要PLL的工作前。升频时等待串口发完；降频时串口忙则推迟，
+	*				发送完成中断唤醒主循环后再试
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void Clock_Update(void)
+{
+#if CLOCK_GOV_EN == 1
+	uint8_t level = Clock_Need();
+	uint32_t start;
+
+	if(level == s_ucLevel)
+	{
+		return;
+	}
+	if(level == CLOCK_LEVEL_PLL)
+	{
+		start = bsp_GetRunTimeUs();
+		while(!comTxIdle(COM_BLE));
+		Clock_To_PLL();
+		s_tClockStat.up_us = bsp_GetRunTimeUs() - start;
+		if(s_tClockStat.up_us > s_tClockStat.up_us_max)
+		{
+			s_tClockStat.up_us_max = s_tClockStat.up_us;
+		}
+	}
+	else
+	{
+		if(!comTxIdle(COM_BLE))
+		{
+			s_tClockStat.defer++;
+			return;
+		}
+		Clock_To_MSI();
+	}
+#endif
+}
+/*============================================================
+	*	@func:		Clock_Resume
+	*	@brief:		STOP唤醒后 SystemClock_Config 已切换到PLL，同步当前级并
+	*				重新计算外设分频。SysTick由 bsp_TimerResume 按新频率重新定时
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void Clock_Resume(void)
+{
+	Clock_Account();
+	if(s_ucLevel != CLOCK_LEVEL_PLL)
+	{
+		s_ucLevel = CLOCK_LEVEL_PLL;
+		s_tClockStat.enter[CLOCK_LEVEL_PLL]++;
+	}
+	DISABLE_INT();
+	bsp_UartSetClock();
+	bsp_HwTimer_SetClock();
+	bsp_PWM_SetClock();
+	ENABLE_INT();
+}
+/*============================================================
+	*	@func:		Clock_Idle
+	*	@brief:		主循环一次WFI睡眠的时间计入当前级
+	*	@param:		us：睡眠时间
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void Clock_Idle(uint32_t us)
+{
+	s_uiIdleUs += us;
+	s_tClockStat.idle_ms[s_ucLevel] += s_uiIdleUs / 1000U;
+	s_uiIdleUs %= 1000U;
+}
+/*============================================================
+	*	@func:		Clock_GetLevel
+	*	@brief:		当前时钟级
+	*	@param:		NA
+	*	@retval:	CLOCK_LEVEL_MSI / CLOCK_LEVEL_PLL
+	*	@modify: 	data 			remarks
+=============================================================*/
+uint8_t Clock_GetLevel(void)
+{
+	return s_ucLevel;
+}
+/*============================================================
+	*	@func:		Clock_GetStat
+	*	@brief:		获取各级时钟时间统计，当前级的时间计到此刻
+	*	@param:		NA
+	*	@retval:	统计结构体
+	*	@modify: 	data 			remarks
+=============================================================*/
+CLOCK_STAT *Clock_GetStat(void)
+{
+	Clock_Account();
+	return &s_tClockStat;
+}
+/*============================================================
+	*	@func:		Clock_Current_uA
+	*	@brief:		按各级的运行、睡眠时间和电流模型估算上电以来的平均电流
+	*	@param:		NA
+	*	@retval:	平均电流(uA)
+	*	@modify: 	data 			remarks
+=============================================================*/
+uint32_t Clock_Current_uA(void)
+{
+	uint64_t charge = 0;
+	uint32_t total = 0;
+	uint32_t idle;
+
+	Clock_Account();
+	for (uint8_t i = 0; i < CLOCK_LEVEL_COUNT; ++i)
+	{
+		idle = s_tClockStat.idle_ms[i];
+		if(idle > s_tClockStat.time_ms[i])
+		{
+			idle = s_tClockStat.time_ms[i];
+		}
+		charge += (uint64_t)(s_tClockStat.time_ms[i] - idle) * s_usRunUA[i];
+		charge += (uint64_t)idle * s_usSleepUA[i];
+		total += s_tClockStat.time_ms[i];
+	}
+	return total ? (uint32_t)(charge / total) : 0;
+}
+/*============================================================
+	*	@func:		Clock_Need
+	*	@brief:		按当前需求应运行的时钟级
+	*	@param:		NA
+	*	@retval:	CLOCK_LEVEL_MSI / CLOCK_LEVEL_PLL
+	*	@modify: 	data 			remarks
+=============================================================*/
+static uint8_t Clock_Need(void)
+{
+	uint8_t demand = s_ucDemand;
+
+	if(demand & (CLOCK_REQ_KEY | CLOCK_REQ_LED))
+	{
+		return CLOCK_LEVEL_PLL;
+	}
+	if((demand & CLOCK_REQ_USB) && !(demand & CLOCK_USB_SUSPEND))
+	{
+		return CLOCK_LEVEL_PLL;
+	}
+	return CLOCK_LEVEL_MSI;
+}
+/*============================================================
+	*	@func:		Clock_Account
+	*	@brief:		从上次统计到现在的时间计入当前级
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+static void Clock_Account(void)
+{
+	int32_t now = bsp_GetRunTime();
+
+	s_tClockStat.time_ms[s_ucLevel] += (uint32_t)(now - s_iLevelTime) & 0x7FFFFFFF;
+	s_iLevelTime = now;
+}
+/*============================================================
+	*	@func:		Clock_Switch
+	*	@brief:		切换系统时钟，目标振荡器已就绪。关中断完成切换和分频更新，
+	*				中断不会在新时钟下使用旧的分频
+	*	@param:		clk：时钟配置 latency：Flash等待周期 level：目标级
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+static void Clock_Switch(RCC_ClkInitTypeDef *clk, uint32_t latency, uint8_t level)
+{
+	Clock_Account();
+	DISABLE_INT();
+	HAL_RCC_ClockConfig(clk, latency);		//更新 SystemCoreClock，HAL_InitTick 已由bsp_timer覆盖
+	bsp_TimerSetClock();
+	bsp_UartSetClock();
+	bsp_HwTimer_SetClock();
+	bsp_PWM_SetClock();
+	ENABLE_INT();
+	s_ucLevel = level;
+	s_tClockStat.enter[level]++;
+}
+/*============================================================
+	*	@func:		Clock_To_PLL
+	*	@brief:		升到PLL 32MHz：先升电压档，开中断等待HSE起振和PLL锁定，
+	*				再切换系统时钟，最后关闭MSI
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+static void Clock_To_PLL(void)
+{
+	RCC_OscInitTypeDef RCC_OscInitStruct;
+	RCC_ClkInitTypeDef RCC_ClkInitStruct;
+
+	__HAL_PWR_VOLTAGESCALING_CONFIG(PWR_REGULATOR_VOLTAGE_SCALE1);
+	while(__HAL_PWR_GET_FLAG(PWR_FLAG_VOS));
+
+	RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_HSE;
+	RCC_OscInitStruct.HSEState = RCC_HSE_ON;
+	RCC_OscInitStruct.PLL.PLLState = RCC_PLL_ON;
+	RCC_OscInitStruct.PLL.PLLSource = RCC_PLLSOURCE_HSE;
+	RCC_OscInitStruct.PLL.PLLMUL = CLOCK_PLL_MUL;
+	RCC_OscInitStruct.PLL.PLLDIV = CLOCK_PLL_DIV;
+	HAL_RCC_OscConfig(&RCC_OscInitStruct);
+
+	RCC_ClkInitStruct.ClockType = RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_SYSCLK
+								| RCC_CLOCKTYPE_PCLK1 | RCC_CLOCKTYPE_PCLK2;
+	RCC_ClkInitStruct.SYSCLKSource = RCC_SYSCLKSOURCE_PLLCLK;
+	RCC_ClkInitStruct.AHBCLKDivider = RCC_SYSCLK_DIV1;
+	RCC_ClkInitStruct.APB1CLKDivider = RCC_HCLK_DIV1;
+	RCC_ClkInitStruct.APB2CLKDivider = RCC_HCLK_DIV1;
+	Clock_Switch(&RCC_ClkInitStruct, FLASH_LATENCY_1, CLOCK_LEVEL_PLL);
+
+	RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_MSI;
+	RCC_OscInitStruct.MSIState = RCC_MSI_OFF;
+	RCC_OscInitStruct.PLL.PLLState = RCC_PLL_NONE;
+	HAL_RCC_OscConfig(&RCC_OscInitStruct);
+}
+/*============================================================
+	*	@func:		Clock_To_MSI
+	*	@brief:		降到MSI：启动MSI并切换系统时钟，然后关闭PLL和HSE，降电压档
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+static void Clock_To_MSI(void)
+{
+	RCC_OscInitTypeDef RCC_OscInitStruct;
+	RCC_ClkInitTypeDef RCC_ClkInitStruct;
+
+	RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_MSI;
+	RCC_OscInitStruct.MSIState = RCC_MSI_ON;
+	RCC_OscInitStruct.MSICalibrationValue = RCC_MSICALIBRATION_DEFAULT;
+	RCC_OscInitStruct.MSIClockRange = CLOCK_MSI_RANGE;
+	RCC_OscInitStruct.PLL.PLLState = RCC_PLL_NONE;
+	HAL_RCC_OscConfig(&RCC_OscInitStruct);
+
+	RCC_ClkInitStruct.ClockType = RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_SYSCLK
+								| RCC_CLOCKTYPE_PCLK1 | RCC_CLOCKTYPE_PCLK2;
+	RCC_ClkInitStruct.SYSCLKSource = RCC_SYSCLKSOURCE_MSI;
+	RCC_ClkInitStruct.AHBCLKDivider = RCC_SYSCLK_DIV1;
+	RCC_ClkInitStruct.APB1CLKDivider = RCC_HCLK_DIV1;
+	RCC_ClkInitStruct.APB2CLKDivider = RCC_HCLK_DIV1;
+	Clock_Switch(&RCC_ClkInitStruct, FLASH_LATENCY_0, CLOCK_LEVEL_MSI);
+
+	RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_HSE;
+	RCC_OscInitStruct.HSEState = RCC_HSE_OFF;
+	RCC_OscInitStruct.PLL.PLLState = RCC_PLL_OFF;
+	HAL_RCC_OscConfig(&RCC_OscInitStruct);
+
+	__HAL_PWR_VOLTAGESCALING_CONFIG(PWR_REGULATOR_VOLTAGE_SCALE3);
+}
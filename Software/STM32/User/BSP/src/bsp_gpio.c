@@ -161,4 +161,17 @@ void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
 {
   /* Clear Wake Up Flag */
   __HAL_PWR_CLEAR_FLAG(PWR_FLAG_WU);
+  Key_Scan_Wakeup(GPIO_Pin);
+}
+/*============================================================
+	*	@func:		GPIO_Disable_EXTI
+	*	@brief:		关闭列中断并清除挂起标志，列保持下拉输入用于扫描
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void GPIO_Disable_EXTI(void)
+{
+	LL_EXTI_DisableIT_0_31(KEY_COL_ALL_PIN);
+	LL_EXTI_ClearFlag_0_31(KEY_COL_ALL_PIN);
 }
@@ -0,0 +1,220 @@
+/************************************************************
+	*	@file:		bsp_hwtimer.c
+	*	@brief:		微秒硬件定时器。TIM6单次定时用于按键扫描的行稳定等待，
+	*				到时在中断中回调 Key_Scan_Row_ISR；TIM21连续定时切换LED位平面，
+	*				每次更新回调 Display_BCM_ISR；TIM22自由计数，作为微秒延时和
+	*				耗时统计的时基，不受SysTick重装影响
+	*	@author:	XIET
+	*	@version:	V1.0
+	*	@data:		201x-xx-xx
+	*	@modify:	data  			remarks
+**************************************************************/
+#include "bsp.h"
+/*============================================================
+	*	@func:		bsp_Init_HwTimer
+	*	@brief:		TIM6 配置为1MHz计数、单次模式、更新中断
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void bsp_Init_HwTimer(void)
+{
+	LL_TIM_InitTypeDef TIM_InitStruct;
+
+	LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_TIM6);
+
+	LL_TIM_DisableCounter(HW_TIMER);
+	TIM_InitStruct.Prescaler = HW_TIMER_PSC();		//1MHZ
+	TIM_InitStruct.CounterMode = LL_TIM_COUNTERMODE_UP;
+	TIM_InitStruct.Autoreload = 0xFFFF;
+	TIM_InitStruct.ClockDivision = LL_TIM_CLOCKDIVISION_DIV1;
+	LL_TIM_Init(HW_TIMER, &TIM_InitStruct);		//产生更新事件装载预分频值
+	LL_TIM_SetOnePulseMode(HW_TIMER, LL_TIM_ONEPULSEMODE_SINGLE);
+	LL_TIM_SetUpdateSource(HW_TIMER, LL_TIM_UPDATESOURCE_COUNTER);
+	LL_TIM_ClearFlag_UPDATE(HW_TIMER);
+	LL_TIM_EnableIT_UPDATE(HW_TIMER);
+
+	NVIC_SetPriority(HW_TIMER_IRQn, 2);		//高于USB，保证行稳定时间
+	NVIC_EnableIRQ(HW_TIMER_IRQn);
+}
+/*============================================================
+	*	@func:		bsp_HwTimer_Start
+	*	@brief:		启动一次定时，计满后计数器自动停止并进入中断
+	*	@param:		us：定时时间，1~65535
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void bsp_HwTimer_Start(uint16_t us)
+{
+	LL_TIM_SetAutoReload(HW_TIMER, us - 1);
+	LL_TIM_SetCounter(HW_TIMER, 0);
+	LL_TIM_EnableCounter(HW_TIMER);
+}
+/*============================================================
+	*	@func:		bsp_HwTimer_Stop
+	*	@brief:		停止定时并清除挂起的中断
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void bsp_HwTimer_Stop(void)
+{
+	LL_TIM_DisableCounter(HW_TIMER);
+	LL_TIM_ClearFlag_UPDATE(HW_TIMER);
+	NVIC_ClearPendingIRQ(HW_TIMER_IRQn);
+}
+/*============================================================
+	*	@func:		bsp_HwTimer_SetClock
+	*	@brief:		系统时钟切换后调用，需关中断。预分频值立即装载：TIM6正在定时的
+	*				行从0按新频率重新计时，稳定时间只会变长；TIM21只在PLL下运行；
+	*				TIM22装载后恢复原计数值，计数保持连续
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void bsp_HwTimer_SetClock(void)
+{
+	uint16_t cnt = bsp_UsTimer_Now();
+
+	LL_TIM_SetPrescaler(US_TIMER, HW_TIMER_PSC());
+	LL_TIM_GenerateEvent_UPDATE(US_TIMER);
+	LL_TIM_SetCounter(US_TIMER, cnt);
+	LL_TIM_SetPrescaler(HW_TIMER, HW_TIMER_PSC());
+	LL_TIM_GenerateEvent_UPDATE(HW_TIMER);		//URS置位，不产生中断
+	LL_TIM_SetPrescaler(LED_TIMER, HW_TIMER_PSC());
+	if(!LL_TIM_IsEnabledCounter(LED_TIMER))
+	{
+		LL_TIM_GenerateEvent_UPDATE(LED_TIMER);
+	}
+}
+/*============================================================
+	*	@func:		bsp_HwTimer_ISR
+	*	@brief:		定时器中断处理，在 TIM6_DAC_IRQHandler 中调用
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void bsp_HwTimer_ISR(void)
+{
+	if(LL_TIM_IsActiveFlag_UPDATE(HW_TIMER))
+	{
+		LL_TIM_ClearFlag_UPDATE(HW_TIMER);
+		Key_Scan_Row_ISR();
+	}
+}
+/*============================================================
+	*	@func:		bsp_Init_LedTimer
+	*	@brief:		TIM21 配置为1MHz计数、自动重装预装载、更新中断。
+	*				中断优先级低于按键行定时器，LED不影响扫描时序
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void bsp_Init_LedTimer(void)
+{
+	LL_TIM_InitTypeDef TIM_InitStruct;
+
+	LL_APB2_GRP1_EnableClock(LL_APB2_GRP1_PERIPH_TIM21);
+
+	LL_TIM_DisableCounter(LED_TIMER);
+	TIM_InitStruct.Prescaler = HW_TIMER_PSC();		//1MHZ
+	TIM_InitStruct.CounterMode = LL_TIM_COUNTERMODE_UP;
+	TIM_InitStruct.Autoreload = 0xFFFF;
+	TIM_InitStruct.ClockDivision = LL_TIM_CLOCKDIVISION_DIV1;
+	LL_TIM_Init(LED_TIMER, &TIM_InitStruct);
+	LL_TIM_EnableARRPreload(LED_TIMER);
+	LL_TIM_SetUpdateSource(LED_TIMER, LL_TIM_UPDATESOURCE_COUNTER);
+	LL_TIM_ClearFlag_UPDATE(LED_TIMER);
+	LL_TIM_EnableIT_UPDATE(LED_TIMER);
+
+	NVIC_SetPriority(LED_TIMER_IRQn, 3);
+	NVIC_EnableIRQ(LED_TIMER_IRQn);
+}
+/*============================================================
+	*	@func:		bsp_LedTimer_Start
+	*	@brief:		启动连续定时。重装值有预装载，中断中设置的是再下一段的时间，
+	*				各段首尾相接，不受中断响应延迟影响
+	*	@param:		us：第一段时间 next_us：第二段时间
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void bsp_LedTimer_Start(uint16_t us, uint16_t next_us)
+{
+	LL_TIM_DisableCounter(LED_TIMER);
+	LL_TIM_SetAutoReload(LED_TIMER, us - 1);
+	LL_TIM_GenerateEvent_UPDATE(LED_TIMER);		//装载第一段，URS置位不产生中断
+	LL_TIM_SetAutoReload(LED_TIMER, next_us - 1);
+	LL_TIM_EnableCounter(LED_TIMER);
+}
+/*============================================================
+	*	@func:		bsp_LedTimer_SetNext
+	*	@brief:		设置下一段时间，在更新中断中调用
+	*	@param:		us：时间，1~65535
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void bsp_LedTimer_SetNext(uint16_t us)
+{
+	LL_TIM_SetAutoReload(LED_TIMER, us - 1);
+}
+/*============================================================
+	*	@func:		bsp_LedTimer_Stop
+	*	@brief:		停止定时并清除挂起的中断
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void bsp_LedTimer_Stop(void)
+{
+	LL_TIM_DisableCounter(LED_TIMER);
+	LL_TIM_ClearFlag_UPDATE(LED_TIMER);
+	NVIC_ClearPendingIRQ(LED_TIMER_IRQn);
+}
+/*============================================================
+	*	@func:		bsp_LedTimer_ISR
+	*	@brief:		LED定时器中断处理，在 TIM21_IRQHandler 中调用
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void bsp_LedTimer_ISR(void)
+{
+	if(LL_TIM_IsActiveFlag_UPDATE(LED_TIMER))
+	{
+		LL_TIM_ClearFlag_UPDATE(LED_TIMER);
+		Display_BCM_ISR();
+	}
+}
+/*============================================================
+	*	@func:		bsp_Init_UsTimer
+	*	@brief:		TIM22 配置为1MHz计数、16位自由运行，不开中断
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void bsp_Init_UsTimer(void)
+{
+	LL_TIM_InitTypeDef TIM_InitStruct;
+
+	LL_APB2_GRP1_EnableClock(LL_APB2_GRP1_PERIPH_TIM22);
+
+	LL_TIM_DisableCounter(US_TIMER);
+	TIM_InitStruct.Prescaler = HW_TIMER_PSC();		//1MHZ
+	TIM_InitStruct.CounterMode = LL_TIM_COUNTERMODE_UP;
+	TIM_InitStruct.Autoreload = 0xFFFF;
+	TIM_InitStruct.ClockDivision = LL_TIM_CLOCKDIVISION_DIV1;
+	LL_TIM_Init(US_TIMER, &TIM_InitStruct);
+	LL_TIM_EnableCounter(US_TIMER);
+}
+/*============================================================
+	*	@func:		bsp_UsTimer_Now
+	*	@brief:		微秒计数值，约65ms回绕，只用于计算短时间差。
+	*				两次读数之差的平均值等于实际耗时，单次最多差1us
+	*	@param:		NA
+	*	@retval:	计数值
+	*	@modify: 	data 			remarks
+=============================================================*/
+uint16_t bsp_UsTimer_Now(void)
+{
+	return (uint16_t)LL_TIM_GetCounter(US_TIMER);
+}
@@ -7,17 +7,68 @@
   * @modify:  data        remarks
 **************************************************************/
 #include "bsp.h"
+static uint32_t s_uiWakeUs = 0;                     //唤醒时刻(us)
+static volatile uint8_t s_ucWakeReport = 0;         //等待记录的唤醒键报告阶段
+static PWR_WAKE_STAT s_tWakeStat;
+#if PWR_WARM_RESUME == 1
+static GPIO_TypeDef * const s_tGpioPort[PWR_GPIO_PORTS] = {GPIOA, GPIOB, GPIOC, GPIOD, GPIOH};
+static PWR_GPIO_SAVE s_tGpioSave[PWR_GPIO_PORTS];   //STOP前的IO配置
+static uint32_t s_uiGpioClock = 0;                  //STOP前的IO时钟
+
+static void SystemPower_Save(void);
+static void SystemPower_Restore(void);
+#endif
+static void Pwr_Wake_Max(uint32_t *max, uint32_t us);
 static void SystemPower_Config(void);
 extern  void SystemClock_Config(void);
 /*============================================================
-  * @func:    XX
-  * @brief:   XX
+  * @func:    System_Enter_StopMode
+  * @brief:   进入STOP，列中断唤醒后返回。热恢复只恢复系统时钟、STOP前改为
+  *           模拟输入的IO和USB，外设寄存器在STOP中保持不变；按键矩阵和
+  *           消抖状态保留，唤醒键同步扫描后作为第一个报告发出
   * @param:   NA
   * @retval:  NA
   * @modify:  data      remarks
 =============================================================*/
 void System_Enter_StopMode(void)
 {
+#if PWR_WARM_RESUME == 1
+    uint8_t hit;
+
+    Display_Suspend();
+    Key_Scan_Suspend();
+    USB_Disable();
+    SystemPower_Save();
+    SystemPower_Config();
+    GPIO_Config_EXTI();
+    bsp_TimerSuspend();
+    HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+    SystemClock_Config();
+    Clock_Resume();
+    s_tWakeStat.clock_us = bsp_TimerResume();
+    s_uiWakeUs = bsp_GetRunTimeUs() - s_tWakeStat.clock_us;
+    SystemPower_Restore();
+    Report_Queue_Hold();
+    USB_Enable();
+    Display_Resume();
+    Link_Init();                //BLE模块在STOP期间断电，重新同步
+    Keymap_Resume();
+    hit = Key_Scan_Capture();
+    bsp_StartTimer(TMR_SLEEP, TMR_PERIOD_10MIN);
+    DISABLE_INT();
+    s_tWakeStat.wake_count++;
+    if(hit)
+    {
+        s_ucWakeReport = PWR_WAKE_QUEUE | PWR_WAKE_SEND;
+    }
+    else
+    {
+        s_ucWakeReport = 0;
+        s_tWakeStat.miss++;
+    }
+    s_tWakeStat.resume_us = bsp_GetRunTimeUs() - s_uiWakeUs;
+    ENABLE_INT();
+#else
     USB_Disable();
     SystemPower_Config();
     GPIO_Config_EXTI();
@@ -29,7 +80,129 @@ void System_Enter_StopMode(void)
     GPIO_LED_Power(ENABLE);
     Display_Init();
     Key_Scan_Init();
+    Keymap_Resume();
+    Link_Init();
+    Event_Init();
+#endif
+}
+/*============================================================
+  * @func:    Pwr_Wake_Report
+  * @brief:   唤醒键报告生成或发出时调用，记录距唤醒的时间，每次唤醒只记录
+  *           第一个报告。可在USB中断中调用
+  * @param:   stage：PWR_WAKE_QUEUE / PWR_WAKE_SEND
+  * @retval:  NA
+  * @modify:  data      remarks
+=============================================================*/
+void Pwr_Wake_Report(uint8_t stage)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint32_t us;
+
+    DISABLE_INT();
+    stage &= s_ucWakeReport;
+    if(stage)
+    {
+        s_ucWakeReport &= ~stage;
+        us = bsp_GetRunTimeUs() - s_uiWakeUs;
+        if(stage & PWR_WAKE_QUEUE)
+        {
+            s_tWakeStat.queue_us = us;
+            Pwr_Wake_Max(&s_tWakeStat.queue_us_max, us);
+        }
+        if(stage & PWR_WAKE_SEND)
+        {
+            s_tWakeStat.send_us = us;
+            Pwr_Wake_Max(&s_tWakeStat.send_us_max, us);
+        }
+    }
+    __set_PRIMASK(primask);
+}
+/*============================================================
+  * @func:    Pwr_Wake_GetStat
+  * @brief:   获取唤醒耗时统计
+  * @param:   NA
+  * @retval:  统计结构体
+  * @modify:  data      remarks
+=============================================================*/
+PWR_WAKE_STAT *Pwr_Wake_GetStat(void)
+{
+    return &s_tWakeStat;
+}
+/*============================================================
+  * @func:    Pwr_Wake_Max
+  * @brief:   更新最大值
+  * @param:   max：最大值 us：本次耗时
+  * @retval:  NA
+  * @modify:  data      remarks
+=============================================================*/
+static void Pwr_Wake_Max(uint32_t *max, uint32_t us)
+{
+    if(us > *max)
+    {
+        *max = us;
+    }
+}
+#if PWR_WARM_RESUME == 1
+/*============================================================
+  * @func:    SystemPower_Save
+  * @brief:   保存各端口IO配置，SystemPower_Config 会把全部IO改为模拟输入
+  * @param:   NA
+  * @retval:  NA
+  * @modify:  data      remarks
+=============================================================*/
+static void SystemPower_Save(void)
+{
+    GPIO_TypeDef *port;
+
+    s_uiGpioClock = RCC->IOPENR;
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+    __HAL_RCC_GPIOC_CLK_ENABLE();
+    __HAL_RCC_GPIOD_CLK_ENABLE();
+    __HAL_RCC_GPIOH_CLK_ENABLE();
+    for (uint8_t i = 0; i < PWR_GPIO_PORTS; ++i)
+    {
+        port = s_tGpioPort[i];
+        s_tGpioSave[i].moder = port->MODER;
+        s_tGpioSave[i].otyper = port->OTYPER;
+        s_tGpioSave[i].ospeedr = port->OSPEEDR;
+        s_tGpioSave[i].pupdr = port->PUPDR;
+        s_tGpioSave[i].odr = port->ODR;
+        s_tGpioSave[i].afr[0] = port->AFR[0];
+        s_tGpioSave[i].afr[1] = port->AFR[1];
+    }
+}
+/*============================================================
+  * @func:    SystemPower_Restore
+  * @brief:   唤醒后恢复IO配置：先写输出电平和复用，最后写模式，
+  *           输出脚切换时直接为STOP前的电平。LED和BLE电源随之恢复
+  * @param:   NA
+  * @retval:  NA
+  * @modify:  data      remarks
+=============================================================*/
+static void SystemPower_Restore(void)
+{
+    GPIO_TypeDef *port;
+
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+    __HAL_RCC_GPIOC_CLK_ENABLE();
+    __HAL_RCC_GPIOD_CLK_ENABLE();
+    __HAL_RCC_GPIOH_CLK_ENABLE();
+    for (uint8_t i = 0; i < PWR_GPIO_PORTS; ++i)
+    {
+        port = s_tGpioPort[i];
+        port->ODR = s_tGpioSave[i].odr;
+        port->AFR[0] = s_tGpioSave[i].afr[0];
+        port->AFR[1] = s_tGpioSave[i].afr[1];
+        port->OTYPER = s_tGpioSave[i].otyper;
+        port->OSPEEDR = s_tGpioSave[i].ospeedr;
+        port->PUPDR = s_tGpioSave[i].pupdr;
+        port->MODER = s_tGpioSave[i].moder;
+    }
+    RCC->IOPENR = s_uiGpioClock;
 }
+#endif
 /*============================================================
   *  @func:    XX
   *  @brief:    XX
@@ -24,6 +24,18 @@ void bsp_Init_PWM(void)
 {
     PWM_Config_74HC595_OE();
 }
+/*============================================================
+    *   @func:      bsp_PWM_SetClock
+    *   @brief:     系统时钟切换后调用，重新装载预分频，PWM周期保持1ms
+    *   @param:     NA
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+void bsp_PWM_SetClock(void)
+{
+    LL_TIM_SetPrescaler(TIM2, HW_TIMER_PSC());
+    LL_TIM_GenerateEvent_UPDATE(TIM2);
+}
 /*============================================================
     *   @func:      PWM_Config_74HC595_OE
     *   @brief:     74HC595 OE 脚PWM配置,使用TIM15
@@ -43,7 +55,7 @@ static void PWM_Config_74HC595_OE(void)
     /* Peripheral clock enable */
     LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_TIM2);
 	
-	  prescalerValue = (SystemCoreClock / 1000000 ) - 1;          //1MHZ
+	  prescalerValue = HW_TIMER_PSC();          //1MHZ
 		Channel1Pulse = LUMINANCE_LEVEL*PERIOD_VALUE / 10;
 	
     TIM_InitStruct.Prescaler = prescalerValue;   //1K 
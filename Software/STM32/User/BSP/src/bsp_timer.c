@@ -12,14 +12,33 @@ static volatile uint32_t s_uiDelayCount = 0;
 static volatile uint8_t s_ucTimeOutFlag = 0;
 
 static SOFT_TMR s_tTmr[TMR_COUNT];
+static volatile uint8_t s_ucTmrHead = TMR_NONE;		/* 差分链表头，最先到期的定时器 */
+static uint32_t s_uiCyclesPerMs;			/* 每毫秒SysTick计数 */
+static uint32_t s_uiUsPerCycQ16;			/* 每个SysTick计数的微秒数，Q16定点 */
+static uint32_t s_uiMaxPeriod;				/* SysTick 24位计数器一次最长定时(ms) */
+static volatile uint32_t s_uiPeriod = 1;	/* 当前SysTick周期(ms) */
+static volatile uint32_t s_uiRem = 0;		/* 当前周期开始时已经过的不足1ms的计数 */
+static volatile uint32_t s_uiTickWakeups = 0;	/* SysTick中断次数 */
 
 __IO int32_t g_iRunTime = 0;
 
-static void bsp_SoftTimerDec(SOFT_TMR *_tmr);
+/* 当前SysTick周期已经过的计数。写VAL后第一个时钟VAL读出为0，第二个时钟才重装 */
+#define TMR_ELAPSED(val)	((val) ? (SysTick->LOAD + 2 - (val)) : 0)
+/* 到期后已经过的计数。计到0后下一个时钟即重装，中断响应前读出为0 */
+#define TMR_OVERRUN(val)	((val) ? (SysTick->LOAD + 1 - (val)) : 0)
+
+static void bsp_TimerInsert(uint8_t _id, uint32_t _ms);
+static void bsp_TimerRemove(uint8_t _id);
+static void bsp_TimerAdvance(uint32_t _ms);
+static void bsp_TimerSync(uint32_t _cyc);
+static void bsp_TimerUpdate(void);
+static void bsp_TimerSetCycles(void);
+static uint32_t bsp_TimerCycToUs(uint32_t _cyc);
 
 /*============================================================
 	*	@func:		bsp_InitTimer
-	*	@brief:		XX
+	*	@brief:		软件定时器初始化。SysTick不再固定1ms中断，
+	*				每次只定时到最近一个定时器到期
 	*	@param:		NA
 	*	@retval:	NA	
 	*	@modify: 	data 			remarks 
@@ -31,78 +50,287 @@ void bsp_InitTimer(void)
 	/* 清零所有的软件定时器 */
 	for (i = 0; i < TMR_COUNT; i++)
 	{
-		s_tTmr[i].Count = 0;
+		s_tTmr[i].Delta = 0;
 		s_tTmr[i].PreLoad = 0;
 		s_tTmr[i].Flag = 0;
 		s_tTmr[i].Mode = TMR_ONCE_MODE;	/* 缺省是一次性工作模式 */
+		s_tTmr[i].Next = TMR_NONE;
+		s_tTmr[i].Active = 0;
+		s_tTmr[i].Callback = 0;
 	}
-	SysTick_Config(SystemCoreClock/1000U);
+	s_ucTmrHead = TMR_NONE;
+	s_uiDelayCount = 0;
+	bsp_TimerSetCycles();
+	SysTick_Config(s_uiCyclesPerMs);
+	DISABLE_INT();
+	s_uiPeriod = 1;
+	s_uiRem = 0;
+	bsp_TimerUpdate();
+	ENABLE_INT();
 }
 /*============================================================
-	*	@func:		bsp_InitTimer
-	*	@brief:		XX
+	*	@func:		bsp_TimerSuspend
+	*	@brief:		进入STOP前调用：软件定时器同步到当前后，SysTick改为无中断的
+	*				24位自由计数。STOP期间内核时钟停止，唤醒后按HSI继续计数，
+	*				用于测量恢复时钟的耗时
+	*	@param:		NA
+	*	@retval:	NA	
+	*	@modify: 	data 			remarks 
+=============================================================*/
+void bsp_TimerSuspend(void)
+{
+	DISABLE_INT();
+	bsp_TimerUpdate();
+	SysTick->CTRL = 0;
+	SysTick->LOAD = SysTick_LOAD_RELOAD_Msk;
+	SysTick->VAL = 0;
+	SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+	SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk;
+	ENABLE_INT();
+}
+/*============================================================
+	*	@func:		bsp_TimerResume
+	*	@brief:		STOP唤醒并恢复系统时钟后调用，定时器链表保留，重新按链表定时。
+	*				STOP期间及恢复时钟期间软件定时器不计时
+	*	@param:		NA
+	*	@retval:	唤醒后到此的时间(us)，全部按唤醒时钟HSI折算，切换PLL后的
+	*				少量计数被算大，结果偏保守
+	*	@modify: 	data 			remarks 
+=============================================================*/
+uint32_t bsp_TimerResume(void)
+{
+	uint32_t cycles = SysTick_LOAD_RELOAD_Msk - SysTick->VAL;
+
+	bsp_TimerSetCycles();
+	SysTick_Config(s_uiCyclesPerMs);
+	DISABLE_INT();
+	s_uiPeriod = 1;
+	s_uiRem = 0;
+	bsp_TimerUpdate();
+	ENABLE_INT();
+	return cycles / (HSI_VALUE / 1000000U);
+}
+/*============================================================
+	*	@func:		bsp_TimerSetClock
+	*	@brief:		系统时钟切换后立即调用，需关中断。已经过的时间按旧频率计入，
+	*				不足1ms的计数换算为新频率后重新定时
+	*	@param:		NA
+	*	@retval:	NA	
+	*	@modify: 	data 			remarks 
+=============================================================*/
+void bsp_TimerSetClock(void)
+{
+	uint32_t old = s_uiCyclesPerMs;
+
+	bsp_TimerUpdate();
+	bsp_TimerSetCycles();
+	bsp_TimerSync(s_uiRem * s_uiCyclesPerMs / old);
+}
+/*============================================================
+	*	@func:		bsp_TimerSetCycles
+	*	@brief:		按当前 SystemCoreClock 计算每毫秒计数、最长定时和计数换算系数
+	*	@param:		NA
+	*	@retval:	NA	
+	*	@modify: 	data 			remarks 
+=============================================================*/
+static void bsp_TimerSetCycles(void)
+{
+	s_uiCyclesPerMs = SystemCoreClock / 1000U;
+	s_uiUsPerCycQ16 = (1000U << 16) / s_uiCyclesPerMs;
+	s_uiMaxPeriod = (SysTick_LOAD_RELOAD_Msk + 1) / s_uiCyclesPerMs;
+}
+/*============================================================
+	*	@func:		bsp_TimerCycToUs
+	*	@brief:		SysTick计数换算为微秒，整毫秒部分精确，不足1ms的部分按Q16系数
+	*	@param:		_cyc：计数
+	*	@retval:	微秒
+	*	@modify: 	data 			remarks 
+=============================================================*/
+static uint32_t bsp_TimerCycToUs(uint32_t _cyc)
+{
+	uint32_t ms = _cyc / s_uiCyclesPerMs;
+
+	_cyc -= ms * s_uiCyclesPerMs;
+	return ms * 1000U + ((_cyc * s_uiUsPerCycQ16) >> 16);
+}
+/*============================================================
+	*	@func:		SysTick_ISR
+	*	@brief:		一个SysTick周期结束：推进时间，处理到期的定时器，
+	*				再定时到下一个到期时间
 	*	@param:		NA
 	*	@retval:	NA	
 	*	@modify: 	data 			remarks 
 =============================================================*/
-extern void bsp_RunPer1ms(void);
-extern void bsp_RunPer10ms(void);
 void SysTick_ISR(void)
 {
-	static uint8_t s_count = 0;
-	uint8_t i;
+	s_uiTickWakeups++;
+	bsp_TimerAdvance(s_uiPeriod);
+	bsp_TimerSync(TMR_OVERRUN(SysTick->VAL));
+}
+/*============================================================
+	*	@func:		bsp_TimerUpdate
+	*	@brief:		在主程序中把时间同步到当前，并按链表重新定时，需关中断调用。
+	*				SysTick已到期但中断尚未执行时，在这里代为处理
+	*	@param:		NA
+	*	@retval:	NA	
+	*	@modify: 	data 			remarks 
+=============================================================*/
+static void bsp_TimerUpdate(void)
+{
+	uint32_t val = SysTick->VAL;
 
-	if (s_uiDelayCount > 0)
+	if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)
 	{
-		if (--s_uiDelayCount == 0)
-		{
-			s_ucTimeOutFlag = 1;
-		}
+		bsp_TimerAdvance(s_uiPeriod);
+		bsp_TimerSync(TMR_OVERRUN(SysTick->VAL));
 	}
+	else
+	{
+		bsp_TimerSync(s_uiRem + TMR_ELAPSED(val));
+	}
+}
+/*============================================================
+	*	@func:		bsp_TimerSync
+	*	@brief:		把本周期已经过的整毫秒计入时间，然后按最近到期时间
+	*				重新装载SysTick。不足1ms的部分从新周期中扣除，不累积误差。
+	*				需关中断或在SysTick中断中调用
+	*	@param:		_cyc：本周期起点(整毫秒)之后已经过的计数
+	*	@retval:	NA	
+	*	@modify: 	data 			remarks 
+=============================================================*/
+static void bsp_TimerSync(uint32_t _cyc)
+{
+	uint32_t ms;
 
-	for (i = 0; i < TMR_COUNT; i++)
+	ms = _cyc / s_uiCyclesPerMs;
+	if (ms)
 	{
-		bsp_SoftTimerDec(&s_tTmr[i]);
+		bsp_TimerAdvance(ms);
+		_cyc -= ms * s_uiCyclesPerMs;
 	}
 
-	g_iRunTime++;
-	if (g_iRunTime == 0x7FFFFFFF)	
+	ms = s_uiMaxPeriod;
+	if ((s_ucTmrHead != TMR_NONE) && (s_tTmr[s_ucTmrHead].Delta < ms))
 	{
-		g_iRunTime = 0;
+		ms = s_tTmr[s_ucTmrHead].Delta;
 	}
+	if (s_uiDelayCount && (s_uiDelayCount < ms))
+	{
+		ms = s_uiDelayCount;
+	}
+	if (ms == 0)
+	{
+		ms = 1;
+	}
+	s_uiPeriod = ms;
+	s_uiRem = _cyc;
+	/* 写VAL后下一个时钟才重装，周期为 LOAD+2 个计数 */
+	_cyc = ms * s_uiCyclesPerMs - _cyc;
+	SysTick->LOAD = (_cyc > 2) ? (_cyc - 2) : 1;
+	SysTick->VAL = 0;				/* 立即按新的LOAD重新计数 */
+	SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk;	/* 读取VAL之后的到期已计入 */
+}
+/*============================================================
+	*	@func:		bsp_TimerAdvance
+	*	@brief:		时间前进 _ms 毫秒，链表头依次到期：置标志、执行回调，
+	*				自动模式以到期时刻为起点重新插入
+	*	@param:		_ms：经过的时间
+	*	@retval:	NA	
+	*	@modify: 	data 			remarks 
+=============================================================*/
+static void bsp_TimerAdvance(uint32_t _ms)
+{
+	SOFT_TMR *tmr;
+	uint8_t id;
 
-	bsp_RunPer1ms();		
+	g_iRunTime = (int32_t)(((uint32_t)g_iRunTime + _ms) & 0x7FFFFFFF);
 
-	if (++s_count >= 10)
+	if (s_uiDelayCount > 0)
 	{
-		s_count = 0;
+		if (s_uiDelayCount <= _ms)
+		{
+			s_uiDelayCount = 0;
+			s_ucTimeOutFlag = 1;
+		}
+		else
+		{
+			s_uiDelayCount -= _ms;
+		}
+	}
 
-		bsp_RunPer10ms();	
+	while (s_ucTmrHead != TMR_NONE)
+	{
+		id = s_ucTmrHead;
+		tmr = &s_tTmr[id];
+		if (tmr->Delta > _ms)
+		{
+			tmr->Delta -= _ms;
+			break;
+		}
+		_ms -= tmr->Delta;
+		s_ucTmrHead = tmr->Next;
+		tmr->Active = 0;
+		tmr->Flag = 1;
+		if (tmr->Mode == TMR_AUTO_MODE)
+		{
+			bsp_TimerInsert(id, tmr->PreLoad);
+		}
+		if (tmr->Callback)
+		{
+			tmr->Callback();
+		}
 	}
 }
-
 /*============================================================
-	*	@func:		bsp_SoftTimerDec
-	*	@brief:		XX
-	*	@param:		NA
+	*	@func:		bsp_TimerInsert
+	*	@brief:		按到期时间插入差分链表，相同到期时间排在后面
+	*	@param:		_id：定时器ID _ms：距链表起点的时间
 	*	@retval:	NA	
 	*	@modify: 	data 			remarks 
 =============================================================*/
-static void bsp_SoftTimerDec(SOFT_TMR *_tmr)
+static void bsp_TimerInsert(uint8_t _id, uint32_t _ms)
 {
-	if (_tmr->Count > 0)
+	volatile uint8_t *link = &s_ucTmrHead;
+
+	while ((*link != TMR_NONE) && (s_tTmr[*link].Delta <= _ms))
 	{
-		
-		if (--_tmr->Count == 0)
-		{
-			_tmr->Flag = 1;
+		_ms -= s_tTmr[*link].Delta;
+		link = &s_tTmr[*link].Next;
+	}
+	if (*link != TMR_NONE)
+	{
+		s_tTmr[*link].Delta -= _ms;
+	}
+	s_tTmr[_id].Delta = _ms;
+	s_tTmr[_id].Next = *link;
+	s_tTmr[_id].Active = 1;
+	*link = _id;
+}
+/*============================================================
+	*	@func:		bsp_TimerRemove
+	*	@brief:		从差分链表中移除，时间差并入下一项
+	*	@param:		_id：定时器ID
+	*	@retval:	NA	
+	*	@modify: 	data 			remarks 
+=============================================================*/
+static void bsp_TimerRemove(uint8_t _id)
+{
+	volatile uint8_t *link = &s_ucTmrHead;
 
-			if(_tmr->Mode == TMR_AUTO_MODE)
-			{
-				_tmr->Count = _tmr->PreLoad;
-			}
-		}
+	if (!s_tTmr[_id].Active)
+	{
+		return;
+	}
+	while (*link != _id)
+	{
+		link = &s_tTmr[*link].Next;
 	}
+	*link = s_tTmr[_id].Next;
+	if (*link != TMR_NONE)
+	{
+		s_tTmr[*link].Delta += s_tTmr[_id].Delta;
+	}
+	s_tTmr[_id].Active = 0;
 }
 /*============================================================
 	*	@func:		bsp_DelayMS
@@ -124,8 +352,10 @@ void bsp_DelayMS(uint32_t n)
 
 	DISABLE_INT();  			
 
+	bsp_TimerUpdate();
 	s_uiDelayCount = n;
 	s_ucTimeOutFlag = 0;
+	bsp_TimerUpdate();
 
 	ENABLE_INT();  				
 
@@ -141,50 +371,26 @@ void bsp_DelayMS(uint32_t n)
 
 /*============================================================
 	*	@func:		bsp_DelayUS
-	*	@brief:		XX
-	*	@param:		NA
+	*	@brief:		按 TIM22 微秒计数器忙等，不读SysTick。SysTick随软件定时器
+	*				随时重装，中断或定时器操作打断延时也不影响计时。
+	*				至少延时 n us，长延时分段避免16位计数回绕
+	*	@param:		n：延时时间(us)
 	*	@retval:	NA	
 	*	@modify: 	data 			remarks 
 =============================================================*/
 void bsp_DelayUS(uint32_t n)
 {
-    uint32_t ticks;
-    uint32_t told;
-    uint32_t tnow;
-    uint32_t tcnt = 0;
-    uint32_t reload;
-       
-		reload = SysTick->LOAD;                
-    ticks = n * (SystemCoreClock / 1000000);	 
-    
-    tcnt = 0;
-    told = SysTick->VAL;            
-
-    while (1)
-    {
-        tnow = SysTick->VAL;    
-        if (tnow != told)
-        {    
- 
-            if (tnow < told)
-            {
-                tcnt += told - tnow;    
-            }
-          
-            else
-            {
-                tcnt += reload - tnow + told;    
-            }        
-            told = tnow;
-
-    
-            if (tcnt >= ticks)
-            {
-            	break;
-            }
-        }  
-    }
-} 
+	uint16_t start;
+	uint16_t us;
+
+	while (n)
+	{
+		us = (n > 0x8000U) ? 0x8000U : (uint16_t)n;
+		n -= us;
+		start = bsp_UsTimer_Now();
+		while ((uint16_t)(bsp_UsTimer_Now() - start) <= us);	/* 起点读数最多已过1us */
+	}
+}
 
 
 /*============================================================
@@ -203,10 +409,16 @@ void bsp_StartTimer(uint8_t _id, uint32_t _period)
 
 	DISABLE_INT();  			
 
-	s_tTmr[_id].Count = _period;		
+	bsp_TimerUpdate();				/* 链表起点对齐到当前时间 */
+	bsp_TimerRemove(_id);
 	s_tTmr[_id].PreLoad = _period;		
 	s_tTmr[_id].Flag = 0;				
 	s_tTmr[_id].Mode = TMR_ONCE_MODE;	
+	if (_period)
+	{
+		bsp_TimerInsert(_id, _period);
+		bsp_TimerUpdate();
+	}
 
 	ENABLE_INT();  				
 }
@@ -227,10 +439,16 @@ void bsp_StartAutoTimer(uint8_t _id, uint32_t _period)
 
 	DISABLE_INT();  		
 
-	s_tTmr[_id].Count = _period;			
+	bsp_TimerUpdate();
+	bsp_TimerRemove(_id);
 	s_tTmr[_id].PreLoad = _period;		/*  */
 	s_tTmr[_id].Flag = 0;				/*  */
 	s_tTmr[_id].Mode = TMR_AUTO_MODE;	/*  */
+	if (_period)
+	{
+		bsp_TimerInsert(_id, _period);
+		bsp_TimerUpdate();
+	}
 
 	ENABLE_INT();  			/*  */
 }
@@ -252,7 +470,7 @@ void bsp_StopTimer(uint8_t _id)
 
 	DISABLE_INT();  	/*  */
 
-	s_tTmr[_id].Count = 0;				/*  */
+	bsp_TimerRemove(_id);				/*  */
 	s_tTmr[_id].Flag = 0;				/*  */
 	s_tTmr[_id].Mode = TMR_ONCE_MODE;	/*  */
 
@@ -284,26 +502,111 @@ uint8_t bsp_CheckTimer(uint8_t _id)
 	}
 }
 
+/*============================================================
+	*	@func:		bsp_SetTimerCallback
+	*	@brief:		设置定时器到时回调，回调在SysTick中断中执行，
+	*				可替代 bsp_CheckTimer 查询
+	*	@param:		_id：定时器ID _cb：回调，0为不回调
+	*	@retval:	NA	
+	*	@modify: 	data 			remarks 
+=============================================================*/
+void bsp_SetTimerCallback(uint8_t _id, TMR_CALLBACK _cb)
+{
+	if (_id >= TMR_COUNT)
+	{
+		while(1);
+	}
+
+	DISABLE_INT();
+	s_tTmr[_id].Callback = _cb;
+	ENABLE_INT();
+}
+
 /*============================================================
 	*	@func:		bsp_GetRunTime
-	*	@brief:		XX
+	*	@brief:		运行时间(ms)。g_iRunTime 只在SysTick到期时更新，
+	*				加上当前周期已经过的时间
 	*	@param:		NA
 	*	@retval:	NA	
 	*	@modify: 	data 			remarks 
 =============================================================*/
 int32_t bsp_GetRunTime(void)
 {
-	int32_t runtime;
+	uint32_t runtime;
+	uint32_t val;
 
 	DISABLE_INT();  	/*  */
 
+	val = SysTick->VAL;
 	runtime = g_iRunTime;	/*  */
+	if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)
+	{
+		runtime += s_uiPeriod;
+	}
+	else
+	{
+		runtime += (s_uiRem + TMR_ELAPSED(val)) / s_uiCyclesPerMs;
+	}
 
 	ENABLE_INT();  		/*  */
 
+	return (int32_t)(runtime & 0x7FFFFFFF);
+}
+
+/*============================================================
+	*	@func:		bsp_GetRunTimeUs
+	*	@brief:		运行时间(us)，约71分钟回绕，只用于计算时间差。
+	*				保存并恢复中断状态，可在中断和关中断区域中调用
+	*	@param:		NA
+	*	@retval:	运行时间
+	*	@modify: 	data 			remarks 
+=============================================================*/
+uint32_t bsp_GetRunTimeUs(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	uint32_t runtime;
+	uint32_t val;
+
+	DISABLE_INT();
+	val = SysTick->VAL;
+	runtime = (uint32_t)g_iRunTime * 1000U;
+	if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)
+	{
+		runtime += s_uiPeriod * 1000U + bsp_TimerCycToUs(TMR_OVERRUN(SysTick->VAL));
+	}
+	else
+	{
+		runtime += bsp_TimerCycToUs(s_uiRem + TMR_ELAPSED(val));
+	}
+	__set_PRIMASK(primask);
+
 	return runtime;
 }
 
+/*============================================================
+	*	@func:		bsp_GetTickWakeups
+	*	@brief:		SysTick中断次数，用于统计每秒唤醒次数
+	*	@param:		NA
+	*	@retval:	中断次数
+	*	@modify: 	data 			remarks 
+=============================================================*/
+uint32_t bsp_GetTickWakeups(void)
+{
+	return s_uiTickWakeups;
+}
+
+/*============================================================
+	*	@func:		HAL_InitTick
+	*	@brief:		覆盖HAL的弱函数。SysTick由本文件管理，HAL_RCC_ClockConfig
+	*				切换时钟时不再把它改回1ms周期中断
+	*	@param:		TickPriority：未使用
+	*	@retval:	HAL_OK
+	*	@modify: 	data 			remarks 
+=============================================================*/
+HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority)
+{
+	return HAL_OK;
+}
 /*============================================================
 	*	@func:		SysTick_Handler
 	*	@brief:		XX
@@ -20,6 +20,8 @@ static void UartSend(UART_T *_pUart, uint8_t *_ucaBuf, uint16_t _usLen);
 static uint8_t UartGetChar(UART_T *_pUart, uint8_t *_pByte);
 static void UartIRQ(UART_T *_pUart);
 static void ConfigUartNVIC(void);
+static void UartDmaKick(UART_T *_pUart);
+static void UartDmaIRQ(UART_T *_pUart);
 
 /*
 *********************************************************************************************************
@@ -99,6 +101,65 @@ void comSendBuf(COM_PORT_E _ucPort, uint8_t *_ucaBuf, uint16_t _usLen)
 	UartSend(pUart, _ucaBuf, _usLen);
 }
 
+/*
+*********************************************************************************************************
+*	  : comSendBufNoCopy
+*	˵: 㿽ͣDMAֱӶȡߵĻдFIFO֮󷢳
+*			  ÿͬʱֻһ㿽ǰ߲ܸдû
+*	    : _ucPort: ˿ں(COM1 - COM6)
+*			  _ucaBuf: ͵ݻ
+*			  _usLen : ݳ
+*	  ֵ: 1 ʾѽգ0 ʾһ㿽δ򴮿δʹDMAδ
+*********************************************************************************************************
+*/
+uint8_t comSendBufNoCopy(COM_PORT_E _ucPort, uint8_t *_ucaBuf, uint16_t _usLen)
+{
+	UART_T *pUart;
+
+	pUart = ComToUart(_ucPort);
+	if ((pUart == 0) || (pUart->ucTxDma == 0) || (_usLen == 0))
+	{
+		return 0;
+	}
+
+	DISABLE_INT();
+	if (pUart->pTxExt != 0)
+	{
+		ENABLE_INT();
+		return 0;
+	}
+	if (pUart->SendBefor != 0)
+	{
+		pUart->SendBefor();
+	}
+	pUart->pTxExt = _ucaBuf;
+	pUart->usTxExtLen = _usLen;
+	pUart->usTxExtMark = pUart->usTxCount;
+	UartDmaKick(pUart);
+	ENABLE_INT();
+	return 1;
+}
+
+/*
+*********************************************************************************************************
+*	  : comNoCopyBusy
+*	˵: 㿽Ƿڵȴ
+*	    : _ucPort: ˿ں(COM1 - COM6)
+*	  ֵ: 1 ʾæ0 ʾ
+*********************************************************************************************************
+*/
+uint8_t comNoCopyBusy(COM_PORT_E _ucPort)
+{
+	UART_T *pUart;
+
+	pUart = ComToUart(_ucPort);
+	if (pUart == 0)
+	{
+		return 0;
+	}
+	return (pUart->pTxExt != 0);
+}
+
 /*
 *********************************************************************************************************
 *	  : comSendChar
@@ -153,9 +214,17 @@ void comClearTxFifo(COM_PORT_E _ucPort)
 		return;
 	}
 
+	DISABLE_INT();
+	if (pUart->ucTxDma)
+	{
+		LL_DMA_DisableChannel(DMA1, UART1_TX_DMA_CH);
+		pUart->usTxDmaLen = 0;
+		pUart->pTxExt = 0;
+	}
 	pUart->usTxWrite = 0;
 	pUart->usTxRead = 0;
 	pUart->usTxCount = 0;
+	ENABLE_INT();
 }
 
 /*
@@ -180,6 +249,70 @@ void comClearRxFifo(COM_PORT_E _ucPort)
 	pUart->usRxRead = 0;
 	pUart->usRxCount = 0;
 }
+
+/*
+*********************************************************************************************************
+*	  : comSetReceiveNew
+*	˵: ýջصFIFOɿձΪǿʱڴже
+*	    : _ucPort: ˿ں(COM1 - COM6)
+*			  _pCallback: ص0Ϊص
+*	  ֵ: 
+*********************************************************************************************************
+*/
+void comSetReceiveNew(COM_PORT_E _ucPort, void (*_pCallback)(void))
+{
+	UART_T *pUart;
+
+	pUart = ComToUart(_ucPort);
+	if (pUart == 0)
+	{
+		return;
+	}
+
+	pUart->ReciveNew = _pCallback;
+}
+/*
+*********************************************************************************************************
+*	  : comTxIdle
+*	˵: FIFODMA㿽ѷ꣬һֽƳ
+*	    : _ucPort: ˿ں(COM1 - COM6)
+*	  ֵ: 1 ʾУ0 ʾڷ
+*********************************************************************************************************
+*/
+uint8_t comTxIdle(COM_PORT_E _ucPort)
+{
+	UART_T *pUart;
+
+	pUart = ComToUart(_ucPort);
+	if (pUart == 0)
+	{
+		return 1;
+	}
+	if (pUart->usTxCount || pUart->usTxDmaLen || pUart->pTxExt)
+	{
+		return 0;
+	}
+	return (LL_USART_IsActiveFlag_TC(pUart->uart) != RESET);
+}
+
+/*
+*********************************************************************************************************
+*	  : bsp_UartSetClock
+*	˵: ϵͳʱлµPCLK¼㲨ʣжϵáǰӦȷϷͿУ
+*			  BRRֻUE=0ʱд룬ʱڽյֽڻᶪʧ·CRCطָ
+*	    : 
+*	  ֵ: 
+*********************************************************************************************************
+*/
+void bsp_UartSetClock(void)
+{
+#if UART1_FIFO_EN == 1
+	LL_USART_Disable(USART1);
+	LL_USART_SetBaudRate(USART1, SystemCoreClock, LL_USART_OVERSAMPLING_8, UART1_BAUD);
+	LL_USART_Enable(USART1);
+#endif
+}
+
 /*
 *********************************************************************************************************
 *	  : UartVarInit
@@ -205,6 +338,13 @@ static void UartVarInit(void)
 	g_tUart1.SendBefor = 0;						/* ǰĻص */
 	g_tUart1.SendOver = 0;						/* ϺĻص */
 	g_tUart1.ReciveNew = 0;						/* յݺĻص */
+	g_tUart1.ucTxDma = UART1_TX_DMA_EN;			/* DMA */
+	g_tUart1.ucTxDmaExt = 0;
+	g_tUart1.usTxDmaLen = 0;
+	g_tUart1.usTxDmaDone = 0;
+	g_tUart1.pTxExt = 0;						/* 㿽 */
+	g_tUart1.usTxExtLen = 0;
+	g_tUart1.usTxExtMark = 0;
 #endif
 
 #if UART2_FIFO_EN == 1
@@ -222,6 +362,8 @@ static void UartVarInit(void)
 	g_tUart2.SendBefor = 0;						/* ǰĻص */
 	g_tUart2.SendOver = 0;						/* ϺĻص */
 	g_tUart2.ReciveNew = 0;						/* յݺĻص */
+	g_tUart2.ucTxDma = 0;						/* ֽжϷ */
+	g_tUart2.pTxExt = 0;
 #endif
 
 }
@@ -279,6 +421,20 @@ static void InitHardUart(void)
 
   LL_USART_ClearFlag_TC(USART1);
 
+#if UART1_TX_DMA_EN == 1
+  /* USART1_TX DMA洢裬ֽڿȣ洢ַ봫ʹж */
+  LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_DMA1);
+  LL_DMA_DisableChannel(DMA1, UART1_TX_DMA_CH);
+  LL_DMA_SetPeriphRequest(DMA1, UART1_TX_DMA_CH, LL_DMA_REQUEST_3);
+  LL_DMA_ConfigTransfer(DMA1, UART1_TX_DMA_CH, LL_DMA_DIRECTION_MEMORY_TO_PERIPH | LL_DMA_PRIORITY_LOW |
+                        LL_DMA_MODE_NORMAL | LL_DMA_PERIPH_NOINCREMENT | LL_DMA_MEMORY_INCREMENT |
+                        LL_DMA_PDATAALIGN_BYTE | LL_DMA_MDATAALIGN_BYTE);
+  LL_DMA_SetPeriphAddress(DMA1, UART1_TX_DMA_CH, LL_USART_DMA_GetRegAddr(USART1, LL_USART_DMA_REG_DATA_TRANSMIT));
+  LL_DMA_ClearFlag_GI4(DMA1);
+  LL_DMA_EnableIT_HT(DMA1, UART1_TX_DMA_CH);
+  LL_DMA_EnableIT_TC(DMA1, UART1_TX_DMA_CH);
+  LL_USART_EnableDMAReq_TX(USART1);
+#endif
 }
 
 /*
@@ -293,12 +449,16 @@ static void ConfigUartNVIC(void)
 {
 	NVIC_SetPriority(USART1_IRQn,3);
   NVIC_EnableIRQ(USART1_IRQn);
+#if UART1_TX_DMA_EN == 1
+	NVIC_SetPriority(DMA1_Channel4_5_6_7_IRQn,3);
+  NVIC_EnableIRQ(DMA1_Channel4_5_6_7_IRQn);
+#endif
 }
 
 /*
 *********************************************************************************************************
 *	  : UartSend
-*	˵: дݵUARTͻ,жϡжϴϺԶرշж
+*	˵: дݵUARTͻ,жϻDMAжϴϺԶرշж
 *	    :  
 *	  ֵ: 
 *********************************************************************************************************
@@ -314,6 +474,10 @@ static void UartSend(UART_T *_pUart, uint8_t *_ucaBuf, uint16_t _usLen)
 			uint16_t usCount;
 
 			DISABLE_INT();
+			if (_pUart->ucTxDma && (_pUart->usTxCount >= _pUart->usTxBufSize))
+			{
+				UartDmaKick(_pUart);	/* FIFOȰдݽDMA */
+			}
 			usCount = _pUart->usTxCount;
 			ENABLE_INT();
 
@@ -334,7 +498,132 @@ static void UartSend(UART_T *_pUart, uint8_t *_ucaBuf, uint16_t _usLen)
 		_pUart->usTxCount++;
 		ENABLE_INT();
 	}
-	LL_USART_EnableIT_TXE(_pUart->uart);
+	if (_pUart->ucTxDma)
+	{
+		DISABLE_INT();
+		UartDmaKick(_pUart);
+		ENABLE_INT();
+	}
+	else
+	{
+		LL_USART_EnableIT_TXE(_pUart->uart);
+	}
+}
+
+/*
+*********************************************************************************************************
+*	  : UartDmaKick
+*	˵: DMAʱһη͡FIFOеݰһֱӽDMAƴΣ
+*			  㿽֮ǰдFIFOݷ͡ڹжϻDMAже
+*	    : _pUart : 豸
+*	  ֵ: 
+*********************************************************************************************************
+*/
+static void UartDmaKick(UART_T *_pUart)
+{
+	uint8_t *pBuf;
+	uint16_t usLen;
+
+	if (_pUart->usTxDmaLen != 0)	/* DMAڷ */
+	{
+		return;
+	}
+
+	if ((_pUart->pTxExt != 0) && (_pUart->usTxExtMark == 0))
+	{
+		pBuf = _pUart->pTxExt;
+		usLen = _pUart->usTxExtLen;
+		_pUart->ucTxDmaExt = 1;
+	}
+	else
+	{
+		usLen = _pUart->usTxCount;
+		if ((_pUart->pTxExt != 0) && (usLen > _pUart->usTxExtMark))
+		{
+			usLen = _pUart->usTxExtMark;
+		}
+		if (usLen > _pUart->usTxBufSize - _pUart->usTxRead)
+		{
+			usLen = _pUart->usTxBufSize - _pUart->usTxRead;
+		}
+		if (usLen == 0)
+		{
+			return;
+		}
+		pBuf = &_pUart->pTxBuf[_pUart->usTxRead];
+		_pUart->ucTxDmaExt = 0;
+	}
+
+	_pUart->usTxDmaLen = usLen;
+	_pUart->usTxDmaDone = 0;
+	LL_DMA_DisableChannel(DMA1, UART1_TX_DMA_CH);
+	LL_DMA_SetMemoryAddress(DMA1, UART1_TX_DMA_CH, (uint32_t)pBuf);
+	LL_DMA_SetDataLength(DMA1, UART1_TX_DMA_CH, usLen);
+	LL_DMA_EnableChannel(DMA1, UART1_TX_DMA_CH);
+}
+
+/*
+*********************************************************************************************************
+*	  : UartDmaIRQ
+*	˵: DMA봫/жϴDMAѶߵֽڹ黹FIFO(ƽusTxRead)
+*			  ɺһ
+*	    : _pUart : 豸
+*	  ֵ: 
+*********************************************************************************************************
+*/
+static void UartDmaIRQ(UART_T *_pUart)
+{
+	uint8_t ucDone;
+	uint16_t usSent;
+	uint16_t usFree;
+
+	ucDone = LL_DMA_IsActiveFlag_TC4(DMA1);
+	LL_DMA_ClearFlag_HT4(DMA1);
+	if (ucDone)
+	{
+		LL_DMA_ClearFlag_TC4(DMA1);		/* ֻѶɱ־ⶪʧ֮󵽴ж */
+	}
+
+	if (_pUart->usTxDmaLen == 0)
+	{
+		return;
+	}
+
+	if (_pUart->ucTxDmaExt)
+	{
+		if (ucDone)
+		{
+			_pUart->pTxExt = 0;		/* 㿽ϣ߿Ըд */
+		}
+	}
+	else
+	{
+		usSent = _pUart->usTxDmaLen;
+		if (!ucDone)
+		{
+			usSent -= LL_DMA_GetDataLength(DMA1, UART1_TX_DMA_CH);
+		}
+		usFree = usSent - _pUart->usTxDmaDone;
+		_pUart->usTxDmaDone = usSent;
+
+		_pUart->usTxRead += usFree;
+		if (_pUart->usTxRead >= _pUart->usTxBufSize)
+		{
+			_pUart->usTxRead -= _pUart->usTxBufSize;
+		}
+		_pUart->usTxCount -= usFree;
+		if (_pUart->pTxExt != 0)
+		{
+			_pUart->usTxExtMark -= usFree;
+		}
+	}
+
+	if (ucDone)
+	{
+		LL_DMA_DisableChannel(DMA1, UART1_TX_DMA_CH);
+		_pUart->usTxDmaLen = 0;
+		UartDmaKick(_pUart);
+	}
 }
 
 /*
@@ -411,8 +700,8 @@ static void UartIRQ(UART_T *_pUart)
 		}		
 	}
 
-	/* ͻж */
-	if (LL_USART_IsActiveFlag_TXE(_pUart->uart) != RESET)
+	/* ͻжϣDMAʱTXEжϲʹܣ˷֧ */
+	if ((LL_USART_IsEnabledIT_TXE(_pUart->uart) != RESET) && (LL_USART_IsActiveFlag_TXE(_pUart->uart) != RESET))
 	{
 		//if (_pUart->usTxRead == _pUart->usTxWrite)
 		if (_pUart->usTxCount == 0)
@@ -436,7 +725,7 @@ static void UartIRQ(UART_T *_pUart)
 
 	}
 	/* bitλȫϵж */
-	else if (LL_USART_IsActiveFlag_TC(_pUart->uart) != RESET)
+	else if ((LL_USART_IsEnabledIT_TC(_pUart->uart) != RESET) && (LL_USART_IsActiveFlag_TC(_pUart->uart) != RESET))
 	{
 		//if (_pUart->usTxRead == _pUart->usTxWrite)
 		if (_pUart->usTxCount == 0)
@@ -480,6 +769,13 @@ void USART1_IRQHandler(void)
 }
 #endif
 
+#if (UART1_FIFO_EN == 1) && (UART1_TX_DMA_EN == 1)
+void DMA1_Channel4_5_6_7_IRQHandler(void)
+{
+	UartDmaIRQ(&g_tUart1);
+}
+#endif
+
 #if UART2_FIFO_EN == 1
 void USART2_IRQHandler(void)
 {
@@ -10,132 +10,463 @@
 extern PCD_HandleTypeDef hpcd;
 extern USBD_HandleTypeDef USBD_Device;
 uint8_t report_release[8]={0,0,0,0,0,0,0,0};
-uint8_t report_buf[8]={0,0,0,0,0,0,0,0};
+uint8_t report_buf[HID_BOOT_REPORT_LEN]={0,0,0,0,0,0,0,0};	//6KRO启动报告
+uint8_t nkro_buf[HID_NKRO_REPORT_LEN];						//NKRO位图报告
 uint8_t send_report_flag=0;				//USB 发送报告标志
-static uint8_t FN0_Press_Flag=0;		//FN键按下标志 1：按下 0：释放
+
+static uint8_t modifier_key=0;						//功能键状态
+static uint8_t key_bits[HID_NKRO_KEY_MAX / 8];		//按键位图，bit n 对应键值 n
+static uint32_t s_uiConsumer=0;						//消费类按键位图，位序与报告描述符一致
+static uint8_t s_ucSystem=0;						//系统控制按键位图
+static uint8_t s_ucUsageDirty=0;					//待发送的消费类/系统控制报告
+static uint8_t s_ucReportPending=0;					//报告队列满未入队，等待EVT_USB_TX重发
+
+#define USAGE_DIRTY_CONSUMER	0x01
+#define USAGE_DIRTY_SYSTEM		0x02
+#define USAGE_BIT_NONE			0xFF
+/* KC_SYSTEM_POWER~KC_BRIGHTNESS_DOWN 在报告中的位，前3个属于系统控制报告 */
+static const uint8_t s_ucUsageBit[KC_BRIGHTNESS_DOWN - KC_SYSTEM_POWER + 1]=
+{
+	0, 1, 2,										//Power Sleep Wake
+	5, 6, 7, 0, 1, USAGE_BIT_NONE, USAGE_BIT_NONE,	//Mute VolUp VolDown Next Prev FFwd Rew
+	2, 4, 3, 8, 9, 10, 11,							//Stop Play Eject Select Mail Calc MyComputer
+	12, 13, 14, 15, 16, 17, 18,						//Search Home Back Forward Stop Refresh Favorites
+	19, 20											//BrightnessUp BrightnessDown
+};
 
 static uint8_t USB_BLE_Switch=1;
+#if HID_LOW_LATENCY == 1
+static volatile uint8_t s_ucSofFlag=0;		//USB SOF 到达标志
+static volatile int32_t s_iSofTime=0;		//最近一次 SOF 的时间
+#endif
+
+static uint8_t Keyboard_Scan_Tick(void);
+static void Keyboard_Event_Handle(void);
+static void Keyboard_Build_Boot(uint8_t *buf, uint8_t mod, uint8_t *bits_map);
+static void Keyboard_Build_NKRO(uint8_t *buf, uint8_t mod, uint8_t *bits);
+static void Keyboard_Usage(uint8_t key_code, uint8_t pressed);
+static void Keyboard_SendUsage(void);
 /*============================================================
-	*	@func:		XX
-	*	@brief:		XX
+	*	@func:		Keyboard_Task
+	*	@brief:		键盘任务。先处理扫描中断写入事件环的按键事件，再按节拍
+	*				启动下一轮扫描，行稳定等待和比较都不占用主循环
 	*	@param:		NA
 	*	@retval:	NA	
 	*	@modify: 	data 			remarks 
 =============================================================*/
 void Keyboard_Task(void)
 {
-	if(!bsp_CheckTimer(TMR_KEY_SCAN))
+	if(Key_Scan_Done())
 	{
-		return;
+		Keyboard_Event_Handle();
+		Key_Scan_Idle_Check();
+	}
+	else if(s_ucReportPending)		//队列满时未入队的报告，端点发送完成后重发，入队后继续取事件
+	{
+		Keyboard_Event_Handle();
+	}
+	if(Keyboard_Scan_Tick())
+	{
+		Key_Scan();
 	}
-	static uint16_t matrix_prev[MATRIX_ROWS];
-	uint16_t matrix_now=0;
-	uint16_t matrix_change=0;
+	Report_Queue_Kick();		//STOP唤醒后USB枚举完成，发出保留的报告
+}
+/*============================================================
+	*	@func:		Keyboard_Event_Handle
+	*	@brief:		依次取出事件环中的按键事件处理并发送报告。主循环被耽误时
+	*				环中可能有多轮扫描的事件，每轮扫描单独发送一次报告，
+	*				快速敲击的按下和释放不会合并成一个报告。报告队列满时
+	*				停止取事件，先重发未入队的快照，其余事件留在事件环中
+	*	@param:		NA
+	*	@retval:	NA	
+	*	@modify: 	data 			remarks 
+=============================================================*/
+static void Keyboard_Event_Handle(void)
+{
+	static uint8_t protocol_prev=HID_PROTOCOL_REPORT;
+	uint8_t protocol;
+	uint8_t seq=0;
+	uint8_t handled=0;
+	KEY_EVENT_REC rec;
 	KeyEvent key_e;
 	send_report_flag = 0;
-	Key_Scan();
-	for (uint8_t r = 0; r < MATRIX_ROWS; ++r)
+	if(s_ucReportPending)		//上一轮的快照未入队，入队前不改变按键状态
 	{
-		matrix_now = Key_Matrix_Get_Row(r);
-		matrix_change = matrix_now ^ matrix_prev[r];
-		if(matrix_change)
+		Keyboard_SendReport();
+		if(s_ucReportPending)
 		{
-			bsp_StartTimer(TMR_SLEEP,TMR_PERIOD_10MIN);
-			send_report_flag = 1;
-			for (uint8_t c = 0; c < MATRIX_COLS; ++c)
-			{
-				if(matrix_change & ((uint16_t)1<<c))
-				{
-					key_e.key.row=r;
-					key_e.key.col=c;
-					key_e.pressed=matrix_now & ((uint16_t)1<<c);
-					Keyboard_Process(key_e);
-					matrix_prev[r] ^= (uint16_t)1<<c;
-				}
-			}
+			return;
 		}
 	}
+	while(!s_ucReportPending && Key_Event_Peek(&rec))
+	{
+		if(send_report_flag && (rec.seq != seq))		//下一轮扫描的事件，先发出上一轮的报告，队列满时事件留在环中
+		{
+			Keyboard_SendReport();
+			send_report_flag = 0;
+			continue;
+		}
+		Key_Event_Get(&rec);
+		seq = rec.seq;
+		send_report_flag = 1;
+		handled = 1;
+		key_e.key.row = rec.row;
+		key_e.key.col = rec.col;
+		key_e.pressed = rec.pressed;
+		Keyboard_Process(key_e);
+	}
+	if(handled)
+	{
+		bsp_StartTimer(TMR_SLEEP,TMR_PERIOD_10MIN);
+	}
+	protocol = USBD_HID_GetProtocol(&USBD_Device);
+	if(protocol != protocol_prev)		//主机切换启动/报告协议，按新格式重发当前状态
+	{
+		protocol_prev = protocol;
+		s_ucUsageDirty = USAGE_DIRTY_CONSUMER | USAGE_DIRTY_SYSTEM;
+		send_report_flag = 1;
+	}
 	if(send_report_flag)
 	{
-		Keyboard_SendReport(report_buf);
+		Keyboard_SendReport();
 	}
 }
 
 /*============================================================
-	*	@func:		XX
-	*	@brief:		XX
+	*	@func:		Keyboard_Scan_Tick
+	*	@brief:		扫描节拍。低延迟模式下USB有SOF时与SOF对齐，每帧扫描一次，
+	*				扫描后报告在下一帧发出；否则使用TMR_KEY_SCAN定时扫描。
+	*				空闲等待列中断时不扫描，唤醒后立即扫描一次。
+	*				扫描周期随节拍来源变化，消抖时间按当前周期换算
+	*	@param:		NA
+	*	@retval:	1：需要扫描 0：不需要
+	*	@modify: 	data 			remarks 
+=============================================================*/
+static uint8_t Keyboard_Scan_Tick(void)
+{
+	uint8_t tick;
+	uint8_t period = KEY_SCAN_PERIOD_MS;
+
+	if(Key_Scan_Resume())		//列中断唤醒，立即扫描
+	{
+		return 1;
+	}
+	tick = bsp_CheckTimer(TMR_KEY_SCAN);
+#if HID_LOW_LATENCY == 1
+	int32_t sof_age = bsp_GetRunTime() - s_iSofTime;
+
+	if(USB_BLE_Switch && (sof_age >= 0) && (sof_age <= TMR_PERIOD_2MS))
+	{
+		tick = s_ucSofFlag;
+		s_ucSofFlag = 0;
+		period = KEY_SCAN_SOF_PERIOD_MS;
+	}
+#endif
+	Debounce_SetPeriod(period);
+	if(Key_Scan_IsIdle())		//中断等待中，SOF不触发扫描
+	{
+		return 0;
+	}
+	return tick;
+}
+/*============================================================
+	*	@func:		Keyboard_USB_SOF
+	*	@brief:		USB SOF 回调，在USB中断中调用
 	*	@param:		NA
 	*	@retval:	NA	
 	*	@modify: 	data 			remarks 
 =============================================================*/
+void Keyboard_USB_SOF(void)
+{
+#if HID_LOW_LATENCY == 1
+	s_ucSofFlag = 1;
+	s_iSofTime = bsp_GetRunTime();
+	if(USB_BLE_Switch && !Key_Scan_IsIdle())		//空闲等待列中断时SOF不唤醒主循环
+	{
+		Event_Post(EVT_SCAN_TICK);
+	}
+#endif
+}
+/*============================================================
+	*	@func:		Keyboard_Process
+	*	@brief:		按键处理。键值由层缓存解析，释放时使用按下时的键值；
+	*				Fn键的层动作在层模块中执行，命令动作在此处理
+	*	@param:		key_e：按键事件
+	*	@retval:	NA	
+	*	@modify: 	data 			remarks 
+=============================================================*/
 void Keyboard_Process(KeyEvent key_e)
 {
-	uint8_t key_code=0;
-	static uint8_t modifier_key=0;
-	uint8_t static key_buf[6]={0,0,0,0,0,0};
+	uint8_t key_code;
+	uint8_t action;
+
 	if(key_e.pressed)
 	{
-		key_code = keymaps[0][key_e.key.row][key_e.key.col];
-		if((key_code & 0xF0) == 0xE0 )		//功能键
+		key_code = Layer_Press(key_e.key.row, key_e.key.col);
+	}
+	else
+	{
+		key_code = Layer_Release(key_e.key.row, key_e.key.col);
+	}
+	if(IS_FN(key_code))		//Fn键
+	{
+		action = FN_ACTION(key_code);
+		if(key_e.pressed && (ACTION_TYPE(action) == ACTION_TYPE_COMMAND))
+		{
+			Keyboard_FN_Combind(ACTION_ARG(action));
+		}
+		else if(key_e.pressed && (ACTION_TYPE(action) == ACTION_TYPE_MACRO))
+		{
+			Macro_Play(ACTION_ARG(action));
+		}
+	}
+	else if((key_code & 0xF0) == 0xE0 )		//功能键
+	{
+		if(key_e.pressed)
 		{
 			modifier_key |= 1 << (key_code & 0x0F);
-			report_buf[0] = modifier_key;
 		}
-		else							//常规按键
+		else
 		{
-			for (uint8_t i=0; i < 6; i++)
-			{
-				if(key_buf[i]==0)
-				{
-					key_buf[i] = key_code;
-					break;
-				}
-			}
-			Keyboard_FN_Combind(key_code);
+			modifier_key &= ~(1 << (key_code & 0x0F));
+		}
+	}
+	else if((key_code >= KC_SYSTEM_POWER) && (key_code <= KC_BRIGHTNESS_DOWN))		//系统控制和多媒体按键
+	{
+		Keyboard_Usage(key_code, key_e.pressed);
+	}
+	else if((key_code != KC_NO) && (key_code < HID_NKRO_KEY_MAX))		//常规按键，直接置位/清零位图
+	{
+		if(key_e.pressed)
+		{
+			key_bits[key_code >> 3] |= (uint8_t)(1 << (key_code & 0x07));
+		}
+		else
+		{
+			key_bits[key_code >> 3] &= (uint8_t)~(1 << (key_code & 0x07));
+		}
+	}
+}
+
+/*============================================================
+	*	@func:		Keyboard_Usage
+	*	@brief:		系统控制/多媒体按键置位或清零对应报告的位图，有变化时标记
+	*				该报告待发送
+	*	@param:		key_code：键值 pressed：1按下 0释放
+	*	@retval:	NA	
+	*	@modify: 	data 			remarks 
+=============================================================*/
+static void Keyboard_Usage(uint8_t key_code, uint8_t pressed)
+{
+	uint8_t bit = s_ucUsageBit[key_code - KC_SYSTEM_POWER];
+	uint32_t mask;
+
+	if(bit == USAGE_BIT_NONE)
+	{
+		return;
+	}
+	mask = 1UL << bit;
+	if(key_code <= KC_SYSTEM_WAKE)
+	{
+		if(((s_ucSystem & mask) != 0) != (pressed != 0))
+		{
+			s_ucSystem ^= (uint8_t)mask;
+			s_ucUsageDirty |= USAGE_DIRTY_SYSTEM;
 		}
 	}
 	else
 	{
-		key_code = keymaps[0][key_e.key.row][key_e.key.col];
-		if((key_code & 0xF0) == 0xE0 )		//功能键
+		if(((s_uiConsumer & mask) != 0) != (pressed != 0))
 		{
-			modifier_key &= ~(1 << (key_code & 0x0F));
-			report_buf[0] = modifier_key;
+			s_uiConsumer ^= mask;
+			s_ucUsageDirty |= USAGE_DIRTY_CONSUMER;
 		}
-		else						//常规按键
+	}
+}
+/*============================================================
+	*	@func:		Keyboard_SendUsage
+	*	@brief:		发送有变化的消费类/系统控制报告。USB下与键盘报告进入同一个
+	*				报告队列，按产生顺序交替发出，长度和报告ID不同不会与键盘
+	*				报告合并；队列满时保留待发送标志，随键盘报告一起重发。
+	*				启动协议下主机不解析报告ID，不发送。BLE下经
+	*				链路转发，由BLE端发到对应的HOGP报告
+	*	@param:		NA
+	*	@retval:	NA	
+	*	@modify: 	data 			remarks 
+=============================================================*/
+static void Keyboard_SendUsage(void)
+{
+	uint8_t buf[HID_CONSUMER_REPORT_LEN];
+
+	if(USB_BLE_Switch && (USBD_HID_GetProtocol(&USBD_Device) == HID_PROTOCOL_BOOT))
+	{
+		s_ucUsageDirty = 0;
+		return;
+	}
+	if(s_ucUsageDirty & USAGE_DIRTY_CONSUMER)
+	{
+		Keyboard_Get_Usage(HID_CONSUMER_REPORT_ID, buf);
+		if(USB_BLE_Switch)
+		{
+			if(Report_Queue_Push(buf, HID_CONSUMER_REPORT_LEN) == REPORT_PUSH_FULL)
+			{
+				s_ucReportPending = 1;
+				return;
+			}
+		}
+		else
 		{
-			for (uint8_t i = 0; i < 6; ++i)
+			Link_SendExt(buf, HID_CONSUMER_REPORT_LEN);
+		}
+		s_ucUsageDirty &= ~USAGE_DIRTY_CONSUMER;
+	}
+	if(s_ucUsageDirty & USAGE_DIRTY_SYSTEM)
+	{
+		Keyboard_Get_Usage(HID_SYSTEM_REPORT_ID, buf);
+		if(USB_BLE_Switch)
+		{
+			if(Report_Queue_Push(buf, HID_SYSTEM_REPORT_LEN) == REPORT_PUSH_FULL)
 			{
-				if(key_code == key_buf[i])
-				{
-					key_buf[i]=0;
-				}
+				s_ucReportPending = 1;
+				return;
 			}
 		}
+		else
+		{
+			Link_SendExt(buf, HID_SYSTEM_REPORT_LEN);
+		}
+		s_ucUsageDirty &= ~USAGE_DIRTY_SYSTEM;
 	}
-	if(key_code == KC_FN0)		//Fn键
+}
+/*============================================================
+	*	@func:		Keyboard_Get_Usage
+	*	@brief:		由当前消费类/系统控制按键状态生成完整报告
+	*	@param:		id：HID_CONSUMER_REPORT_ID/HID_SYSTEM_REPORT_ID buf：报告缓冲区
+	*	@retval:	报告长度，含报告ID
+	*	@modify: 	data 			remarks 
+=============================================================*/
+uint8_t Keyboard_Get_Usage(uint8_t id, uint8_t *buf)
+{
+	buf[0] = id;
+	if(id == HID_SYSTEM_REPORT_ID)
 	{
-		FN0_Press_Flag ^= 0x01;
+		buf[1] = s_ucSystem;
+		return HID_SYSTEM_REPORT_LEN;
 	}
-	memcpy(&report_buf[2],key_buf,6);	
+	buf[1] = (uint8_t)s_uiConsumer;
+	buf[2] = (uint8_t)(s_uiConsumer >> 8);
+	buf[3] = (uint8_t)(s_uiConsumer >> 16);
+	return HID_CONSUMER_REPORT_LEN;
+}
+/*============================================================
+	*	@func:		Keyboard_Get_Boot
+	*	@brief:		由当前按键状态生成启动报告，回放中的宏按键叠加在实时按键上。
+	*				状态由经过层解析的按键事件维护，与输出链路无关
+	*	@param:		buf：报告缓冲区
+	*	@retval:	NA	
+	*	@modify: 	data 			remarks 
+=============================================================*/
+void Keyboard_Get_Boot(uint8_t *buf)
+{
+	uint8_t mod = modifier_key;
+	uint8_t bits[sizeof(key_bits)];
+
+	memcpy(bits, key_bits, sizeof(key_bits));
+	Macro_Merge(&mod, bits);
+	Keyboard_Build_Boot(buf, mod, bits);
 }
+/*============================================================
+	*	@func:		Keyboard_Build_Boot
+	*	@brief:		由位图生成8字节启动报告，超过6键时按协议填充 ErrorRollOver
+	*	@param:		buf：报告缓冲区 mod：功能键 bits：按键位图
+	*	@retval:	NA	
+	*	@modify: 	data 			remarks 
+=============================================================*/
+static void Keyboard_Build_Boot(uint8_t *buf, uint8_t mod, uint8_t *bits_map)
+{
+	uint8_t n = 0;
+	uint8_t bits;
 
+	memset(buf, 0, HID_BOOT_REPORT_LEN);
+	buf[0] = mod;
+	for (uint8_t i = 0; i < sizeof(key_bits); ++i)
+	{
+		bits = bits_map[i];
+		for (uint8_t j = 0; bits; ++j, bits >>= 1)
+		{
+			if(!(bits & 0x01))
+			{
+				continue;
+			}
+			if(n == 6)
+			{
+				memset(&buf[2], KC_ROLL_OVER, 6);
+				return;
+			}
+			buf[2 + n++] = (i << 3) | j;
+		}
+	}
+}
 /*============================================================
-	*	@func:		XX
-	*	@brief:		XX
+	*	@func:		Keyboard_Build_NKRO
+	*	@brief:		生成NKRO报告：[报告ID][功能键][128位键值位图]
+	*	@param:		buf：报告缓冲区 mod：功能键 bits：按键位图
+	*	@retval:	NA	
+	*	@modify: 	data 			remarks 
+=============================================================*/
+static void Keyboard_Build_NKRO(uint8_t *buf, uint8_t mod, uint8_t *bits)
+{
+	buf[0] = HID_NKRO_REPORT_ID;
+	buf[1] = mod;
+	memcpy(&buf[2], bits, sizeof(key_bits));
+}
+/*============================================================
+	*	@func:		Keyboard_SendReport
+	*	@brief:		发送当前按键状态，回放中的宏按键叠加在实时按键上。
+	*				USB报告协议下发送NKRO报告，启动协议及BLE下发送6KRO启动报告。
+	*				消费类/系统控制按键有变化时随后发送对应报告。队列满时
+	*				不改写队尾，置待发送标志由键盘任务在EVT_USB_TX时重发
 	*	@param:		NA
 	*	@retval:	NA	
 	*	@modify: 	data 			remarks 
 =============================================================*/
-void Keyboard_SendReport(uint8_t *buf)
+void Keyboard_SendReport(void)
 {
+	uint8_t mod = modifier_key;
+	uint8_t bits[sizeof(key_bits)];
+	uint8_t push;
+
+	memcpy(bits, key_bits, sizeof(key_bits));
+	Macro_Merge(&mod, bits);
+	s_ucReportPending = 0;
 	if(USB_BLE_Switch)
 	{
-		USBD_HID_SendReport(&USBD_Device,buf,8);
+		if(USBD_HID_GetProtocol(&USBD_Device) == HID_PROTOCOL_BOOT)
+		{
+			Keyboard_Build_Boot(report_buf, mod, bits);
+			push = Report_Queue_Push(report_buf, HID_BOOT_REPORT_LEN);		//保存报告快照，端点忙时排队
+		}
+		else
+		{
+			Keyboard_Build_NKRO(nkro_buf, mod, bits);
+			push = Report_Queue_Push(nkro_buf, HID_NKRO_REPORT_LEN);
+		}
+		if(push == REPORT_PUSH_FULL)		//队列满，保留状态待下一次EVT_USB_TX重发，消费类报告不越过键盘报告
+		{
+			s_ucReportPending = 1;
+			Report_Queue_Kick();
+			return;
+		}
+		Keyboard_SendUsage();
+		Pwr_Wake_Report(PWR_WAKE_QUEUE);
+		Report_Queue_Kick();
 	}
 	else
 	{
-		comSendBuf(COM_BLE,buf,8);
+		Keyboard_Build_Boot(report_buf, mod, bits);
+		Link_SendReport(report_buf);		//带序号和CRC的帧，BLE端失步后自动重发快照
+		Keyboard_SendUsage();
+		Pwr_Wake_Report(PWR_WAKE_QUEUE | PWR_WAKE_SEND);
 	}
 }
 /*============================================================
@@ -161,36 +492,42 @@ void Keyboard_ReceiveReport(uint8_t data)
 	}
 }
 /*============================================================
-	*	@func:		XX
-	*	@brief:		XX
+	*	@func:		Keyboard_Is_USB
+	*	@brief:		当前输出链路
 	*	@param:		NA
+	*	@retval:	1：USB 0：BLE
+	*	@modify: 	data 			remarks 
+=============================================================*/
+uint8_t Keyboard_Is_USB(void)
+{
+	return USB_BLE_Switch;
+}
+/*============================================================
+	*	@func:		Keyboard_FN_Combind
+	*	@brief:		Fn层命令处理，命令键不改变按键位图
+	*	@param:		cmd：KB_CMD_ID
 	*	@retval:	NA	
 	*	@modify: 	data 			remarks 
 =============================================================*/
-void Keyboard_FN_Combind(uint8_t keycode)
+void Keyboard_FN_Combind(uint8_t cmd)
 {
-	if(!FN0_Press_Flag)		//Fn键未按下，直接返回
-	{
-		return ;
-	}
-	send_report_flag = 0;//FN 键按下，USB不发送键值
-	if(keycode == KC_W)		//snake mode
+	if(cmd == KB_CMD_SNAKE)		//snake mode
 	{
 		Display_SetWorkMode(SNAKE_MODE);
 	}
-	else if(keycode == KC_F)		//flow mode
+	else if(cmd == KB_CMD_FLOW)		//flow mode
 	{
 		Display_SetWorkMode(FLOW_MODE);
 	}
-	else if(keycode == KC_E)	//end 
+	else if(cmd == KB_CMD_IDLE)	//end 
 	{
 		Display_SetWorkMode(IDLE_MODE);
 	}
-	else if(keycode == KC_T)		//change snake color
+	else if(cmd == KB_CMD_STATIC)		//static mode
 	{
 		Display_SetWorkMode(STATIC_MODE);
 	}
-	else if(keycode == KC_C)		//change snake color
+	else if(cmd == KB_CMD_COLOR)		//change snake color
 	{
 		if(g_Work_Mode ==SNAKE_MODE)
 		{
@@ -201,18 +538,19 @@ void Keyboard_FN_Combind(uint8_t keycode)
 			Display_ChangeStaticColor();
 		}
 	}
-	else if(keycode == KC_U)		//USB
+	else if(cmd == KB_CMD_USB)		//USB
 	{
 		USB_BLE_Switch = 1;
 	}
-	else if(keycode == KC_B)		//BLE
+	else if(cmd == KB_CMD_BLE)		//BLE
 	{
 		USB_BLE_Switch =0;
 	}
-	else if(keycode == KC_S)
+	else if(cmd == KB_CMD_SWITCH)
 	{
 		USB_BLE_Switch ^= 1;
 	}
+	Clock_Demand(CLOCK_REQ_USB, USB_BLE_Switch);		//BLE模式下USB不需要PLL
 }
 
 
@@ -15,9 +15,61 @@ typedef struct KeyEvent_Type
 	bool pressed;
 }KeyEvent;
 
+/* Fn层命令，fn_actions 中 ACTION_COMMAND 的参数 */
+typedef enum
+{
+	KB_CMD_SNAKE = 0,		//贪吃蛇灯效
+	KB_CMD_FLOW,			//流水灯效
+	KB_CMD_IDLE,			//关闭灯效
+	KB_CMD_STATIC,			//静态灯效
+	KB_CMD_COLOR,			//切换颜色
+	KB_CMD_USB,				//USB模式
+	KB_CMD_BLE,				//BLE模式
+	KB_CMD_SWITCH			//USB/BLE切换
+}KB_CMD_ID;
+
+/*
+	按键到USB总线的延迟模型(us)：
+	按键边沿到被扫描到最多一个扫描周期，延迟消抖再等待 DEBOUNCE_MS 减一个扫描
+	周期(即时消抖不等待)，报告入队后最多再等待一个主机轮询间隔。标准模式下
+	轮询相位任意，平均等待半个间隔；低延迟模式扫描与SOF对齐，报告总是在
+	下一帧发出，等待整个间隔。
+	消抖时间按扫描周期换算为扫描次数，两种模式下以ms计的消抖时间相同。
+	test_latency 按扫描、消抖和轮询模拟，检查下表。
+	                                  最坏    平均
+	标准模式(2ms扫描, 10ms轮询)  延迟  20ms    14ms
+	                             即时  12ms    6ms
+	低延迟模式(SOF 1ms, 1ms轮询) 延迟  11ms    10.5ms
+	                             即时  2ms     1.5ms
+*/
+#define KEY_SCAN_PERIOD_MS			TMR_PERIOD_2MS		//定时器扫描周期
+#define KEY_SCAN_SOF_PERIOD_MS		1					//与SOF对齐时的扫描周期
+#if HID_LOW_LATENCY == 1
+	#define KEY_SCAN_PERIOD_US		(KEY_SCAN_SOF_PERIOD_MS * 1000)
+#else
+	#define KEY_SCAN_PERIOD_US		(KEY_SCAN_PERIOD_MS * 1000)
+#endif
+#if DEBOUNCE_ALGORITHM == DEBOUNCE_EAGER
+	#define KEY_DEBOUNCE_DELAY_US	0
+#else
+	#define KEY_DEBOUNCE_DELAY_US	(DEBOUNCE_MS * 1000 - KEY_SCAN_PERIOD_US)
+#endif
+#define KEY_POLL_PERIOD_US			(HID_FS_BINTERVAL * 1000)
+#if HID_LOW_LATENCY == 1
+	#define KEY_POLL_WAIT_MEAN_US	KEY_POLL_PERIOD_US			//SOF对齐，下一帧发出
+#else
+	#define KEY_POLL_WAIT_MEAN_US	(KEY_POLL_PERIOD_US / 2)
+#endif
+#define KEY_LATENCY_WORST_US		(KEY_SCAN_PERIOD_US + KEY_DEBOUNCE_DELAY_US + KEY_POLL_PERIOD_US)
+#define KEY_LATENCY_MEAN_US			(KEY_SCAN_PERIOD_US / 2 + KEY_DEBOUNCE_DELAY_US + KEY_POLL_WAIT_MEAN_US)
+
 void Keyboard_Task(void);					//键盘任务
 void Keyboard_Process(KeyEvent key_e);		//按键处理
-void Keyboard_SendReport(uint8_t *buf);		//USB发送键值
+void Keyboard_SendReport(void);				//发送键值
 void Keyboard_ReceiveReport(uint8_t data);	//USB输出处理
-void Keyboard_FN_Combind(uint8_t keycode);	//FN组合键处理
+void Keyboard_FN_Combind(uint8_t cmd);		//FN组合键处理
+void Keyboard_USB_SOF(void);				//USB SOF回调
+uint8_t Keyboard_Is_USB(void);				//当前是否为USB模式
+void Keyboard_Get_Boot(uint8_t *buf);		//当前按键状态的启动报告
+uint8_t Keyboard_Get_Usage(uint8_t id, uint8_t *buf);	//当前消费类/系统控制报告
 #endif
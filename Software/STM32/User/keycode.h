@@ -120,6 +120,8 @@
 #define KC_WSTP KC_WWW_STOP
 #define KC_WREF KC_WWW_REFRESH
 #define KC_WFAV KC_WWW_FAVORITES
+#define KC_BRIU KC_BRIGHTNESS_UP
+#define KC_BRID KC_BRIGHTNESS_DOWN
 /* Jump to bootloader */
 #define KC_BTLD KC_BOOTLOADER
 /* Transparent */
@@ -384,6 +386,8 @@ enum internal_special_keycodes {
     KC_WWW_STOP,
     KC_WWW_REFRESH,
     KC_WWW_FAVORITES,    /* 0xBC */
+    KC_BRIGHTNESS_UP,
+    KC_BRIGHTNESS_DOWN,  /* 0xBE */
 
     /* Jump to bootloader */
     KC_BOOTLOADER       = 0xBF,
@@ -1,5 +1,5 @@
 #include "bsp.h"
-const  uint8_t keymaps[][MATRIX_ROWS][MATRIX_COLS]={
+const  uint8_t keymaps[KEYMAP_LAYERS][MATRIX_ROWS][MATRIX_COLS]={
 	    /* 0: qwerty */
 KEYMAP_ANSI(
 		ESC, F1,  F2,  F3,  F4,  F5,  F6,  F7,  F8,  F9,  F10,  F11,  F12,  PSCR,  PAUS,  DEL, \
@@ -8,4 +8,39 @@ KEYMAP_ANSI(
         CAPS, A,   S,   D,   F,   G,   H,   J,   K,   L, SCLN,  QUOT, 		ENT,  		 PGUP, \
         LSFT, Z,   X,   C,   V,   B,   N,   M,COMM,	DOT, SLSH,  RSFT, 				UP,	 PGDN, \
         LCTL,LGUI,LALT,          	SPC,                 RALT,	 FN0, RCTL,	LEFT,  DOWN,RGHT),
+	    /* 1: Fn，W/F/E/T/C 灯效，U/B/S 切换USB/BLE，G 切换游戏层，1/2 宏，F1~F12 多媒体，PSCR 睡眠 */
+KEYMAP_ANSI(
+		TRNS,BRID,BRIU,CALC,MAIL,MPRV,MPLY,MNXT,MSTP,MUTE,VOLD, VOLU, WHOM, SLEP,  TRNS,  TRNS, \
+        TRNS,FN12,FN13,TRNS,TRNS,TRNS,TRNS,TRNS,TRNS,TRNS, TRNS, TRNS, TRNS, TRNS,  		 TRNS, \
+        TRNS,TRNS, FN4, FN6,TRNS, FN7,TRNS, FN9,TRNS,TRNS, TRNS, TRNS, TRNS, TRNS,   	 TRNS, \
+        TRNS,TRNS,FN11,TRNS, FN5, FN1,TRNS,TRNS,TRNS,TRNS, TRNS, TRNS, 		TRNS,  		 TRNS, \
+        TRNS,TRNS,TRNS, FN8,TRNS,FN10,TRNS,TRNS,TRNS,TRNS, TRNS, TRNS, 				TRNS,TRNS, \
+        TRNS,TRNS,TRNS,          	TRNS,                TRNS,	TRNS,TRNS,	TRNS,  TRNS,TRNS),
+	    /* 2: 游戏，屏蔽Win键 */
+KEYMAP_ANSI(
+		TRNS,TRNS,TRNS,TRNS,TRNS,TRNS,TRNS,TRNS,TRNS,TRNS,TRNS, TRNS, TRNS, TRNS,  TRNS,  TRNS, \
+        TRNS,TRNS,TRNS,TRNS,TRNS,TRNS,TRNS,TRNS,TRNS,TRNS, TRNS, TRNS, TRNS, TRNS,  		 TRNS, \
+        TRNS,TRNS,TRNS,TRNS,TRNS,TRNS,TRNS,TRNS,TRNS,TRNS, TRNS, TRNS, TRNS, TRNS,   	 TRNS, \
+        TRNS,TRNS,TRNS,TRNS,TRNS,TRNS,TRNS,TRNS,TRNS,TRNS, TRNS, TRNS, 		TRNS,  		 TRNS, \
+        TRNS,TRNS,TRNS,TRNS,TRNS,TRNS,TRNS,TRNS,TRNS,TRNS, TRNS, TRNS, 				TRNS,TRNS, \
+        TRNS,  NO,TRNS,          	TRNS,                TRNS,	TRNS,TRNS,	TRNS,  TRNS,TRNS),
+};
+/* KC_FNn 对应的动作 */
+const  uint8_t fn_actions[]={
+	ACTION_LAYER_MOMENTARY(1),		//FN0：按住进入Fn层
+	ACTION_LAYER_TOGGLE(2),			//FN1：切换游戏层
+	ACTION_LAYER_ONESHOT(1),		//FN2：单次Fn层，备用
+	ACTION_LAYER_ONESHOT(2),		//FN3：备用
+	ACTION_COMMAND(KB_CMD_SNAKE),	//FN4
+	ACTION_COMMAND(KB_CMD_FLOW),	//FN5
+	ACTION_COMMAND(KB_CMD_IDLE),	//FN6
+	ACTION_COMMAND(KB_CMD_STATIC),	//FN7
+	ACTION_COMMAND(KB_CMD_COLOR),	//FN8
+	ACTION_COMMAND(KB_CMD_USB),		//FN9
+	ACTION_COMMAND(KB_CMD_BLE),		//FN10
+	ACTION_COMMAND(KB_CMD_SWITCH),	//FN11
+	ACTION_MACRO(0),				//FN12：全选并复制
+	ACTION_MACRO(1),				//FN13：输入字符串
 };
+/* 项数必须与 FN_ACTION_COUNT 一致，否则编译出错 */
+typedef char fn_actions_count_check[(sizeof(fn_actions) == FN_ACTION_COUNT) ? 1 : -1];
@@ -3,7 +3,10 @@
 #include "bsp.h"
 #define MATRIX_ROWS 6
 #define MATRIX_COLS 16
-extern const  uint8_t keymaps[][MATRIX_ROWS][MATRIX_COLS];
+#define KEYMAP_LAYERS 3		//0：基础层 1：Fn层 2：游戏层
+extern const  uint8_t keymaps[KEYMAP_LAYERS][MATRIX_ROWS][MATRIX_COLS];		//默认键值表，EEPROM无效时使用
+#define FN_ACTION_COUNT 14		//fn_actions 的项数，KC_FN0~KC_FN13
+extern const  uint8_t fn_actions[FN_ACTION_COUNT];
     /* 
      * ,-------------------------------------------------------------------.        total
      * |Ecs| F1| F2| F3| F4| F5| F6| F7| F8| F9|F10|F11|F12|PrtSc|Pause|Del|        16
@@ -25,11 +25,14 @@ int main(void)
 	GPIO_LED_Power(ENABLE);
 	Display_Init();
 	Key_Scan_Init();
+	Keymap_Init();
+	Layer_Init();
+	Macro_Init();
+	Link_Init();
+	Event_Init();
   while (1)
   { 
-		Keyboard_Task();
-		Display_Handle();
-		Pwr_Sleep_Check();
+		Event_Run();			//事件驱动，无事件时WFI
   }
 }
 /*============================================================
@@ -62,8 +65,8 @@ void SystemClock_Config(void)
 	RCC_OscInitStruct.HSIState = RCC_HSI_OFF;
   RCC_OscInitStruct.PLL.PLLState = RCC_PLL_ON;
   RCC_OscInitStruct.PLL.PLLSource = RCC_PLLSOURCE_HSE;
-  RCC_OscInitStruct.PLL.PLLMUL = RCC_PLLMUL_12;
-  RCC_OscInitStruct.PLL.PLLDIV = RCC_PLLDIV_3;
+  RCC_OscInitStruct.PLL.PLLMUL = CLOCK_PLL_MUL;
+  RCC_OscInitStruct.PLL.PLLDIV = CLOCK_PLL_DIV;
 	HAL_RCC_OscConfig(&RCC_OscInitStruct);
   
 //  /* Select HSI as system clock source and configure the HCLK, PCLK1 and PCLK2 
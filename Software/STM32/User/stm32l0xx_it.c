@@ -224,6 +224,21 @@ void EXTI4_15_IRQHandler(void)
     }
 }
 
+void TIM6_DAC_IRQHandler(void)
+{
+    bsp_HwTimer_ISR();
+}
+
+void TIM21_IRQHandler(void)
+{
+    bsp_LedTimer_ISR();
+}
+
+void DMA1_Channel2_3_IRQHandler(void)
+{
+    HC595_DMA_ISR();
+}
+
 /**
   * @}
   */
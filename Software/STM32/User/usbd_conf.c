@@ -47,6 +47,7 @@
 /* Includes ------------------------------------------------------------------*/
 #include "stm32l0xx_hal.h"
 #include "usbd_core.h"
+#include "bsp.h"
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
 /* Private macro -------------------------------------------------------------*/
@@ -170,6 +171,7 @@ void HAL_PCD_SOFCallback(PCD_HandleTypeDef *hpcd)
   */
 void HAL_PCD_ResetCallback(PCD_HandleTypeDef *hpcd)
 {   
+  Clock_Demand(CLOCK_USB_SUSPEND, 0);
   USBD_LL_SetSpeed(hpcd->pData, USBD_SPEED_FULL);
   /* Reset Device */
   USBD_LL_Reset(hpcd->pData);
@@ -182,6 +184,8 @@ void HAL_PCD_ResetCallback(PCD_HandleTypeDef *hpcd)
   */
 void HAL_PCD_SuspendCallback(PCD_HandleTypeDef *hpcd)
 {
+  /* Bus suspended: the clock governor may drop to MSI */
+  Clock_Demand(CLOCK_USB_SUSPEND, 1);
 //  /* Inform USB library that core enters in suspend Mode */
 //  USBD_LL_Suspend(hpcd->pData);
 //  
@@ -200,6 +204,8 @@ void HAL_PCD_SuspendCallback(PCD_HandleTypeDef *hpcd)
   */
 void HAL_PCD_ResumeCallback(PCD_HandleTypeDef *hpcd)
 {
+  /* Bus resumed: back to PLL before the host restarts traffic */
+  Clock_Demand(CLOCK_USB_SUSPEND, 0);
 //  if ((hpcd->Init.low_power_enable)&&(remotewakeupon == 0))
 //  {
 //    SystemClockConfig_STOP();
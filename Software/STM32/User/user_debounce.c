@@ -0,0 +1,223 @@
+/************************************************************
+    *   @file:      user_debounce.c
+    *   @brief:     按键消抖。每个按键一个4位计数器，按位切片存放：
+    *               s_cnt[n][row] 的第 col 位是 (row,col) 计数器的第 n 位，
+    *               一行16个按键的计数用几次字运算同时更新。
+    *               消抖时间和即时消抖的锁定时间以ms给出，按当前扫描周期
+    *               换算为扫描次数
+    *   @author:    XIET
+    *   @version:   V1.0
+    *   @data:      201x-xx-xx
+    *   @modify:    data            remarks
+**************************************************************/
+#include "bsp.h"
+
+#if DEBOUNCE_ALGORITHM == DEBOUNCE_EAGER
+    #define DEBOUNCE_TIME_MS    DEBOUNCE_LOCK_MS    //计数器计时：上报后的锁定时间
+#else
+    #define DEBOUNCE_TIME_MS    DEBOUNCE_MS         //计数器计时：上报前的稳定时间
+#endif
+
+static uint8_t s_ucPeriod = TMR_PERIOD_2MS;     //扫描周期(ms)
+static uint8_t s_ucScans = (DEBOUNCE_TIME_MS + TMR_PERIOD_2MS - 1) / TMR_PERIOD_2MS;   //计数扫描次数
+#if DEBOUNCE_ALGORITHM == DEBOUNCE_SYMMETRIC
+static uint16_t s_raw_prev[MATRIX_ROWS];
+static uint8_t s_debouncing = 0;
+#else
+static uint16_t s_cnt[DEBOUNCE_CNT_BITS][MATRIX_ROWS];      //位切片计数器
+#endif
+
+#if DEBOUNCE_ALGORITHM != DEBOUNCE_SYMMETRIC
+static uint16_t Debounce_Active(uint8_t row);
+static void Debounce_Load(uint8_t row, uint16_t mask);
+#if DEBOUNCE_ALGORITHM == DEBOUNCE_DEFER
+static void Debounce_Clear(uint8_t row, uint16_t mask);
+#endif
+static void Debounce_Dec(uint8_t row, uint16_t mask);
+#endif
+/*============================================================
+    *   @func:      Debounce_Init
+    *   @brief:     消抖状态初始化
+    *   @param:     NA
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+void Debounce_Init(void)
+{
+#if DEBOUNCE_ALGORITHM == DEBOUNCE_SYMMETRIC
+    memset(s_raw_prev, 0, sizeof(s_raw_prev));
+    s_debouncing = 0;
+#else
+    memset(s_cnt, 0, sizeof(s_cnt));
+#endif
+}
+/*============================================================
+    *   @func:      Debounce_SetPeriod
+    *   @brief:     设置扫描周期，消抖时间或锁定时间向上取整换算为扫描次数。
+    *               低延迟模式SOF对齐时为1ms，否则为定时器的2ms；
+    *               已在计数的按键保持原计数，之后装入的按新次数
+    *   @param:     period_ms：扫描周期(ms)
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+void Debounce_SetPeriod(uint8_t period_ms)
+{
+    if((period_ms == 0) || (period_ms == s_ucPeriod))
+    {
+        return;
+    }
+    s_ucPeriod = period_ms;
+    s_ucScans = (DEBOUNCE_TIME_MS + period_ms - 1) / period_ms;
+    if(s_ucScans == 0)
+    {
+        s_ucScans = 1;
+    }
+}
+/*============================================================
+    *   @func:      Debounce_Matrix
+    *   @brief:     根据本次扫描的原始值更新消抖后的矩阵
+    *   @param:     raw：本次扫描原始值 matrix：消抖后的矩阵
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+void Debounce_Matrix(uint16_t *raw, uint16_t *matrix)
+{
+    uint8_t r;
+#if DEBOUNCE_ALGORITHM == DEBOUNCE_SYMMETRIC
+    for (r = 0; r < MATRIX_ROWS; ++r)
+    {
+        if(raw[r] != s_raw_prev[r])
+        {
+            s_raw_prev[r] = raw[r];
+            s_debouncing = s_ucScans;
+        }
+    }
+    if(s_debouncing)
+    {
+        if(--s_debouncing == 0)
+        {
+            memcpy(matrix, s_raw_prev, sizeof(s_raw_prev));
+        }
+    }
+#else
+    uint16_t change;
+    uint16_t active;
+    uint16_t done;
+
+    for (r = 0; r < MATRIX_ROWS; ++r)
+    {
+        change = raw[r] ^ matrix[r];
+        active = Debounce_Active(r);
+#if DEBOUNCE_ALGORITHM == DEBOUNCE_EAGER
+        /* 锁定中的按键只计时，未锁定且有变化的按键立即上报并开始锁定，
+           锁定到边沿之后至少 DEBOUNCE_LOCK_MS 的扫描 */
+        Debounce_Dec(r, active);
+        done = change & (uint16_t)~active;
+        Debounce_Load(r, done);
+#else
+        /* 回弹的按键清除计数，新变化的按键开始计数，计满的按键上报 */
+        Debounce_Clear(r, active & (uint16_t)~change);
+        Debounce_Load(r, change & (uint16_t)~active);
+        Debounce_Dec(r, change);
+        done = change & (uint16_t)~Debounce_Active(r);
+#endif
+        matrix[r] ^= done;
+    }
+#endif
+}
+/*============================================================
+    *   @func:      Debounce_Seed
+    *   @brief:     STOP唤醒后的同步扫描只有一轮，原始值直接作为消抖后的状态，
+    *               短按的唤醒键不必等待 DEBOUNCE_MS。即时消抖时变化的按键
+    *               开始锁定，屏蔽随后的回弹；延迟消抖时清除进行中的计数
+    *   @param:     raw：本次扫描原始值 matrix：消抖后的矩阵
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+void Debounce_Seed(uint16_t *raw, uint16_t *matrix)
+{
+#if DEBOUNCE_ALGORITHM == DEBOUNCE_SYMMETRIC
+    memcpy(s_raw_prev, raw, sizeof(s_raw_prev));
+    s_debouncing = 0;
+#else
+    for (uint8_t r = 0; r < MATRIX_ROWS; ++r)
+    {
+#if DEBOUNCE_ALGORITHM == DEBOUNCE_EAGER
+        Debounce_Load(r, raw[r] ^ matrix[r]);
+#else
+        Debounce_Clear(r, 0xFFFF);
+#endif
+    }
+#endif
+    memcpy(matrix, raw, MATRIX_ROWS * sizeof(uint16_t));
+}
+
+#if DEBOUNCE_ALGORITHM != DEBOUNCE_SYMMETRIC
+/*============================================================
+    *   @func:      Debounce_Active
+    *   @brief:     计数器非零的按键
+    *   @param:     row：行
+    *   @retval:    按键位
+    *   @modify:    data            remarks
+=============================================================*/
+static uint16_t Debounce_Active(uint8_t row)
+{
+    return s_cnt[0][row] | s_cnt[1][row] | s_cnt[2][row] | s_cnt[3][row];
+}
+/*============================================================
+    *   @func:      Debounce_Load
+    *   @brief:     mask 中的按键计数器装入当前周期下的消抖扫描次数
+    *   @param:     row：行 mask：按键位
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+static void Debounce_Load(uint8_t row, uint16_t mask)
+{
+    for (uint8_t n = 0; n < DEBOUNCE_CNT_BITS; ++n)
+    {
+        if(s_ucScans & (1 << n))
+        {
+            s_cnt[n][row] |= mask;
+        }
+        else
+        {
+            s_cnt[n][row] &= (uint16_t)~mask;
+        }
+    }
+}
+#if DEBOUNCE_ALGORITHM == DEBOUNCE_DEFER
+/*============================================================
+    *   @func:      Debounce_Clear
+    *   @brief:     mask 中的按键计数器清零
+    *   @param:     row：行 mask：按键位
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+static void Debounce_Clear(uint8_t row, uint16_t mask)
+{
+    for (uint8_t n = 0; n < DEBOUNCE_CNT_BITS; ++n)
+    {
+        s_cnt[n][row] &= (uint16_t)~mask;
+    }
+}
+#endif
+/*============================================================
+    *   @func:      Debounce_Dec
+    *   @brief:     mask 中非零的计数器减一，借位逐位传递
+    *   @param:     row：行 mask：按键位
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+static void Debounce_Dec(uint8_t row, uint16_t mask)
+{
+    uint16_t borrow = mask & Debounce_Active(row);
+    uint16_t next;
+
+    for (uint8_t n = 0; n < DEBOUNCE_CNT_BITS; ++n)
+    {
+        next = borrow & (uint16_t)~s_cnt[n][row];
+        s_cnt[n][row] ^= borrow;
+        borrow = next;
+    }
+}
+#endif
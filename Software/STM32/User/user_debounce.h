@@ -0,0 +1,25 @@
+#ifndef __USER_DEBOUNCE_H
+#define __USER_DEBOUNCE_H
+#include "bsp.h"
+
+#define DEBOUNCE_EAGER			0		//逐键即时：首个边沿立即上报，之后该键锁定 DEBOUNCE_LOCK_MS
+#define DEBOUNCE_DEFER			1		//逐键延迟：单键连续 DEBOUNCE_MS 不同后上报
+#define DEBOUNCE_SYMMETRIC		2		//全局对称延迟：整个矩阵稳定 DEBOUNCE_MS 后统一上报
+
+#ifndef DEBOUNCE_ALGORITHM
+	#define DEBOUNCE_ALGORITHM	DEBOUNCE_EAGER
+#endif
+#define DEBOUNCE_MS				10		//消抖时间(ms)，按当前扫描周期换算为扫描次数
+#define DEBOUNCE_LOCK_MS		DEBOUNCE_MS		//即时消抖上报后的锁定时间(ms)
+#define DEBOUNCE_CNT_BITS		4		//位切片计数器位数
+#define DEBOUNCE_CNT_MAX		((1 << DEBOUNCE_CNT_BITS) - 1)
+
+#if (DEBOUNCE_MS > DEBOUNCE_CNT_MAX) || (DEBOUNCE_LOCK_MS > DEBOUNCE_CNT_MAX)
+	#error "DEBOUNCE_MS/DEBOUNCE_LOCK_MS at a 1ms scan period must fit the bit sliced counter"
+#endif
+
+void Debounce_Init(void);										//消抖状态初始化
+void Debounce_SetPeriod(uint8_t period_ms);						//设置扫描周期
+void Debounce_Matrix(uint16_t *raw, uint16_t *matrix);			//一次扫描的消抖处理
+void Debounce_Seed(uint16_t *raw, uint16_t *matrix);			//原始值直接作为稳定状态
+#endif
@@ -22,6 +22,26 @@
 #include "bsp.h"
 WORKE_MODE g_Work_Mode = IDLE_MODE;
 uint8_t snake_Color = RED;
+
+static LED_PIXEL s_tPixel[LED_ROWS][LED_COLS];                     //帧缓冲区，每通道 LED_BCM_BITS 位亮度
+static uint16_t s_usPlane[LED_ROWS][LED_BCM_BITS][LED_ROW_WORDS];   //预先打包好的位平面，中断中直接DMA发送
+static uint8_t s_ucBright = LED_BCM_MAX;                            //整体亮度
+static uint8_t s_ucDirty = 0;                                       //需要重新打包的行
+static uint8_t s_ucActive = 0;                                      //有LED点亮的行
+static uint8_t s_ucBcmRun = 0;                                      //BCM定时器运行中
+static uint8_t s_ucBcmRow = 0;                                      //595中已移入、下次更新时锁存的行
+static uint8_t s_ucBcmPlane = 0;                                    //及其位平面
+static volatile uint8_t s_ucBcmLoaded = 0;                          //该平面已由DMA移入595
+static volatile uint8_t s_ucBcmWait = 0;                            //平面切换时刻已到，等待DMA完成后锁存
+static uint8_t s_ucBcmFirst = 0;                                    //首次锁存，之后启动定时器
+static LED_BCM_STAT s_tBcmStat;
+
+static void Display_LED_Select(uint8_t row);
+static void Display_Pack_Row(uint8_t row);
+static void Display_BCM_Start(void);
+static void Display_BCM_Stop(void);
+static void Display_BCM_Next(void);
+static void Display_Mark_Dirty(uint8_t rows);
 /*============================================================
     *   @func:      Display_OneImage
     *   @brief:     通过SPI显示一张图片
@@ -31,52 +51,338 @@ uint8_t snake_Color = RED;
 =============================================================*/
 void Display_Init(void)
 {
+    Display_Resume();
     g_Work_Mode = INIT_MODE;
-    Display_Color(BLACK);
-    Display_ON();
-    bsp_StartAutoTimer(TMR_LED_CTRL, TMR_PERIOD_3MS);
     bsp_StartAutoTimer(TMR_LED_INIT, TMR_PERIOD_500MS);
 }
+/*============================================================
+    *   @func:      Display_Suspend
+    *   @brief:     进入STOP前调用，停止BCM和显示相关定时器
+    *   @param:     NA
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+void Display_Suspend(void)
+{
+    Display_BCM_Stop();
+    bsp_StopTimer(TMR_LED_CTRL);
+    bsp_StopTimer(TMR_LED_INIT);
+    bsp_StopTimer(TMR_FLOW);
+}
+/*============================================================
+    *   @func:      Display_Resume
+    *   @brief:     STOP唤醒后调用，清空帧缓冲区并熄灭595后进入空闲模式，
+    *               不再重复上电自检
+    *   @param:     NA
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+void Display_Resume(void)
+{
+    g_Work_Mode = IDLE_MODE;
+    Display_Suspend();
+    memset(s_tPixel, 0, sizeof(s_tPixel));
+    memset(s_usPlane, 0xFF, sizeof(s_usPlane));
+    s_ucActive = 0;
+    s_ucDirty = 0;
+    HC595_SendData(s_usPlane[0][0], LED_ROW_WORDS);   //上电时595内容不定，先全部熄灭
+    while(!HC595_DMA_Done());
+    HC595_LATCH();
+    Display_ON();
+}
 /*============================================================
     *   @func:      Display_LEDPwr_Ctrl
-    *   @brief:     LED电源控制，扫描方式
+    *   @brief:     像素变化后 TMR_LED_CTRL 单次到时：重新打包变化过的行的位平面，
+    *               有LED点亮时启动BCM定时器，全部熄灭时停止并关闭行
     *   @param:     NA
     *   @retval:    NA
     *   @modify:    data            remarks
 =============================================================*/
 void Display_LEDPwr_Ctrl(void)
 {
-    static uint8_t row = 1;
-    if(bsp_CheckTimer(TMR_LED_CTRL))
+    if(!bsp_CheckTimer(TMR_LED_CTRL))
     {
-        switch (row)
+        return;
+    }
+    for (uint8_t row = 0; s_ucDirty; ++row)
+    {
+        if(s_ucDirty & (1 << row))
         {
-        case 1:
-            LED_ROW1_ON();
-            break;
-        case 2:
-            LED_ROW2_ON();
-            break;
-        case 3:
-            LED_ROW3_ON();
-            break;
-        case 4:
-            LED_ROW4_ON();
-            break;
-        case 5:
-            LED_ROW5_ON();
-            break;
-        case 6:
-            LED_ROW6_ON();
-            break;
-        default:
-            break;
+            s_ucDirty &= ~(1 << row);
+            Display_Pack_Row(row);
         }
-        if(++row > 6)
+    }
+    if(s_ucActive && !s_ucBcmRun)
+    {
+        Display_BCM_Start();
+    }
+    else if(!s_ucActive && s_ucBcmRun)
+    {
+        Display_BCM_Stop();
+    }
+}
+/*============================================================
+    *   @func:      Display_BCM_Start
+    *   @brief:     启动第0行第0平面的DMA后立即返回，DMA完成中断中锁存并
+    *               启动定时器，之后各平面由定时器和DMA中断接力
+    *   @param:     NA
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+static void Display_BCM_Start(void)
+{
+    Clock_Demand(CLOCK_REQ_LED, 1);
+    Clock_Update();                 //位平面中断需要PLL，启动前升频
+    LED_ALL_ROW_OFF();
+    s_ucBcmRow = 0;
+    s_ucBcmPlane = 0;
+    s_ucBcmLoaded = 0;
+    s_ucBcmWait = 1;                //DMA完成即锁存
+    s_ucBcmFirst = 1;
+    s_ucBcmRun = 1;
+    HC595_SendData_DMA(s_usPlane[0][0], LED_ROW_WORDS);
+}
+/*============================================================
+    *   @func:      Display_BCM_Stop
+    *   @brief:     停止BCM定时器和进行中的DMA并关闭全部行，不等待
+    *   @param:     NA
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+static void Display_BCM_Stop(void)
+{
+    DISABLE_INT();
+    bsp_LedTimer_Stop();
+    HC595_DMA_Abort();
+    s_ucBcmRun = 0;
+    s_ucBcmWait = 0;
+    s_ucBcmLoaded = 0;
+    ENABLE_INT();
+    LED_ALL_ROW_OFF();
+    Clock_Demand(CLOCK_REQ_LED, 0);
+}
+/*============================================================
+    *   @func:      Display_BCM_ISR
+    *   @brief:     位平面切换，在LED定时器更新中断中调用。此刻开始显示的平面
+    *               通常已由DMA移入595，直接锁存；DMA尚未完成时不等待，
+    *               由DMA完成中断锁存
+    *   @param:     NA
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+void Display_BCM_ISR(void)
+{
+    if(!s_ucBcmRun)
+    {
+        return;
+    }
+    if(!s_ucBcmLoaded)
+    {
+        s_tBcmStat.late++;
+        s_ucBcmWait = 1;
+        return;
+    }
+    Display_BCM_Next();
+}
+/*============================================================
+    *   @func:      Display_BCM_DMA_ISR
+    *   @brief:     位平面移入完成，在595 DMA完成中断中调用。平面切换时刻
+    *               已过(启动或DMA迟到)时立即锁存
+    *   @param:     NA
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+void Display_BCM_DMA_ISR(void)
+{
+    if(!s_ucBcmRun)
+    {
+        return;
+    }
+    s_ucBcmLoaded = 1;
+    if(s_ucBcmWait)
+    {
+        s_ucBcmWait = 0;
+        Display_BCM_Next();
+    }
+}
+/*============================================================
+    *   @func:      Display_BCM_Next
+    *   @brief:     锁存已移入的平面，设置下一平面时间并启动下一平面的DMA。
+    *               换行时先关行再锁存，避免串影。DMA完成后最后一个字仍在
+    *               移位，DMA中断中立即锁存时需等待，定时器中断中早已移完
+    *   @param:     NA
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+static void Display_BCM_Next(void)
+{
+    uint8_t row = s_ucBcmRow;
+    uint8_t plane = s_ucBcmPlane;
+
+    HC595_Wait_Shift();
+    if(plane == 0)
+    {
+        LED_ALL_ROW_OFF();
+        HC595_LATCH();
+        Display_LED_Select(row);
+    }
+    else
+    {
+        HC595_LATCH();
+    }
+    if(++plane >= LED_BCM_BITS)
+    {
+        plane = 0;
+        if(++row >= LED_ROWS)
+        {
+            row = 0;
+            s_tBcmStat.frames++;
+        }
+    }
+    s_ucBcmRow = row;
+    s_ucBcmPlane = plane;
+    if(s_ucBcmFirst)        //第0平面刚锁存，定时器从这里开始计时
+    {
+        s_ucBcmFirst = 0;
+        bsp_LedTimer_Start(LED_BCM_UNIT_US, LED_BCM_UNIT_US << plane);
+    }
+    else
+    {
+        bsp_LedTimer_SetNext(LED_BCM_UNIT_US << plane);
+    }
+    s_ucBcmLoaded = 0;
+    HC595_SendData_DMA(s_usPlane[row][plane], LED_ROW_WORDS);
+}
+/*============================================================
+    *   @func:      Display_BCM_GetStat
+    *   @brief:     获取BCM刷新统计
+    *   @param:     NA
+    *   @retval:    统计结构体
+    *   @modify:    data            remarks
+=============================================================*/
+LED_BCM_STAT *Display_BCM_GetStat(void)
+{
+    return &s_tBcmStat;
+}
+/*============================================================
+    *   @func:      Display_Pack_Row
+    *   @brief:     把一行像素按整体亮度缩放后打包成 LED_BCM_BITS 个48位位平面，
+    *               第0列在最高3位，低电平点亮。缓冲区在关中断下整体替换，
+    *               正在DMA发送的平面最多错一个平面时间
+    *   @param:     row：行
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+static void Display_Pack_Row(uint8_t row)
+{
+    uint32_t temp[LED_BCM_BITS][2];
+    uint8_t r, g, b;
+    uint8_t on = 0;
+    uint8_t col = LED_COLS;
+
+    memset(temp, 0, sizeof(temp));
+    while(col--)
+    {
+        r = s_tPixel[row][col].r * s_ucBright / LED_BCM_MAX;
+        g = s_tPixel[row][col].g * s_ucBright / LED_BCM_MAX;
+        b = s_tPixel[row][col].b * s_ucBright / LED_BCM_MAX;
+        on |= r | g | b;
+        for (uint8_t p = 0; p < LED_BCM_BITS; ++p)
         {
-            row = 1;
+            temp[p][0] = (temp[p][0] >> 3) | ((temp[p][1] & 0x07) << 29);
+            temp[p][1] = (temp[p][1] >> 3) | ((uint32_t)((((r >> p) & 1) ? 0 : 4) |
+                                                          (((g >> p) & 1) ? 0 : 2) |
+                                                          (((b >> p) & 1) ? 0 : 1)) << 13);
         }
     }
+    DISABLE_INT();
+    for (uint8_t p = 0; p < LED_BCM_BITS; ++p)
+    {
+        s_usPlane[row][p][0] = (uint16_t)temp[p][0];
+        s_usPlane[row][p][1] = (uint16_t)(temp[p][0] >> 16);
+        s_usPlane[row][p][2] = (uint16_t)temp[p][1];
+    }
+    ENABLE_INT();
+    if(on)
+    {
+        s_ucActive |= 1 << row;
+    }
+    else
+    {
+        s_ucActive &= ~(1 << row);
+    }
+}
+/*============================================================
+    *   @func:      Display_PixelRGB
+    *   @brief:     设置一个LED三个通道的亮度，只在变化时标记该行
+    *   @param:     row：行 0~5 col：列 0~15 r/g/b：亮度 0~LED_BCM_MAX
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+void Display_PixelRGB(uint8_t row, uint8_t col, uint8_t r, uint8_t g, uint8_t b)
+{
+    LED_PIXEL *p;
+
+    if((row >= LED_ROWS) || (col >= LED_COLS))
+    {
+        return;
+    }
+    p = &s_tPixel[row][col];
+    if((p->r != r) || (p->g != g) || (p->b != b))
+    {
+        p->r = r;
+        p->g = g;
+        p->b = b;
+        Display_Mark_Dirty(1 << row);
+    }
+}
+/*============================================================
+    *   @func:      Display_Pixel
+    *   @brief:     按3位颜色值设置一个LED，点亮的通道为最大亮度
+    *   @param:     row：行 0~5 col：列 0~15 color：颜色，低电平点亮
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+void Display_Pixel(uint8_t row, uint8_t col, uint8_t color)
+{
+    Display_PixelRGB(row, col, (color & 0x04) ? 0 : LED_BCM_MAX,
+                     (color & 0x02) ? 0 : LED_BCM_MAX,
+                     (color & 0x01) ? 0 : LED_BCM_MAX);
+}
+/*============================================================
+    *   @func:      Display_SetBright
+    *   @brief:     设置整体亮度，所有行在下一节拍重新打包
+    *   @param:     level：0~LED_BCM_MAX
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+void Display_SetBright(uint8_t level)
+{
+    if(level > LED_BCM_MAX)
+    {
+        level = LED_BCM_MAX;
+    }
+    if(s_ucBright != level)
+    {
+        s_ucBright = level;
+        Display_Mark_Dirty((1 << LED_ROWS) - 1);
+    }
+}
+/*============================================================
+    *   @func:      Display_Mark_Dirty
+    *   @brief:     标记需要重新打包的行。没有待处理的行时启动一次 TMR_LED_CTRL，
+    *               这段时间内的变化合并打包；画面不变时不占用定时器
+    *   @param:     rows：行掩码
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+static void Display_Mark_Dirty(uint8_t rows)
+{
+    if(s_ucDirty == 0)
+    {
+        bsp_StartTimer(TMR_LED_CTRL, TMR_PERIOD_3MS);
+    }
+    s_ucDirty |= rows;
 }
 /*============================================================
     *   @func:      Display_LED_Select
@@ -182,10 +488,8 @@ void Display_InitMode(void)
         Display_Color(BLUE);
         break;
     case 3:
-        Display_Color(BLACK);
-        bsp_StopTimer(TMR_LED_CTRL);
+        Display_Color(BLACK);           //全黑时行扫描不再发送数据
         bsp_StopTimer(TMR_LED_INIT);
-        LED_ALL_ROW_OFF();
         g_Work_Mode = IDLE_MODE;
 //        Display_SetWorkMode(STATIC_MODE);
 
@@ -235,21 +539,6 @@ void Display_Start_Flow(void)
     bsp_StartAutoTimer(TMR_FLOW, TMR_PERIOD_50MS);
     Display_ON();
 }
-/*============================================================
-    *   @func:      Display_OneImage
-    *   @brief:     通过SPI显示一张图片
-    *   @param:     NA
-    *   @retval:    NA
-    *   @modify:    data            remarks
-=============================================================*/
-void Display_OneImage(uint8_t *data)
-{
-    HC595_LAT_LOW();
-    HC595_SendData((uint16_t *)data, 3);
-    bsp_DelayUS(10);
-    HC595_LAT_HIGH();
-}
-
 /*============================================================
     *   @func:      Display_Color
     *   @brief:     一次只能显示一种颜色
@@ -259,18 +548,17 @@ void Display_OneImage(uint8_t *data)
 =============================================================*/
 void Display_Color(uint8_t color)
 {
-    uint8_t i = 0;
-    uint32_t temp[2] = {0x00, 0x00};
-    for (i = 0; i < 16; ++i)
+    for (uint8_t r = 0; r < LED_ROWS; ++r)
     {
-        temp[0] = (temp[0] >> 3) | ((temp[1] & 0x07) << 29);
-        temp[1] = (temp[1] >> 3) | (color << 13);
+        for (uint8_t c = 0; c < LED_COLS; ++c)
+        {
+            Display_Pixel(r, c, color);
+        }
     }
-    Display_OneImage((uint8_t *)temp);
 }
 /*============================================================
-    *   @func:      Display_LED_Blue
-    *   @brief:     显示蓝色
+    *   @func:      Display_FlowColor
+    *   @brief:     流水灯，每步所有行右移一列，第0列移入新颜色
     *   @param:     NA
     *   @retval:    NA
     *   @modify:    data            remarks
@@ -282,10 +570,15 @@ void Display_FlowColor(void)
     // uint8_t color[12] = {3, 2, 1, 0, 5, 4, 6, 4, 5, 0, 1, 2};//RGB
     // uint8_t color[10] = {3,2,6,4,5,1,5,4,6,2};//RGB
     uint8_t color[6] = {3, 2, 6, 4, 5, 1}; //RGB
-    static uint32_t temp[2] = {0xFFFFFFFF, 0xFFFF};
-    Display_OneImage((uint8_t *)temp);
-    temp[0] = (temp[0] >> 3) | ((temp[1] & 0x07) << 29);
-    temp[1] = (temp[1] >> 3) | (color[j] << 13);
+    for (uint8_t r = 0; r < LED_ROWS; ++r)
+    {
+        for (uint8_t c = LED_COLS - 1; c > 0; --c)
+        {
+            LED_PIXEL *p = &s_tPixel[r][c - 1];
+            Display_PixelRGB(r, c, p->r, p->g, p->b);
+        }
+        Display_Pixel(r, 0, color[j]);
+    }
     if(++i == 4)
     {
         i = 0;
@@ -313,12 +606,10 @@ void Display_Indicate_LED(uint8_t led, uint8_t state)
         if(state == ENABLE)
         {
             Display_OneLED(4, 1, RED);
-            LED_ROW4_ON();
         }
         else
         {
             Display_OneLED(4, 1, BLACK);
-            LED_ALL_ROW_OFF();
         }
 
         break;
@@ -338,48 +629,15 @@ void Display_Indicate_LED(uint8_t led, uint8_t state)
 
 }
 /*============================================================
-    *   @func:      Display_Color
-    *   @brief:     一次只能显示一种颜色
-    *   @param:     NA
+    *   @func:      Display_OneLED
+    *   @brief:     设置某行某列LED颜色
+    *   @param:     row：行 1~6 col：列 1~16 color：BGR颜色
     *   @retval:    NA
     *   @modify:    data            remarks
 =============================================================*/
 void Display_OneLED(uint8_t row, uint8_t col, uint8_t color)
 {
-    uint8_t i = 0;
-    uint32_t temp[2] = {0xFFFFFFFF, 0xFFFF};
-    temp[1] = temp[1] | (color << 16);
-    for (i = 0; i < col; ++i)
-    {
-        temp[0] = (temp[0] >> 3) | ((temp[1] & 0x07) << 29);
-        temp[1] = (temp[1] >> 3) | (0xFF << 16);
-    }
-    Display_OneImage((uint8_t *)temp);
-}
-/*============================================================
-    *   @func:      Display_Snake_LED
-    *   @brief:     贪吃蛇模式LED控制
-    *   @param:     NA
-    *   @retval:    NA
-    *   @modify:    data            remarks
-=============================================================*/
-static void Display_Snake_LED(uint8_t row_num)
-{
-    static uint8_t i = 0;
-    static  uint32_t temp[2] = {0xFFFFFFFF, 0xFFFF};
-    if(i == 0)
-    {
-        temp[1] = temp[1] | (snake_Color << 16);
-    }
-    temp[0] = (temp[0] >> 3) | ((temp[1] & 0x07) << 29);
-    temp[1] = (temp[1] >> 3) | (0xFF << 16);
-    Display_OneImage((uint8_t *)temp);
-    if(++i == row_num)
-    {
-        i = 0;
-        temp[0] = 0xFFFFFFFF;
-        temp[1] = 0xFFFF;
-    }
+    Display_Pixel(row - 1, col - 1, color);
 }
 /*============================================================
     *   @func:      Display_Snake_Init
@@ -390,11 +648,11 @@ static void Display_Snake_LED(uint8_t row_num)
 =============================================================*/
 static void Display_Snake_Init(void)
 {
-    Display_LED_Select(0);
+    Display_Color(BLACK);
 }
 /*============================================================
     *   @func:      Display_Snake_Mode
-    *   @brief:     贪吃蛇模式
+    *   @brief:     贪吃蛇模式，一个LED逐行逐列移动
     *   @param:     NA
     *   @retval:    NA
     *   @modify:    data            remarks
@@ -403,8 +661,12 @@ void Display_Snake_Mode(void)
 {
     static uint8_t rows_num[6] = {16, 15, 15, 14, 14, 14};
     static uint8_t i = 0, j = 0;
-    Display_LED_Select(j);
-    Display_Snake_LED(rows_num[j]);
+    static uint8_t last_row = 0, last_col = 0;
+
+    Display_Pixel(last_row, last_col, BLACK);
+    Display_Pixel(j, i, snake_Color);
+    last_row = j;
+    last_col = i;
     if(++i == rows_num[j])
     {
         i = 0;
@@ -431,7 +693,6 @@ void Display_SetWorkMode(uint8_t mode)
     {
     case FLOW_MODE:
         bsp_StartAutoTimer(TMR_FLOW, TMR_PERIOD_50MS);
-        bsp_StartAutoTimer(TMR_LED_CTRL, TMR_PERIOD_3MS);
         break;
     case SNAKE_MODE:
         Display_Snake_Init();
@@ -439,15 +700,12 @@ void Display_SetWorkMode(uint8_t mode)
         break;
 
     case IDLE_MODE:
-        bsp_StopTimer(TMR_LED_CTRL);
         bsp_StopTimer(TMR_FLOW);
         Display_Color(BLACK);
-        LED_ALL_ROW_OFF();
 
         break;
 
     case STATIC_MODE:
-        bsp_StartAutoTimer(TMR_LED_CTRL, TMR_PERIOD_3MS);
         Display_Color(RED);
     break;
 
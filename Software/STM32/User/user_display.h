@@ -1,6 +1,56 @@
 #ifndef __USER_DISPLAY_H
 #define __USER_DISPLAY_H
 #include "bsp.h"
+
+#define LED_ROWS			6			//LED行数
+#define LED_COLS			16			//每行LED数
+#define LED_ROW_WORDS		3			//一行595数据：16个LED×3位，16位SPI发送3次
+
+/* BCM亮度：每个通道 LED_BCM_BITS 位亮度，每行按位平面依次显示，
+ * 第p个位平面显示 LED_BCM_UNIT_US<<p 微秒 */
+#ifndef LED_BCM_BITS
+	#define LED_BCM_BITS	4			//每通道亮度位数，4~6
+#endif
+#define LED_BCM_MAX			((1 << LED_BCM_BITS) - 1)	//最大亮度
+
+#if LED_BCM_BITS == 4
+	#define LED_BCM_UNIT_US		40
+#elif LED_BCM_BITS == 5
+	#define LED_BCM_UNIT_US		20
+#elif LED_BCM_BITS == 6
+	#define LED_BCM_UNIT_US		16
+#else
+	#error "LED_BCM_BITS must be 4~6"
+#endif
+
+/* 刷新率与中断负载估算，32MHz、SPI 4MHz：
+ *	位数	最短平面	行时间		刷新率	中断/秒	负载
+ *	4		40us		600us		277Hz	6650	约3.1%
+ *	5		20us		620us		268Hz	8040	约3.8%
+ *	6		16us		1008us		165Hz	5940	约2.8%
+ * 最短平面必须大于一行48位的SPI移位时间，否则锁存时DMA未完成。
+ * 主机测试 test_display 按 4~6 位分别编译，实测刷新率和中断次数 */
+#define LED_BCM_REFRESH_MIN_HZ	150		//低于此刷新率可见闪烁
+#define LED_BCM_LOAD_MAX_PERMIL	50		//位平面中断负载上限
+#define LED_BCM_CPU_MHZ		32			//系统时钟
+#define LED_BCM_ISR_CYCLES	150			//一次位平面中断的周期数(估计)
+#define LED_SPI_PUSH_US		14			//48位@4MHz 12us，加DMA启动余量
+#define LED_BCM_ROW_US		(LED_BCM_MAX * LED_BCM_UNIT_US)
+#define LED_BCM_FRAME_US	(LED_ROWS * LED_BCM_ROW_US)
+#define LED_BCM_REFRESH_HZ	(1000000 / LED_BCM_FRAME_US)
+#define LED_BCM_IRQ_PER_SEC	(LED_ROWS * LED_BCM_BITS * LED_BCM_REFRESH_HZ)
+#define LED_BCM_LOAD_PERMIL	(LED_BCM_IRQ_PER_SEC * LED_BCM_ISR_CYCLES / (LED_BCM_CPU_MHZ * 1000))
+
+#if LED_BCM_UNIT_US < LED_SPI_PUSH_US
+	#error "BCM unit shorter than one 595 row push"
+#endif
+#if LED_BCM_REFRESH_HZ < LED_BCM_REFRESH_MIN_HZ
+	#error "BCM refresh rate below 150Hz flickers"
+#endif
+#if LED_BCM_LOAD_PERMIL > LED_BCM_LOAD_MAX_PERMIL
+	#error "BCM ISR load above 5%"
+#endif
+
 typedef enum
  {
  	RED=3,
@@ -10,6 +60,19 @@ typedef enum
  	WHITE=0
  }COLOR_VALUE;
 
+typedef struct
+{
+	uint8_t r;						//红，0~LED_BCM_MAX
+	uint8_t g;						//绿
+	uint8_t b;						//蓝
+}LED_PIXEL;
+
+typedef struct
+{
+	volatile uint32_t frames;		//完整刷新次数
+	volatile uint32_t late;			//平面切换时DMA尚未完成、推迟到DMA完成时锁存的次数
+}LED_BCM_STAT;
+
  typedef enum
 {
 	IDLE_MODE=0x11,
@@ -23,18 +86,24 @@ typedef enum
 }WORKE_MODE;
 extern WORKE_MODE g_Work_Mode;
 void Display_Init(void);						//显示初始化
+void Display_Suspend(void);						//进入STOP前停止显示
+void Display_Resume(void);						//STOP唤醒后恢复显示，不自检
 void Display_ON(void);							//开启显示
 void Display_OFF(void);							//关闭显示
-void Display_OneImage(uint8_t *data);			//显示一张图片
 void Display_FlowColor(void);					//流水灯控制
 void Display_Color(uint8_t color);				//显示指定颜色
-void Display_Image(void);						//刷图
 void Display_Handle(void);						//显示处理
 void Display_Start_Flow(void);					//启动流水灯
 void Display_LEDPwr_Ctrl(void);					//LED电源控制切换
 void Display_InitMode(void);					//初始化模式
 void Display_Indicate_LED(uint8_t led, uint8_t state);	//指示灯状态
 void Display_OneLED(uint8_t row, uint8_t col, uint8_t color);	//制定某行某列LED显示颜色	
+void Display_Pixel(uint8_t row, uint8_t col, uint8_t color);	//设置帧缓冲区像素
+void Display_PixelRGB(uint8_t row, uint8_t col, uint8_t r, uint8_t g, uint8_t b);	//设置像素亮度
+void Display_SetBright(uint8_t level);			//设置整体亮度 0~LED_BCM_MAX
+void Display_BCM_ISR(void);						//位平面切换，LED定时器中断中调用
+void Display_BCM_DMA_ISR(void);					//位平面移入完成，595 DMA中断中调用
+LED_BCM_STAT *Display_BCM_GetStat(void);		//获取BCM统计
 void Display_SetWorkMode(uint8_t mode);			//设置显示模式
 void Display_Snake_Mode(void);					//贪吃蛇模式
 void Display_ChangeSnakeColor(void);			//改变贪吃蛇颜色
@@ -0,0 +1,246 @@
+/************************************************************
+	*	@file:		user_event.c
+	*	@brief:		事件调度。中断只置位事件，任务在主循环中按固定顺序
+	*				运行到结束，队列为空时WFI休眠，并统计任务耗时和空闲时间
+	*	@author:	XIET
+	*	@version:	V1.0
+	*	@data:		201x-xx-xx
+	*	@modify:	data  			remarks
+**************************************************************/
+#include "bsp.h"
+
+static volatile uint32_t s_uiEvent = 0;				//待处理事件
+static volatile uint32_t s_uiPostTime[EVT_COUNT];	//事件首次发布的时间(us)
+static EVENT_STAT s_tEventStat;
+
+/* 任务表，按顺序运行。休眠检查在显示之前，进入休眠模式后由显示任务执行停机 */
+static const EVENT_TASK s_tEventTask[TASK_COUNT] =
+{
+	{EVT_SCAN_TICK | EVT_MATRIX | EVT_KEY_WAKE | EVT_USB_TX, Keyboard_Task},
+	{EVT_MACRO | EVT_USB_TX, Macro_Task},
+	{EVT_UART_RX | EVT_LINK, Link_Task},
+	{EVT_KEYMAP, Keymap_Task},
+	{EVT_SLEEP, Pwr_Sleep_Check},
+	{EVT_LED | EVT_SLEEP, Display_Handle},
+};
+
+static void Event_Tmr_Scan(void);
+static void Event_Tmr_Led(void);
+static void Event_Tmr_Sleep(void);
+static void Event_Tmr_Link(void);
+static void Event_Tmr_Macro(void);
+static void Event_Uart_Rx(void);
+static uint32_t Event_First_Post(uint32_t evt, uint32_t now);
+/*============================================================
+	*	@func:		Event_Init
+	*	@brief:		登记事件源：软件定时器到时回调、串口接收回调。
+	*				bsp_Init 会清除这些回调，初始化和停机唤醒后都要调用。
+	*				首次运行所有任务一次
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void Event_Init(void)
+{
+	bsp_SetTimerCallback(TMR_KEY_SCAN, Event_Tmr_Scan);
+	bsp_SetTimerCallback(TMR_LED_CTRL, Event_Tmr_Led);
+	bsp_SetTimerCallback(TMR_LED_INIT, Event_Tmr_Led);
+	bsp_SetTimerCallback(TMR_FLOW, Event_Tmr_Led);
+	bsp_SetTimerCallback(TMR_SLEEP, Event_Tmr_Sleep);
+	bsp_SetTimerCallback(TMR_LINK, Event_Tmr_Link);
+	bsp_SetTimerCallback(TMR_MACRO, Event_Tmr_Macro);
+	comSetReceiveNew(COM_BLE, Event_Uart_Rx);
+	Event_ClearStat();
+	Event_Post(EVT_ALL);
+}
+/*============================================================
+	*	@func:		Event_Post
+	*	@brief:		发布事件。保存并恢复中断状态，可在中断、定时器回调
+	*				及关中断区域中调用
+	*	@param:		evt：事件位
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void Event_Post(uint32_t evt)
+{
+	uint32_t primask = __get_PRIMASK();
+	uint32_t fresh;
+	uint32_t now;
+
+	DISABLE_INT();
+	fresh = evt & ~s_uiEvent;
+	s_uiEvent |= evt;
+	__set_PRIMASK(primask);
+	if(fresh)
+	{
+		now = bsp_GetRunTimeUs();
+		for (uint8_t i = 0; fresh; ++i, fresh >>= 1)
+		{
+			if(fresh & 0x01)
+			{
+				s_uiPostTime[i] = now;
+			}
+		}
+	}
+}
+/*============================================================
+	*	@func:		Event_Run
+	*	@brief:		取出全部待处理事件，依次运行订阅的任务并统计耗时。
+	*				没有事件时关中断检查后WFI，唤醒中断在开中断后执行
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void Event_Run(void)
+{
+	EVENT_TASK_STAT *p_stat;
+	uint32_t evt;
+	uint32_t start;
+	uint32_t used;
+
+	DISABLE_INT();
+	evt = s_uiEvent;
+	s_uiEvent = 0;
+	ENABLE_INT();
+
+	if(evt == 0)
+	{
+		Clock_Update();			//睡眠前按需求切换时钟
+		start = bsp_GetRunTimeUs();
+		DISABLE_INT();
+		if(s_uiEvent == 0)
+		{
+			__WFI();
+			s_tEventStat.wakeups++;
+		}
+		ENABLE_INT();
+		used = bsp_GetRunTimeUs() - start;
+		s_tEventStat.idle_us += used;
+		Clock_Idle(used);
+		return;
+	}
+	for (uint8_t i = 0; i < TASK_COUNT; ++i)
+	{
+		if(!(evt & s_tEventTask[i].mask))
+		{
+			continue;
+		}
+		p_stat = &s_tEventStat.task[i];
+		start = bsp_GetRunTimeUs();
+		used = start - Event_First_Post(evt & s_tEventTask[i].mask, start);
+		if(used > p_stat->lat_max_us)
+		{
+			p_stat->lat_max_us = used;
+		}
+		s_tEventTask[i].run();
+		used = bsp_GetRunTimeUs() - start;
+		p_stat->runs++;
+		p_stat->time_us += used;
+		if(used > p_stat->max_us)
+		{
+			p_stat->max_us = used;
+		}
+	}
+}
+/*============================================================
+	*	@func:		Event_GetStat
+	*	@brief:		获取任务运行统计
+	*	@param:		NA
+	*	@retval:	统计结构体
+	*	@modify: 	data 			remarks
+=============================================================*/
+EVENT_STAT *Event_GetStat(void)
+{
+	return &s_tEventStat;
+}
+/*============================================================
+	*	@func:		Event_GetIdlePercent
+	*	@brief:		统计起点以来WFI休眠时间所占百分比
+	*	@param:		NA
+	*	@retval:	0~100
+	*	@modify: 	data 			remarks
+=============================================================*/
+uint8_t Event_GetIdlePercent(void)
+{
+	uint32_t total = bsp_GetRunTimeUs() - s_tEventStat.start_us;
+
+	if(total < 100)
+	{
+		return 0;
+	}
+	return (uint8_t)(s_tEventStat.idle_us / (total / 100));
+}
+/*============================================================
+	*	@func:		Event_ClearStat
+	*	@brief:		清除统计，重新开始计时
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void Event_ClearStat(void)
+{
+	memset(&s_tEventStat, 0, sizeof(s_tEventStat));
+	s_tEventStat.start_us = bsp_GetRunTimeUs();
+}
+/*============================================================
+	*	@func:		Event_First_Post
+	*	@brief:		一组事件中最早的发布时间
+	*	@param:		evt：事件位 now：当前时间
+	*	@retval:	最早发布时间
+	*	@modify: 	data 			remarks
+=============================================================*/
+static uint32_t Event_First_Post(uint32_t evt, uint32_t now)
+{
+	uint32_t age = 0;
+
+	for (uint8_t i = 0; evt; ++i, evt >>= 1)
+	{
+		if((evt & 0x01) && ((now - s_uiPostTime[i]) > age))
+		{
+			age = now - s_uiPostTime[i];
+		}
+	}
+	return now - age;
+}
+/*============================================================
+	*	@func:		Event_Tmr_Scan
+	*	@brief:		软件定时器到时回调，在SysTick中断中执行，只发布事件
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+static void Event_Tmr_Scan(void)
+{
+	Event_Post(EVT_SCAN_TICK);
+}
+
+static void Event_Tmr_Led(void)
+{
+	Event_Post(EVT_LED);
+}
+
+static void Event_Tmr_Sleep(void)
+{
+	Event_Post(EVT_SLEEP);
+}
+
+static void Event_Tmr_Link(void)
+{
+	Event_Post(EVT_LINK);
+}
+
+static void Event_Tmr_Macro(void)
+{
+	Event_Post(EVT_MACRO);
+}
+/*============================================================
+	*	@func:		Event_Uart_Rx
+	*	@brief:		BLE串口接收回调，接收FIFO由空变为非空时在串口中断中调用
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+static void Event_Uart_Rx(void)
+{
+	Event_Post(EVT_UART_RX);
+}
@@ -0,0 +1,62 @@
+#ifndef __USER_EVENT_H
+#define __USER_EVENT_H
+#include "bsp.h"
+
+/*
+	事件驱动主循环：中断中 Event_Post 置位事件，主循环取出全部事件，
+	依次运行订阅了这些事件的任务，每个任务运行到结束；没有事件时WFI休眠。
+	软件定时器到时通过回调发布事件，任务内部仍可用 bsp_CheckTimer 区分定时器。
+*/
+#define EVT_SCAN_TICK		(1 << 0)		//扫描节拍：TMR_KEY_SCAN 或 USB SOF
+#define EVT_MATRIX			(1 << 1)		//一轮矩阵扫描完成
+#define EVT_KEY_WAKE		(1 << 2)		//列中断唤醒
+#define EVT_USB_TX			(1 << 3)		//USB IN 端点发送完成
+#define EVT_UART_RX			(1 << 4)		//BLE串口收到数据
+#define EVT_LINK			(1 << 5)		//链路补发快照定时
+#define EVT_LED				(1 << 6)		//LED节拍：TMR_LED_CTRL/TMR_FLOW/TMR_LED_INIT
+#define EVT_SLEEP			(1 << 7)		//休眠定时
+#define EVT_MACRO			(1 << 8)		//宏回放节拍或延时到
+#define EVT_KEYMAP			(1 << 9)		//键值表被修改或继续写EEPROM
+#define EVT_COUNT			10
+#define EVT_ALL				((1 << EVT_COUNT) - 1)
+
+typedef enum
+{
+	TASK_KEYBOARD = 0,
+	TASK_MACRO,
+	TASK_LINK,
+	TASK_KEYMAP,
+	TASK_SLEEP,
+	TASK_DISPLAY,
+	TASK_COUNT
+}EVENT_TASK_ID;
+
+typedef struct
+{
+	uint32_t mask;					//订阅的事件
+	void (*run)(void);				//任务函数
+}EVENT_TASK;
+
+typedef struct
+{
+	uint32_t runs;					//运行次数
+	uint32_t time_us;				//累计运行时间
+	uint32_t max_us;				//单次最长运行时间
+	uint32_t lat_max_us;			//事件发布到任务开始运行的最长时间
+}EVENT_TASK_STAT;
+
+typedef struct
+{
+	EVENT_TASK_STAT task[TASK_COUNT];
+	uint32_t idle_us;				//WFI休眠累计时间
+	uint32_t start_us;				//统计起点
+	uint32_t wakeups;				//从WFI唤醒次数
+}EVENT_STAT;
+
+void Event_Init(void);							//事件源登记，定时器初始化后调用
+void Event_Post(uint32_t evt);					//发布事件，可在中断中调用
+void Event_Run(void);							//运行一次调度，无事件时休眠
+EVENT_STAT *Event_GetStat(void);				//获取任务运行统计
+uint8_t Event_GetIdlePercent(void);				//统计起点以来的空闲百分比
+void Event_ClearStat(void);						//重新开始统计
+#endif
@@ -7,12 +7,32 @@
     *   @modify:    data            remarks
 **************************************************************/
 #include "bsp.h"
-#define DEBOUNCE 5
 uint16_t matrix[MATRIX_ROWS];
 uint16_t matrix_Debouncing[MATRIX_ROWS];
-static uint8_t debouncing = DEBOUNCE;
+static uint16_t s_usMatrixPrev[MATRIX_ROWS];  //已转换为事件的矩阵状态
+
+static KEY_SCAN_STAT s_tKeyStat;            //扫描耗时统计
+static volatile uint8_t s_ucKeyIdle = 0;    //1：停止扫描，等待列中断
+static volatile uint8_t s_ucKeyWake = 0;    //1：列中断已唤醒，等待恢复扫描
+static int32_t s_iKeyActiveTime = 0;        //最近一次有按键按下的时间
+static int32_t s_iKeyIdleTime = 0;          //进入中断等待的时间
+static volatile uint8_t s_ucScanBusy = 0;   //1：一轮扫描进行中
+static volatile uint8_t s_ucScanRow = 0;    //当前等待稳定的行
+static volatile uint8_t s_ucMatrixReady = 0;    //1：有新的矩阵快照未取走
+static uint32_t s_uiScanUs = 0;             //本轮扫描中断累计耗时(us)
+static volatile uint16_t s_usWakeCol = 0;   //中断等待期间产生上升沿的列
+/* 单生产者单消费者事件环：扫描中断只写 write，主循环只写 read，下标自由回绕 */
+static KEY_EVENT_REC s_tEventRing[KEY_EVENT_RING_SIZE];
+static volatile uint8_t s_ucEventWrite = 0;
+static volatile uint8_t s_ucEventRead = 0;
+static uint8_t s_ucScanSeq = 0;             //扫描序号
+/* 4位最低置位位置，0按4计 */
+static const uint8_t s_ucNibbleCtz[16] = {4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0};
 
 static void Key_Select_Row(uint8_t row);
+static void Key_Event_Diff(void);
+static uint8_t Key_Ctz16(uint16_t w);
+static void Key_Scan_Stat(uint32_t us);
 /*============================================================
     *   @func:      Key_Scan_Init
     *   @brief:     按键扫描初始化
@@ -22,52 +42,408 @@ static void Key_Select_Row(uint8_t row);
 =============================================================*/
 void Key_Scan_Init(void)
 {
+    bsp_HwTimer_Stop();
+    s_ucScanBusy = 0;
+    s_ucMatrixReady = 0;
     KEY_ALL_ROW_UNSELECT();     //释放行
     for (uint8_t i = 0; i < MATRIX_ROWS; ++i)
     {
         matrix[i] = 0;
         matrix_Debouncing[i] = 0;
     }
+    Debounce_Init();
+    GPIO_Disable_EXTI();        //STOP唤醒后列中断仍处于使能状态
+    s_ucKeyIdle = 0;
+    s_ucKeyWake = 0;
+    s_iKeyActiveTime = bsp_GetRunTime();
+    Clock_Demand(CLOCK_REQ_KEY, 1);
     bsp_StartAutoTimer(TMR_KEY_SCAN, TMR_PERIOD_2MS);
     bsp_StartTimer(TMR_SLEEP, TMR_PERIOD_10MIN);
 }
 /*============================================================
-    *   @func:      XX
-    *   @brief:     XX
+    *   @func:      Key_Scan
+    *   @brief:     启动一轮扫描：选中第一行并启动行稳定定时，立即返回。
+    *               之后每行在定时器中断中读取，整轮结束后消抖并发布快照
     *   @param:     NA
     *   @retval:    NA
     *   @modify:    data            remarks
 =============================================================*/
 void Key_Scan(void)
 {
-    uint8_t i;
-    uint16_t col_Value;
+    if(s_ucScanBusy)        //上一轮未完成
+    {
+        s_tKeyStat.scan_overrun++;
+        return;
+    }
+    s_uiScanUs = 0;
+    s_ucScanRow = 0;
+    s_ucScanBusy = 1;
+    Key_Select_Row(0);
+    bsp_HwTimer_Start(KEY_SETTLE_US);
+}
+/*============================================================
+    *   @func:      Key_Scan_Row_ISR
+    *   @brief:     行稳定定时到，在定时器中断中调用。读取当前行并选中下一行，
+    *               最后一行读完后释放行、消抖，变化的按键写入事件环
+    *   @param:     NA
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+void Key_Scan_Row_ISR(void)
+{
+    uint16_t start = bsp_UsTimer_Now();
+    uint8_t row = s_ucScanRow;
 
-    for (i = 0; i < MATRIX_ROWS; ++i)
+    if(!s_ucScanBusy)
     {
-        Key_Select_Row(i);
-        bsp_DelayUS(10);
-        col_Value = Key_Read_Col();
-        if(col_Value != matrix_Debouncing[i])
-        {
-            matrix_Debouncing[i] = col_Value;
-            debouncing = DEBOUNCE;
-        }
+        return;
+    }
+    matrix_Debouncing[row] = Key_Read_Col();
+    if(++row < MATRIX_ROWS)
+    {
+        s_ucScanRow = row;
+        Key_Select_Row(row);
+        bsp_HwTimer_Start(KEY_SETTLE_US);
+        s_uiScanUs += (uint16_t)(bsp_UsTimer_Now() - start);
+        return;
+    }
+    KEY_ALL_ROW_UNSELECT();
+    Debounce_Matrix(matrix_Debouncing, matrix);
+    Key_Event_Diff();
+    s_ucMatrixReady = 1;
+    Event_Post(EVT_MATRIX);
+    s_ucScanBusy = 0;
+    Key_Scan_Stat(s_uiScanUs + (uint16_t)(bsp_UsTimer_Now() - start));
+}
+/*============================================================
+    *   @func:      Key_Scan_Done
+    *   @brief:     是否完成了新的一轮扫描，关中断读取后清除
+    *   @param:     NA
+    *   @retval:    1：有新一轮扫描 0：没有
+    *   @modify:    data            remarks
+=============================================================*/
+uint8_t Key_Scan_Done(void)
+{
+    uint8_t ready;
+
+    DISABLE_INT();      //读取和清除之间不能插入扫描完成
+    ready = s_ucMatrixReady;
+    s_ucMatrixReady = 0;
+    ENABLE_INT();
+    return ready;
+}
+/*============================================================
+    *   @func:      Key_Event_Get
+    *   @brief:     从事件环取出一个按键事件，在主循环中调用。先拷贝记录再
+    *               释放槽位，扫描中断不会覆盖正在读取的记录
+    *   @param:     rec：事件记录
+    *   @retval:    1：取到事件 0：环为空
+    *   @modify:    data            remarks
+=============================================================*/
+uint8_t Key_Event_Get(KEY_EVENT_REC *rec)
+{
+    uint8_t read = s_ucEventRead;
+    uint32_t delay;
+
+    if(read == s_ucEventWrite)
+    {
+        return 0;
+    }
+    *rec = s_tEventRing[read & (KEY_EVENT_RING_SIZE - 1)];
+    __DMB();
+    s_ucEventRead = read + 1;
+    delay = bsp_GetRunTimeUs() - rec->time;
+    if(delay > s_tKeyStat.event_delay_us_max)
+    {
+        s_tKeyStat.event_delay_us_max = delay;
+    }
+    return 1;
+}
+/*============================================================
+    *   @func:      Key_Event_Peek
+    *   @brief:     读取事件环中最早的按键事件但不取出，主循环据此决定是否
+    *               先发出上一轮扫描的报告
+    *   @param:     rec：事件记录
+    *   @retval:    1：有事件 0：环为空
+    *   @modify:    data            remarks
+=============================================================*/
+uint8_t Key_Event_Peek(KEY_EVENT_REC *rec)
+{
+    uint8_t read = s_ucEventRead;
+
+    if(read == s_ucEventWrite)
+    {
+        return 0;
     }
-    if(debouncing)
+    *rec = s_tEventRing[read & (KEY_EVENT_RING_SIZE - 1)];
+    return 1;
+}
+/*============================================================
+    *   @func:      Key_Event_Diff
+    *   @brief:     消抖后的矩阵与已入环状态比较，变化的按键按行列顺序写入事件环，
+    *               在扫描中断或关中断时调用。只遍历变化字中置位的位，每行入环的
+    *               位最后一次写回。环满时其余按键状态不更新，下一轮扫描重新产生，
+    *               同一按键的按下和释放不会颠倒或丢失
+    *   @param:     NA
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+static void Key_Event_Diff(void)
+{
+    uint32_t now = bsp_GetRunTimeUs();
+    uint8_t write = s_ucEventWrite;
+    uint8_t space = KEY_EVENT_RING_SIZE - (uint8_t)(write - s_ucEventRead);    //中断中读下标只会增加
+    uint8_t used;
+    uint8_t c;
+    uint16_t row_now;
+    uint16_t change;
+    uint16_t done;
+    KEY_EVENT_REC *p_rec;
+
+    s_ucScanSeq++;
+    for (uint8_t r = 0; r < MATRIX_ROWS; ++r)
     {
-        if(--debouncing)
+        row_now = matrix[r];
+        change = row_now ^ s_usMatrixPrev[r];
+        if(!change)
         {
+            continue;
         }
-        else
+        done = 0;
+        while(change)
         {
-            for ( i = 0; i < MATRIX_ROWS; ++i)
+            if(space == 0)
             {
-                matrix[i] = matrix_Debouncing[i];
+                for (; change; change &= change - 1)
+                {
+                    s_tKeyStat.event_overflow++;
+                }
+                break;
             }
+            c = Key_Ctz16(change);
+            change &= change - 1;       //清除最低位
+            done |= (uint16_t)1 << c;
+            p_rec = &s_tEventRing[write & (KEY_EVENT_RING_SIZE - 1)];
+            p_rec->time = now;
+            p_rec->row = r;
+            p_rec->col = c;
+            p_rec->pressed = (row_now >> c) & 0x01;
+            p_rec->seq = s_ucScanSeq;
+            write++;
+            space--;
         }
+        s_usMatrixPrev[r] ^= done;
+    }
+    s_tKeyStat.event_count += (uint8_t)(write - s_ucEventWrite);
+    used = (uint8_t)(write - s_ucEventRead);
+    if(used > s_tKeyStat.event_high)
+    {
+        s_tKeyStat.event_high = used;
+    }
+    __DMB();            //记录写完后再发布
+    s_ucEventWrite = write;
+}
+/*============================================================
+    *   @func:      Key_Ctz16
+    *   @brief:     最低置位位的位置。M0+没有CLZ/RBIT指令，先按字节、半字节
+    *               缩小范围，再查4位表
+    *   @param:     w：非零的16位字
+    *   @retval:    0~15
+    *   @modify:    data            remarks
+=============================================================*/
+static uint8_t Key_Ctz16(uint16_t w)
+{
+    uint8_t n = 0;
+
+    if(!(w & 0x00FF))
+    {
+        w >>= 8;
+        n = 8;
+    }
+    if(!(w & 0x000F))
+    {
+        w >>= 4;
+        n += 4;
+    }
+    return n + s_ucNibbleCtz[w & 0x000F];
+}
+/*============================================================
+    *   @func:      Key_Scan_Stat
+    *   @brief:     一轮扫描结束，累计扫描耗时
+    *   @param:     us：本轮扫描各次中断耗时之和
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+static void Key_Scan_Stat(uint32_t us)
+{
+    s_tKeyStat.scan_count++;
+    s_tKeyStat.scan_us += us;
+    if(us > s_tKeyStat.scan_us_max)
+    {
+        s_tKeyStat.scan_us_max = us;
     }
 }
+/*============================================================
+    *   @func:      Key_Scan_Idle_Check
+    *   @brief:     每次扫描后调用。所有按键释放且持续 KEY_IDLE_TIME 后停止
+    *               定时扫描，行全部输出高电平，列切换为上升沿中断
+    *   @param:     NA
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+void Key_Scan_Idle_Check(void)
+{
+#if KEY_IDLE_EN == 1
+    int32_t now = bsp_GetRunTime();
+
+    if(s_ucScanBusy)
+    {
+        return;
+    }
+    for (uint8_t i = 0; i < MATRIX_ROWS; ++i)
+    {
+        if(matrix[i] | matrix_Debouncing[i])
+        {
+            s_iKeyActiveTime = now;
+            return;
+        }
+    }
+    if((now - s_iKeyActiveTime) < KEY_IDLE_TIME)
+    {
+        return;
+    }
+    bsp_StopTimer(TMR_KEY_SCAN);
+    s_iKeyIdleTime = now;
+    s_tKeyStat.idle_count++;
+    s_ucKeyIdle = 1;
+    Clock_Demand(CLOCK_REQ_KEY, 0);     //中断等待时不需要PLL
+    GPIO_Config_EXTI();
+    if(Key_Read_Col())      //使能中断前已有按键按下，不会再产生上升沿
+    {
+        DISABLE_INT();
+        Key_Scan_Wakeup(Key_Read_Col());
+        ENABLE_INT();
+    }
+#endif
+}
+/*============================================================
+    *   @func:      Key_Scan_Wakeup
+    *   @brief:     列中断回调，在EXTI中断中调用。记录唤醒列，关闭列中断并通知主循环恢复扫描
+    *   @param:     col：产生中断的列
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+void Key_Scan_Wakeup(uint16_t col)
+{
+    GPIO_Disable_EXTI();
+    s_usWakeCol |= col & KEY_COL_ALL_PIN;
+    if(s_ucKeyIdle && (!s_ucKeyWake))
+    {
+        s_ucKeyWake = 1;
+        s_tKeyStat.wake_count++;
+        Event_Post(EVT_KEY_WAKE);
+    }
+}
+/*============================================================
+    *   @func:      Key_Scan_Resume
+    *   @brief:     列中断唤醒后恢复定时扫描
+    *   @param:     NA
+    *   @retval:    1：刚恢复，需立即扫描 0：无唤醒
+    *   @modify:    data            remarks
+=============================================================*/
+uint8_t Key_Scan_Resume(void)
+{
+    int32_t now;
+
+    if(!s_ucKeyWake)
+    {
+        return 0;
+    }
+    now = bsp_GetRunTime();
+    s_tKeyStat.idle_ms += now - s_iKeyIdleTime;
+    s_iKeyActiveTime = now;
+    KEY_ALL_ROW_UNSELECT();
+    Clock_Demand(CLOCK_REQ_KEY, 1);     //首轮扫描在当前时钟下进行，睡眠前升频
+    bsp_StartAutoTimer(TMR_KEY_SCAN, TMR_PERIOD_2MS);
+    s_ucKeyWake = 0;
+    s_ucKeyIdle = 0;
+    return 1;
+}
+/*============================================================
+    *   @func:      Key_Scan_Suspend
+    *   @brief:     进入STOP前调用。停止扫描并进入中断等待状态，矩阵和消抖状态保留
+    *   @param:     NA
+    *   @retval:    NA
+    *   @modify:    data            remarks
+=============================================================*/
+void Key_Scan_Suspend(void)
+{
+    bsp_HwTimer_Stop();
+    s_ucScanBusy = 0;
+    KEY_ALL_ROW_UNSELECT();
+    bsp_StopTimer(TMR_KEY_SCAN);
+    if(!s_ucKeyIdle)
+    {
+        s_iKeyIdleTime = bsp_GetRunTime();
+        s_tKeyStat.idle_count++;
+        s_ucKeyIdle = 1;
+    }
+    s_ucKeyWake = 0;
+    s_usWakeCol = 0;
+    Clock_Demand(CLOCK_REQ_KEY, 0);
+}
+/*============================================================
+    *   @func:      Key_Scan_Capture
+    *   @brief:     STOP唤醒、恢复时钟和IO后调用。同步扫描一轮，结果直接作为
+    *               消抖后的状态并立即发布事件，任何消抖算法下短按的唤醒键
+    *               在恢复定时扫描前释放也不会丢失
+    *   @param:     NA
+    *   @retval:    1：唤醒列上有按键按下 0：唤醒键已释放
+    *   @modify:    data            remarks
+=============================================================*/
+uint8_t Key_Scan_Capture(void)
+{
+    uint16_t hit = 0;
+
+    for (uint8_t row = 0; row < MATRIX_ROWS; ++row)
+    {
+        Key_Select_Row(row);
+        bsp_DelayUS(KEY_SETTLE_US);
+        matrix_Debouncing[row] = Key_Read_Col();
+        hit |= matrix_Debouncing[row];
+    }
+    KEY_ALL_ROW_UNSELECT();
+    DISABLE_INT();
+    Debounce_Seed(matrix_Debouncing, matrix);
+    Key_Event_Diff();
+    s_ucMatrixReady = 1;
+    ENABLE_INT();
+    Event_Post(EVT_MATRIX);
+    return (hit & s_usWakeCol) ? 1 : 0;
+}
+/*============================================================
+    *   @func:      Key_Scan_IsIdle
+    *   @brief:     是否处于中断等待状态
+    *   @param:     NA
+    *   @retval:    1：中断等待 0：定时扫描
+    *   @modify:    data            remarks
+=============================================================*/
+uint8_t Key_Scan_IsIdle(void)
+{
+    return s_ucKeyIdle;
+}
+/*============================================================
+    *   @func:      Key_Scan_GetStat
+    *   @brief:     获取扫描统计。扫描耗时由TIM22计时，单位为us，不随系统时钟变化，
+    *               事件延迟同样以us计
+    *   @param:     NA
+    *   @retval:    统计结构体
+    *   @modify:    data            remarks
+=============================================================*/
+KEY_SCAN_STAT *Key_Scan_GetStat(void)
+{
+    return &s_tKeyStat;
+}
 
 /*============================================================
     *   @func:      Key_Select_Row
@@ -1,9 +1,55 @@
 #ifndef __USER_KEY_H
 #define __USER_KEY_H
 #include "bsp.h"
+
+#define KEY_IDLE_EN			1					//1：按键空闲时停止定时扫描，等待列中断唤醒
+#define KEY_IDLE_TIME		TMR_PERIOD_50MS		//全部释放后进入中断等待的时间(ms)，需大于消抖时间
+#define KEY_SETTLE_US		10					//选中行后等待列电平稳定的时间(us)
+#define KEY_EVENT_RING_SIZE	32					//按键事件环深度，2的幂且不超过128
+
+#if (KEY_EVENT_RING_SIZE & (KEY_EVENT_RING_SIZE - 1)) || (KEY_EVENT_RING_SIZE > 128)
+	#error "KEY_EVENT_RING_SIZE must be a power of 2 no larger than 128"
+#endif
+
+/* 扫描中断产生、主循环取出的按键事件，同一轮扫描的事件序号和时间相同 */
+typedef struct
+{
+	uint32_t time;					//扫描完成时间(us)
+	uint8_t row;					//行
+	uint8_t col;					//列
+	uint8_t pressed;				//1：按下 0：释放
+	uint8_t seq;					//扫描序号
+}KEY_EVENT_REC;
+
+typedef struct
+{
+	uint32_t scan_count;			//扫描次数
+	uint32_t scan_us;				//扫描中断累计耗时(us)，不含行稳定等待
+	uint32_t scan_us_max;			//单轮扫描最大耗时(us)
+	uint32_t scan_overrun;			//启动扫描时上一轮未完成次数
+	uint32_t idle_count;			//进入中断等待次数
+	volatile uint32_t wake_count;	//列中断唤醒次数
+	uint32_t idle_ms;				//中断等待累计时间(ms)
+	uint32_t event_count;			//入环事件数
+	uint32_t event_overflow;		//环满推迟到下一轮扫描的事件数
+	uint8_t event_high;				//环中最多同时存在的事件数
+	uint32_t event_delay_us_max;	//扫描完成到主循环取出的最大延迟(us)
+}KEY_SCAN_STAT;
+
 void Key_Scan_Init(void);					//按键扫描初始化
-void Key_Scan(void);						//按键扫描
+void Key_Scan(void);						//启动一轮按键扫描
+void Key_Scan_Row_ISR(void);				//行稳定定时中断回调
+uint8_t Key_Scan_Done(void);				//是否完成了新的一轮扫描
+uint8_t Key_Event_Get(KEY_EVENT_REC *rec);	//从事件环取出一个按键事件
+uint8_t Key_Event_Peek(KEY_EVENT_REC *rec);	//读取最早的按键事件，不取出
 uint16_t Key_Read_Col(void);				//读取列数据
 uint16_t Key_Matrix_Get_Row(uint8_t row);	//	获取按键扫描值
+void Key_Scan_Idle_Check(void);				//空闲检测，进入中断等待
+void Key_Scan_Wakeup(uint16_t col);			//列中断唤醒回调
+void Key_Scan_Suspend(void);				//进入STOP前停止扫描
+uint8_t Key_Scan_Capture(void);				//STOP唤醒后同步扫描一轮
+uint8_t Key_Scan_Resume(void);				//唤醒后恢复扫描
+uint8_t Key_Scan_IsIdle(void);				//是否处于中断等待
+KEY_SCAN_STAT *Key_Scan_GetStat(void);		//获取扫描统计
 
 #endif
@@ -0,0 +1,432 @@
+/************************************************************
+	*	@file:		user_keymap.c
+	*	@brief:		可修改的键值表：保存在数据EEPROM中，校验后载入RAM缓存，
+	*				由USB特性报告修改，按字比较后分批写回EEPROM
+	*	@author:	XIET
+	*	@version:	V1.0
+	*	@data:		201x-xx-xx
+	*	@modify:	data  			remarks
+**************************************************************/
+#include "bsp.h"
+
+#define KEYMAP_HDR			((const KEYMAP_HEADER *)KEYMAP_EEPROM_ADDR)
+#define KEYMAP_DATA_ADDR	(KEYMAP_EEPROM_ADDR + sizeof(KEYMAP_HEADER))
+#define KEYMAP_HDR_WORDS	(sizeof(KEYMAP_HEADER) / 4)
+
+enum
+{
+	KEYMAP_STATE_IDLE = 0,
+	KEYMAP_STATE_START,				//已请求写入，等待任务计算CRC
+	KEYMAP_STATE_DATA,				//写键值表
+	KEYMAP_STATE_HEADER				//写头
+};
+
+static uint32_t s_uiKeymap[KEYMAP_WORDS];			//RAM缓存，按字对齐，整字写EEPROM
+static uint32_t s_uiHeader[KEYMAP_HDR_WORDS];		//写入中的头
+static uint32_t s_uiHeaderSeen[KEYMAP_HDR_WORDS];	//载入时EEPROM中的头
+static uint16_t s_usCrc = 0;						//最近一次载入或写入的键值表CRC
+static uint16_t s_usPos = 0;						//下一个要比较的字
+static volatile uint8_t s_ucState = KEYMAP_STATE_IDLE;
+static volatile uint8_t s_ucEdited = 0;				//1：RAM缓存已修改，需要刷新层缓存
+static uint8_t s_ucCmd = 0;							//上一条特性报告命令
+static uint8_t s_ucStatus = KEYMAP_OK;				//上一条命令的结果
+static uint16_t s_usReadOff = 0;					//READ 位置
+static uint8_t s_ucReadLen = 0;						//READ 长度
+static int32_t s_iCommitTime = 0;					//开始写入的时间
+static KEYMAP_STAT s_tKeymapStat;
+
+static uint8_t Keymap_Load(void);
+static void Keymap_Default(void);
+static uint8_t Keymap_Start(void);
+static uint8_t Keymap_Write_Next(uint32_t addr, const uint32_t *buf, uint16_t words);
+static uint8_t Keymap_EE_Word(uint32_t addr, uint32_t data);
+static uint16_t Keymap_CRC16(const uint8_t *buf, uint16_t len);
+static uint8_t Keymap_Check(const uint8_t *buf, uint16_t len);
+/*============================================================
+	*	@func:		Keymap_Init
+	*	@brief:		从EEPROM载入键值表，无效时使用默认键值表。在 Layer_Init 前调用
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void Keymap_Init(void)
+{
+	s_ucState = KEYMAP_STATE_IDLE;
+	s_ucEdited = 0;
+	s_ucCmd = 0;
+	s_ucStatus = KEYMAP_OK;
+	memset(&s_tKeymapStat, 0, sizeof(s_tKeymapStat));
+	if(!Keymap_Load())
+	{
+		Keymap_Default();
+		s_tKeymapStat.invalid++;
+	}
+}
+/*============================================================
+	*	@func:		Keymap_Resume
+	*	@brief:		STOP唤醒后调用。RAM在STOP中保持，EEPROM中的头与载入时相同
+	*				时缓存仍然有效，不重新校验；否则重新载入。写入中或有未写入
+	*				的修改时保留RAM缓存
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void Keymap_Resume(void)
+{
+	const uint32_t *hdr = (const uint32_t *)KEYMAP_EEPROM_ADDR;
+
+	if(s_ucState != KEYMAP_STATE_IDLE)
+	{
+		return;
+	}
+	if(memcmp(hdr, s_uiHeaderSeen, sizeof(s_uiHeaderSeen)) == 0)
+	{
+		return;
+	}
+	if(!Keymap_Load())
+	{
+		Keymap_Default();
+		s_tKeymapStat.invalid++;
+	}
+	Layer_Refresh();
+}
+/*============================================================
+	*	@func:		Keymap_Key
+	*	@brief:		查RAM缓存中的键值
+	*	@param:		layer：层 row：行 col：列
+	*	@retval:	键值
+	*	@modify: 	data 			remarks
+=============================================================*/
+uint8_t Keymap_Key(uint8_t layer, uint8_t row, uint8_t col)
+{
+	return ((const uint8_t *)s_uiKeymap)[((uint16_t)layer * MATRIX_ROWS + row) * MATRIX_COLS + col];
+}
+/*============================================================
+	*	@func:		Keymap_Task
+	*	@brief:		键值表任务，订阅 EVT_KEYMAP。RAM缓存被修改后刷新层缓存；
+	*				写入时每次最多写一个有变化的字，写完再发布事件继续，
+	*				键值表写完后写头
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void Keymap_Task(void)
+{
+	KEYMAP_HEADER hdr;
+	uint8_t ret;
+
+	if(s_ucEdited)
+	{
+		s_ucEdited = 0;
+		Layer_Refresh();
+	}
+	switch(s_ucState)
+	{
+		case KEYMAP_STATE_START:
+			hdr.magic = KEYMAP_MAGIC;
+			hdr.version = KEYMAP_VERSION;
+			hdr.layers = KEYMAP_LAYERS;
+			hdr.rows = MATRIX_ROWS;
+			hdr.cols = MATRIX_COLS;
+			hdr.crc = Keymap_CRC16((const uint8_t *)s_uiKeymap, KEYMAP_SIZE);
+			memcpy(s_uiHeader, &hdr, sizeof(hdr));
+			s_usPos = 0;
+			s_ucState = KEYMAP_STATE_DATA;
+			/* fall through */
+		case KEYMAP_STATE_DATA:
+			ret = Keymap_Write_Next(KEYMAP_DATA_ADDR, s_uiKeymap, KEYMAP_WORDS);
+			if(ret == 1)
+			{
+				break;
+			}
+			if(ret == 0)
+			{
+				s_usPos = 0;
+				s_ucState = KEYMAP_STATE_HEADER;
+				Event_Post(EVT_KEYMAP);
+			}
+			break;
+		case KEYMAP_STATE_HEADER:
+			ret = Keymap_Write_Next(KEYMAP_EEPROM_ADDR, s_uiHeader, KEYMAP_HDR_WORDS);
+			if(ret == 0)
+			{
+				memcpy(s_uiHeaderSeen, s_uiHeader, sizeof(s_uiHeaderSeen));
+				s_usCrc = ((const KEYMAP_HEADER *)s_uiHeader)->crc;
+				s_tKeymapStat.commit++;
+				s_tKeymapStat.time_ms = bsp_GetRunTime() - s_iCommitTime;
+				s_ucState = KEYMAP_STATE_IDLE;
+			}
+			break;
+		default:
+			break;
+	}
+}
+/*============================================================
+	*	@func:		Keymap_Feature_Set
+	*	@brief:		处理特性报告命令，在USB中断中调用。WRITE只改RAM缓存，
+	*				写EEPROM交给 Keymap_Task；写入中拒绝修改，含没有动作的Fn键时
+	*				WRITE和COMMIT返回 KEYMAP_ERR
+	*	@param:		buf：报告，含报告ID len：长度
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void Keymap_Feature_Set(uint8_t *buf, uint8_t len)
+{
+	uint16_t off;
+	uint8_t n;
+
+	if((len < 6) || (buf[0] != KEYMAP_FEATURE_ID))
+	{
+		return;
+	}
+	s_ucCmd = buf[1];
+	off = buf[3] | ((uint16_t)buf[4] << 8);
+	n = buf[5];
+	s_ucStatus = KEYMAP_OK;
+	switch(s_ucCmd)
+	{
+		case KEYMAP_CMD_INFO:
+			break;
+		case KEYMAP_CMD_READ:
+			if((n > KEYMAP_FEATURE_DATA) || (off + n > KEYMAP_SIZE))
+			{
+				s_ucStatus = KEYMAP_ERR;
+				break;
+			}
+			s_usReadOff = off;
+			s_ucReadLen = n;
+			break;
+		case KEYMAP_CMD_WRITE:
+			if(s_ucState != KEYMAP_STATE_IDLE)
+			{
+				s_ucStatus = KEYMAP_BUSY;
+				break;
+			}
+			if((n > KEYMAP_FEATURE_DATA) || (6 + n > len) || (off + n > KEYMAP_SIZE)
+				|| !Keymap_Check(&buf[6], n))
+			{
+				s_ucStatus = KEYMAP_ERR;
+				break;
+			}
+			memcpy((uint8_t *)s_uiKeymap + off, &buf[6], n);
+			s_ucEdited = 1;
+			Event_Post(EVT_KEYMAP);
+			break;
+		case KEYMAP_CMD_DEFAULT:
+			if(s_ucState != KEYMAP_STATE_IDLE)
+			{
+				s_ucStatus = KEYMAP_BUSY;
+				break;
+			}
+			memcpy(s_uiKeymap, keymaps, KEYMAP_SIZE);
+			s_ucEdited = 1;
+			s_ucStatus = Keymap_Start();
+			break;
+		case KEYMAP_CMD_COMMIT:
+			if(!Keymap_Check((const uint8_t *)s_uiKeymap, KEYMAP_SIZE))
+			{
+				s_ucStatus = KEYMAP_ERR;
+				break;
+			}
+			s_ucStatus = Keymap_Start();
+			break;
+		default:
+			s_ucStatus = KEYMAP_ERR;
+			break;
+	}
+}
+/*============================================================
+	*	@func:		Keymap_Feature_Get
+	*	@brief:		生成特性报告，返回上一条命令的结果，在USB中断中调用
+	*	@param:		buf：输出缓冲区，KEYMAP_FEATURE_LEN 字节
+	*	@retval:	报告长度
+	*	@modify: 	data 			remarks
+=============================================================*/
+uint8_t Keymap_Feature_Get(uint8_t *buf)
+{
+	memset(buf, 0, KEYMAP_FEATURE_LEN);
+	buf[0] = KEYMAP_FEATURE_ID;
+	buf[1] = s_ucCmd;
+	buf[2] = s_ucStatus;
+	if(((s_ucCmd == KEYMAP_CMD_COMMIT) || (s_ucCmd == KEYMAP_CMD_DEFAULT))
+		&& (s_ucStatus == KEYMAP_OK) && (s_ucState != KEYMAP_STATE_IDLE))
+	{
+		buf[2] = KEYMAP_BUSY;
+	}
+	if(s_ucStatus != KEYMAP_OK)
+	{
+		return KEYMAP_FEATURE_LEN;
+	}
+	if(s_ucCmd == KEYMAP_CMD_READ)
+	{
+		buf[3] = (uint8_t)s_usReadOff;
+		buf[4] = (uint8_t)(s_usReadOff >> 8);
+		buf[5] = s_ucReadLen;
+		memcpy(&buf[6], (const uint8_t *)s_uiKeymap + s_usReadOff, s_ucReadLen);
+	}
+	else if(s_ucCmd == KEYMAP_CMD_INFO)
+	{
+		buf[5] = 6;
+		buf[6] = KEYMAP_VERSION;
+		buf[7] = KEYMAP_LAYERS;
+		buf[8] = MATRIX_ROWS;
+		buf[9] = MATRIX_COLS;
+		buf[10] = (uint8_t)s_usCrc;
+		buf[11] = (uint8_t)(s_usCrc >> 8);
+	}
+	return KEYMAP_FEATURE_LEN;
+}
+/*============================================================
+	*	@func:		Keymap_GetStat
+	*	@brief:		获取载入和写入统计
+	*	@param:		NA
+	*	@retval:	统计结构体
+	*	@modify: 	data 			remarks
+=============================================================*/
+KEYMAP_STAT *Keymap_GetStat(void)
+{
+	return &s_tKeymapStat;
+}
+/*============================================================
+	*	@func:		Keymap_Load
+	*	@brief:		校验EEPROM中的头、CRC和键值，有效时载入RAM缓存
+	*	@param:		NA
+	*	@retval:	1：载入成功 0：EEPROM无效
+	*	@modify: 	data 			remarks
+=============================================================*/
+static uint8_t Keymap_Load(void)
+{
+	const KEYMAP_HEADER *hdr = KEYMAP_HDR;
+
+	memcpy(s_uiHeaderSeen, (const void *)KEYMAP_EEPROM_ADDR, sizeof(s_uiHeaderSeen));
+	if((hdr->magic != KEYMAP_MAGIC) || (hdr->version != KEYMAP_VERSION) || (hdr->layers != KEYMAP_LAYERS)
+		|| (hdr->rows != MATRIX_ROWS) || (hdr->cols != MATRIX_COLS))
+	{
+		return 0;
+	}
+	if((Keymap_CRC16((const uint8_t *)KEYMAP_DATA_ADDR, KEYMAP_SIZE) != hdr->crc)
+		|| !Keymap_Check((const uint8_t *)KEYMAP_DATA_ADDR, KEYMAP_SIZE))
+	{
+		return 0;
+	}
+	memset(s_uiKeymap, 0, sizeof(s_uiKeymap));
+	memcpy(s_uiKeymap, (const void *)KEYMAP_DATA_ADDR, KEYMAP_SIZE);
+	s_usCrc = hdr->crc;
+	s_tKeymapStat.load++;
+	return 1;
+}
+/*============================================================
+	*	@func:		Keymap_Default
+	*	@brief:		RAM缓存载入固件中的默认键值表，不写EEPROM
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+static void Keymap_Default(void)
+{
+	memset(s_uiKeymap, 0, sizeof(s_uiKeymap));
+	memcpy(s_uiKeymap, keymaps, KEYMAP_SIZE);
+	s_usCrc = Keymap_CRC16((const uint8_t *)s_uiKeymap, KEYMAP_SIZE);
+}
+/*============================================================
+	*	@func:		Keymap_Start
+	*	@brief:		请求把RAM缓存写入EEPROM，在USB中断中调用
+	*	@param:		NA
+	*	@retval:	KEYMAP_OK / KEYMAP_BUSY
+	*	@modify: 	data 			remarks
+=============================================================*/
+static uint8_t Keymap_Start(void)
+{
+	if(s_ucState != KEYMAP_STATE_IDLE)
+	{
+		return KEYMAP_BUSY;
+	}
+	s_iCommitTime = bsp_GetRunTime();
+	s_ucState = KEYMAP_STATE_START;
+	Event_Post(EVT_KEYMAP);
+	return KEYMAP_OK;
+}
+/*============================================================
+	*	@func:		Keymap_Write_Next
+	*	@brief:		从 s_usPos 起跳过与EEPROM相同的字，写入下一个不同的字
+	*	@param:		addr：EEPROM起始地址 buf：数据 words：字数
+	*	@retval:	1：写了一个字，还需继续 0：全部写完 2：写入失败
+	*	@modify: 	data 			remarks
+=============================================================*/
+static uint8_t Keymap_Write_Next(uint32_t addr, const uint32_t *buf, uint16_t words)
+{
+	while((s_usPos < words) && (*(__IO uint32_t *)(addr + s_usPos * 4) == buf[s_usPos]))
+	{
+		s_usPos++;
+		s_tKeymapStat.skip++;
+	}
+	if(s_usPos >= words)
+	{
+		return 0;
+	}
+	if(!Keymap_EE_Word(addr + s_usPos * 4, buf[s_usPos]))
+	{
+		s_ucStatus = KEYMAP_FAIL;
+		s_ucState = KEYMAP_STATE_IDLE;
+		return 2;
+	}
+	s_usPos++;
+	Event_Post(EVT_KEYMAP);
+	return 1;
+}
+/*============================================================
+	*	@func:		Keymap_EE_Word
+	*	@brief:		写数据EEPROM一个字
+	*	@param:		addr：字对齐地址 data：数据
+	*	@retval:	1：成功 0：写入失败
+	*	@modify: 	data 			remarks
+=============================================================*/
+static uint8_t Keymap_EE_Word(uint32_t addr, uint32_t data)
+{
+	HAL_StatusTypeDef ret;
+
+	HAL_FLASHEx_DATAEEPROM_Unlock();
+	ret = HAL_FLASHEx_DATAEEPROM_Program(FLASH_TYPEPROGRAMDATA_WORD, addr, data);
+	HAL_FLASHEx_DATAEEPROM_Lock();
+	s_tKeymapStat.words++;
+	return (ret == HAL_OK);
+}
+/*============================================================
+	*	@func:		Keymap_CRC16
+	*	@brief:		CRC16-CCITT，多项式0x1021，初值0xFFFF
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+static uint16_t Keymap_CRC16(const uint8_t *buf, uint16_t len)
+{
+	uint16_t crc = 0xFFFF;
+
+	for (uint16_t i = 0; i < len; ++i)
+	{
+		crc ^= (uint16_t)buf[i] << 8;
+		for (uint8_t j = 0; j < 8; ++j)
+		{
+			crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+		}
+	}
+	return crc;
+}
+/*============================================================
+	*	@func:		Keymap_Check
+	*	@brief:		检查键值：KC_FN0 之后超出 fn_actions 的Fn键没有动作，不允许出现
+	*	@param:		buf：键值 len：长度
+	*	@retval:	1：有效 0：含无效键值
+	*	@modify: 	data 			remarks
+=============================================================*/
+static uint8_t Keymap_Check(const uint8_t *buf, uint16_t len)
+{
+	for (uint16_t i = 0; i < len; ++i)
+	{
+		if((buf[i] >= KC_FN0 + FN_ACTION_COUNT) && (buf[i] <= KC_FN31))
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
@@ -0,0 +1,70 @@
+#ifndef __USER_KEYMAP_H
+#define __USER_KEYMAP_H
+#include "bsp.h"
+
+/*
+	键值表保存在数据EEPROM中宏区之后：[头][键值表]，头中带版本、尺寸和键值表CRC16。
+	上电时校验后载入RAM缓存，层模块只读RAM缓存；EEPROM无效时使用固件中的默认
+	键值表 keymaps，不写EEPROM。
+	USB特性报告修改键值表，报告格式(SET和GET相同)：
+	[ID][命令][状态][偏移L][偏移H][长度][数据，最多 KEYMAP_FEATURE_DATA 字节]
+	偏移为键值表中的字节位置，按 层/行/列 排列。GET_REPORT 返回上一条命令的结果。
+	  INFO    ：数据为 [版本][层数][行数][列数][CRC L][CRC H]
+	  READ    ：设置读取位置和长度，GET 返回该段键值
+	  WRITE   ：写入RAM缓存，立即生效，不写EEPROM
+	  COMMIT  ：RAM缓存写入EEPROM，状态为 BUSY 直到写完
+	  DEFAULT ：恢复为默认键值表并写入EEPROM
+	键值中不能有超出 fn_actions 的Fn键(KC_FN0+FN_ACTION_COUNT~KC_FN31)，WRITE、COMMIT
+	返回 KEYMAP_ERR，EEPROM中出现时按无效处理。
+	写EEPROM按字(4字节)进行，内容相同的字跳过，头最后写。每写一字(约3.2ms，期间
+	CPU停顿)后回到主循环，扫描和报告不会被整段写入阻塞。
+*/
+#define KEYMAP_EEPROM_ADDR		(MACRO_EEPROM_ADDR + MACRO_EEPROM_SIZE)		//紧接宏区
+#define KEYMAP_MAGIC			0x4B4D					//"KM"
+#define KEYMAP_VERSION			1
+#define KEYMAP_SIZE				(KEYMAP_LAYERS * MATRIX_ROWS * MATRIX_COLS)
+#define KEYMAP_WORDS			((KEYMAP_SIZE + 3) / 4)
+
+#define KEYMAP_FEATURE_ID		HID_FEATURE_REPORT_ID
+#define KEYMAP_FEATURE_LEN		HID_FEATURE_REPORT_LEN
+#define KEYMAP_FEATURE_DATA		(KEYMAP_FEATURE_LEN - 6)
+
+#define KEYMAP_CMD_INFO			0x01
+#define KEYMAP_CMD_READ			0x02
+#define KEYMAP_CMD_WRITE		0x03
+#define KEYMAP_CMD_COMMIT		0x04
+#define KEYMAP_CMD_DEFAULT		0x05
+
+#define KEYMAP_OK				0x00
+#define KEYMAP_BUSY				0x01		//正在写EEPROM
+#define KEYMAP_ERR				0x02		//命令或范围错误
+#define KEYMAP_FAIL				0x03		//EEPROM写入失败
+
+typedef struct
+{
+	uint16_t magic;					//KEYMAP_MAGIC
+	uint8_t version;				//KEYMAP_VERSION
+	uint8_t layers;					//层数
+	uint8_t rows;					//行数
+	uint8_t cols;					//列数
+	uint16_t crc;					//键值表CRC16
+}KEYMAP_HEADER;
+
+typedef struct
+{
+	uint32_t load;					//从EEPROM载入次数
+	uint32_t invalid;				//EEPROM无效使用默认键值表的次数
+	uint32_t commit;				//写入次数
+	uint32_t words;					//实际写入的字数
+	uint32_t skip;					//内容相同跳过的字数
+	uint32_t time_ms;				//最近一次写入耗时
+}KEYMAP_STAT;
+
+void Keymap_Init(void);										//载入键值表
+void Keymap_Resume(void);									//STOP唤醒后检查键值表
+uint8_t Keymap_Key(uint8_t layer, uint8_t row, uint8_t col);	//查键值
+void Keymap_Task(void);										//写EEPROM任务
+void Keymap_Feature_Set(uint8_t *buf, uint8_t len);			//特性报告SET_REPORT，USB中断中调用
+uint8_t Keymap_Feature_Get(uint8_t *buf);					//特性报告GET_REPORT，USB中断中调用
+KEYMAP_STAT *Keymap_GetStat(void);							//获取统计
+#endif
@@ -0,0 +1,198 @@
+/************************************************************
+	*	@file:		user_layer.c
+	*	@brief:		多层键值表解析：瞬时层、切换层、单次层和透明键，
+	*				解析结果按层状态缓存，按下时的键值保存到释放
+	*	@author:	XIET
+	*	@version:	V1.0
+	*	@data:		201x-xx-xx
+	*	@modify:	data  			remarks
+**************************************************************/
+#include "bsp.h"
+
+static uint8_t s_ucLayerState = 0;			//打开的层，bit n 对应层n，层0始终有效
+static uint8_t s_ucOneShot = 0;				//等待下一个按键关闭的单次层
+static uint8_t s_ucCache[MATRIX_ROWS][MATRIX_COLS];		//当前层状态下的键值
+static uint8_t s_ucPressed[MATRIX_ROWS][MATRIX_COLS];		//按下时解析出的键值
+static LAYER_STAT s_tLayerStat;
+
+static void Layer_Set(uint8_t state);
+static void Layer_Rebuild(void);
+static void Layer_Action(uint8_t code, uint8_t pressed);
+/*============================================================
+	*	@func:		Layer_Init
+	*	@brief:		层状态和缓存初始化，只打开层0。在 Keymap_Init 之后调用
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void Layer_Init(void)
+{
+	s_ucLayerState = 0;
+	s_ucOneShot = 0;
+	memset(s_ucPressed, KC_NO, sizeof(s_ucPressed));
+	memset(&s_tLayerStat, 0, sizeof(s_tLayerStat));
+	Layer_Rebuild();
+}
+/*============================================================
+	*	@func:		Layer_Press
+	*	@brief:		按键按下：查缓存得到键值并记录，Fn键执行层动作。
+	*				普通按键按下后关闭单次层
+	*	@param:		row：行 col：列
+	*	@retval:	键值
+	*	@modify: 	data 			remarks
+=============================================================*/
+uint8_t Layer_Press(uint8_t row, uint8_t col)
+{
+	uint8_t code = s_ucCache[row][col];
+
+	s_ucPressed[row][col] = code;
+	s_tLayerStat.lookup++;
+	if(IS_FN(code))
+	{
+		Layer_Action(code, 1);
+	}
+	else if(s_ucOneShot && (code != KC_NO))
+	{
+		Layer_Set(s_ucLayerState & (uint8_t)~s_ucOneShot);
+		s_ucOneShot = 0;
+	}
+	return code;
+}
+/*============================================================
+	*	@func:		Layer_Release
+	*	@brief:		按键释放：返回按下时记录的键值，与当前层无关
+	*	@param:		row：行 col：列
+	*	@retval:	键值
+	*	@modify: 	data 			remarks
+=============================================================*/
+uint8_t Layer_Release(uint8_t row, uint8_t col)
+{
+	uint8_t code = s_ucPressed[row][col];
+
+	s_ucPressed[row][col] = KC_NO;
+	if(IS_FN(code))
+	{
+		Layer_Action(code, 0);
+	}
+	return code;
+}
+/*============================================================
+	*	@func:		Layer_GetState
+	*	@brief:		当前打开的层
+	*	@param:		NA
+	*	@retval:	层位图，不含层0
+	*	@modify: 	data 			remarks
+=============================================================*/
+uint8_t Layer_GetState(void)
+{
+	return s_ucLayerState;
+}
+/*============================================================
+	*	@func:		Layer_Refresh
+	*	@brief:		键值表被修改或重新载入，重建缓存。在主循环中调用
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void Layer_Refresh(void)
+{
+	Layer_Rebuild();
+}
+/*============================================================
+	*	@func:		Layer_GetStat
+	*	@brief:		获取缓存重建和查表统计
+	*	@param:		NA
+	*	@retval:	统计结构体
+	*	@modify: 	data 			remarks
+=============================================================*/
+LAYER_STAT *Layer_GetStat(void)
+{
+	return &s_tLayerStat;
+}
+/*============================================================
+	*	@func:		Layer_Set
+	*	@brief:		更新层状态，有变化时重建缓存
+	*	@param:		state：新的层位图
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+static void Layer_Set(uint8_t state)
+{
+	state &= (uint8_t)((1 << KEYMAP_LAYERS) - 1) & (uint8_t)~0x01;
+	if(state != s_ucLayerState)
+	{
+		s_ucLayerState = state;
+		Layer_Rebuild();
+	}
+}
+/*============================================================
+	*	@func:		Layer_Rebuild
+	*	@brief:		按当前层状态重建缓存：每个按键从最高的打开层向下查找，
+	*				跳过 KC_TRNS，层0的 KC_TRNS 视为 KC_NO
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+static void Layer_Rebuild(void)
+{
+	uint8_t state = s_ucLayerState | 0x01;
+	uint8_t code;
+	uint8_t key;
+	int8_t l;
+
+	for (uint8_t r = 0; r < MATRIX_ROWS; ++r)
+	{
+		for (uint8_t c = 0; c < MATRIX_COLS; ++c)
+		{
+			code = KC_NO;
+			for (l = KEYMAP_LAYERS - 1; l >= 0; --l)
+			{
+				if(state & (1 << l))
+				{
+					key = Keymap_Key(l, r, c);
+					if(key != KC_TRNS)
+					{
+						code = key;
+						break;
+					}
+				}
+			}
+			s_ucCache[r][c] = code;
+		}
+	}
+	s_tLayerStat.rebuild++;
+}
+/*============================================================
+	*	@func:		Layer_Action
+	*	@brief:		执行Fn键的层动作，命令类动作由 keyboard.c 处理
+	*	@param:		code：Fn键值 pressed：1按下 0释放
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+static void Layer_Action(uint8_t code, uint8_t pressed)
+{
+	uint8_t action = FN_ACTION(code);
+	uint8_t bit = (uint8_t)(1 << ACTION_ARG(action));
+
+	switch(ACTION_TYPE(action))
+	{
+		case ACTION_TYPE_MOMENTARY:
+			Layer_Set(pressed ? (s_ucLayerState | bit) : (s_ucLayerState & (uint8_t)~bit));
+			break;
+		case ACTION_TYPE_TOGGLE:
+			if(pressed)
+			{
+				Layer_Set(s_ucLayerState ^ bit);
+			}
+			break;
+		case ACTION_TYPE_ONESHOT:
+			if(pressed)
+			{
+				s_ucOneShot |= bit;
+				Layer_Set(s_ucLayerState | bit);
+			}
+			break;
+		default:
+			break;
+	}
+}
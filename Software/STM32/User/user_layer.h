@@ -0,0 +1,45 @@
+#ifndef __USER_LAYER_H
+#define __USER_LAYER_H
+#include "bsp.h"
+
+/*
+	按层叠方式解析键值：层0始终有效，其余层由Fn动作打开。按键从最高的有效层
+	向下查找，遇到 KC_TRNS 继续查下一层，键值取自 user_keymap 的RAM缓存。当前层状态下每个按键的解析结果缓存在
+	表中，层状态变化或键值表修改时立即重建，按下时只查一次表。
+	按下时记录解析出的键值，释放时使用该记录，按住期间切换层不会卡键。
+*/
+/* fn_actions 动作：高4位类型，低4位参数 */
+#define ACTION_TYPE_MOMENTARY		0x10		//按住时打开层
+#define ACTION_TYPE_TOGGLE			0x20		//按下切换层开关
+#define ACTION_TYPE_ONESHOT			0x30		//打开层，下一个按键按下后关闭
+#define ACTION_TYPE_COMMAND			0x40		//键盘命令，由 Keyboard_FN_Combind 处理
+#define ACTION_TYPE_MACRO			0x50		//回放宏
+
+#define ACTION_LAYER_MOMENTARY(l)	(ACTION_TYPE_MOMENTARY | (l))
+#define ACTION_LAYER_TOGGLE(l)		(ACTION_TYPE_TOGGLE | (l))
+#define ACTION_LAYER_ONESHOT(l)		(ACTION_TYPE_ONESHOT | (l))
+#define ACTION_COMMAND(id)			(ACTION_TYPE_COMMAND | (id))
+#define ACTION_MACRO(id)			(ACTION_TYPE_MACRO | (id))
+#define ACTION_TYPE(a)				((a) & 0xF0)
+#define ACTION_ARG(a)				((a) & 0x0F)
+
+#define IS_FN(code)					((uint8_t)((code) - KC_FN0) < FN_ACTION_COUNT)		//只有 fn_actions 中有动作的Fn键
+#define FN_ACTION(code)				(fn_actions[(code) - KC_FN0])
+
+#if KEYMAP_LAYERS > 8
+	#error "layer state is an 8 bit mask"
+#endif
+
+typedef struct
+{
+	uint32_t rebuild;		//缓存重建次数
+	uint32_t lookup;		//按下时查表次数
+}LAYER_STAT;
+
+void Layer_Init(void);								//层状态和缓存初始化
+uint8_t Layer_Press(uint8_t row, uint8_t col);		//按下：解析键值并执行层动作
+uint8_t Layer_Release(uint8_t row, uint8_t col);		//释放：返回按下时的键值
+uint8_t Layer_GetState(void);						//当前打开的层
+void Layer_Refresh(void);							//键值表被修改，重建缓存
+LAYER_STAT *Layer_GetStat(void);					//获取统计
+#endif
@@ -0,0 +1,341 @@
+/************************************************************
+	*	@file:		user_link.c
+	*	@brief:		STM32到DA14580的串口报告链路：带序号和CRC8的帧，
+	*				报告变化少时只发增量，BLE端失步后用快照重新同步
+	*	@author:	XIET
+	*	@version:	V1.0
+	*	@data:		201x-xx-xx
+	*	@modify:	data  			remarks
+**************************************************************/
+#include "bsp.h"
+
+enum
+{
+	LINK_WAIT_SOF = 0,
+	LINK_WAIT_LEN,
+	LINK_WAIT_SEQ,
+	LINK_WAIT_TYPE,
+	LINK_WAIT_PAYLOAD,
+	LINK_WAIT_CRC
+};
+
+static uint8_t s_ucLinkSeq = 0;						//发送序号
+static uint8_t s_ucLinkSynced = 0;					//0：下一帧必须发快照
+static uint8_t s_ucLinkDeltaCnt = 0;				//上次快照后的增量帧数
+static uint8_t s_ucLinkRefresh = 0;					//1：等待补发快照
+static uint8_t s_ucLinkLast[LINK_REPORT_LEN];		//BLE端当前应持有的报告
+static uint8_t s_ucLinkExt[LINK_EXT_NUM][LINK_EXT_MAX];		//BLE端当前应持有的EXT报告
+static uint8_t s_ucLinkExtLen[LINK_EXT_NUM];				//0：未发送过
+static const uint8_t s_ucExtId[LINK_EXT_NUM] = {HID_CONSUMER_REPORT_ID, HID_SYSTEM_REPORT_ID};	//EXT报告ID
+static uint8_t s_ucLinkFrame[LINK_FRAME_MAX];
+static LINK_PARSER s_tLinkRx;
+static LINK_STAT s_tLinkStat;
+
+static uint8_t Link_CRC8(uint8_t crc, uint8_t byte);
+static void Link_Send_Frame(uint8_t type, uint8_t *payload, uint8_t len);
+static void Link_Send_Snapshot(void);
+/*============================================================
+	*	@func:		Link_Init
+	*	@brief:		链路初始化，第一帧发快照
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void Link_Init(void)
+{
+	s_ucLinkSynced = 0;
+	s_ucLinkDeltaCnt = 0;
+	s_ucLinkRefresh = 0;
+	bsp_StopTimer(TMR_LINK);
+	memset(s_ucLinkLast, 0, LINK_REPORT_LEN);
+	memset(s_ucLinkExtLen, 0, sizeof(s_ucLinkExtLen));
+	memset(&s_tLinkRx, 0, sizeof(s_tLinkRx));
+}
+/*============================================================
+	*	@func:		Link_SendReport
+	*	@brief:		发送启动报告。增量比快照短时发增量，否则发快照
+	*	@param:		report：8字节启动报告
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void Link_SendReport(uint8_t *report)
+{
+	uint8_t delta[LINK_PAYLOAD_MAX];
+	uint8_t n = 0;
+
+	if(s_ucLinkSynced && (s_ucLinkDeltaCnt < LINK_SNAPSHOT_PERIOD))
+	{
+		for (uint8_t i = 0; i < LINK_REPORT_LEN; ++i)
+		{
+			if(report[i] == s_ucLinkLast[i])
+			{
+				continue;
+			}
+			if(n + 2 >= LINK_PAYLOAD_MAX)		//增量不比快照短
+			{
+				n = LINK_PAYLOAD_MAX;
+				break;
+			}
+			delta[n++] = i;
+			delta[n++] = report[i];
+		}
+		if(n == 0)		//报告未变化
+		{
+			return;
+		}
+	}
+	else
+	{
+		n = LINK_PAYLOAD_MAX;
+	}
+	memcpy(s_ucLinkLast, report, LINK_REPORT_LEN);
+	if(n < LINK_PAYLOAD_MAX)
+	{
+		Link_Send_Frame(LINK_TYPE_DELTA, delta, n);
+		s_ucLinkDeltaCnt++;
+		s_tLinkStat.delta++;
+	}
+	else
+	{
+		Link_Send_Frame(LINK_TYPE_SNAPSHOT, s_ucLinkLast, LINK_REPORT_LEN);
+		s_ucLinkSynced = 1;
+		s_ucLinkDeltaCnt = 0;
+		s_tLinkStat.snapshot++;
+	}
+	s_ucLinkRefresh = 1;
+}
+/*============================================================
+	*	@func:		Link_SendExt
+	*	@brief:		发送消费类/系统控制报告，报告很短，每次发完整报告。
+	*				占用帧序号，BLE端据此发现其间丢失的增量帧
+	*	@param:		report：[报告ID][数据] len：长度，含报告ID
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void Link_SendExt(uint8_t *report, uint8_t len)
+{
+	uint8_t n = (report[0] == HID_SYSTEM_REPORT_ID) ? 1 : 0;
+
+	if(len > LINK_EXT_MAX)
+	{
+		len = LINK_EXT_MAX;
+	}
+	if((s_ucLinkExtLen[n] == len) && (memcmp(s_ucLinkExt[n], report, len) == 0))		//报告未变化
+	{
+		return;
+	}
+	memcpy(s_ucLinkExt[n], report, len);
+	s_ucLinkExtLen[n] = len;
+	Link_Send_Frame(LINK_TYPE_EXT, s_ucLinkExt[n], len);
+	s_tLinkStat.ext++;
+	s_ucLinkRefresh = 1;
+}
+/*============================================================
+	*	@func:		Link_Task
+	*	@brief:		处理BLE端的重发请求；停止输入 LINK_REFRESH_TIME 后补发一次
+	*				快照和EXT报告，保证最后一帧丢失时BLE端也能恢复
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void Link_Task(void)
+{
+	uint8_t byte;
+	uint8_t send = 0;
+
+	while(comGetChar(COM_BLE, &byte))
+	{
+		if(Link_Parse_Byte(&s_tLinkRx, byte) && (s_tLinkRx.type == LINK_TYPE_RESYNC))
+		{
+			s_tLinkStat.resync++;
+			s_ucLinkSynced = 0;
+			send = 1;		//立即补发
+		}
+	}
+	if(bsp_CheckTimer(TMR_LINK) && s_ucLinkRefresh)
+	{
+		send = 1;
+	}
+	if(send)
+	{
+		Link_Send_Snapshot();
+	}
+}
+/*============================================================
+	*	@func:		Link_Build_Frame
+	*	@brief:		组帧：[SOF][LEN][SEQ][TYPE][PAYLOAD][CRC8]
+	*	@param:		frame：输出缓冲区，至少 LINK_FRAME_MAX 字节
+	*	@retval:	帧长度
+	*	@modify: 	data 			remarks
+=============================================================*/
+uint8_t Link_Build_Frame(uint8_t *frame, uint8_t seq, uint8_t type, uint8_t *payload, uint8_t len)
+{
+	uint8_t crc = 0;
+	uint8_t n = 0;
+
+	frame[n++] = LINK_SOF;
+	frame[n++] = len;
+	frame[n++] = seq;
+	frame[n++] = type;
+	memcpy(&frame[n], payload, len);
+	n += len;
+	for (uint8_t i = 1; i < n; ++i)
+	{
+		crc = Link_CRC8(crc, frame[i]);
+	}
+	frame[n++] = crc;
+	return n;
+}
+/*============================================================
+	*	@func:		Link_Parse_Byte
+	*	@brief:		逐字节解帧，CRC错误或长度非法时丢弃并重新寻找SOF
+	*	@param:		p：解析器 byte：收到的字节
+	*	@retval:	1：收到完整有效帧，结果在 p 中 0：未完成
+	*	@modify: 	data 			remarks
+=============================================================*/
+uint8_t Link_Parse_Byte(LINK_PARSER *p, uint8_t byte)
+{
+	switch(p->state)
+	{
+	case LINK_WAIT_SOF:
+		if(byte == LINK_SOF)
+		{
+			p->crc = 0;
+			p->state = LINK_WAIT_LEN;
+		}
+		break;
+	case LINK_WAIT_LEN:
+		if(byte > LINK_PAYLOAD_MAX)
+		{
+			p->state = (byte == LINK_SOF) ? LINK_WAIT_LEN : LINK_WAIT_SOF;
+			break;
+		}
+		p->len = byte;
+		p->idx = 0;
+		p->crc = Link_CRC8(p->crc, byte);
+		p->state = LINK_WAIT_SEQ;
+		break;
+	case LINK_WAIT_SEQ:
+		p->seq = byte;
+		p->crc = Link_CRC8(p->crc, byte);
+		p->state = LINK_WAIT_TYPE;
+		break;
+	case LINK_WAIT_TYPE:
+		p->type = byte;
+		p->crc = Link_CRC8(p->crc, byte);
+		p->state = p->len ? LINK_WAIT_PAYLOAD : LINK_WAIT_CRC;
+		break;
+	case LINK_WAIT_PAYLOAD:
+		p->payload[p->idx++] = byte;
+		p->crc = Link_CRC8(p->crc, byte);
+		if(p->idx >= p->len)
+		{
+			p->state = LINK_WAIT_CRC;
+		}
+		break;
+	default:
+		if(byte == p->crc)
+		{
+			p->state = LINK_WAIT_SOF;
+			return 1;
+		}
+		p->crc_err++;
+		p->crc = 0;
+		p->state = (byte == LINK_SOF) ? LINK_WAIT_LEN : LINK_WAIT_SOF;		//帧被截断时可能是下一帧的SOF
+		break;
+	}
+	return 0;
+}
+/*============================================================
+	*	@func:		Link_GetStat
+	*	@brief:		获取链路统计
+	*	@param:		NA
+	*	@retval:	统计结构体
+	*	@modify: 	data 			remarks
+=============================================================*/
+LINK_STAT *Link_GetStat(void)
+{
+	return &s_tLinkStat;
+}
+/*============================================================
+	*	@func:		Link_Send_Frame
+	*	@brief:		组帧并发送，序号加一。上一帧仍在零拷贝发送时改为拷贝到FIFO
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+static void Link_Send_Frame(uint8_t type, uint8_t *payload, uint8_t len)
+{
+	uint8_t frame[LINK_FRAME_MAX];
+	uint8_t n;
+
+	if(!comNoCopyBusy(COM_BLE))		//帧缓冲区空闲，DMA直接从帧缓冲区发送
+	{
+		n = Link_Build_Frame(s_ucLinkFrame, s_ucLinkSeq++, type, payload, len);
+		if(!comSendBufNoCopy(COM_BLE, s_ucLinkFrame, n))	//串口未使用DMA
+		{
+			comSendBuf(COM_BLE, s_ucLinkFrame, n);
+		}
+	}
+	else
+	{
+		n = Link_Build_Frame(frame, s_ucLinkSeq++, type, payload, len);
+		comSendBuf(COM_BLE, frame, n);
+	}
+	s_tLinkStat.bytes += n;
+	bsp_StartTimer(TMR_LINK, LINK_REFRESH_TIME);
+}
+/*============================================================
+	*	@func:		Link_Send_Snapshot
+	*	@brief:		重发快照和EXT报告，BLE端据此恢复全部状态。报告由键盘当前
+	*				状态重新生成：USB模式下不经链路发送报告，上次记录的快照
+	*				可能早已过时。EXT报告发送过或当前不为空时才发
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+static void Link_Send_Snapshot(void)
+{
+	uint8_t ext[LINK_EXT_MAX];
+	uint8_t len;
+	uint8_t active;
+
+	Keyboard_Get_Boot(s_ucLinkLast);
+	Link_Send_Frame(LINK_TYPE_SNAPSHOT, s_ucLinkLast, LINK_REPORT_LEN);
+	s_ucLinkSynced = 1;
+	s_ucLinkDeltaCnt = 0;
+	s_ucLinkRefresh = 0;
+	s_tLinkStat.snapshot++;
+	for (uint8_t n = 0; n < LINK_EXT_NUM; ++n)
+	{
+		len = Keyboard_Get_Usage(s_ucExtId[n], ext);
+		active = 0;
+		for (uint8_t i = 1; i < len; ++i)
+		{
+			active |= ext[i];
+		}
+		if(s_ucLinkExtLen[n] || active)
+		{
+			memcpy(s_ucLinkExt[n], ext, len);
+			s_ucLinkExtLen[n] = len;
+			Link_Send_Frame(LINK_TYPE_EXT, s_ucLinkExt[n], s_ucLinkExtLen[n]);
+			s_tLinkStat.ext++;
+		}
+	}
+}
+/*============================================================
+	*	@func:		Link_CRC8
+	*	@brief:		CRC8，多项式0x07
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+static uint8_t Link_CRC8(uint8_t crc, uint8_t byte)
+{
+	crc ^= byte;
+	for (uint8_t i = 0; i < 8; ++i)
+	{
+		crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+	}
+	return crc;
+}
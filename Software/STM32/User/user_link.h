@@ -0,0 +1,57 @@
+#ifndef __USER_LINK_H
+#define __USER_LINK_H
+#include "bsp.h"
+
+/*
+	STM32 -> DA14580 串口报告链路帧格式：
+	[SOF][LEN][SEQ][TYPE][PAYLOAD(LEN字节)][CRC8]
+	CRC8 多项式0x07，初值0，计算范围 LEN..PAYLOAD。
+	SNAPSHOT：8字节完整启动报告；DELTA：变化字节对[下标][新值]...，只有上一帧
+	之后序号连续时接收端才应用；RESYNC：BLE端请求重发快照，无负载；
+	EXT：完整的消费类/系统控制报告[报告ID][数据]，接收端直接覆盖，
+	BLE端按报告ID发到对应的HOGP报告。
+	BLE端发现CRC错误或序号不连续即发RESYNC，STM32下一帧立即发快照。
+*/
+#define LINK_SOF				0xA5
+#define LINK_TYPE_SNAPSHOT		0x01		//完整报告
+#define LINK_TYPE_DELTA			0x02		//报告增量
+#define LINK_TYPE_RESYNC		0x03		//请求重发快照
+#define LINK_TYPE_EXT			0x04		//消费类/系统控制报告
+
+#define LINK_REPORT_LEN			8			//启动报告长度
+#define LINK_PAYLOAD_MAX		LINK_REPORT_LEN
+#define LINK_FRAME_MAX			(LINK_PAYLOAD_MAX + 5)
+#define LINK_SNAPSHOT_PERIOD	16					//连续增量帧数上限，之后强制发快照
+#define LINK_REFRESH_TIME		TMR_PERIOD_50MS		//最后一帧后补发一次快照的时间(ms)
+#define LINK_EXT_NUM			2					//EXT报告种类：消费类、系统控制
+#define LINK_EXT_MAX			HID_CONSUMER_REPORT_LEN
+
+typedef struct
+{
+	uint8_t state;						//解析状态
+	uint8_t len;						//负载长度
+	uint8_t seq;						//帧序号
+	uint8_t type;						//帧类型
+	uint8_t idx;						//已收负载字节数
+	uint8_t crc;						//CRC8累计值
+	uint8_t payload[LINK_PAYLOAD_MAX];	//负载
+	uint32_t crc_err;					//CRC错误次数
+}LINK_PARSER;
+
+typedef struct
+{
+	uint32_t snapshot;				//快照帧数
+	uint32_t delta;					//增量帧数
+	uint32_t ext;					//EXT帧数
+	uint32_t resync;				//收到重发请求次数
+	uint32_t bytes;					//发送字节数
+}LINK_STAT;
+
+void Link_Init(void);										//链路初始化
+void Link_SendReport(uint8_t *report);						//发送启动报告
+void Link_SendExt(uint8_t *report, uint8_t len);			//发送消费类/系统控制报告
+void Link_Task(void);										//接收重发请求，补发快照
+uint8_t Link_Build_Frame(uint8_t *frame, uint8_t seq, uint8_t type, uint8_t *payload, uint8_t len);	//组帧
+uint8_t Link_Parse_Byte(LINK_PARSER *p, uint8_t byte);		//逐字节解帧
+LINK_STAT *Link_GetStat(void);								//获取统计
+#endif
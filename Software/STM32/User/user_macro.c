@@ -0,0 +1,530 @@
+/************************************************************
+	*	@file:		user_macro.c
+	*	@brief:		按键宏：宏字节码保存在数据EEPROM中，回放时每步最多一个报告，
+	*				USB按报告队列空闲、BLE按连接间隔步进，并统计各链路字符速率
+	*	@author:	XIET
+	*	@version:	V1.0
+	*	@data:		201x-xx-xx
+	*	@modify:	data  			remarks
+**************************************************************/
+#include "bsp.h"
+
+#define SH(kc)		((kc) | 0x80)		//需要Shift
+#define MACRO_HDR	((const MACRO_HEADER *)MACRO_EEPROM_ADDR)
+
+/* ASCII 0x20~0x7E 对应的键值，最高位表示需要Shift(美式布局) */
+static const uint8_t s_ucAsciiCode[MACRO_CHAR_MAX - MACRO_CHAR_MIN + 1] =
+{
+	KC_SPACE, SH(KC_1), SH(KC_QUOTE), SH(KC_3), SH(KC_4), SH(KC_5), SH(KC_7), KC_QUOTE,
+	SH(KC_9), SH(KC_0), SH(KC_8), SH(KC_EQUAL), KC_COMMA, KC_MINUS, KC_DOT, KC_SLASH,
+	KC_0, KC_1, KC_2, KC_3, KC_4, KC_5, KC_6, KC_7,
+	KC_8, KC_9, SH(KC_SCOLON), KC_SCOLON, SH(KC_COMMA), KC_EQUAL, SH(KC_DOT), SH(KC_SLASH),
+	SH(KC_2), SH(KC_A), SH(KC_B), SH(KC_C), SH(KC_D), SH(KC_E), SH(KC_F), SH(KC_G),
+	SH(KC_H), SH(KC_I), SH(KC_J), SH(KC_K), SH(KC_L), SH(KC_M), SH(KC_N), SH(KC_O),
+	SH(KC_P), SH(KC_Q), SH(KC_R), SH(KC_S), SH(KC_T), SH(KC_U), SH(KC_V), SH(KC_W),
+	SH(KC_X), SH(KC_Y), SH(KC_Z), KC_LBRACKET, KC_BSLASH, KC_RBRACKET, SH(KC_6), SH(KC_MINUS),
+	KC_GRAVE, KC_A, KC_B, KC_C, KC_D, KC_E, KC_F, KC_G,
+	KC_H, KC_I, KC_J, KC_K, KC_L, KC_M, KC_N, KC_O,
+	KC_P, KC_Q, KC_R, KC_S, KC_T, KC_U, KC_V, KC_W,
+	KC_X, KC_Y, KC_Z, SH(KC_LBRACKET), SH(KC_BSLASH), SH(KC_RBRACKET), SH(KC_GRAVE),
+};
+
+/* 宏区无效时写入的默认宏 */
+static const uint8_t s_ucMacroCopy[] = {MACRO_PRESS, KC_LCTRL, MACRO_TAP, KC_A, MACRO_TAP, KC_C, MACRO_RELEASE, KC_LCTRL};
+static const uint8_t s_ucMacroHello[] = {'H', 'e', 'l', 'l', 'o', ' ', 'W', 'o', 'r', 'l', 'd', '!', MACRO_TAP, KC_ENTER};
+
+static const uint8_t *s_pStep = NULL;		//下一步字节码
+static uint8_t s_ucPlaying = 0;				//1：回放中
+static uint8_t s_ucWait = 0;				//1：MACRO_DELAY 等待中
+static uint8_t s_ucLink = MACRO_LINK_USB;	//回放开始时的链路
+static uint8_t s_ucRelease = KC_NO;			//下一步要释放的键
+static uint8_t s_ucShift = 0;				//下一步要释放Shift
+static uint8_t s_ucMod = 0;					//回放中按下的功能键
+static uint8_t s_ucBits[HID_NKRO_KEY_MAX / 8];	//回放中按下的按键位图
+static uint32_t s_uiStartUs = 0;			//本段回放开始时间
+static MACRO_STAT s_tMacroStat;
+
+static void Macro_Step(void);
+static void Macro_Stop(void);
+static void Macro_Key(uint8_t code, uint8_t pressed);
+static void Macro_Report(void);
+static void Macro_Account(void);
+static uint16_t Macro_Length(const uint8_t *seq, uint16_t max);
+static uint8_t Macro_EE_Write(uint32_t addr, const uint8_t *buf, uint16_t len);
+static void Macro_Format(void);
+static uint16_t Macro_CRC(const MACRO_HEADER *hdr);
+static uint16_t Macro_CRC16(uint16_t crc, const uint8_t *buf, uint16_t len);
+/*============================================================
+	*	@func:		Macro_Init
+	*	@brief:		检查宏区头和CRC。没有宏区时写入默认宏；CRC不一致(写入中
+	*				掉电或数据损坏)时清空宏区，不回放损坏的字节码
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void Macro_Init(void)
+{
+	s_ucPlaying = 0;
+	s_ucWait = 0;
+	memset(&s_tMacroStat, 0, sizeof(s_tMacroStat));
+	if((MACRO_HDR->magic != MACRO_MAGIC) || (MACRO_HDR->used < sizeof(MACRO_HEADER))
+		|| (MACRO_HDR->used > MACRO_EEPROM_SIZE))
+	{
+		Macro_Format();
+		Macro_Save(0, s_ucMacroCopy, sizeof(s_ucMacroCopy));
+		Macro_Save(1, s_ucMacroHello, sizeof(s_ucMacroHello));
+		return;
+	}
+	if(Macro_CRC(MACRO_HDR) != MACRO_HDR->crc)
+	{
+		s_tMacroStat.crc_err++;
+		Macro_Format();
+	}
+}
+/*============================================================
+	*	@func:		Macro_Save
+	*	@brief:		保存一个宏。先删除旧宏并把后面的宏前移，再追加到末尾，
+	*				宏区始终紧凑。只写有变化的字节，最后写带新CRC的头
+	*	@param:		id：宏号 seq：字节码，不含 MACRO_END len：长度，0为删除
+	*	@retval:	1：成功 0：参数错误、格式错误或空间不足
+	*	@modify: 	data 			remarks
+=============================================================*/
+uint8_t Macro_Save(uint8_t id, const uint8_t *seq, uint16_t len)
+{
+	MACRO_HEADER hdr;
+	uint16_t old;
+	uint16_t old_len = 0;
+	uint8_t end = MACRO_END;
+
+	if((id >= MACRO_MAX) || s_ucPlaying || (len && (Macro_Length(seq, len) != len)))
+	{
+		return 0;
+	}
+	memcpy(&hdr, MACRO_HDR, sizeof(hdr));
+	old = hdr.offset[id];
+	if(old)
+	{
+		old_len = Macro_Length((const uint8_t *)(MACRO_EEPROM_ADDR + old), hdr.used - old) + 1;
+	}
+	if((hdr.used - old_len + (len ? len + 1 : 0)) > MACRO_EEPROM_SIZE)
+	{
+		return 0;
+	}
+	if(old)
+	{
+		Macro_EE_Write(MACRO_EEPROM_ADDR + old, (const uint8_t *)(MACRO_EEPROM_ADDR + old + old_len),
+						hdr.used - old - old_len);
+		for (uint8_t i = 0; i < MACRO_MAX; ++i)
+		{
+			if(hdr.offset[i] > old)
+			{
+				hdr.offset[i] -= old_len;
+			}
+		}
+		hdr.offset[id] = 0;
+		hdr.used -= old_len;
+	}
+	if(len)
+	{
+		Macro_EE_Write(MACRO_EEPROM_ADDR + hdr.used, seq, len);
+		Macro_EE_Write(MACRO_EEPROM_ADDR + hdr.used + len, &end, 1);
+		hdr.offset[id] = hdr.used;
+		hdr.used += len + 1;
+	}
+	hdr.crc = Macro_CRC(&hdr);
+	return Macro_EE_Write(MACRO_EEPROM_ADDR, (const uint8_t *)&hdr, sizeof(hdr));
+}
+/*============================================================
+	*	@func:		Macro_Play
+	*	@brief:		开始回放，回放中再次触发忽略
+	*	@param:		id：宏号
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void Macro_Play(uint8_t id)
+{
+	if(s_ucPlaying)
+	{
+		s_tMacroStat.busy++;
+		return;
+	}
+	if((id >= MACRO_MAX) || (MACRO_HDR->magic != MACRO_MAGIC) || (MACRO_HDR->offset[id] == 0))
+	{
+		return;
+	}
+	s_pStep = (const uint8_t *)(MACRO_EEPROM_ADDR + MACRO_HDR->offset[id]);
+	s_ucLink = Keyboard_Is_USB() ? MACRO_LINK_USB : MACRO_LINK_BLE;
+	s_ucPlaying = 1;
+	s_ucWait = 0;
+	s_ucRelease = KC_NO;
+	s_ucShift = 0;
+	s_tMacroStat.runs++;
+	s_uiStartUs = bsp_GetRunTimeUs();
+	if(s_ucLink == MACRO_LINK_BLE)
+	{
+		bsp_StartAutoTimer(TMR_MACRO, MACRO_BLE_INTERVAL);
+	}
+	Event_Post(EVT_MACRO);
+}
+/*============================================================
+	*	@func:		Macro_Task
+	*	@brief:		回放任务，订阅 EVT_MACRO 和 EVT_USB_TX。USB下报告队列空闲时
+	*				走一步，BLE下每个 TMR_MACRO 节拍走一步
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void Macro_Task(void)
+{
+	uint8_t tick;
+
+	if(!s_ucPlaying)
+	{
+		return;
+	}
+	tick = bsp_CheckTimer(TMR_MACRO);
+	if(s_ucWait)
+	{
+		if(!tick)
+		{
+			return;
+		}
+		s_ucWait = 0;
+		s_uiStartUs = bsp_GetRunTimeUs();
+		if(s_ucLink == MACRO_LINK_BLE)
+		{
+			bsp_StartAutoTimer(TMR_MACRO, MACRO_BLE_INTERVAL);
+		}
+	}
+	else if(s_ucLink == MACRO_LINK_BLE)
+	{
+		if(!tick)
+		{
+			return;
+		}
+	}
+	if((s_ucLink == MACRO_LINK_USB) && !Report_Queue_Idle())
+	{
+		return;
+	}
+	Macro_Step();
+}
+/*============================================================
+	*	@func:		Macro_Merge
+	*	@brief:		生成报告时把回放中按下的键叠加到实时按键状态上
+	*	@param:		mod：功能键 bits：按键位图
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void Macro_Merge(uint8_t *mod, uint8_t *bits)
+{
+	if(!s_ucPlaying)
+	{
+		return;
+	}
+	*mod |= s_ucMod;
+	for (uint8_t i = 0; i < sizeof(s_ucBits); ++i)
+	{
+		bits[i] |= s_ucBits[i];
+	}
+}
+/*============================================================
+	*	@func:		Macro_IsPlaying
+	*	@brief:		是否在回放
+	*	@param:		NA
+	*	@retval:	1：回放中 0：空闲
+	*	@modify: 	data 			remarks
+=============================================================*/
+uint8_t Macro_IsPlaying(void)
+{
+	return s_ucPlaying;
+}
+/*============================================================
+	*	@func:		Macro_Get_CPS
+	*	@brief:		链路的回放速率
+	*	@param:		link：MACRO_LINK_USB / MACRO_LINK_BLE
+	*	@retval:	字符/秒
+	*	@modify: 	data 			remarks
+=============================================================*/
+uint32_t Macro_Get_CPS(uint8_t link)
+{
+	if(s_tMacroStat.time_us[link] == 0)
+	{
+		return 0;
+	}
+	return (uint32_t)((uint64_t)s_tMacroStat.chars[link] * 1000000U / s_tMacroStat.time_us[link]);
+}
+/*============================================================
+	*	@func:		Macro_GetStat
+	*	@brief:		获取回放统计
+	*	@param:		NA
+	*	@retval:	统计结构体
+	*	@modify: 	data 			remarks
+=============================================================*/
+MACRO_STAT *Macro_GetStat(void)
+{
+	return &s_tMacroStat;
+}
+/*============================================================
+	*	@func:		Macro_Step
+	*	@brief:		执行一步：先释放上一步TAP或字符按下的键，否则取下一条字节码。
+	*				每步最多产生一个报告
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+static void Macro_Step(void)
+{
+	uint8_t op;
+	uint8_t code;
+
+	if(s_ucRelease != KC_NO)
+	{
+		Macro_Key(s_ucRelease, 0);
+		if(s_ucShift)
+		{
+			Macro_Key(KC_LSHIFT, 0);
+			s_ucShift = 0;
+		}
+		s_ucRelease = KC_NO;
+		Macro_Report();
+		return;
+	}
+	op = *s_pStep++;
+	if((op >= MACRO_CHAR_MIN) && (op <= MACRO_CHAR_MAX))
+	{
+		code = s_ucAsciiCode[op - MACRO_CHAR_MIN];
+		if((code & 0x80) && !(s_ucMod & (1 << (KC_LSHIFT & 0x07))))
+		{
+			Macro_Key(KC_LSHIFT, 1);
+			s_ucShift = 1;
+		}
+		s_ucRelease = code & 0x7F;
+		Macro_Key(s_ucRelease, 1);
+		s_tMacroStat.chars[s_ucLink]++;
+		Macro_Report();
+		return;
+	}
+	switch(op)
+	{
+		case MACRO_PRESS:
+			Macro_Key(*s_pStep++, 1);
+			Macro_Report();
+			break;
+		case MACRO_RELEASE:
+			Macro_Key(*s_pStep++, 0);
+			Macro_Report();
+			break;
+		case MACRO_TAP:
+			s_ucRelease = *s_pStep++;
+			Macro_Key(s_ucRelease, 1);
+			Macro_Report();
+			break;
+		case MACRO_DELAY:
+			code = *s_pStep++;
+			Macro_Account();
+			s_ucWait = 1;
+			bsp_StartTimer(TMR_MACRO, (code ? code : 1) * MACRO_DELAY_UNIT);
+			break;
+		default:						//MACRO_END
+			Macro_Stop();
+			break;
+	}
+}
+/*============================================================
+	*	@func:		Macro_Stop
+	*	@brief:		结束回放，仍按下的键全部释放
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+static void Macro_Stop(void)
+{
+	uint8_t held = s_ucMod;
+
+	for (uint8_t i = 0; i < sizeof(s_ucBits); ++i)
+	{
+		held |= s_ucBits[i];
+	}
+	s_ucMod = 0;
+	memset(s_ucBits, 0, sizeof(s_ucBits));
+	Macro_Account();
+	bsp_StopTimer(TMR_MACRO);
+	s_ucPlaying = 0;
+	if(held)
+	{
+		Keyboard_SendReport();
+	}
+}
+/*============================================================
+	*	@func:		Macro_Key
+	*	@brief:		改变回放中的按键状态
+	*	@param:		code：键值 pressed：1按下 0释放
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+static void Macro_Key(uint8_t code, uint8_t pressed)
+{
+	if((code & 0xF8) == 0xE0)		//功能键
+	{
+		if(pressed)
+		{
+			s_ucMod |= 1 << (code & 0x07);
+		}
+		else
+		{
+			s_ucMod &= (uint8_t)~(1 << (code & 0x07));
+		}
+	}
+	else if((code != KC_NO) && (code < HID_NKRO_KEY_MAX))
+	{
+		if(pressed)
+		{
+			s_ucBits[code >> 3] |= (uint8_t)(1 << (code & 0x07));
+		}
+		else
+		{
+			s_ucBits[code >> 3] &= (uint8_t)~(1 << (code & 0x07));
+		}
+	}
+}
+/*============================================================
+	*	@func:		Macro_Report
+	*	@brief:		发送叠加了回放状态的报告。USB报告被立即丢弃说明USB未配置，中止回放
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+static void Macro_Report(void)
+{
+	s_tMacroStat.reports[s_ucLink]++;
+	Keyboard_SendReport();
+	if((s_ucLink == MACRO_LINK_USB) && Report_Queue_Idle())
+	{
+		s_tMacroStat.abort++;
+		Macro_Stop();
+	}
+}
+/*============================================================
+	*	@func:		Macro_Account
+	*	@brief:		本段回放时间计入链路统计
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+static void Macro_Account(void)
+{
+	if(!s_ucWait)
+	{
+		s_tMacroStat.time_us[s_ucLink] += bsp_GetRunTimeUs() - s_uiStartUs;
+	}
+}
+/*============================================================
+	*	@func:		Macro_Length
+	*	@brief:		逐条解析字节码，得到 MACRO_END 之前的长度
+	*	@param:		seq：字节码 max：最大长度
+	*	@retval:	长度。遇到未知操作码或操作数越界时停在该条之前
+	*	@modify: 	data 			remarks
+=============================================================*/
+static uint16_t Macro_Length(const uint8_t *seq, uint16_t max)
+{
+	uint16_t n = 0;
+	uint8_t op;
+
+	while(n < max)
+	{
+		op = seq[n];
+		if((op >= MACRO_CHAR_MIN) && (op <= MACRO_CHAR_MAX))
+		{
+			n++;
+		}
+		else if((op >= MACRO_PRESS) && (op <= MACRO_DELAY) && (n + 1 < max))
+		{
+			n += 2;
+		}
+		else
+		{
+			break;
+		}
+	}
+	return n;
+}
+/*============================================================
+	*	@func:		Macro_EE_Write
+	*	@brief:		按字节写数据EEPROM，内容相同的字节跳过。源可以是EEPROM中
+	*				更高的地址(前移)
+	*	@param:		addr：目标地址 buf：数据 len：长度
+	*	@retval:	1：成功 0：写入失败
+	*	@modify: 	data 			remarks
+=============================================================*/
+static uint8_t Macro_EE_Write(uint32_t addr, const uint8_t *buf, uint16_t len)
+{
+	uint8_t ret = 1;
+
+	HAL_FLASHEx_DATAEEPROM_Unlock();
+	for (uint16_t i = 0; i < len; ++i)
+	{
+		if(*(__IO uint8_t *)(addr + i) == buf[i])
+		{
+			continue;
+		}
+		if(HAL_FLASHEx_DATAEEPROM_Program(FLASH_TYPEPROGRAMDATA_BYTE, addr + i, buf[i]) != HAL_OK)
+		{
+			ret = 0;
+			break;
+		}
+	}
+	HAL_FLASHEx_DATAEEPROM_Lock();
+	return ret;
+}
+/*============================================================
+	*	@func:		Macro_Format
+	*	@brief:		宏区写入空的头，没有宏
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+static void Macro_Format(void)
+{
+	MACRO_HEADER hdr;
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.magic = MACRO_MAGIC;
+	hdr.used = sizeof(MACRO_HEADER);
+	hdr.crc = Macro_CRC(&hdr);
+	Macro_EE_Write(MACRO_EEPROM_ADDR, (const uint8_t *)&hdr, sizeof(hdr));
+}
+/*============================================================
+	*	@func:		Macro_CRC
+	*	@brief:		宏区CRC：头中crc(最后一项)之前的部分，加上EEPROM中头之后 used 以内的字节码
+	*	@param:		hdr：头，used 已在有效范围内
+	*	@retval:	CRC16
+	*	@modify: 	data 			remarks
+=============================================================*/
+static uint16_t Macro_CRC(const MACRO_HEADER *hdr)
+{
+	uint16_t crc;
+
+	crc = Macro_CRC16(0xFFFF, (const uint8_t *)hdr, sizeof(MACRO_HEADER) - sizeof(hdr->crc));
+	return Macro_CRC16(crc, (const uint8_t *)(MACRO_EEPROM_ADDR + sizeof(MACRO_HEADER)),
+						hdr->used - sizeof(MACRO_HEADER));
+}
+/*============================================================
+	*	@func:		Macro_CRC16
+	*	@brief:		CRC16-CCITT，多项式0x1021，与键值表相同，可分段累计
+	*	@param:		crc：初值，首段为0xFFFF buf：数据 len：长度
+	*	@retval:	CRC16
+	*	@modify: 	data 			remarks
+=============================================================*/
+static uint16_t Macro_CRC16(uint16_t crc, const uint8_t *buf, uint16_t len)
+{
+	for (uint16_t i = 0; i < len; ++i)
+	{
+		crc ^= (uint16_t)buf[i] << 8;
+		for (uint8_t j = 0; j < 8; ++j)
+		{
+			crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+		}
+	}
+	return crc;
+}
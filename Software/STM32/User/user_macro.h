@@ -0,0 +1,58 @@
+#ifndef __USER_MACRO_H
+#define __USER_MACRO_H
+#include "bsp.h"
+
+/*
+	宏保存在数据EEPROM中：[头][宏字节码...]，头中记录各宏的偏移和CRC16，CRC覆盖
+	头(不含crc)和全部宏字节码，头最后写。上电时校验，不一致时宏区清空。
+	字节码：0x20~0x7E 直接输入该ASCII字符，其余为操作码，宏以 MACRO_END 结束。
+	回放每步最多产生一个报告：USB下等报告队列空闲(上一个报告已被主机取走)再走
+	下一步，即每个轮询间隔一个报告；BLE下每个连接间隔一步。回放状态叠加在实时
+	按键之上一起组成报告，回放时仍可正常打字。
+*/
+#define MACRO_END			0x00		//结束
+#define MACRO_PRESS			0x01		//按下 [键值]
+#define MACRO_RELEASE		0x02		//释放 [键值]
+#define MACRO_TAP			0x03		//按下并在下一步释放 [键值]
+#define MACRO_DELAY			0x04		//延时 [n×10ms]
+#define MACRO_CHAR_MIN		0x20
+#define MACRO_CHAR_MAX		0x7E
+
+#define MACRO_MAX			8						//宏个数
+#define MACRO_EEPROM_ADDR	DATA_EEPROM_BASE		//宏区起始地址
+#define MACRO_EEPROM_SIZE	1024					//宏区大小，其余数据EEPROM留作他用
+#define MACRO_MAGIC			0x4D43					//"MC"
+#define MACRO_BLE_INTERVAL	10						//BLE回放步进间隔(ms)，不小于连接间隔
+#define MACRO_DELAY_UNIT	10						//MACRO_DELAY 单位(ms)
+
+#define MACRO_LINK_BLE		0
+#define MACRO_LINK_USB		1
+
+typedef struct
+{
+	uint16_t magic;					//MACRO_MAGIC
+	uint16_t used;					//已用字节数，含头
+	uint16_t offset[MACRO_MAX];		//各宏相对宏区起点的偏移，0为空
+	uint16_t crc;					//头(不含crc)和宏字节码的CRC16
+}MACRO_HEADER;
+
+typedef struct
+{
+	uint32_t runs;					//回放次数
+	uint32_t busy;					//回放中再次触发被忽略的次数
+	uint32_t abort;					//USB未配置中止的次数
+	uint32_t chars[2];				//各链路输入的字符数，按 MACRO_LINK_xx 索引
+	uint32_t reports[2];			//各链路产生的报告数
+	uint32_t time_us[2];			//各链路回放累计时间，不含 MACRO_DELAY
+	uint32_t crc_err;				//上电时CRC不一致清空宏区的次数
+}MACRO_STAT;
+
+void Macro_Init(void);											//检查宏区，无效时写入默认宏
+uint8_t Macro_Save(uint8_t id, const uint8_t *seq, uint16_t len);	//保存一个宏
+void Macro_Play(uint8_t id);									//开始回放
+void Macro_Task(void);											//回放任务
+void Macro_Merge(uint8_t *mod, uint8_t *bits);					//叠加回放中的按键状态
+uint8_t Macro_IsPlaying(void);									//是否在回放
+uint32_t Macro_Get_CPS(uint8_t link);							//各链路字符/秒
+MACRO_STAT *Macro_GetStat(void);								//获取统计
+#endif
@@ -0,0 +1,333 @@
+/************************************************************
+	*	@file:		user_report.c
+	*	@brief:		USB报告队列，端点忙时缓存报告快照，由DataIn回调依次发出
+	*	@author:	XIET
+	*	@version:	V1.0
+	*	@data:		201x-xx-xx
+	*	@modify:	data  			remarks
+**************************************************************/
+#include "bsp.h"
+extern USBD_HandleTypeDef USBD_Device;
+
+static REPORT_QUEUE s_tReport;
+
+static void Report_Queue_Transmit(void);
+static uint8_t Report_Queue_Holding(void);
+static uint8_t Report_Has_Key(uint8_t *buf, uint8_t key);
+static uint8_t Report_Can_Merge_Boot(uint8_t *prev, uint8_t *tail, uint8_t *now);
+static uint8_t Report_Can_Merge_Bitmap(uint8_t *prev, uint8_t *tail, uint8_t *now, uint8_t len);
+static uint8_t Report_Can_Merge(REPORT_ITEM *tail, uint8_t *prev, uint8_t prev_len, uint8_t *now, uint8_t len);
+/*============================================================
+	*	@func:		Report_Queue_Init
+	*	@brief:		报告队列初始化，USB重新配置时调用。STOP唤醒后保留期间
+	*				配置完成时保留队列中的报告，通知键盘任务发出
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void Report_Queue_Init(void)
+{
+	DISABLE_INT();
+	if(Report_Queue_Holding())
+	{
+		s_tReport.hold = 0;
+		Event_Post(EVT_USB_TX);
+	}
+	else
+	{
+		s_tReport.read = 0;
+		s_tReport.write = 0;
+		s_tReport.count = 0;
+	}
+	s_tReport.busy = 0;
+	memset(s_tReport.last, 0, REPORT_MAX_LEN);
+	s_tReport.last_len = 0;
+	ENABLE_INT();
+}
+/*============================================================
+	*	@func:		Report_Queue_Hold
+	*	@brief:		STOP唤醒、重新使能USB时调用。清空队列，此后 REPORT_HOLD_TIME
+	*				内USB未配置时不丢弃报告，唤醒键的报告在枚举完成后第一个发出
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void Report_Queue_Hold(void)
+{
+	DISABLE_INT();
+	s_tReport.read = 0;
+	s_tReport.write = 0;
+	s_tReport.count = 0;
+	s_tReport.busy = 0;
+	s_tReport.hold = 1;
+	s_tReport.hold_time = bsp_GetRunTime();
+	ENABLE_INT();
+}
+/*============================================================
+	*	@func:		Report_Queue_Push
+	*	@brief:		报告快照入队。若与队尾合并不会丢失按键变化，则直接改写队尾；
+	*				队列满且不能合并时不入队、不改写队尾并计入溢出，由调用者
+	*				保留待发送状态，在下一次EVT_USB_TX时重发当前快照
+	*	@param:		buf：报告 len：长度
+	*	@retval:	REPORT_PUSH_QUEUED：新入队 REPORT_PUSH_MERGED：已合并
+	*				REPORT_PUSH_FULL：队列满未入队
+	*	@modify: 	data 			remarks
+=============================================================*/
+uint8_t Report_Queue_Push(uint8_t *buf, uint8_t len)
+{
+	uint8_t tail;
+	uint8_t *prev;
+	uint8_t prev_len;
+	uint8_t ret = REPORT_PUSH_QUEUED;
+
+	if(len > REPORT_MAX_LEN)
+	{
+		len = REPORT_MAX_LEN;
+	}
+	DISABLE_INT();
+	tail = (s_tReport.write + REPORT_QUEUE_SIZE - 1) % REPORT_QUEUE_SIZE;
+	/* 队尾正在端点上发送时不能改写 */
+	if((s_tReport.count > 1) || ((s_tReport.count == 1) && (!s_tReport.busy)))
+	{
+		if(s_tReport.count > 1)
+		{
+			prev = s_tReport.item[(tail + REPORT_QUEUE_SIZE - 1) % REPORT_QUEUE_SIZE].buf;
+			prev_len = s_tReport.item[(tail + REPORT_QUEUE_SIZE - 1) % REPORT_QUEUE_SIZE].len;
+		}
+		else
+		{
+			prev = s_tReport.last;
+			prev_len = s_tReport.last_len;
+		}
+		if(Report_Can_Merge(&s_tReport.item[tail], prev, prev_len, buf, len))		//同ID同长度且不丢失变化
+		{
+			s_tReport.merged++;
+			ret = REPORT_PUSH_MERGED;
+		}
+	}
+	if((ret == REPORT_PUSH_QUEUED) && (s_tReport.count >= REPORT_QUEUE_SIZE))
+	{
+		s_tReport.overflow++;
+		ENABLE_INT();
+		return REPORT_PUSH_FULL;
+	}
+	if(ret == REPORT_PUSH_QUEUED)
+	{
+		tail = s_tReport.write;
+		s_tReport.write = (s_tReport.write + 1) % REPORT_QUEUE_SIZE;
+		s_tReport.count++;
+	}
+	s_tReport.item[tail].len = len;
+	memcpy(s_tReport.item[tail].buf, buf, len);
+	ENABLE_INT();
+	return ret;
+}
+/*============================================================
+	*	@func:		Report_Queue_Kick
+	*	@brief:		端点空闲且队列非空时发送队首报告
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void Report_Queue_Kick(void)
+{
+	DISABLE_INT();
+	if((!s_tReport.busy) && s_tReport.count)
+	{
+		Report_Queue_Transmit();
+	}
+	ENABLE_INT();
+}
+/*============================================================
+	*	@func:		Report_Queue_TxCplt
+	*	@brief:		端点发送完成，在USB中断DataIn中调用，释放队首并发送下一个
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+void Report_Queue_TxCplt(void)
+{
+	if(s_tReport.busy)
+	{
+		s_tReport.busy = 0;
+		s_tReport.read = (s_tReport.read + 1) % REPORT_QUEUE_SIZE;
+		s_tReport.count--;
+	}
+	if(s_tReport.count)
+	{
+		Report_Queue_Transmit();
+	}
+	Event_Post(EVT_USB_TX);
+}
+/*============================================================
+	*	@func:		Report_Queue_Idle
+	*	@brief:		队列为空且端点空闲，之前的报告都已被主机取走
+	*	@param:		NA
+	*	@retval:	1：空闲 0：有报告未发完
+	*	@modify: 	data 			remarks
+=============================================================*/
+uint8_t Report_Queue_Idle(void)
+{
+	return (s_tReport.count == 0) && (!s_tReport.busy);
+}
+/*============================================================
+	*	@func:		Report_Queue_GetOverflow
+	*	@brief:		获取队列满次数
+	*	@param:		NA
+	*	@retval:	溢出计数
+	*	@modify: 	data 			remarks
+=============================================================*/
+uint32_t Report_Queue_GetOverflow(void)
+{
+	return s_tReport.overflow;
+}
+/*============================================================
+	*	@func:		Report_Queue_Transmit
+	*	@brief:		将队首报告交给端点，调用前需关中断或处于USB中断中
+	*	@param:		NA
+	*	@retval:	NA
+	*	@modify: 	data 			remarks
+=============================================================*/
+static void Report_Queue_Transmit(void)
+{
+	REPORT_ITEM *p_item = &s_tReport.item[s_tReport.read];
+	uint8_t ret;
+
+	ret = USBD_HID_SendReport(&USBD_Device, p_item->buf, p_item->len);
+	if(ret == USBD_OK)
+	{
+		s_tReport.busy = 1;
+		memcpy(s_tReport.last, p_item->buf, p_item->len);
+		s_tReport.last_len = p_item->len;
+		Pwr_Wake_Report(PWR_WAKE_SEND);
+	}
+	else if((ret == USBD_FAIL) && (!Report_Queue_Holding()))		//USB未配置，丢弃队列
+	{
+		s_tReport.hold = 0;
+		s_tReport.read = s_tReport.write;
+		s_tReport.count = 0;
+	}
+}
+/*============================================================
+	*	@func:		Report_Queue_Holding
+	*	@brief:		是否在STOP唤醒后的保留期内，调用前需关中断或处于USB中断中
+	*	@param:		NA
+	*	@retval:	1：保留 0：不保留
+	*	@modify: 	data 			remarks
+=============================================================*/
+static uint8_t Report_Queue_Holding(void)
+{
+	return s_tReport.hold && ((bsp_GetRunTime() - s_tReport.hold_time) < REPORT_HOLD_TIME);
+}
+/*============================================================
+	*	@func:		Report_Has_Key
+	*	@brief:		报告的6个按键槽中是否包含指定键值
+	*	@param:		NA
+	*	@retval:	1：包含 0：不包含
+	*	@modify: 	data 			remarks
+=============================================================*/
+static uint8_t Report_Has_Key(uint8_t *buf, uint8_t key)
+{
+	for (uint8_t i = 2; i < 8; ++i)
+	{
+		if(buf[i] == key)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+/*============================================================
+	*	@func:		Report_Can_Merge
+	*	@brief:		prev->tail->now 合并为 prev->now 时是否会隐藏按键变化
+	*				条件：三个报告格式相同；功能键不变；同一按键不能在两步中都变化；
+	*				两步不能都有按下，以保证按下顺序不变
+	*	@param:		NA
+	*	@retval:	1：可以合并 0：不可合并
+	*	@modify: 	data 			remarks
+=============================================================*/
+static uint8_t Report_Can_Merge(REPORT_ITEM *tail, uint8_t *prev, uint8_t prev_len, uint8_t *now, uint8_t len)
+{
+	if((tail->len != len) || (prev_len != len))
+	{
+		return 0;
+	}
+	if(len == HID_BOOT_REPORT_LEN)
+	{
+		return Report_Can_Merge_Boot(prev, tail->buf, now);
+	}
+	if((prev[0] != now[0]) || (tail->buf[0] != now[0]))		//报告ID不同
+	{
+		return 0;
+	}
+	return Report_Can_Merge_Bitmap(prev, tail->buf, now, len);
+}
+/*============================================================
+	*	@func:		Report_Can_Merge_Bitmap
+	*	@brief:		NKRO位图报告合并判断：[ID][功能键][位图]，按位并行比较
+	*	@param:		NA
+	*	@retval:	1：可以合并 0：不可合并
+	*	@modify: 	data 			remarks
+=============================================================*/
+static uint8_t Report_Can_Merge_Bitmap(uint8_t *prev, uint8_t *tail, uint8_t *now, uint8_t len)
+{
+	uint8_t press1 = 0, press2 = 0;
+
+	if((prev[1] != tail[1]) || (tail[1] != now[1]))
+	{
+		return 0;
+	}
+	for (uint8_t i = 2; i < len; ++i)
+	{
+		if((prev[i] ^ tail[i]) & (tail[i] ^ now[i]))
+		{
+			return 0;
+		}
+		press1 |= tail[i] & (uint8_t)~prev[i];
+		press2 |= now[i] & (uint8_t)~tail[i];
+	}
+	return !(press1 && press2);
+}
+/*============================================================
+	*	@func:		Report_Can_Merge_Boot
+	*	@brief:		6KRO启动报告合并判断：[功能键][保留][6个键值]
+	*	@param:		NA
+	*	@retval:	1：可以合并 0：不可合并
+	*	@modify: 	data 			remarks
+=============================================================*/
+static uint8_t Report_Can_Merge_Boot(uint8_t *prev, uint8_t *tail, uint8_t *now)
+{
+	uint8_t *list[3];
+	uint8_t key;
+	uint8_t in_prev, in_tail, in_now;
+	uint8_t press1 = 0, press2 = 0;
+
+	if((prev[0] != tail[0]) || (tail[0] != now[0]))
+	{
+		return 0;
+	}
+	list[0] = prev;
+	list[1] = tail;
+	list[2] = now;
+	for (uint8_t n = 0; n < 3; ++n)
+	{
+		for (uint8_t i = 2; i < 8; ++i)
+		{
+			key = list[n][i];
+			if(key == 0)
+			{
+				continue;
+			}
+			in_prev = Report_Has_Key(prev, key);
+			in_tail = Report_Has_Key(tail, key);
+			in_now = Report_Has_Key(now, key);
+			if((in_prev != in_tail) && (in_tail != in_now))
+			{
+				return 0;
+			}
+			press1 |= (in_tail && !in_prev);
+			press2 |= (in_now && !in_tail);
+		}
+	}
+	return !(press1 && press2);
+}
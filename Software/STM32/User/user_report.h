@@ -0,0 +1,41 @@
+#ifndef __USER_REPORT_H
+#define __USER_REPORT_H
+#include "bsp.h"
+
+#define REPORT_QUEUE_SIZE	16		//报告队列深度
+#define REPORT_MAX_LEN		HID_NKRO_REPORT_LEN		//单个报告最大长度
+#define REPORT_HOLD_TIME	2000	//STOP唤醒后等待USB重新枚举、保留队列的最长时间(ms)
+
+#define REPORT_PUSH_FULL	0		//队列满，未入队
+#define REPORT_PUSH_QUEUED	1		//新入队
+#define REPORT_PUSH_MERGED	2		//已合并到队尾
+
+typedef struct
+{
+	uint8_t len;					//报告长度
+	uint8_t buf[REPORT_MAX_LEN];	//报告快照
+}REPORT_ITEM;
+
+typedef struct
+{
+	REPORT_ITEM item[REPORT_QUEUE_SIZE];
+	volatile uint8_t read;			//队首，正在发送或等待发送的报告
+	volatile uint8_t write;			//队尾
+	volatile uint8_t count;			//队列中报告个数
+	volatile uint8_t busy;			//队首报告已交给端点，等待DataIn完成
+	volatile uint8_t hold;			//1：STOP唤醒后USB未配置，保留队列等待枚举
+	int32_t hold_time;				//开始保留的时间
+	uint8_t last[REPORT_MAX_LEN];	//最近一次交给端点的报告
+	uint8_t last_len;				//最近一次交给端点的报告长度
+	volatile uint32_t merged;		//合并次数
+	volatile uint32_t overflow;		//队列满次数
+}REPORT_QUEUE;
+
+void Report_Queue_Init(void);								//报告队列初始化
+void Report_Queue_Hold(void);								//STOP唤醒后保留报告直到枚举完成
+uint8_t Report_Queue_Push(uint8_t *buf, uint8_t len);		//报告入队
+void Report_Queue_Kick(void);								//端点空闲时启动发送
+void Report_Queue_TxCplt(void);								//端点发送完成回调
+uint8_t Report_Queue_Idle(void);							//队列为空且端点空闲
+uint32_t Report_Queue_GetOverflow(void);					//获取溢出计数
+#endif
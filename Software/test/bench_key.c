@@ -0,0 +1,112 @@
+/************************************************************
+	*	@file:		bench_key.c
+	*	@brief:		按键事件比较的主机基准：直接包含 user_key.c 调用静态函数，
+	*				测量0/1/6/20个按键变化时 Key_Event_Diff 一次比较的耗时，
+	*				并与逐位遍历96个按键的比较对照。Key_Ctz16 对全部非零输入
+	*				检查结果。耗时只打印，不作为通过条件
+	*	@author:	XIET
+	*	@version:	V1.0
+	*	@data:		201x-xx-xx
+	*	@modify:	data  			remarks
+**************************************************************/
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "user_key.c"
+#include "sim.h"
+
+#define BENCH_LOOPS		200000
+
+static const uint16_t s_usBenchMatrix[4][MATRIX_ROWS] =
+{
+	{0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},		//0个变化
+	{0x0001, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},		//1个
+	{0x0001, 0x0002, 0x0004, 0x0008, 0x0010, 0x0020},		//6个
+	{0x000F, 0x00F0, 0x0F00, 0xF000, 0x8421, 0x0000},		//20个
+};
+static const uint8_t s_ucBenchKeys[4] = {0, 1, 6, 20};
+static volatile uint32_t s_uiSink;
+
+static double Now_Ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+/* 对照：逐位遍历所有按键，变化的按键写入事件环 */
+static void Naive_Diff(void)
+{
+	uint8_t write = s_ucEventWrite;
+	KEY_EVENT_REC *p_rec;
+
+	for (uint8_t r = 0; r < MATRIX_ROWS; ++r)
+	{
+		for (uint8_t c = 0; c < MATRIX_COLS; ++c)
+		{
+			if(((matrix[r] ^ s_usMatrixPrev[r]) >> c) & 0x01)
+			{
+				p_rec = &s_tEventRing[write & (KEY_EVENT_RING_SIZE - 1)];
+				p_rec->row = r;
+				p_rec->col = c;
+				p_rec->pressed = (matrix[r] >> c) & 0x01;
+				write++;
+				s_usMatrixPrev[r] ^= (uint16_t)1 << c;
+			}
+		}
+	}
+	s_ucEventWrite = write;
+}
+static double Bench(void (*diff)(void), uint8_t i)
+{
+	double start;
+
+	start = Now_Ns();
+	for (uint32_t n = 0; n < BENCH_LOOPS; n++)
+	{
+		memcpy(matrix, s_usBenchMatrix[i], sizeof(matrix));
+		memset(s_usMatrixPrev, 0, sizeof(s_usMatrixPrev));
+		s_ucEventWrite = 0;
+		s_ucEventRead = 0;
+		diff();
+		s_uiSink += s_ucEventWrite;
+	}
+	return (Now_Ns() - start) / BENCH_LOOPS;
+}
+static void Test_Ctz16(void)
+{
+	uint32_t err = 0;
+
+	for (uint32_t w = 1; w <= 0xFFFF; w++)
+	{
+		if(Key_Ctz16((uint16_t)w) != __builtin_ctz(w))
+		{
+			err++;
+		}
+	}
+	CHECK(err == 0);
+}
+static void Test_Diff(void)
+{
+	for (uint8_t i = 0; i < 4; i++)
+	{
+		memcpy(matrix, s_usBenchMatrix[i], sizeof(matrix));
+		memset(s_usMatrixPrev, 0, sizeof(s_usMatrixPrev));
+		s_ucEventWrite = 0;
+		s_ucEventRead = 0;
+		Key_Event_Diff();
+		CHECK(s_ucEventWrite == s_ucBenchKeys[i]);
+		CHECK(memcmp(s_usMatrixPrev, matrix, sizeof(matrix)) == 0);
+		printf("bench_key: %2u keys  diff %6.1f ns  naive %6.1f ns\n", s_ucBenchKeys[i], Bench(Key_Event_Diff, i), Bench(Naive_Diff, i));
+	}
+}
+
+int main(void)
+{
+	Sim_Reset();
+	Test_Ctz16();
+	Test_Diff();
+	printf("bench_key: %s\n", s_iFail ? "FAIL" : "OK");
+	return s_iFail ? EXIT_FAILURE : EXIT_SUCCESS;
+}
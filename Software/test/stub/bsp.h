@@ -0,0 +1,212 @@
+/************************************************************
+	*	@file:		bsp.h
+	*	@brief:		主机测试用的bsp.h替身，只提供被测模块用到的类型、宏和函数。
+	*				GPIO、SysTick等寄存器是普通变量，由 sim.c 模拟按键矩阵和时间，
+	*				软件定时器的类型和ID直接使用 bsp_timer.h
+	*	@author:	XIET
+	*	@version:	V1.0
+	*	@data:		201x-xx-xx
+	*	@modify:	data  			remarks
+**************************************************************/
+#ifndef __BSP_H
+#define __BSP_H
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* USB HID 报告格式，与 usbd_hid.h 一致 */
+#define HID_BOOT_REPORT_LEN		8
+#define HID_NKRO_REPORT_ID		0x01
+#define HID_NKRO_KEY_MAX		128
+#define HID_NKRO_REPORT_LEN		(2 + HID_NKRO_KEY_MAX / 8)
+#define HID_CONSUMER_REPORT_ID	0x03
+#define HID_CONSUMER_REPORT_LEN	4
+#define HID_SYSTEM_REPORT_ID	0x04
+#define HID_SYSTEM_REPORT_LEN	2
+
+#define HID_PROTOCOL_BOOT		0x00
+#define HID_PROTOCOL_REPORT		0x01
+#ifndef HID_LOW_LATENCY
+	#define HID_LOW_LATENCY		1
+#endif
+#if HID_LOW_LATENCY == 1
+	#define HID_FS_BINTERVAL	0x01
+#else
+	#define HID_FS_BINTERVAL	0x0A
+#endif
+
+typedef struct
+{
+	uint8_t dummy;
+}USBD_HandleTypeDef;
+typedef struct
+{
+	uint8_t dummy;
+}PCD_HandleTypeDef;
+
+#define USBD_OK		0
+#define USBD_BUSY	1
+#define USBD_FAIL	2
+
+#define PWR_WAKE_QUEUE		0x01
+#define PWR_WAKE_SEND		0x02
+
+/* 与 user_event.h 一致 */
+#define EVT_SCAN_TICK		(1 << 0)
+#define EVT_MATRIX			(1 << 1)
+#define EVT_KEY_WAKE		(1 << 2)
+#define EVT_USB_TX			(1 << 3)
+
+#define CLOCK_REQ_KEY		(1 << 0)
+#define CLOCK_REQ_LED		(1 << 1)
+#define CLOCK_REQ_USB		(1 << 2)
+
+#define DISABLE		0
+#define ENABLE		1
+
+/* 与 bsp_uart_fifo.h 一致 */
+typedef enum
+{
+	COM_BLE = 0
+}COM_PORT_E;
+
+/* 寄存器替身 */
+typedef struct
+{
+	volatile uint32_t ODR;
+}GPIO_TypeDef;
+typedef struct
+{
+	volatile uint32_t CTRL;
+	volatile uint32_t LOAD;
+	volatile uint32_t VAL;
+}SysTick_Type;
+typedef struct
+{
+	volatile uint32_t ICSR;
+}SCB_Type;
+extern GPIO_TypeDef g_tSimGPIOA;
+extern GPIO_TypeDef g_tSimGPIOB;
+extern GPIO_TypeDef g_tSimGPIOC;
+extern SysTick_Type g_tSimSysTick;
+extern SCB_Type g_tSimSCB;
+extern uint32_t SystemCoreClock;
+#define GPIOA		(&g_tSimGPIOA)
+#define GPIOB		(&g_tSimGPIOB)
+#define GPIOC		(&g_tSimGPIOC)
+#define SysTick		(&g_tSimSysTick)
+#define SCB			(&g_tSimSCB)
+#define __IO		volatile
+#define __DMB()
+#define __get_PRIMASK()		0
+#define __set_PRIMASK(x)	((void)(x))
+#define SysTick_CTRL_ENABLE_Msk		(1UL << 0)
+#define SysTick_CTRL_TICKINT_Msk	(1UL << 1)
+#define SysTick_CTRL_CLKSOURCE_Msk	(1UL << 2)
+#define SysTick_LOAD_RELOAD_Msk		0xFFFFFFUL
+#define SCB_ICSR_PENDSTCLR_Msk		(1UL << 25)
+#define SCB_ICSR_PENDSTSET_Msk		(1UL << 26)
+#define HSI_VALUE			16000000U
+
+typedef enum
+{
+	HAL_OK = 0
+}HAL_StatusTypeDef;
+
+/* 与 bsp_gpio.h 一致 */
+#define KEY_ROW_PORT		GPIOC
+#define KEY_ROW1_PIN		(1 << 1)
+#define KEY_ROW2_PIN		(1 << 2)
+#define KEY_ROW3_PIN		(1 << 3)
+#define KEY_ROW4_PIN		(1 << 4)
+#define KEY_ROW5_PIN		(1 << 5)
+#define KEY_ROW6_PIN		(1 << 6)
+#define KEY_ROW_ALL_PIN		(KEY_ROW1_PIN|KEY_ROW2_PIN|KEY_ROW3_PIN|KEY_ROW4_PIN|KEY_ROW5_PIN|KEY_ROW6_PIN)
+#define KEY_ALL_ROW_UNSELECT()	KEY_ROW_PORT->ODR = (KEY_ROW_PORT->ODR) & (~KEY_ROW_ALL_PIN)
+#define KEY_ALL_ROW_SELECT()	KEY_ROW_PORT->ODR = (KEY_ROW_PORT->ODR) | KEY_ROW_ALL_PIN
+#define KEY_ROW1_SELECT()		KEY_ROW_PORT->ODR = ((KEY_ROW_PORT->ODR & (~KEY_ROW_ALL_PIN)) | KEY_ROW1_PIN)
+#define KEY_ROW2_SELECT()		KEY_ROW_PORT->ODR = ((KEY_ROW_PORT->ODR & (~KEY_ROW_ALL_PIN)) | KEY_ROW2_PIN)
+#define KEY_ROW3_SELECT()		KEY_ROW_PORT->ODR = ((KEY_ROW_PORT->ODR & (~KEY_ROW_ALL_PIN)) | KEY_ROW3_PIN)
+#define KEY_ROW4_SELECT()		KEY_ROW_PORT->ODR = ((KEY_ROW_PORT->ODR & (~KEY_ROW_ALL_PIN)) | KEY_ROW4_PIN)
+#define KEY_ROW5_SELECT()		KEY_ROW_PORT->ODR = ((KEY_ROW_PORT->ODR & (~KEY_ROW_ALL_PIN)) | KEY_ROW5_PIN)
+#define KEY_ROW6_SELECT()		KEY_ROW_PORT->ODR = ((KEY_ROW_PORT->ODR & (~KEY_ROW_ALL_PIN)) | KEY_ROW6_PIN)
+#define KEY_COL_PORT		GPIOB
+#define KEY_COL_ALL_PIN		0xFFFF
+#define LED_ROW_PORT		GPIOA
+#define LED_ROW1_PIN		(1 << 1)
+#define LED_ROW2_PIN		(1 << 2)
+#define LED_ROW3_PIN		(1 << 3)
+#define LED_ROW4_PIN		(1 << 4)
+#define LED_ROW5_PIN		(1 << 8)
+#define LED_ROW6_PIN		(1 << 15)
+#define LED_ROW_ALL_PIN		(LED_ROW1_PIN|LED_ROW2_PIN|LED_ROW3_PIN|LED_ROW4_PIN|LED_ROW5_PIN|LED_ROW6_PIN)
+#define LED_ALL_ROW_OFF()	LED_ROW_PORT->ODR = (LED_ROW_PORT->ODR) | LED_ROW_ALL_PIN
+#define LED_ALL_ROW_ON()	LED_ROW_PORT->ODR = (LED_ROW_PORT->ODR) & (~LED_ROW_ALL_PIN)
+#define LED_ROW1_ON()		LED_ROW_PORT->ODR = ((LED_ROW_PORT->ODR | LED_ROW_ALL_PIN) & (~LED_ROW1_PIN))
+#define LED_ROW2_ON()		LED_ROW_PORT->ODR = ((LED_ROW_PORT->ODR | LED_ROW_ALL_PIN) & (~LED_ROW2_PIN))
+#define LED_ROW3_ON()		LED_ROW_PORT->ODR = ((LED_ROW_PORT->ODR | LED_ROW_ALL_PIN) & (~LED_ROW3_PIN))
+#define LED_ROW4_ON()		LED_ROW_PORT->ODR = ((LED_ROW_PORT->ODR | LED_ROW_ALL_PIN) & (~LED_ROW4_PIN))
+#define LED_ROW5_ON()		LED_ROW_PORT->ODR = ((LED_ROW_PORT->ODR | LED_ROW_ALL_PIN) & (~LED_ROW5_PIN))
+#define LED_ROW6_ON()		LED_ROW_PORT->ODR = ((LED_ROW_PORT->ODR | LED_ROW_ALL_PIN) & (~LED_ROW6_PIN))
+
+/* 与 bsp_74hc595.h 一致，锁存由 sim_led.c 记录 */
+#define HC595_LATCH()		HC595_Sim_Latch()
+
+/* 主机上没有中断，临界区为空 */
+#define ENABLE_INT()
+#define DISABLE_INT()
+
+#include "bsp_timer.h"
+#include "keycode.h"
+#include "user_display.h"
+#include "keymap.h"
+#include "user_keymap.h"
+#include "user_layer.h"
+#include "user_debounce.h"
+#include "user_key.h"
+#include "keyboard.h"
+#include "user_report.h"
+#include "user_link.h"
+#include "user_macro.h"
+
+/* sim.c 实现的外设替身 */
+uint32_t LL_GPIO_ReadInputPort(GPIO_TypeDef *port);
+void GPIO_Config_EXTI(void);
+void GPIO_Disable_EXTI(void);
+void bsp_HwTimer_Start(uint16_t us);
+void bsp_HwTimer_Stop(void);
+uint16_t bsp_UsTimer_Now(void);
+void Clock_Demand(uint8_t req, uint8_t on);
+
+/* sim_led.c 实现的595和LED定时器替身 */
+void HC595_Sim_Latch(void);
+void HC595_SendData(uint16_t *pbuf, uint8_t len);
+void HC595_SendData_DMA(uint16_t *pbuf, uint8_t len);
+uint8_t HC595_DMA_Done(void);
+void HC595_DMA_Abort(void);
+void HC595_Wait_Shift(void);
+void bsp_LedTimer_Start(uint16_t us, uint16_t next_us);
+void bsp_LedTimer_SetNext(uint16_t us);
+void bsp_LedTimer_Stop(void);
+void Clock_Update(void);
+void GPIO_LED_Power(uint8_t on);
+void System_Enter_StopMode(void);
+
+/* 由测试程序实现的替身 */
+void comSendBuf(COM_PORT_E _ucPort, uint8_t *_ucaBuf, uint16_t _usLen);
+uint8_t comSendBufNoCopy(COM_PORT_E _ucPort, uint8_t *_ucaBuf, uint16_t _usLen);
+uint8_t comNoCopyBusy(COM_PORT_E _ucPort);
+uint8_t comGetChar(COM_PORT_E _ucPort, uint8_t *_pByte);
+void Keyboard_Get_Boot(uint8_t *buf);
+uint8_t Keyboard_Get_Usage(uint8_t id, uint8_t *buf);
+
+/* 由 sim.c 或测试程序实现的替身 */
+uint8_t USBD_HID_SendReport(USBD_HandleTypeDef *pdev, uint8_t *report, uint16_t len);
+uint8_t USBD_HID_GetProtocol(USBD_HandleTypeDef *pdev);
+void bsp_Idle(void);
+void SysTick_Handler(void);
+uint32_t SysTick_Config(uint32_t ticks);
+void Event_Post(uint32_t evt);
+void Pwr_Wake_Report(uint8_t stage);
+
+#endif
@@ -0,0 +1,133 @@
+/************************************************************
+	*	@file:		sim.c
+	*	@brief:		主机测试的外设模拟：行输出选中的行上按下的按键出现在列输入，
+	*				时间以us计，软件定时器和行稳定定时器只记录状态
+	*	@author:	XIET
+	*	@version:	V1.0
+	*	@data:		201x-xx-xx
+	*	@modify:	data  			remarks
+**************************************************************/
+#define SIM_NO_CHECK
+#include "sim.h"
+
+GPIO_TypeDef g_tSimGPIOB;
+GPIO_TypeDef g_tSimGPIOC;
+
+uint16_t g_usSimKey[MATRIX_ROWS];
+uint32_t g_uiSimUs;
+uint32_t g_uiSimEvent;
+uint8_t g_ucSimHwTimer;
+uint8_t g_ucSimScanTimer;
+uint8_t g_ucSimExti;
+
+void Sim_Reset(void)
+{
+	memset(g_usSimKey, 0, sizeof(g_usSimKey));
+	g_uiSimUs = 0;
+	g_uiSimEvent = 0;
+	g_ucSimHwTimer = 0;
+	g_ucSimScanTimer = 0;
+	g_ucSimExti = 0;
+	g_tSimGPIOC.ODR = 0;
+}
+void Sim_Advance_Us(uint32_t us)
+{
+	g_uiSimUs += us;
+}
+void Sim_Scan(void)
+{
+	Key_Scan();
+	while(g_ucSimHwTimer)
+	{
+		g_ucSimHwTimer = 0;
+		Sim_Advance_Us(KEY_SETTLE_US);
+		Key_Scan_Row_ISR();
+	}
+}
+uint32_t Sim_Take_Event(uint32_t evt)
+{
+	uint32_t ret = g_uiSimEvent & evt;
+
+	g_uiSimEvent &= ~evt;
+	return ret;
+}
+uint32_t LL_GPIO_ReadInputPort(GPIO_TypeDef *port)
+{
+	uint32_t col = 0;
+
+	if(port != KEY_COL_PORT)
+	{
+		return 0;
+	}
+	for(uint8_t r = 0; r < MATRIX_ROWS; r++)
+	{
+		if(KEY_ROW_PORT->ODR & (KEY_ROW1_PIN << r))
+		{
+			col |= g_usSimKey[r];
+		}
+	}
+	return col;
+}
+void GPIO_Config_EXTI(void)
+{
+	KEY_ALL_ROW_SELECT();
+	g_ucSimExti = 1;
+}
+void GPIO_Disable_EXTI(void)
+{
+	g_ucSimExti = 0;
+}
+void bsp_HwTimer_Start(uint16_t us)
+{
+	(void)us;
+	g_ucSimHwTimer = 1;
+}
+void bsp_HwTimer_Stop(void)
+{
+	g_ucSimHwTimer = 0;
+}
+void bsp_StartTimer(uint8_t _id, uint32_t _period)
+{
+	(void)_id;
+	(void)_period;
+}
+void bsp_StartAutoTimer(uint8_t _id, uint32_t _period)
+{
+	(void)_period;
+	if(_id == TMR_KEY_SCAN)
+	{
+		g_ucSimScanTimer = 1;
+	}
+}
+void bsp_StopTimer(uint8_t _id)
+{
+	if(_id == TMR_KEY_SCAN)
+	{
+		g_ucSimScanTimer = 0;
+	}
+}
+void bsp_DelayUS(uint32_t n)
+{
+	Sim_Advance_Us(n);
+}
+uint16_t bsp_UsTimer_Now(void)
+{
+	return (uint16_t)g_uiSimUs;
+}
+uint32_t bsp_GetRunTimeUs(void)
+{
+	return g_uiSimUs;
+}
+int32_t bsp_GetRunTime(void)
+{
+	return (int32_t)(g_uiSimUs / 1000);
+}
+void Clock_Demand(uint8_t req, uint8_t on)
+{
+	(void)req;
+	(void)on;
+}
+void Event_Post(uint32_t evt)
+{
+	g_uiSimEvent |= evt;
+}
@@ -0,0 +1,32 @@
+/************************************************************
+	*	@file:		sim.h
+	*	@brief:		主机测试的外设模拟：按键矩阵、时间、定时器和事件
+	*	@author:	XIET
+	*	@version:	V1.0
+	*	@data:		201x-xx-xx
+	*	@modify:	data  			remarks
+**************************************************************/
+#ifndef __SIM_H
+#define __SIM_H
+#include <stdio.h>
+#include "bsp.h"
+
+/* 测试程序共用的检查：失败时打印位置并计数，main 按 s_iFail 返回。
+   模拟外设的 sim.c 不使用，包含前定义 SIM_NO_CHECK */
+#ifndef SIM_NO_CHECK
+static int s_iFail;
+#define CHECK(x)	do { if(!(x)) { printf("%s:%d: CHECK(%s)\n", __FILE__, __LINE__, #x); s_iFail++; } } while(0)
+#endif
+
+extern uint16_t g_usSimKey[MATRIX_ROWS];		//按下的按键，行选中时出现在列上
+extern uint32_t g_uiSimUs;						//当前时间(us)
+extern uint32_t g_uiSimEvent;					//已投递的事件
+extern uint8_t g_ucSimHwTimer;					//行稳定定时器运行中
+extern uint8_t g_ucSimScanTimer;				//TMR_KEY_SCAN 运行中
+extern uint8_t g_ucSimExti;						//列中断使能
+
+void Sim_Reset(void);							//模拟状态复位
+void Sim_Advance_Us(uint32_t us);				//时间前进
+void Sim_Scan(void);							//启动一轮扫描并运行行稳定中断直到结束
+uint32_t Sim_Take_Event(uint32_t evt);			//取出并清除事件
+#endif
@@ -0,0 +1,106 @@
+/************************************************************
+	*	@file:		sim_led.c
+	*	@brief:		主机测试的LED外设模拟：595 DMA发送在测试调用
+	*				Sim_Led_Dma_Done 时完成，锁存记录595中的数据和当前点亮的行，
+	*				LED定时器记录各段时间；更新时当前段结束，预装的下一段生效
+	*	@author:	XIET
+	*	@version:	V1.0
+	*	@data:		201x-xx-xx
+	*	@modify:	data  			remarks
+**************************************************************/
+#include "sim_led.h"
+
+GPIO_TypeDef g_tSimGPIOA;
+SIM_LED g_tSimLed;
+
+void Sim_Led_Reset(void)
+{
+	memset(&g_tSimLed, 0, sizeof(g_tSimLed));
+	g_tSimGPIOA.ODR = LED_ROW_ALL_PIN;
+}
+void Sim_Led_Dma_Done(void)
+{
+	if(!g_tSimLed.dma_busy)
+	{
+		return;
+	}
+	g_tSimLed.dma_busy = 0;
+	g_tSimLed.shift = g_tSimLed.dma_buf;
+	g_tSimLed.dma_irq++;
+	g_tSimLed.in_isr = 1;
+	Display_BCM_DMA_ISR();
+	g_tSimLed.in_isr = 0;
+}
+void Sim_Led_Timer_Update(void)
+{
+	if(!g_tSimLed.timer_run)
+	{
+		return;
+	}
+	g_tSimLed.elapsed_us += g_tSimLed.timer_us;
+	g_tSimLed.timer_us = g_tSimLed.timer_next_us;
+	g_tSimLed.timer_irq++;
+	g_tSimLed.in_isr = 1;
+	Display_BCM_ISR();
+	g_tSimLed.in_isr = 0;
+}
+void HC595_Sim_Latch(void)
+{
+	g_tSimLed.latched = g_tSimLed.shift;
+	g_tSimLed.latch_count++;
+}
+void HC595_SendData(uint16_t *pbuf, uint8_t len)
+{
+	(void)len;
+	g_tSimLed.shift = pbuf;
+}
+void HC595_SendData_DMA(uint16_t *pbuf, uint8_t len)
+{
+	(void)len;
+	g_tSimLed.dma_buf = pbuf;
+	g_tSimLed.dma_busy = 1;
+}
+uint8_t HC595_DMA_Done(void)
+{
+	if(g_tSimLed.in_isr)
+	{
+		g_tSimLed.isr_poll++;
+	}
+	return !g_tSimLed.dma_busy;
+}
+void HC595_DMA_Abort(void)
+{
+	g_tSimLed.dma_busy = 0;
+}
+void HC595_Wait_Shift(void)
+{
+	if(g_tSimLed.dma_busy)		//DMA未完成时等待移位是错误用法
+	{
+		g_tSimLed.isr_poll++;
+	}
+}
+void bsp_LedTimer_Start(uint16_t us, uint16_t next_us)
+{
+	g_tSimLed.timer_run = 1;
+	g_tSimLed.timer_us = us;
+	g_tSimLed.timer_next_us = next_us;
+	g_tSimLed.timer_start++;
+}
+void bsp_LedTimer_SetNext(uint16_t us)
+{
+	g_tSimLed.timer_next_us = us;
+}
+void bsp_LedTimer_Stop(void)
+{
+	g_tSimLed.timer_run = 0;
+}
+void Clock_Update(void)
+{
+}
+void GPIO_LED_Power(uint8_t on)
+{
+	(void)on;
+}
+void System_Enter_StopMode(void)
+{
+}
@@ -0,0 +1,37 @@
+/************************************************************
+	*	@file:		sim_led.h
+	*	@brief:		主机测试的LED外设模拟
+	*	@author:	XIET
+	*	@version:	V1.0
+	*	@data:		201x-xx-xx
+	*	@modify:	data  			remarks
+**************************************************************/
+#ifndef __SIM_LED_H
+#define __SIM_LED_H
+#include "bsp.h"
+
+typedef struct
+{
+	uint16_t *dma_buf;				//正在DMA发送的数据
+	uint8_t dma_busy;				//DMA发送中
+	uint16_t *shift;				//595移位寄存器中的数据
+	uint16_t *latched;				//595输出的数据
+	uint32_t latch_count;			//锁存次数
+	uint8_t in_isr;					//正在执行中断回调
+	uint32_t isr_poll;				//中断中查询或等待DMA的次数
+	uint8_t timer_run;				//LED定时器运行中
+	uint16_t timer_us;				//第一段时间
+	uint16_t timer_next_us;			//下一段时间
+	uint32_t timer_start;			//定时器启动次数
+	uint32_t elapsed_us;			//定时器运行的总时间
+	uint32_t timer_irq;				//定时器中断次数
+	uint32_t dma_irq;				//DMA完成中断次数
+}SIM_LED;
+
+extern GPIO_TypeDef g_tSimGPIOA;
+extern SIM_LED g_tSimLed;
+
+void Sim_Led_Reset(void);				//模拟状态复位
+void Sim_Led_Dma_Done(void);			//DMA发送完成，进入DMA中断
+void Sim_Led_Timer_Update(void);		//LED定时器更新，进入定时器中断
+#endif
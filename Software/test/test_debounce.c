@@ -0,0 +1,203 @@
+/************************************************************
+	*	@file:		test_debounce.c
+	*	@brief:		消抖主机测试：以ms计的消抖时间和锁定时间在2ms定时扫描和
+	*				1ms SOF扫描下相同，单次扫描的抖动不上报。基准：典型机械
+	*				按键的抖动波形在各扫描相位下回放，打印各算法按下和释放
+	*				增加的延迟，每次按键必须只上报一次按下和一次释放
+	*	@author:	XIET
+	*	@version:	V1.0
+	*	@data:		201x-xx-xx
+	*	@modify:	data  			remarks
+**************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include "sim.h"
+
+#define TRACE_EDGES		12
+#define TRACE_RELEASE_US	40000	//按下第一个边沿到释放第一个边沿的时间
+#define TRACE_PHASE_US		100		//扫描相位的取样间隔
+
+/* 抖动波形：边沿时刻(us)，第一个为0，之后接通和断开交替，边沿数为奇数 */
+typedef struct
+{
+	const char *name;
+	uint8_t press_edges;
+	uint16_t press_us[TRACE_EDGES];
+	uint8_t release_edges;
+	uint16_t release_us[TRACE_EDGES];
+}BOUNCE_TRACE;
+
+static const BOUNCE_TRACE s_tTrace[] =
+{
+	{"clean",	1, {0},													1, {0}},
+	{"short",	5, {0, 80, 150, 400, 450},								3, {0, 120, 200}},
+	{"typical",	7, {0, 300, 700, 1100, 1500, 2100, 2600},				3, {0, 500, 900}},
+	{"long",	9, {0, 400, 900, 1600, 2300, 3000, 3700, 4200, 4500},	5, {0, 600, 1300, 2000, 2500}},
+	{"worn",	9, {0, 500, 1500, 2500, 3500, 4500, 5500, 6500, 7000},	5, {0, 1000, 2500, 4000, 5000}},
+};
+
+static uint16_t s_raw[MATRIX_ROWS];
+static uint16_t s_matrix[MATRIX_ROWS];
+
+static void Reset(uint8_t period)
+{
+	memset(s_raw, 0, sizeof(s_raw));
+	memset(s_matrix, 0, sizeof(s_matrix));
+	Debounce_Init();
+	Debounce_SetPeriod(period);
+}
+/* 以period扫描直到(row,col)的消抖输出等于level，返回经过的ms，超时返回-1 */
+static int Scan_Until(uint8_t period, uint8_t row, uint8_t col, uint8_t level)
+{
+	for(int t = 0; t < 100; t += period)
+	{
+		Debounce_Matrix(s_raw, s_matrix);
+		if(((s_matrix[row] >> col) & 1) == level)
+		{
+			return t;
+		}
+	}
+	return -1;
+}
+#if DEBOUNCE_ALGORITHM != DEBOUNCE_EAGER
+/* 延迟消抖：稳定按下 DEBOUNCE_MS 减一个扫描周期后上报，与扫描周期无关 */
+static void Test_Delay(uint8_t period)
+{
+	Reset(period);
+	s_raw[2] = 1 << 5;
+	CHECK(Scan_Until(period, 2, 5, 1) == DEBOUNCE_MS - period);
+	s_raw[2] = 0;
+	CHECK(Scan_Until(period, 2, 5, 0) == DEBOUNCE_MS - period);
+}
+/* 延迟消抖：短于消抖时间的抖动不上报 */
+static void Test_Glitch(uint8_t period)
+{
+	Reset(period);
+	for(int t = 0; t < 4 * DEBOUNCE_MS; t += period)
+	{
+		s_raw[0] = ((t / period) % 2) ? 0x0001 : 0;		//每次扫描都翻转
+		Debounce_Matrix(s_raw, s_matrix);
+		CHECK(s_matrix[0] == 0);
+	}
+}
+#else
+/* 即时消抖：边沿立即上报，之后 DEBOUNCE_LOCK_MS 内的变化等锁定结束才上报 */
+static void Test_Lock(uint8_t period)
+{
+	int t;
+
+	Reset(period);
+	s_raw[1] = 1 << 3;
+	CHECK(Scan_Until(period, 1, 3, 1) == 0);
+	s_raw[1] = 0;		//边沿后的下一次扫描就释放
+	t = Scan_Until(period, 1, 3, 0) + period;
+	CHECK(t > DEBOUNCE_LOCK_MS);
+	CHECK(t <= DEBOUNCE_LOCK_MS + 2 * period);
+}
+/* 即时消抖：锁定只作用于发生边沿的按键，其他按键立即上报 */
+static void Test_Lock_Other(uint8_t period)
+{
+	Reset(period);
+	s_raw[1] = 1 << 3;
+	Debounce_Matrix(s_raw, s_matrix);
+	s_raw[4] = 1 << 15;
+	CHECK(Scan_Until(period, 4, 15, 1) == 0);
+	CHECK(s_matrix[1] == (1 << 3));
+}
+#endif
+/* 波形在t时刻的电平：边沿从0开始交替 */
+static uint8_t Trace_Level(const BOUNCE_TRACE *p, uint32_t t)
+{
+	uint8_t n = 0;
+	const uint16_t *edge = p->press_us;
+	uint8_t edges = p->press_edges;
+	uint8_t pressed = 1;
+
+	if(t >= TRACE_RELEASE_US)
+	{
+		t -= TRACE_RELEASE_US;
+		edge = p->release_us;
+		edges = p->release_edges;
+		pressed = 0;
+	}
+	while((n < edges) && (edge[n] <= t))
+	{
+		n++;
+	}
+	return (n & 1) ? pressed : !pressed;
+}
+/* 以period扫描回放波形，扫描相位从0到period取样，统计按下和释放上报的延迟 */
+static void Bench_Trace(const BOUNCE_TRACE *p, uint8_t period)
+{
+	uint32_t period_us = period * 1000;
+	uint32_t press_max = 0, release_max = 0;
+	uint32_t press_sum = 0, release_sum = 0;
+	uint32_t runs = 0;
+	uint32_t t;
+	uint32_t press_at;
+	uint32_t release_at;
+	uint8_t changes;
+	uint8_t level;
+
+	for(uint32_t phase = 0; phase < period_us; phase += TRACE_PHASE_US)
+	{
+		Reset(period);
+		Debounce_Matrix(s_raw, s_matrix);
+		changes = 0;
+		level = 0;
+		press_at = release_at = 0;
+		for(t = phase; t < 2 * TRACE_RELEASE_US; t += period_us)
+		{
+			s_raw[2] = Trace_Level(p, t) ? (1 << 9) : 0;
+			Debounce_Matrix(s_raw, s_matrix);
+			if(((s_matrix[2] >> 9) & 1) == level)
+			{
+				continue;
+			}
+			level = !level;
+			changes++;
+			if(level)
+			{
+				press_at = t;
+			}
+			else
+			{
+				release_at = t - TRACE_RELEASE_US;
+			}
+		}
+		CHECK(changes == 2);		//抖动不产生多余的按下或释放
+		CHECK(!level);
+		CHECK(press_at <= p->press_us[p->press_edges - 1] + DEBOUNCE_MS * 1000 + period_us);		//最后一个边沿后最多再等消抖时间
+		CHECK(release_at <= p->release_us[p->release_edges - 1] + DEBOUNCE_MS * 1000 + period_us);
+		press_sum += press_at;
+		release_sum += release_at;
+		press_max = (press_at > press_max) ? press_at : press_max;
+		release_max = (release_at > release_max) ? release_at : release_max;
+		runs++;
+	}
+	printf("test_debounce(%d): %dms scan, %-8s press %5u/%5u us, release %5u/%5u us (mean/worst)\n",
+		DEBOUNCE_ALGORITHM, period, p->name, press_sum / runs, press_max, release_sum / runs, release_max);
+}
+
+int main(void)
+{
+	for(uint8_t period = 1; period <= TMR_PERIOD_2MS; period++)
+	{
+#if DEBOUNCE_ALGORITHM != DEBOUNCE_EAGER
+		Test_Delay(period);
+		Test_Glitch(period);
+#else
+		Test_Lock(period);
+		Test_Lock_Other(period);
+#endif
+	}
+	for(uint8_t period = TMR_PERIOD_2MS; period >= 1; period--)
+	{
+		for(uint8_t i = 0; i < sizeof(s_tTrace) / sizeof(s_tTrace[0]); i++)
+		{
+			Bench_Trace(&s_tTrace[i], period);
+		}
+	}
+	printf("test_debounce(%d): %s\n", DEBOUNCE_ALGORITHM, s_iFail ? "FAIL" : "OK");
+	return s_iFail ? EXIT_FAILURE : EXIT_SUCCESS;
+}
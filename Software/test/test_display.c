@@ -0,0 +1,161 @@
+/************************************************************
+	*	@file:		test_display.c
+	*	@brief:		BCM显示主机测试：位平面由定时器和DMA完成中断接力，
+	*				中断中不等待DMA，DMA迟到时在DMA完成中断中锁存。
+	*				按 LED_BCM_BITS 分别编译，实测刷新率和每秒中断次数
+	*	@author:	XIET
+	*	@version:	V1.0
+	*	@data:		201x-xx-xx
+	*	@modify:	data  			remarks
+**************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include "sim_led.h"
+#include "sim.h"
+
+void bsp_StartTimer(uint8_t _id, uint32_t _period)
+{
+	(void)_id;
+	(void)_period;
+}
+void bsp_StartAutoTimer(uint8_t _id, uint32_t _period)
+{
+	(void)_id;
+	(void)_period;
+}
+void bsp_StopTimer(uint8_t _id)
+{
+	(void)_id;
+}
+uint8_t bsp_CheckTimer(uint8_t _id)
+{
+	return _id == TMR_LED_CTRL;
+}
+void Clock_Demand(uint8_t req, uint8_t on)
+{
+	(void)req;
+	(void)on;
+}
+/* 点亮或熄灭一个LED后立即执行 TMR_LED_CTRL 到时的处理 */
+static void Led_Set(uint8_t on)
+{
+	Display_PixelRGB(2, 7, on ? LED_BCM_MAX : 0, 0, 0);
+	Display_LEDPwr_Ctrl();
+}
+/* 启动：先DMA移入第0行第0平面，DMA完成时锁存并启动定时器 */
+static uint16_t *Test_Start(void)
+{
+	uint16_t *base;
+
+	Led_Set(0);					//停止上一项测试中运行的BCM
+	Sim_Led_Reset();
+	Led_Set(1);
+	CHECK(g_tSimLed.dma_busy);
+	CHECK(g_tSimLed.latch_count == 0);
+	CHECK(!g_tSimLed.timer_run);
+	base = g_tSimLed.dma_buf;
+	Sim_Led_Dma_Done();
+	CHECK(g_tSimLed.latched == base);
+	CHECK((LED_ROW_PORT->ODR & LED_ROW_ALL_PIN) == (LED_ROW_ALL_PIN & ~LED_ROW1_PIN));
+	CHECK(g_tSimLed.timer_run);
+	CHECK((g_tSimLed.timer_us == LED_BCM_UNIT_US) && (g_tSimLed.timer_next_us == (LED_BCM_UNIT_US << 1)));
+	CHECK(g_tSimLed.dma_buf == base + LED_ROW_WORDS);
+	return base;
+}
+/* 正常接力：每个平面按行、平面顺序锁存，中断中从不查询或等待DMA */
+static void Test_Chain(void)
+{
+	uint16_t *base = Test_Start();
+	uint32_t frames = Display_BCM_GetStat()->frames;
+	uint32_t late = Display_BCM_GetStat()->late;
+	uint32_t n;
+
+	for(n = 1; n < 3 * LED_ROWS * LED_BCM_BITS; n++)
+	{
+		Sim_Led_Dma_Done();
+		CHECK(g_tSimLed.latched == base + ((n - 1) % (LED_ROWS * LED_BCM_BITS)) * LED_ROW_WORDS);
+		Sim_Led_Timer_Update();
+		CHECK(g_tSimLed.latched == base + (n % (LED_ROWS * LED_BCM_BITS)) * LED_ROW_WORDS);
+		CHECK(g_tSimLed.timer_next_us == (LED_BCM_UNIT_US << ((n + 1) % LED_BCM_BITS)));
+	}
+	CHECK(Display_BCM_GetStat()->frames == frames + 3);
+	CHECK(Display_BCM_GetStat()->late == late);
+	CHECK(g_tSimLed.isr_poll == 0);
+	CHECK(g_tSimLed.timer_start == 1);
+}
+/* DMA迟到：定时器中断不锁存也不等待，DMA完成时立即锁存 */
+static void Test_Late(void)
+{
+	uint16_t *base = Test_Start();
+	uint32_t late = Display_BCM_GetStat()->late;
+	uint32_t latch = g_tSimLed.latch_count;
+
+	Sim_Led_Timer_Update();		//第1平面的DMA尚未完成
+	CHECK(Display_BCM_GetStat()->late == late + 1);
+	CHECK(g_tSimLed.latch_count == latch);
+	Sim_Led_Dma_Done();
+	CHECK(g_tSimLed.latch_count == latch + 1);
+	CHECK(g_tSimLed.latched == base + LED_ROW_WORDS);
+	CHECK(g_tSimLed.dma_buf == base + 2 * LED_ROW_WORDS);
+	Sim_Led_Dma_Done();			//之后恢复正常接力
+	Sim_Led_Timer_Update();
+	CHECK(g_tSimLed.latched == base + 2 * LED_ROW_WORDS);
+	CHECK(g_tSimLed.isr_poll == 0);
+}
+/* 接力运行1秒：刷新率和定时器中断次数与 user_display.h 的估算一致，并在预算内 */
+static void Test_Rate(void)
+{
+	uint32_t frames;
+	uint32_t hz;
+	uint32_t irq;
+	uint32_t load;
+
+	Test_Start();
+	frames = Display_BCM_GetStat()->frames;
+	while(g_tSimLed.elapsed_us < 1000000)
+	{
+		Sim_Led_Dma_Done();
+		Sim_Led_Timer_Update();
+	}
+	hz = Display_BCM_GetStat()->frames - frames;
+	irq = g_tSimLed.timer_irq;
+	load = irq * LED_BCM_ISR_CYCLES / (LED_BCM_CPU_MHZ * 1000);
+	printf("test_display: %u bits, refresh %u Hz (model %u), %u timer + %u DMA irq/s (model %u), load %u permil\n",
+		LED_BCM_BITS, hz, LED_BCM_REFRESH_HZ, irq, g_tSimLed.dma_irq, LED_BCM_IRQ_PER_SEC, load);
+	CHECK((hz + 1 >= LED_BCM_REFRESH_HZ) && (hz <= LED_BCM_REFRESH_HZ + 1));
+	CHECK(irq + LED_ROWS * LED_BCM_BITS >= LED_BCM_IRQ_PER_SEC);		//误差不超过一帧的中断
+	CHECK(irq <= LED_BCM_IRQ_PER_SEC + LED_ROWS * LED_BCM_BITS);
+	CHECK(g_tSimLed.dma_irq <= irq + 1);
+	CHECK(hz >= LED_BCM_REFRESH_MIN_HZ);
+	CHECK(load <= LED_BCM_LOAD_MAX_PERMIL);
+	CHECK(Display_BCM_GetStat()->late == 0);
+	CHECK(g_tSimLed.isr_poll == 0);
+}
+/* 停止：DMA进行中也不等待，关闭全部行，之后的中断不再锁存 */
+static void Test_Stop(void)
+{
+	uint32_t latch;
+
+	Test_Start();
+	CHECK(g_tSimLed.dma_busy);
+	Led_Set(0);
+	CHECK(!g_tSimLed.dma_busy);
+	CHECK(!g_tSimLed.timer_run);
+	CHECK((LED_ROW_PORT->ODR & LED_ROW_ALL_PIN) == LED_ROW_ALL_PIN);
+	latch = g_tSimLed.latch_count;
+	Display_BCM_ISR();
+	Display_BCM_DMA_ISR();
+	CHECK(g_tSimLed.latch_count == latch);
+	Test_Start();				//可以再次启动
+}
+
+int main(void)
+{
+	Display_Init();
+	Test_Chain();
+	Test_Rate();
+	Test_Late();
+	Test_Stop();
+	printf("test_display: %s\n", s_iFail ? "FAIL" : "OK");
+	return s_iFail ? EXIT_FAILURE : EXIT_SUCCESS;
+}
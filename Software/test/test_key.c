@@ -0,0 +1,201 @@
+/************************************************************
+	*	@file:		test_key.c
+	*	@brief:		按键扫描主机测试：空闲进入列中断等待、列中断唤醒恢复扫描、
+	*				STOP唤醒后的同步扫描。每种消抖算法单独编译
+	*	@author:	XIET
+	*	@version:	V1.0
+	*	@data:		201x-xx-xx
+	*	@modify:	data  			remarks
+**************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include "sim.h"
+
+static uint32_t s_uiPress;		//取出的按下事件数
+static uint32_t s_uiRelease;	//取出的释放事件数
+static uint8_t s_ucState[MATRIX_ROWS][MATRIX_COLS];	//由事件还原的按键状态
+static uint32_t s_uiOrderErr;	//同一按键重复按下或释放、同一轮内行列顺序颠倒
+
+/* 与 Keyboard_Task 相同的主循环：扫描完成后取出事件并做空闲检测 */
+static void Loop_Once(void)
+{
+	KEY_EVENT_REC rec;
+	KEY_EVENT_REC prev = {0};
+	uint8_t first = 1;
+
+	if(Key_Scan_Done())
+	{
+		while(Key_Event_Get(&rec))
+		{
+			if(s_ucState[rec.row][rec.col] == rec.pressed)
+			{
+				s_uiOrderErr++;
+			}
+			if(!first && (rec.seq == prev.seq) && ((rec.row << 4 | rec.col) <= (prev.row << 4 | prev.col)))
+			{
+				s_uiOrderErr++;
+			}
+			s_ucState[rec.row][rec.col] = rec.pressed;
+			prev = rec;
+			first = 0;
+			if(rec.pressed)
+			{
+				s_uiPress++;
+			}
+			else
+			{
+				s_uiRelease++;
+			}
+		}
+		Key_Scan_Idle_Check();
+	}
+}
+/* 按2ms定时扫描运行ms，定时器停止后不再扫描 */
+static void Run_Ms(uint32_t ms)
+{
+	for(uint32_t t = 0; t < ms; t += TMR_PERIOD_2MS)
+	{
+		Sim_Advance_Us(TMR_PERIOD_2MS * 1000 - MATRIX_ROWS * KEY_SETTLE_US);
+		if(Key_Scan_Resume() || g_ucSimScanTimer)
+		{
+			Sim_Scan();
+		}
+		Loop_Once();
+	}
+}
+static void Reset(void)
+{
+	Sim_Reset();
+	Key_Scan_Init();
+	s_uiPress = 0;
+	s_uiRelease = 0;
+	s_uiOrderErr = 0;
+	memset(s_ucState, 0, sizeof(s_ucState));
+}
+/* 全部释放 KEY_IDLE_TIME 后停止定时扫描，行全选中并使能列中断 */
+static void Test_Idle(void)
+{
+	uint32_t idle;
+
+	Reset();
+	idle = Key_Scan_GetStat()->idle_count;
+	g_usSimKey[3] = 1 << 4;
+	Run_Ms(40);
+	CHECK(s_uiPress == 1);
+	Run_Ms(2 * KEY_IDLE_TIME);
+	CHECK(!Key_Scan_IsIdle());		//按住时不进入中断等待
+	g_usSimKey[3] = 0;
+	Run_Ms(KEY_IDLE_TIME / 2);
+	CHECK(s_uiRelease == 1);
+	CHECK(!Key_Scan_IsIdle());
+	Run_Ms(KEY_IDLE_TIME);
+	CHECK(Key_Scan_IsIdle());
+	CHECK(!g_ucSimScanTimer);
+	CHECK(g_ucSimExti);
+	CHECK((KEY_ROW_PORT->ODR & KEY_ROW_ALL_PIN) == KEY_ROW_ALL_PIN);
+	CHECK(Key_Scan_GetStat()->idle_count == idle + 1);
+}
+/* 列中断唤醒：恢复定时扫描，唤醒键的按下和释放都上报 */
+static void Test_Wake(void)
+{
+	uint32_t scans;
+	uint32_t wake;
+
+	Test_Idle();
+	wake = Key_Scan_GetStat()->wake_count;
+	scans = Key_Scan_GetStat()->scan_count;
+	Run_Ms(100);
+	CHECK(Key_Scan_GetStat()->scan_count == scans);		//中断等待期间不扫描
+	g_usSimKey[0] = 1 << 9;
+	Key_Scan_Wakeup((uint16_t)LL_GPIO_ReadInputPort(KEY_COL_PORT));		//EXTI中断
+	CHECK(Sim_Take_Event(EVT_KEY_WAKE));
+	CHECK(!g_ucSimExti);
+	Run_Ms(20);
+	CHECK(!Key_Scan_IsIdle());
+	CHECK(g_ucSimScanTimer);
+	CHECK(s_uiPress == 2);
+	g_usSimKey[0] = 0;
+	Run_Ms(20);
+	CHECK(s_uiRelease == 2);
+	CHECK(Key_Scan_GetStat()->wake_count == wake + 1);
+}
+/* 使能列中断前已有按键按下：不会再有上升沿，立即唤醒 */
+static void Test_Wake_Held(void)
+{
+	Reset();
+	Run_Ms(KEY_IDLE_TIME - TMR_PERIOD_2MS);
+	CHECK(!Key_Scan_IsIdle());
+	Sim_Advance_Us(2 * TMR_PERIOD_2MS * 1000);
+	g_usSimKey[5] = 1 << 0;		//最后一轮扫描之后、使能中断之前按下
+	Key_Scan_Idle_Check();
+	CHECK(Key_Scan_IsIdle());
+	Run_Ms(TMR_PERIOD_2MS);
+	CHECK(Sim_Take_Event(EVT_KEY_WAKE));
+	Run_Ms(20);
+	CHECK(!Key_Scan_IsIdle());
+	CHECK(s_uiPress == 1);
+}
+/* STOP唤醒：同步扫描一轮即上报唤醒键，恢复定时扫描前已释放也不丢失 */
+static void Test_Capture(void)
+{
+	Test_Idle();
+	Key_Scan_Suspend();
+	GPIO_Config_EXTI();			//进入STOP前行全选中，列中断唤醒
+	g_usSimKey[2] = 1 << 6;
+	Key_Scan_Wakeup((uint16_t)LL_GPIO_ReadInputPort(KEY_COL_PORT));
+	CHECK(Key_Scan_Capture() == 1);
+	CHECK(Sim_Take_Event(EVT_MATRIX));
+	Loop_Once();
+	CHECK(s_uiPress == 2);
+	g_usSimKey[2] = 0;
+	CHECK(Key_Scan_Resume());
+	Run_Ms(DEBOUNCE_MS + 10);
+	CHECK(s_uiRelease == 2);
+	g_usSimKey[2] = 1 << 6;		//之后的按键照常消抖
+	Run_Ms(DEBOUNCE_MS + 10);
+	CHECK(s_uiPress == 3);
+}
+/* 事件环：一轮变化超过环深度时其余事件推迟到下一轮，下标回绕后不丢失、不颠倒 */
+static void Test_Ring(void)
+{
+	uint32_t overflow;
+
+	Reset();
+	Run_Ms(20);					//前面测试留下的按键先释放，Key_Scan_Init 不清除已上报的状态
+	s_uiOrderErr = 0;
+	s_uiPress = 0;
+	s_uiRelease = 0;
+	overflow = Key_Scan_GetStat()->event_overflow;
+	g_usSimKey[0] = 0xFFFF;
+	g_usSimKey[1] = 0xFFFF;
+	g_usSimKey[2] = 0x00FF;
+	Run_Ms(DEBOUNCE_MS + 10);
+	CHECK(s_uiPress == 40);
+	CHECK(Key_Scan_GetStat()->event_overflow - overflow >= 40 - KEY_EVENT_RING_SIZE);
+	CHECK(Key_Scan_GetStat()->event_high == KEY_EVENT_RING_SIZE);
+	memset(g_usSimKey, 0, sizeof(g_usSimKey));
+	Run_Ms(DEBOUNCE_MS + 10);
+	CHECK(s_uiRelease == 40);
+	for (uint32_t i = 0; i < 100; i++)		//入环600个事件，8位下标回绕两次
+	{
+		g_usSimKey[i % MATRIX_ROWS] = 0x8001;
+		g_usSimKey[(i + 3) % MATRIX_ROWS] = 0x0180;
+		Run_Ms(2 * DEBOUNCE_MS);
+		memset(g_usSimKey, 0, sizeof(g_usSimKey));
+		Run_Ms(2 * DEBOUNCE_MS);
+	}
+	CHECK(s_uiPress == 40 + 400);
+	CHECK(s_uiRelease == 40 + 400);
+	CHECK(s_uiOrderErr == 0);
+}
+
+int main(void)
+{
+	Test_Idle();
+	Test_Wake();
+	Test_Capture();
+	Test_Wake_Held();
+	Test_Ring();
+	printf("test_key: %s\n", s_iFail ? "FAIL" : "OK");
+	return s_iFail ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,348 @@
+/************************************************************
+	*	@file:		test_keyboard.c
+	*	@brief:		键盘任务主机测试：直接包含 keyboard.c，把密集的滚键和快速
+	*				敲击事件逐轮写入事件环，端点每个报告随机忙若干帧，报告队列
+	*				反复写满。由主机收到的NKRO报告还原按下/释放序列，必须与
+	*				输入一致，队列满时不能丢失任何按键变化
+	*	@author:	XIET
+	*	@version:	V1.0
+	*	@data:		201x-xx-xx
+	*	@modify:	data  			remarks
+**************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include "keyboard.c"
+#include "sim.h"
+
+#define TRACE_SCANS		20000		//输入的扫描轮数
+#define TRACE_KEYS		24			//参与的按键，键值 KC_A 起
+#define EVENT_MAX		(TRACE_SCANS * 4)
+#define BUSY_FRAMES_MAX	12			//端点发送一个报告最多忙的帧数
+#define TAP_ONE_IN		3			//按下的键在下一轮释放的比例
+
+PCD_HandleTypeDef hpcd;
+USBD_HandleTypeDef USBD_Device;
+WORKE_MODE g_Work_Mode;
+
+/* 事件环替身：测试写入的全部事件，keyboard.c 按序取出 */
+static KEY_EVENT_REC s_tEvent[EVENT_MAX];
+static uint32_t s_uiEventWrite;
+static uint32_t s_uiEventRead;
+static uint8_t s_ucScanDone;
+
+/* 输入和主机看到的按键变化：键值 | 0x100 表示按下 */
+static uint16_t s_usInput[EVENT_MAX];
+static uint32_t s_uiInputCnt;
+static uint16_t s_usHost[EVENT_MAX];
+static uint32_t s_uiHostCnt;
+static uint8_t s_ucHostBits[HID_NKRO_KEY_MAX / 8];
+static uint8_t s_ucHostMod;
+static uint32_t s_uiHostReports;
+
+/* 端点：发送中的报告在随机帧数后完成 */
+static uint8_t s_ucEpBusy;
+static uint8_t s_ucEpFrames;
+
+uint8_t Key_Scan_Done(void)
+{
+	uint8_t ready = s_ucScanDone;
+
+	s_ucScanDone = 0;
+	return ready;
+}
+uint8_t Key_Event_Peek(KEY_EVENT_REC *rec)
+{
+	if(s_uiEventRead == s_uiEventWrite)
+	{
+		return 0;
+	}
+	*rec = s_tEvent[s_uiEventRead];
+	return 1;
+}
+uint8_t Key_Event_Get(KEY_EVENT_REC *rec)
+{
+	if(!Key_Event_Peek(rec))
+	{
+		return 0;
+	}
+	s_uiEventRead++;
+	return 1;
+}
+void Key_Scan_Idle_Check(void)
+{
+}
+void Key_Scan(void)
+{
+}
+uint8_t Key_Scan_Resume(void)
+{
+	return 0;
+}
+uint8_t Key_Scan_IsIdle(void)
+{
+	return 0;
+}
+void Debounce_SetPeriod(uint8_t period_ms)
+{
+	(void)period_ms;
+}
+void bsp_StartTimer(uint8_t _id, uint32_t _period)
+{
+	(void)_id;
+	(void)_period;
+}
+uint8_t bsp_CheckTimer(uint8_t _id)
+{
+	(void)_id;
+	return 0;
+}
+int32_t bsp_GetRunTime(void)
+{
+	return 0;
+}
+/* 第row行第col列的按键为 KC_A + row * MATRIX_COLS + col，不经过层 */
+uint8_t Layer_Press(uint8_t row, uint8_t col)
+{
+	return (uint8_t)(KC_A + row * MATRIX_COLS + col);
+}
+uint8_t Layer_Release(uint8_t row, uint8_t col)
+{
+	return Layer_Press(row, col);
+}
+void Macro_Play(uint8_t id)
+{
+	(void)id;
+}
+void Macro_Merge(uint8_t *mod, uint8_t *bits)
+{
+	(void)mod;
+	(void)bits;
+}
+void Display_SetWorkMode(uint8_t mode)
+{
+	(void)mode;
+}
+void Display_ChangeSnakeColor(void)
+{
+}
+void Display_ChangeStaticColor(void)
+{
+}
+void Display_Indicate_LED(uint8_t led, uint8_t state)
+{
+	(void)led;
+	(void)state;
+}
+void Clock_Demand(uint8_t req, uint8_t on)
+{
+	(void)req;
+	(void)on;
+}
+void Link_SendReport(uint8_t *report)
+{
+	(void)report;
+}
+void Link_SendExt(uint8_t *report, uint8_t len)
+{
+	(void)report;
+	(void)len;
+}
+void Pwr_Wake_Report(uint8_t stage)
+{
+	(void)stage;
+}
+void Event_Post(uint32_t evt)
+{
+	(void)evt;
+}
+uint8_t USBD_HID_GetProtocol(USBD_HandleTypeDef *pdev)
+{
+	(void)pdev;
+	return HID_PROTOCOL_REPORT;
+}
+/* 主机收到报告：与上一个报告比较，按键值顺序记录变化 */
+uint8_t USBD_HID_SendReport(USBD_HandleTypeDef *pdev, uint8_t *report, uint16_t len)
+{
+	uint8_t code;
+	uint8_t now;
+	uint8_t was;
+
+	(void)pdev;
+	CHECK(!s_ucEpBusy);
+	CHECK((len == HID_NKRO_REPORT_LEN) && (report[0] == HID_NKRO_REPORT_ID));
+	s_ucEpBusy = 1;
+	s_ucEpFrames = 1 + rand() % BUSY_FRAMES_MAX;
+	s_uiHostReports++;
+	s_ucHostMod = report[1];
+	for (uint16_t k = 0; k < HID_NKRO_KEY_MAX; k++)
+	{
+		code = (uint8_t)k;
+		now = (report[2 + (code >> 3)] >> (code & 0x07)) & 0x01;
+		was = (s_ucHostBits[code >> 3] >> (code & 0x07)) & 0x01;
+		if(now != was)
+		{
+			s_usHost[s_uiHostCnt++] = code | (now ? 0x100 : 0);
+		}
+	}
+	memcpy(s_ucHostBits, &report[2], sizeof(s_ucHostBits));
+	return USBD_OK;
+}
+/* 一帧：端点忙的报告计时，到时完成发送 */
+static void Frame(void)
+{
+	if(s_ucEpBusy && (--s_ucEpFrames == 0))
+	{
+		s_ucEpBusy = 0;
+		Report_Queue_TxCplt();
+	}
+	Keyboard_Task();
+}
+/* 一轮扫描的事件，按行列顺序写入事件环，同时按同样顺序记入输入序列 */
+static void Scan(uint8_t seq, const uint8_t *down_now, uint8_t *down)
+{
+	KEY_EVENT_REC *p_rec;
+
+	for (uint8_t k = 0; k < TRACE_KEYS; k++)
+	{
+		if(down_now[k] == down[k])
+		{
+			continue;
+		}
+		down[k] = down_now[k];
+		p_rec = &s_tEvent[s_uiEventWrite++];
+		p_rec->time = 0;
+		p_rec->row = k / MATRIX_COLS;
+		p_rec->col = k % MATRIX_COLS;
+		p_rec->pressed = down[k];
+		p_rec->seq = seq;
+	}
+	s_ucScanDone = 1;
+}
+/* 每个按键的按下/释放序列相同，按下的先后顺序相同 */
+static void Check_Sequence(void)
+{
+	uint32_t i;
+	uint32_t n;
+	uint32_t in_cnt[TRACE_KEYS] = {0};
+	uint32_t host_cnt[TRACE_KEYS] = {0};
+	uint32_t mismatch = 0;
+	uint32_t host_press = 0;
+	uint8_t code;
+
+	for (i = 0; i < s_uiHostCnt; i++)
+	{
+		code = (uint8_t)s_usHost[i];
+		CHECK((code >= KC_A) && (code < KC_A + TRACE_KEYS));
+	}
+	for (uint8_t k = 0; k < TRACE_KEYS; k++)		//同一按键的按下和释放交替出现，次数相同即序列相同
+	{
+		for (i = 0; i < s_uiInputCnt; i++)
+		{
+			if((uint8_t)s_usInput[i] == KC_A + k)
+			{
+				in_cnt[k]++;
+			}
+		}
+		for (i = 0; i < s_uiHostCnt; i++)
+		{
+			if((uint8_t)s_usHost[i] == KC_A + k)
+			{
+				host_cnt[k]++;
+			}
+		}
+		if(in_cnt[k] != host_cnt[k])
+		{
+			mismatch++;
+		}
+	}
+	for (n = 0, i = 0; i < s_uiInputCnt; i++)		//按下的顺序：跳过同一报告内的先后
+	{
+		if(!(s_usInput[i] & 0x100))
+		{
+			continue;
+		}
+		while((host_press < s_uiHostCnt) && !(s_usHost[host_press] & 0x100))
+		{
+			host_press++;
+		}
+		if((host_press == s_uiHostCnt) || (s_usHost[host_press] != s_usInput[i]))
+		{
+			n++;
+		}
+		host_press++;
+	}
+	CHECK(mismatch == 0);
+	CHECK(n == 0);
+	CHECK(s_uiHostCnt == s_uiInputCnt);
+	for (i = 0; i < sizeof(s_ucHostBits); i++)
+	{
+		CHECK(s_ucHostBits[i] == 0);
+	}
+	CHECK(s_ucHostMod == 0);
+}
+/* 滚键和快速敲击：每轮扫描按下0~3个键，部分下一轮就释放，其余按住几轮 */
+static void Test_Busy_Endpoint(void)
+{
+	static uint8_t down[TRACE_KEYS];
+	static uint8_t down_now[TRACE_KEYS];
+	static uint8_t hold[TRACE_KEYS];
+	uint8_t seq = 0;
+	uint8_t k;
+	uint8_t n;
+
+	srand(1);
+	Report_Queue_Init();
+	for (uint32_t s = 0; s < TRACE_SCANS; s++)
+	{
+		for (k = 0; k < TRACE_KEYS; k++)
+		{
+			if(down_now[k] && (hold[k] == 0 || --hold[k] == 0))
+			{
+				down_now[k] = 0;
+			}
+		}
+		for (n = rand() % 4; n; n--)
+		{
+			k = rand() % TRACE_KEYS;
+			if(!down_now[k] && !down[k])
+			{
+				down_now[k] = 1;
+				hold[k] = (rand() % TAP_ONE_IN) ? 1 + rand() % 6 : 1;
+			}
+		}
+		for (k = 0; k < TRACE_KEYS; k++)		//本轮的变化按行列顺序记入输入
+		{
+			if(down_now[k] != down[k])
+			{
+				s_usInput[s_uiInputCnt++] = (KC_A + k) | (down_now[k] ? 0x100 : 0);
+			}
+		}
+		Scan(++seq, down_now, down);
+		Frame();
+	}
+	memset(down_now, 0, sizeof(down_now));		//全部释放
+	for (k = 0; k < TRACE_KEYS; k++)
+	{
+		if(down[k])
+		{
+			s_usInput[s_uiInputCnt++] = KC_A + k;
+		}
+	}
+	Scan(++seq, down_now, down);
+	for (uint32_t f = 0; f < EVENT_MAX && (!Report_Queue_Idle() || s_uiEventRead != s_uiEventWrite || s_ucReportPending); f++)
+	{
+		Frame();
+	}
+	CHECK(s_uiEventRead == s_uiEventWrite);
+	CHECK(Report_Queue_GetOverflow() > 0);		//队列确实写满过
+	Check_Sequence();
+	printf("test_keyboard: %u key changes in %u scans, %u reports, queue full %u times\n",
+		s_uiInputCnt, TRACE_SCANS, s_uiHostReports, Report_Queue_GetOverflow());
+}
+
+int main(void)
+{
+	Test_Busy_Endpoint();
+	printf("test_keyboard: %s\n", s_iFail ? "FAIL" : "OK");
+	return s_iFail ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,108 @@
+/************************************************************
+	*	@file:		test_latency.c
+	*	@brief:		按键到USB总线延迟的主机模型：按键在扫描周期内任意时刻按下，
+	*				经扫描、消抖(user_debounce.c)和主机轮询后出现在总线上。
+	*				标准模式按 TMR_KEY_SCAN 扫描，主机轮询相位任意；低延迟模式
+	*				扫描与SOF对齐，报告在下一帧发出。打印最坏和平均延迟，并与
+	*				keyboard.h 中的 KEY_LATENCY_WORST_US/KEY_LATENCY_MEAN_US 比较。
+	*				按 HID_LOW_LATENCY 和 DEBOUNCE_ALGORITHM 分别编译
+	*	@author:	XIET
+	*	@version:	V1.0
+	*	@data:		201x-xx-xx
+	*	@modify:	data  			remarks
+**************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include "sim.h"
+
+#define STEP_US			50		//按下时刻和轮询相位的取样间隔
+#define SCAN_MAX		64		//消抖最多等待的扫描次数
+
+/* 从第一次看到按键的扫描起，消抖后上报所需的扫描次数(0：当轮上报) */
+static int Debounce_Scans(void)
+{
+	uint16_t raw[MATRIX_ROWS] = {0};
+	uint16_t matrix[MATRIX_ROWS] = {0};
+
+	Debounce_Init();
+#if HID_LOW_LATENCY == 1
+	Debounce_SetPeriod(KEY_SCAN_SOF_PERIOD_MS);
+#else
+	Debounce_SetPeriod(KEY_SCAN_PERIOD_MS);
+#endif
+	Debounce_Matrix(raw, matrix);		//按下前的一轮
+	raw[3] = 1 << 7;
+	for (int n = 0; n < SCAN_MAX; n++)
+	{
+		Debounce_Matrix(raw, matrix);
+		if(matrix[3] & (1 << 7))
+		{
+			return n;
+		}
+	}
+	return -1;
+}
+/* 扫描在 k * KEY_SCAN_PERIOD_US，按键在第0轮之后 press_us 按下，
+   返回按下到报告出现在总线上的时间 */
+static uint32_t Latency_Us(uint32_t press_us, uint32_t poll_phase_us, int scans)
+{
+	uint32_t report_us;
+
+	report_us = KEY_SCAN_PERIOD_US + scans * KEY_SCAN_PERIOD_US;		//第一次看到按键的扫描，再消抖
+#if HID_LOW_LATENCY == 1
+	(void)poll_phase_us;
+	report_us += KEY_POLL_PERIOD_US;		//与SOF对齐：本帧扫描，下一帧的IN令牌取走
+#else
+	if(report_us > poll_phase_us)			//下一次主机轮询
+	{
+		report_us = poll_phase_us + (report_us - poll_phase_us + KEY_POLL_PERIOD_US - 1) / KEY_POLL_PERIOD_US * KEY_POLL_PERIOD_US;
+	}
+	else
+	{
+		report_us = poll_phase_us;
+	}
+#endif
+	return report_us - press_us;
+}
+
+static void Test_Latency(void)
+{
+	int scans = Debounce_Scans();
+	uint32_t worst = 0;
+	uint64_t sum = 0;
+	uint32_t cnt = 0;
+	uint32_t lat;
+	uint32_t mean;
+
+	CHECK(scans >= 0);
+	CHECK((uint32_t)scans * KEY_SCAN_PERIOD_US == KEY_DEBOUNCE_DELAY_US);
+	for (uint32_t press = STEP_US / 2; press < KEY_SCAN_PERIOD_US; press += STEP_US)
+	{
+		for (uint32_t phase = STEP_US / 2; phase < KEY_POLL_PERIOD_US; phase += STEP_US)
+		{
+			lat = Latency_Us(press, phase, scans);
+			if(lat > worst)
+			{
+				worst = lat;
+			}
+			sum += lat;
+			cnt++;
+		}
+	}
+	mean = (uint32_t)(sum / cnt);
+	printf("test_latency: %s, %s debounce: worst %u us (model %u), mean %u us (model %u)\n",
+		(HID_LOW_LATENCY == 1) ? "low latency" : "standard",
+		(DEBOUNCE_ALGORITHM == DEBOUNCE_EAGER) ? "eager" : (DEBOUNCE_ALGORITHM == DEBOUNCE_DEFER) ? "defer" : "symmetric",
+		worst, KEY_LATENCY_WORST_US, mean, KEY_LATENCY_MEAN_US);
+	CHECK(worst <= KEY_LATENCY_WORST_US);
+	CHECK(worst + STEP_US >= KEY_LATENCY_WORST_US);
+	CHECK(mean + STEP_US >= KEY_LATENCY_MEAN_US);
+	CHECK(mean <= KEY_LATENCY_MEAN_US + STEP_US);
+}
+
+int main(void)
+{
+	Test_Latency();
+	printf("test_latency: %s\n", s_iFail ? "FAIL" : "OK");
+	return s_iFail ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,127 @@
+/************************************************************
+	*	@file:		test_layer.c
+	*	@brief:		层解析主机测试：瞬时层、切换层、单次层和透明键，缓存只在层
+	*				状态变化时重建，按下只查表；没有动作的Fn键不查 fn_actions
+	*	@author:	XIET
+	*	@version:	V1.0
+	*	@data:		201x-xx-xx
+	*	@modify:	data  			remarks
+**************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include "sim.h"
+
+static uint8_t s_ucKeymap[KEYMAP_LAYERS][MATRIX_ROWS][MATRIX_COLS];
+
+const uint8_t fn_actions[FN_ACTION_COUNT] = {
+	ACTION_LAYER_MOMENTARY(1),		//FN0
+	ACTION_LAYER_TOGGLE(2),			//FN1
+	ACTION_LAYER_ONESHOT(1),		//FN2
+};
+
+uint8_t Keymap_Key(uint8_t layer, uint8_t row, uint8_t col)
+{
+	return s_ucKeymap[layer][row][col];
+}
+/* 层0：A FN0 FN1 FN2 FN14，其余 KC_NO；层1：(0,0)为B；层2：(0,0)为C；其余透明 */
+static void Reset(void)
+{
+	memset(s_ucKeymap, KC_TRNS, sizeof(s_ucKeymap));
+	memset(s_ucKeymap[0], KC_NO, sizeof(s_ucKeymap[0]));
+	s_ucKeymap[0][0][0] = KC_A;
+	s_ucKeymap[0][0][1] = KC_FN0;
+	s_ucKeymap[0][0][2] = KC_FN1;
+	s_ucKeymap[0][0][3] = KC_FN2;
+	s_ucKeymap[0][0][4] = KC_FN14;
+	s_ucKeymap[1][0][0] = KC_B;
+	s_ucKeymap[2][0][0] = KC_C;
+	Layer_Init();
+}
+static uint8_t Tap(uint8_t row, uint8_t col)
+{
+	uint8_t code = Layer_Press(row, col);
+
+	CHECK(Layer_Release(row, col) == code);
+	return code;
+}
+/* 瞬时层：按住Fn期间生效，按下和释放只重建一次，按下普通键不重建 */
+static void Test_Momentary(void)
+{
+	uint32_t rebuild;
+
+	Reset();
+	rebuild = Layer_GetStat()->rebuild;
+	CHECK(Tap(0, 0) == KC_A);
+	CHECK(Tap(0, 5) == KC_NO);
+	CHECK(Layer_GetStat()->rebuild == rebuild);
+	Layer_Press(0, 1);
+	CHECK(Layer_GetState() == 0x02);
+	CHECK(Layer_GetStat()->rebuild == rebuild + 1);
+	CHECK(Layer_Press(0, 0) == KC_B);
+	CHECK(Tap(1, 0) == KC_NO);				//层1透明，落到层0
+	CHECK(Layer_GetStat()->rebuild == rebuild + 1);
+	Layer_Release(0, 1);
+	CHECK(Layer_GetState() == 0);
+	CHECK(Layer_Release(0, 0) == KC_B);		//释放时使用按下时的键值
+	CHECK(Layer_GetStat()->rebuild == rebuild + 2);
+}
+/* 切换层和单次层 */
+static void Test_Toggle_OneShot(void)
+{
+	Reset();
+	Tap(0, 2);
+	CHECK(Layer_GetState() == 0x04);
+	CHECK(Tap(0, 0) == KC_C);
+	Tap(0, 2);
+	CHECK(Tap(0, 0) == KC_A);
+	Tap(0, 3);
+	CHECK(Layer_GetState() == 0x02);
+	CHECK(Tap(0, 0) == KC_B);				//下一个按键使用单次层后关闭
+	CHECK(Layer_GetState() == 0);
+	CHECK(Tap(0, 0) == KC_A);
+}
+/* 超出 fn_actions 的Fn键不是Fn动作，不改变层状态 */
+static void Test_Fn_Bound(void)
+{
+	uint32_t rebuild;
+
+	Reset();
+	CHECK(IS_FN(KC_FN0) && IS_FN(KC_FN0 + FN_ACTION_COUNT - 1));
+	CHECK(!IS_FN(KC_FN0 + FN_ACTION_COUNT) && !IS_FN(KC_FN31) && !IS_FN(KC_NO) && !IS_FN(KC_FN0 - 1));
+	rebuild = Layer_GetStat()->rebuild;
+	CHECK(Tap(0, 4) == KC_FN14);
+	CHECK(Layer_GetState() == 0);
+	CHECK(Layer_GetStat()->rebuild == rebuild);
+}
+/* 所有打开的层都是 KC_TRNS 时为 KC_NO */
+static void Test_All_Trns(void)
+{
+	Reset();
+	s_ucKeymap[0][1][0] = KC_TRNS;
+	CHECK(Tap(1, 0) == KC_NO);
+	Tap(0, 2);
+	Layer_Press(0, 1);
+	CHECK(Layer_GetState() == 0x06);
+	CHECK(Tap(1, 0) == KC_NO);
+	Layer_Release(0, 1);
+}
+/* 键值表修改后立即重建 */
+static void Test_Refresh(void)
+{
+	Reset();
+	s_ucKeymap[0][0][0] = KC_Z;
+	CHECK(Tap(0, 0) == KC_A);
+	Layer_Refresh();
+	CHECK(Tap(0, 0) == KC_Z);
+}
+
+int main(void)
+{
+	Test_Momentary();
+	Test_Toggle_OneShot();
+	Test_Fn_Bound();
+	Test_All_Trns();
+	Test_Refresh();
+	printf("test_layer: %s\n", s_iFail ? "FAIL" : "OK");
+	return s_iFail ? EXIT_FAILURE : EXIT_SUCCESS;
+}
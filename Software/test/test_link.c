@@ -0,0 +1,316 @@
+/************************************************************
+	*	@file:		test_link.c
+	*	@brief:		报告链路主机测试：组帧解帧、CRC和序号检查、增量与快照、
+	*				RESYNC时由键盘当前状态重新生成快照，线路字节出错或丢失后的恢复
+	*	@author:	XIET
+	*	@version:	V1.0
+	*	@data:		201x-xx-xx
+	*	@modify:	data  			remarks
+**************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include "sim.h"
+
+/* 串口：发出的字节进入线路，可注入错误；BLE端发来的字节由 comGetChar 取出 */
+static uint8_t s_ucWire[1024];
+static uint16_t s_usWireLen;
+static int s_iCorrupt = -1;				//线路上第n个字节取反
+static int s_iDrop = -1;				//从发出的第n个字节起丢失
+static int s_iDropLen;					//丢失的字节数
+static uint16_t s_usTxPos;				//本次接收前发出的字节数，含丢失的
+static uint8_t s_ucRx[64];
+static uint8_t s_ucRxLen;
+static uint8_t s_ucRxRead;
+static uint8_t s_ucTimer;
+
+/* 键盘当前状态 */
+static uint8_t s_ucBoot[LINK_REPORT_LEN];
+static uint8_t s_ucConsumer;
+
+/* BLE端：按序号应用快照和增量，失步时请求重发 */
+static LINK_PARSER s_tPeer;
+static uint8_t s_ucPeerReport[LINK_REPORT_LEN];
+static uint8_t s_ucPeerConsumer[HID_CONSUMER_REPORT_LEN];
+static uint8_t s_ucPeerSeq;
+static uint8_t s_ucPeerSynced;
+static uint32_t s_uiPeerResync;
+static uint32_t s_uiPeerSnapshot;
+
+void comSendBuf(COM_PORT_E _ucPort, uint8_t *_ucaBuf, uint16_t _usLen)
+{
+	(void)_ucPort;
+	for(uint16_t i = 0; i < _usLen; i++, s_usTxPos++)
+	{
+		if((s_iDrop >= 0) && (s_usTxPos >= s_iDrop) && (s_usTxPos < s_iDrop + s_iDropLen))
+		{
+			continue;
+		}
+		s_ucWire[s_usWireLen] = _ucaBuf[i] ^ ((s_usWireLen == s_iCorrupt) ? 0xFF : 0);
+		s_usWireLen++;
+	}
+}
+uint8_t comSendBufNoCopy(COM_PORT_E _ucPort, uint8_t *_ucaBuf, uint16_t _usLen)
+{
+	comSendBuf(_ucPort, _ucaBuf, _usLen);
+	return 1;
+}
+uint8_t comNoCopyBusy(COM_PORT_E _ucPort)
+{
+	(void)_ucPort;
+	return 0;
+}
+uint8_t comGetChar(COM_PORT_E _ucPort, uint8_t *_pByte)
+{
+	(void)_ucPort;
+	if(s_ucRxRead >= s_ucRxLen)
+	{
+		return 0;
+	}
+	*_pByte = s_ucRx[s_ucRxRead++];
+	return 1;
+}
+uint8_t bsp_CheckTimer(uint8_t _id)
+{
+	uint8_t ret = s_ucTimer;
+
+	(void)_id;
+	s_ucTimer = 0;
+	return ret;
+}
+void bsp_StartTimer(uint8_t _id, uint32_t _period)
+{
+	(void)_id;
+	(void)_period;
+}
+void bsp_StopTimer(uint8_t _id)
+{
+	(void)_id;
+}
+void Keyboard_Get_Boot(uint8_t *buf)
+{
+	memcpy(buf, s_ucBoot, LINK_REPORT_LEN);
+}
+uint8_t Keyboard_Get_Usage(uint8_t id, uint8_t *buf)
+{
+	memset(buf, 0, HID_CONSUMER_REPORT_LEN);
+	buf[0] = id;
+	if(id == HID_SYSTEM_REPORT_ID)
+	{
+		return HID_SYSTEM_REPORT_LEN;
+	}
+	buf[1] = s_ucConsumer;
+	return HID_CONSUMER_REPORT_LEN;
+}
+/* BLE端收完线路上的字节，失步时回复RESYNC */
+static void Peer_Receive(void)
+{
+	uint8_t lost = 0;
+	uint8_t payload[1];
+
+	for(uint16_t i = 0; i < s_usWireLen; i++)
+	{
+		if(!Link_Parse_Byte(&s_tPeer, s_ucWire[i]))
+		{
+			continue;
+		}
+		if(s_ucPeerSynced && (s_tPeer.seq != (uint8_t)(s_ucPeerSeq + 1)))
+		{
+			s_ucPeerSynced = 0;
+		}
+		s_ucPeerSeq = s_tPeer.seq;
+		if(s_tPeer.type == LINK_TYPE_SNAPSHOT)
+		{
+			memcpy(s_ucPeerReport, s_tPeer.payload, LINK_REPORT_LEN);
+			s_ucPeerSynced = 1;
+			s_uiPeerSnapshot++;
+		}
+		else if((s_tPeer.type == LINK_TYPE_DELTA) && s_ucPeerSynced)
+		{
+			for(uint8_t n = 0; n + 1 < s_tPeer.len; n += 2)
+			{
+				s_ucPeerReport[s_tPeer.payload[n]] = s_tPeer.payload[n + 1];
+			}
+		}
+		else if((s_tPeer.type == LINK_TYPE_EXT) && (s_tPeer.payload[0] == HID_CONSUMER_REPORT_ID))
+		{
+			memcpy(s_ucPeerConsumer, s_tPeer.payload, s_tPeer.len);
+		}
+	}
+	lost = (s_tPeer.crc_err != 0) || !s_ucPeerSynced;
+	s_tPeer.crc_err = 0;
+	s_usWireLen = 0;
+	s_usTxPos = 0;
+	s_iCorrupt = -1;
+	s_iDrop = -1;
+	if(lost)
+	{
+		s_uiPeerResync++;
+		s_ucRxLen = Link_Build_Frame(s_ucRx, 0, LINK_TYPE_RESYNC, payload, 0);
+		s_ucRxRead = 0;
+	}
+}
+static void Reset(void)
+{
+	Link_Init();
+	memset(&s_tPeer, 0, sizeof(s_tPeer));
+	memset(s_ucPeerReport, 0, sizeof(s_ucPeerReport));
+	memset(s_ucPeerConsumer, 0, sizeof(s_ucPeerConsumer));
+	memset(s_ucBoot, 0, sizeof(s_ucBoot));
+	s_ucPeerSynced = 0;
+	s_uiPeerResync = 0;
+	s_uiPeerSnapshot = 0;
+	s_ucConsumer = 0;
+	s_usWireLen = 0;
+	s_usTxPos = 0;
+	s_ucRxLen = 0;
+	s_ucRxRead = 0;
+}
+/* 键盘状态变化并经链路发送 */
+static void Press(uint8_t slot, uint8_t key)
+{
+	s_ucBoot[2 + slot] = key;
+	Link_SendReport(s_ucBoot);
+	Peer_Receive();
+}
+/* 组帧后逐字节解帧得到相同内容，任一字节错误都被CRC发现 */
+static void Test_Frame(void)
+{
+	uint8_t payload[LINK_PAYLOAD_MAX] = {1, 2, 3, 4, 5, 6, 7, 8};
+	uint8_t frame[LINK_FRAME_MAX];
+	LINK_PARSER p;
+	uint8_t n = Link_Build_Frame(frame, 0x5A, LINK_TYPE_SNAPSHOT, payload, LINK_PAYLOAD_MAX);
+	uint8_t done;
+
+	CHECK(n == LINK_FRAME_MAX);
+	for(uint8_t bad = 0; bad <= n; bad++)		//bad == n：无错误
+	{
+		memset(&p, 0, sizeof(p));
+		done = 0;
+		for(uint8_t i = 0; i < n; i++)
+		{
+			done |= Link_Parse_Byte(&p, frame[i] ^ ((i == bad) ? 0x10 : 0));
+		}
+		if(bad == n)
+		{
+			CHECK(done && (p.seq == 0x5A) && (p.type == LINK_TYPE_SNAPSHOT));
+			CHECK(memcmp(p.payload, payload, LINK_PAYLOAD_MAX) == 0);
+		}
+		else
+		{
+			CHECK(!done);
+		}
+	}
+}
+/* 首帧为快照，之后为增量，BLE端状态与键盘一致 */
+static void Test_Delta(void)
+{
+	Reset();
+	Press(0, 0x04);
+	CHECK(Link_GetStat()->snapshot == 1);
+	Press(1, 0x05);
+	Press(0, 0x00);
+	CHECK(Link_GetStat()->delta == 2);
+	CHECK(memcmp(s_ucPeerReport, s_ucBoot, LINK_REPORT_LEN) == 0);
+	CHECK(s_uiPeerResync == 0);
+}
+/* 帧被破坏后BLE端请求重发，快照使其恢复 */
+static void Test_Resync(void)
+{
+	Reset();
+	Press(0, 0x04);
+	s_iCorrupt = 5;
+	Press(1, 0x05);
+	CHECK(s_uiPeerResync == 1);
+	CHECK(memcmp(s_ucPeerReport, s_ucBoot, LINK_REPORT_LEN) != 0);
+	Link_Task();
+	Peer_Receive();
+	CHECK(memcmp(s_ucPeerReport, s_ucBoot, LINK_REPORT_LEN) == 0);
+	CHECK(Link_GetStat()->resync >= 1);
+}
+/* 增量帧在任一位置丢失一个或连续几个字节：之后继续发送按键变化，BLE端在
+   之后的帧上发现失步并请求重发；收到RESYNC快照起，BLE端的报告与键盘一致 */
+static void Test_Drop(void)
+{
+	const uint8_t keys[] = {0x06, 0x07, 0x00, 0x08, 0x09, 0x00, 0x0A, 0x0B};
+	const uint8_t frame_len = LINK_FRAME_MAX - LINK_PAYLOAD_MAX + 2;		//只变化一个字节的增量帧
+	uint32_t snapshot;
+	uint8_t recovered;
+	uint8_t step;
+	uint8_t frames;
+	uint32_t worst = 0;
+
+	for(uint8_t pos = 0; pos < frame_len; pos++)
+	{
+		for(uint8_t len = 1; pos + len <= frame_len; len++)
+		{
+			Reset();
+			Press(0, 0x04);
+			Press(1, 0x05);
+			CHECK(memcmp(s_ucPeerReport, s_ucBoot, LINK_REPORT_LEN) == 0);
+			s_iDrop = pos;
+			s_iDropLen = len;
+			Press(2, 0x1E);
+			snapshot = s_uiPeerSnapshot;
+			recovered = 0;
+			frames = 0;
+			for(step = 0; step < sizeof(keys); step++)
+			{
+				Link_Task();
+				Peer_Receive();
+				if(!recovered && (s_uiPeerResync > 0) && (s_uiPeerSnapshot > snapshot))
+				{
+					recovered = 1;
+					frames = step;
+				}
+				if(recovered)
+				{
+					CHECK(memcmp(s_ucPeerReport, s_ucBoot, LINK_REPORT_LEN) == 0);
+				}
+				Press(step % 6, keys[step]);
+				if(recovered)
+				{
+					CHECK(memcmp(s_ucPeerReport, s_ucBoot, LINK_REPORT_LEN) == 0);
+				}
+			}
+			Link_Task();
+			Peer_Receive();
+			CHECK(recovered);
+			CHECK(s_ucPeerSynced);
+			CHECK(memcmp(s_ucPeerReport, s_ucBoot, LINK_REPORT_LEN) == 0);
+			if(frames > worst)
+			{
+				worst = frames;
+			}
+		}
+	}
+	CHECK(worst <= 1);		//丢失后至多再发一帧即发现失步
+	printf("test_link: byte loss, recovered within %u frames after the loss\n", worst + 1);
+}
+/* USB模式下报告不经链路，RESYNC的快照和EXT报告由键盘当前状态生成 */
+static void Test_Resync_Usb(void)
+{
+	Reset();
+	Press(0, 0x04);
+	s_ucBoot[2] = 0x00;			//USB模式下的按键变化，不调用 Link_SendReport
+	s_ucBoot[3] = 0x1E;
+	s_ucConsumer = 0x20;
+	s_ucRxLen = Link_Build_Frame(s_ucRx, 0, LINK_TYPE_RESYNC, s_ucRx, 0);
+	s_ucRxRead = 0;
+	Link_Task();
+	Peer_Receive();
+	CHECK(memcmp(s_ucPeerReport, s_ucBoot, LINK_REPORT_LEN) == 0);
+	CHECK((s_ucPeerConsumer[0] == HID_CONSUMER_REPORT_ID) && (s_ucPeerConsumer[1] == 0x20));
+	Press(4, 0x2C);				//之后的增量以新快照为基准
+	CHECK(memcmp(s_ucPeerReport, s_ucBoot, LINK_REPORT_LEN) == 0);
+}
+
+int main(void)
+{
+	Test_Frame();
+	Test_Delta();
+	Test_Resync();
+	Test_Drop();
+	Test_Resync_Usb();
+	printf("test_link: %s\n", s_iFail ? "FAIL" : "OK");
+	return s_iFail ? EXIT_FAILURE : EXIT_SUCCESS;
+}
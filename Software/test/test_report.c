@@ -0,0 +1,162 @@
+/************************************************************
+	*	@file:		test_report.c
+	*	@brief:		报告队列主机测试：合并规则、队列满时不改写队尾、
+	*				发送顺序与入队顺序一致
+	*	@author:	XIET
+	*	@version:	V1.0
+	*	@data:		201x-xx-xx
+	*	@modify:	data  			remarks
+**************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include "sim.h"
+
+USBD_HandleTypeDef USBD_Device;
+
+static uint8_t s_ucSent[64][REPORT_MAX_LEN];	//端点上发出的报告
+static uint8_t s_ucSentLen[64];
+static uint8_t s_ucSentCnt;
+static uint32_t s_uiEvent;
+
+uint8_t USBD_HID_SendReport(USBD_HandleTypeDef *pdev, uint8_t *report, uint16_t len)
+{
+	(void)pdev;
+	memcpy(s_ucSent[s_ucSentCnt], report, len);
+	s_ucSentLen[s_ucSentCnt] = (uint8_t)len;
+	s_ucSentCnt++;
+	return USBD_OK;
+}
+int32_t bsp_GetRunTime(void)
+{
+	return 0;
+}
+void Event_Post(uint32_t evt)
+{
+	s_uiEvent |= evt;
+}
+void Pwr_Wake_Report(uint8_t stage)
+{
+	(void)stage;
+}
+/* NKRO报告：keys 为按下的键值，以0结束 */
+static void Build_NKRO(uint8_t *buf, uint8_t mod, const uint8_t *keys)
+{
+	memset(buf, 0, HID_NKRO_REPORT_LEN);
+	buf[0] = HID_NKRO_REPORT_ID;
+	buf[1] = mod;
+	for(; *keys; keys++)
+	{
+		buf[2 + (*keys >> 3)] |= (uint8_t)(1 << (*keys & 0x07));
+	}
+}
+static void Reset(void)
+{
+	s_ucSentCnt = 0;
+	s_uiEvent = 0;
+	Report_Queue_Init();
+}
+/* 端点发出的第n个报告是否等于buf */
+static int Sent_Is(uint8_t n, const uint8_t *buf, uint8_t len)
+{
+	return (n < s_ucSentCnt) && (s_ucSentLen[n] == len) && (memcmp(s_ucSent[n], buf, len) == 0);
+}
+/* 合并规则：不同按键的按下和释放可以合并，同一按键的两次变化和两次按下不能合并 */
+static void Test_Merge(void)
+{
+	uint8_t r0[REPORT_MAX_LEN], r1[REPORT_MAX_LEN], r2[REPORT_MAX_LEN];
+
+	Reset();
+	Build_NKRO(r0, 0, (const uint8_t[]){4, 5, 0});
+	CHECK(Report_Queue_Push(r0, HID_NKRO_REPORT_LEN) == REPORT_PUSH_QUEUED);
+	Report_Queue_Kick();						//r0 在端点上
+	Build_NKRO(r1, 0, (const uint8_t[]){4, 5, 6, 0});
+	CHECK(Report_Queue_Push(r1, HID_NKRO_REPORT_LEN) == REPORT_PUSH_QUEUED);
+	Build_NKRO(r2, 0, (const uint8_t[]){5, 6, 0});		//释放4：与按下6合并
+	CHECK(Report_Queue_Push(r2, HID_NKRO_REPORT_LEN) == REPORT_PUSH_MERGED);
+	Build_NKRO(r1, 0, (const uint8_t[]){5, 0});		//释放6：6在两步中都变化，不能合并
+	CHECK(Report_Queue_Push(r1, HID_NKRO_REPORT_LEN) == REPORT_PUSH_QUEUED);
+	Build_NKRO(r1, 0, (const uint8_t[]){5, 7, 0});		//先释放后按下不同的键，可以合并
+	CHECK(Report_Queue_Push(r1, HID_NKRO_REPORT_LEN) == REPORT_PUSH_MERGED);
+	Build_NKRO(r1, 0, (const uint8_t[]){5, 7, 8, 0});	//连续两次按下不能合并
+	CHECK(Report_Queue_Push(r1, HID_NKRO_REPORT_LEN) == REPORT_PUSH_QUEUED);
+	Build_NKRO(r1, 0x02, (const uint8_t[]){5, 7, 8, 0});	//功能键变化不能合并
+	CHECK(Report_Queue_Push(r1, HID_NKRO_REPORT_LEN) == REPORT_PUSH_QUEUED);
+	while(!Report_Queue_Idle())
+	{
+		Report_Queue_TxCplt();
+	}
+	CHECK(s_ucSentCnt == 5);
+	CHECK(Sent_Is(1, r2, HID_NKRO_REPORT_LEN));
+}
+/* 消费类报告与键盘报告ID和长度不同，不合并 */
+static void Test_Merge_Id(void)
+{
+	uint8_t nkro[REPORT_MAX_LEN];
+	uint8_t cons[HID_CONSUMER_REPORT_LEN] = {HID_CONSUMER_REPORT_ID, 0x01, 0, 0};
+
+	Reset();
+	Build_NKRO(nkro, 0, (const uint8_t[]){4, 0});
+	Report_Queue_Push(nkro, HID_NKRO_REPORT_LEN);
+	Report_Queue_Kick();
+	Build_NKRO(nkro, 0, (const uint8_t[]){0});
+	CHECK(Report_Queue_Push(nkro, HID_NKRO_REPORT_LEN) == REPORT_PUSH_QUEUED);
+	CHECK(Report_Queue_Push(cons, HID_CONSUMER_REPORT_LEN) == REPORT_PUSH_QUEUED);
+	cons[1] = 0;
+	CHECK(Report_Queue_Push(cons, HID_CONSUMER_REPORT_LEN) == REPORT_PUSH_QUEUED);
+}
+/* 队列满：不能合并的报告返回REPORT_PUSH_FULL且不改写队尾，可以合并的照常合并 */
+static void Test_Full(void)
+{
+	uint8_t r[REPORT_MAX_LEN];
+	uint8_t tail[REPORT_MAX_LEN];
+	uint8_t keys[2] = {0, 0};
+	uint8_t cons[HID_CONSUMER_REPORT_LEN] = {HID_CONSUMER_REPORT_ID, 0x01, 0, 0};
+	uint8_t n;
+	uint32_t overflow;
+
+	Reset();
+	for(n = 0; n < REPORT_QUEUE_SIZE; n++)		//交替按下和释放同一个键，每个都不能合并
+	{
+		keys[0] = (n & 1) ? 0 : 4;
+		Build_NKRO(r, 0, keys);
+		CHECK(Report_Queue_Push(r, HID_NKRO_REPORT_LEN) == REPORT_PUSH_QUEUED);
+		if(n == 0)
+		{
+			Report_Queue_Kick();
+		}
+	}
+	memcpy(tail, r, HID_NKRO_REPORT_LEN);		//队尾为释放
+	overflow = Report_Queue_GetOverflow();
+	keys[0] = 4;
+	Build_NKRO(r, 0, keys);
+	CHECK(Report_Queue_Push(r, HID_NKRO_REPORT_LEN) == REPORT_PUSH_FULL);
+	CHECK(Report_Queue_GetOverflow() == overflow + 1);
+	CHECK(Report_Queue_Push(cons, HID_CONSUMER_REPORT_LEN) == REPORT_PUSH_FULL);
+	Build_NKRO(r, 0, (const uint8_t[]){0});		//与队尾相同，可以合并
+	CHECK(Report_Queue_Push(r, HID_NKRO_REPORT_LEN) == REPORT_PUSH_MERGED);
+	Report_Queue_TxCplt();		//腾出一个位置，重发的报告可以入队
+	CHECK(Report_Queue_Push(cons, HID_CONSUMER_REPORT_LEN) == REPORT_PUSH_QUEUED);
+	CHECK(s_uiEvent & EVT_USB_TX);
+	while(!Report_Queue_Idle())
+	{
+		Report_Queue_TxCplt();
+	}
+	CHECK(s_ucSentCnt == REPORT_QUEUE_SIZE + 1);
+	for(n = 0; n < REPORT_QUEUE_SIZE; n++)		//按下和释放都按顺序发出
+	{
+		keys[0] = (n & 1) ? 0 : 4;
+		Build_NKRO(r, 0, keys);
+		CHECK(Sent_Is(n, r, HID_NKRO_REPORT_LEN));
+	}
+	CHECK(Sent_Is(REPORT_QUEUE_SIZE - 1, tail, HID_NKRO_REPORT_LEN));
+	CHECK(Sent_Is(REPORT_QUEUE_SIZE, cons, HID_CONSUMER_REPORT_LEN));
+}
+
+int main(void)
+{
+	Test_Merge();
+	Test_Merge_Id();
+	Test_Full();
+	printf("test_report: %s\n", s_iFail ? "FAIL" : "OK");
+	return s_iFail ? EXIT_FAILURE : EXIT_SUCCESS;
+}
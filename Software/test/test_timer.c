@@ -0,0 +1,277 @@
+/************************************************************
+	*	@file:		test_timer.c
+	*	@brief:		软件定时器主机测试：差分链表的到期顺序和时间、无节拍定时的
+	*				唤醒次数、运行时间，以及SysTick随时重装时 bsp_DelayUS 的延时。
+	*				SysTick按内核时钟逐个计数模拟，写VAL后第二个时钟重装，
+	*				与 bsp_timer.c 的假设一致；TIM22按模拟时间给出微秒计数
+	*	@author:	XIET
+	*	@version:	V1.0
+	*	@data:		201x-xx-xx
+	*	@modify:	data  			remarks
+**************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include "sim.h"
+
+#define FIRE_MAX		16
+
+SysTick_Type g_tSimSysTick;
+SCB_Type g_tSimSCB;
+uint32_t SystemCoreClock;
+extern __IO int32_t g_iRunTime;
+
+static uint64_t s_ulSimPs;				//模拟时间(ps)
+static uint8_t s_ucZeroByCount;			//VAL由计数到0，下一个时钟重装
+static uint32_t s_uiIsrCount;			//SysTick中断次数
+static uint32_t s_uiFire[TMR_COUNT][FIRE_MAX];
+static uint8_t s_ucFireNum[TMR_COUNT];
+static uint8_t s_ucRestart;				//TMR_LED_CTRL 到时重启 TMR_FLOW，在中断中重装SysTick
+
+#define NEAR(a, b, tol)		(((a) + (tol) >= (b)) && ((a) <= (b) + (tol)))
+
+static uint32_t Sim_Now_Us(void)
+{
+	return (uint32_t)(s_ulSimPs / 1000000U);
+}
+/* 内核时钟前进 n 个周期，SysTick计到0时进入中断 */
+static void Sim_Clock(uint32_t n)
+{
+	uint32_t step;
+
+	while (n)
+	{
+		if (!(SysTick->CTRL & SysTick_CTRL_ENABLE_Msk))
+		{
+			s_ulSimPs += (uint64_t)n * (1000000000000ULL / SystemCoreClock);
+			return;
+		}
+		step = 1;
+		if (SysTick->VAL == 0)
+		{
+			if (s_ucZeroByCount)
+			{
+				SysTick->VAL = SysTick->LOAD;
+			}
+			s_ucZeroByCount = 1;		//软件写0后这一个时钟不重装
+		}
+		else
+		{
+			step = (SysTick->VAL < n) ? SysTick->VAL : n;
+			SysTick->VAL -= step;
+			if (SysTick->VAL == 0)
+			{
+				s_ucZeroByCount = 1;
+				SCB->ICSR |= SCB_ICSR_PENDSTSET_Msk;
+			}
+			else
+			{
+				s_ucZeroByCount = 0;
+			}
+		}
+		n -= step;
+		s_ulSimPs += (uint64_t)step * (1000000000000ULL / SystemCoreClock);
+		if ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) && (SysTick->CTRL & SysTick_CTRL_TICKINT_Msk))
+		{
+			SCB->ICSR &= ~SCB_ICSR_PENDSTSET_Msk;
+			s_uiIsrCount++;
+			SysTick_Handler();
+			if (SysTick->VAL == 0)
+			{
+				s_ucZeroByCount = 0;	//中断中重装了SysTick
+			}
+		}
+	}
+}
+static void Sim_Run_Us(uint32_t us)
+{
+	Sim_Clock(us * (SystemCoreClock / 1000000U));
+}
+uint32_t SysTick_Config(uint32_t ticks)
+{
+	SysTick->LOAD = ticks - 1;
+	SysTick->VAL = 0;
+	SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+	s_ucZeroByCount = 0;
+	return 0;
+}
+/* 每次读取约1us，忙等循环中模拟时间前进 */
+uint16_t bsp_UsTimer_Now(void)
+{
+	Sim_Clock(SystemCoreClock / 1000000U);
+	return (uint16_t)Sim_Now_Us();
+}
+/* WFI：运行到下一次SysTick中断 */
+void bsp_Idle(void)
+{
+	uint32_t count = s_uiIsrCount;
+
+	while (count == s_uiIsrCount)
+	{
+		Sim_Clock(1);
+	}
+}
+static void Timer_Fire(uint8_t id)
+{
+	if (s_ucFireNum[id] < FIRE_MAX)
+	{
+		s_uiFire[id][s_ucFireNum[id]] = Sim_Now_Us();
+	}
+	s_ucFireNum[id]++;
+}
+static void Timer_Fire0(void)
+{
+	Timer_Fire(0);
+}
+static void Timer_Fire1(void)
+{
+	Timer_Fire(1);
+	if (s_ucRestart)
+	{
+		bsp_StartTimer(0, 1);
+	}
+}
+static void Timer_Fire2(void)
+{
+	Timer_Fire(2);
+}
+static void Timer_Reset(uint32_t clock)
+{
+	SystemCoreClock = clock;
+	s_ulSimPs = 0;
+	s_ucRestart = 0;
+	g_iRunTime = 0;
+	SCB->ICSR = 0;
+	memset(s_ucFireNum, 0, sizeof(s_ucFireNum));
+	bsp_InitTimer();
+	bsp_SetTimerCallback(0, Timer_Fire0);
+	bsp_SetTimerCallback(1, Timer_Fire1);
+	bsp_SetTimerCallback(2, Timer_Fire2);
+}
+/* 到期顺序和时间：同时到期的按启动顺序，自动模式不累积误差 */
+static void Test_Order(void)
+{
+	Timer_Reset(32000000);
+	bsp_StartTimer(0, 5);
+	bsp_StartTimer(1, 3);
+	bsp_StartAutoTimer(2, 4);
+	Sim_Run_Us(13000);
+	CHECK(s_ucFireNum[0] == 1 && NEAR(s_uiFire[0][0], 5000, 2));
+	CHECK(s_ucFireNum[1] == 1 && NEAR(s_uiFire[1][0], 3000, 2));
+	CHECK(s_ucFireNum[2] == 3);
+	CHECK(NEAR(s_uiFire[2][0], 4000, 2) && NEAR(s_uiFire[2][1], 8000, 2) && NEAR(s_uiFire[2][2], 12000, 2));
+	CHECK(bsp_CheckTimer(0) && !bsp_CheckTimer(0));
+	CHECK(bsp_CheckTimer(2));
+
+	Sim_Run_Us(300);				//不在整毫秒启动，按毫秒边界计时
+	bsp_StartTimer(0, 2);
+	bsp_StartTimer(1, 2);
+	Sim_Run_Us(3000);
+	CHECK(s_ucFireNum[0] == 2 && s_ucFireNum[1] == 2);
+	CHECK(NEAR(s_uiFire[0][1], 15000, 2) && (s_uiFire[0][1] <= s_uiFire[1][1]));
+}
+/* 停止和重新启动：时间差并入下一项，其余定时器不受影响 */
+static void Test_Stop(void)
+{
+	Timer_Reset(32000000);
+	bsp_StartTimer(0, 10);
+	bsp_StartTimer(1, 20);
+	bsp_StartTimer(2, 15);
+	Sim_Run_Us(2000);
+	bsp_StopTimer(0);
+	bsp_StartTimer(2, 10);
+	Sim_Run_Us(20000);
+	CHECK(s_ucFireNum[0] == 0);
+	CHECK(s_ucFireNum[1] == 1 && NEAR(s_uiFire[1][0], 20000, 2));
+	CHECK(s_ucFireNum[2] == 1 && NEAR(s_uiFire[2][0], 12000, 2));
+}
+/* 无节拍：只有100ms定时器时每次到期才唤醒一次，长时间运行无漂移 */
+static void Test_Tickless(void)
+{
+	uint32_t wake;
+
+	Timer_Reset(32000000);
+	bsp_StartAutoTimer(0, 100);
+	wake = bsp_GetTickWakeups();
+	Sim_Run_Us(1000000);
+	CHECK(bsp_GetTickWakeups() - wake <= 11);
+	CHECK(s_ucFireNum[0] == 10);
+	CHECK(NEAR(s_uiFire[0][9], 1000000, 2));
+	CHECK(bsp_GetRunTime() == 1000);
+}
+/* 运行时间：反复重装SysTick后与实际时间一致 */
+static void Test_RunTime(void)
+{
+	uint32_t last = 0;
+	uint32_t now;
+
+	Timer_Reset(32000000);
+	for (uint32_t i = 0; i < 5000; i++)
+	{
+		Sim_Clock(37 * (i % 97) + 1);
+		bsp_StartTimer(0, 3);
+		now = bsp_GetRunTimeUs();
+		CHECK(now >= last);
+		CHECK(NEAR(now, Sim_Now_Us(), 1));
+		last = now;
+	}
+	CHECK(NEAR((uint32_t)bsp_GetRunTime() * 1000, Sim_Now_Us(), 1000));
+}
+/* 微秒延时：延时期间每毫秒在中断中重装SysTick，延时仍准确 */
+static void Test_DelayUS(uint32_t clock)
+{
+	static const uint32_t s_uiDelay[] = {1, 5, 10, 500, 999, 3000, 70000};
+	uint32_t start;
+	uint32_t used;
+
+	Timer_Reset(clock);
+	s_ucRestart = 1;
+	bsp_StartAutoTimer(1, 1);
+	Sim_Run_Us(250);
+	for (uint8_t i = 0; i < sizeof(s_uiDelay) / sizeof(s_uiDelay[0]); i++)
+	{
+		start = Sim_Now_Us();
+		bsp_DelayUS(s_uiDelay[i]);
+		used = Sim_Now_Us() - start;
+		CHECK((used >= s_uiDelay[i]) && (used <= s_uiDelay[i] + 2 * (s_uiDelay[i] / 0x8000 + 1)));	//每段最多多等2次读数
+	}
+	CHECK(s_ucFireNum[1] > 70);
+}
+/* 毫秒延时：等待中休眠，在第n个毫秒边界前后结束 */
+static void Test_DelayMS(void)
+{
+	uint32_t start;
+	uint32_t used;
+
+	Timer_Reset(32000000);
+	Sim_Run_Us(400);
+	start = Sim_Now_Us();
+	bsp_DelayMS(5);
+	used = Sim_Now_Us() - start;
+	CHECK((used >= 4000) && (used <= 5002));
+}
+/* 切换系统时钟：已经过的时间按旧频率计入，到期时间不变 */
+static void Test_SetClock(void)
+{
+	Timer_Reset(32000000);
+	bsp_StartTimer(0, 10);
+	Sim_Run_Us(4300);
+	SystemCoreClock = 2000000;
+	bsp_TimerSetClock();
+	Sim_Run_Us(10000);
+	CHECK(s_ucFireNum[0] == 1 && NEAR(s_uiFire[0][0], 10000, 2));
+	CHECK(NEAR(bsp_GetRunTimeUs(), Sim_Now_Us(), 1));
+}
+
+int main(void)
+{
+	Test_Order();
+	Test_Stop();
+	Test_Tickless();
+	Test_RunTime();
+	Test_DelayUS(32000000);
+	Test_DelayUS(2000000);
+	Test_DelayMS();
+	Test_SetClock();
+	printf("test_timer: %s\n", s_iFail ? "FAIL" : "OK");
+	return s_iFail ? EXIT_FAILURE : EXIT_SUCCESS;
+}